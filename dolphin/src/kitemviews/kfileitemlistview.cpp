@@ -153,10 +153,13 @@ QPixmap KFileItemListView::createDragPixmap(const KItemSet& indexes) const
     int x = 0;
     int y = 0;
 
+    Q_ASSERT(qobject_cast<KFileItemModel*>(model()));
+    const KFileItemModel* fileItemModel = static_cast<KFileItemModel*>(model());
+
     foreach (int index, indexes) {
-        QPixmap pixmap = model()->data(index).value("iconPixmap").value<QPixmap>();
+        QPixmap pixmap = fileItemModel->roleValue(index, "iconPixmap").value<QPixmap>();
         if (pixmap.isNull()) {
-            KIcon icon(model()->data(index).value("iconName").toString());
+            KIcon icon(fileItemModel->roleValue(index, "iconName").toString());
             pixmap = icon.pixmap(size, size);
         } else {
             pixmap = pixmap.scaled(QSize(size, size), Qt::KeepAspectRatio, Qt::SmoothTransformation);
@@ -57,15 +57,38 @@ bool KFileItemListWidgetInformant::itemIsLink(int index, const KItemListView* vi
 
 QString KFileItemListWidgetInformant::roleText(const QByteArray& role,
                                                const QHash<QByteArray, QVariant>& values) const
+{
+    if (role == "size" || role == "date") {
+        return roleValueText(role, values.value(role), values.value("isDir").toBool());
+    }
+    return KStandardItemListWidgetInformant::roleText(role, values);
+}
+
+QString KFileItemListWidgetInformant::itemRoleText(const QByteArray& role, int index, const KItemListView* view) const
+{
+    Q_ASSERT(qobject_cast<KFileItemModel*>(view->model()));
+    KFileItemModel* fileItemModel = static_cast<KFileItemModel*>(view->model());
+
+    // Read only the values that are required instead of
+    // creating a hash with the values of the item.
+    const QVariant roleValue = fileItemModel->roleValue(index, role);
+    if (role == "size") {
+        return roleValueText(role, roleValue, fileItemModel->roleValue(index, "isDir").toBool());
+    } else if (role == "date") {
+        return roleValueText(role, roleValue, false);
+    }
+    return roleValue.toString();
+}
+
+QString KFileItemListWidgetInformant::roleValueText(const QByteArray& role, const QVariant& roleValue, bool isDir) const
 {
     QString text;
-    const QVariant roleValue = values.value(role);
 
     // Implementation note: In case if more roles require a custom handling
     // use a hash + switch for a linear runtime.
 
     if (role == "size") {
-        if (values.value("isDir").toBool()) {
+        if (isDir) {
             // The item represents a directory. Show the number of sub directories
             // instead of the file size of the directory.
             if (!roleValue.isNull()) {
@@ -84,7 +107,7 @@ QString KFileItemListWidgetInformant::roleText(const QByteArray& role,
         const QDateTime dateTime = roleValue.toDateTime();
         text = KGlobal::locale()->formatDateTime(dateTime);
     } else {
-        text = KStandardItemListWidgetInformant::roleText(role, values);
+        text = roleValue.toString();
     }
 
     return text;
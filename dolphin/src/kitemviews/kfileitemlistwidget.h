@@ -34,7 +34,15 @@ protected:
     virtual QString itemText(int index, const KItemListView* view) const;
     virtual bool itemIsLink(int index, const KItemListView* view) const;
     virtual QString roleText(const QByteArray& role, const QHash<QByteArray, QVariant>& values) const;
+    virtual QString itemRoleText(const QByteArray& role, int index, const KItemListView* view) const;
     virtual QFont customizedFontForLinks(const QFont& baseFont) const;
+
+private:
+    /**
+     * @return Text for the value \a roleValue of the role \a role. \a isDir
+     *         is required to format the "size" role.
+     */
+    QString roleValueText(const QByteArray& role, const QVariant& roleValue, bool isDir) const;
 };
 
 class DOLPHINPRIVATE_EXPORT KFileItemListWidget : public KStandardItemListWidget
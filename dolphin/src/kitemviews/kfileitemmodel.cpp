@@ -32,6 +32,7 @@
 #include <QDir>
 #include <QApplication>
 #include <QMimeData>
+#include <QThread>
 #include <QTimer>
 #include <QWidget>
 #include <QElapsedTimer>
@@ -41,6 +42,12 @@
 
 // #define KFILEITEMMODEL_DEBUG
 
+namespace {
+    // Minimum number of items for which the sort keys are determined
+    // in advance and the sorting is done by several threads.
+    const int ParallelSortingThreshold = 1000;
+}
+
 KFileItemModel::KFileItemModel(QObject* parent) :
     KItemModelBase("text", parent),
     m_dirLister(0),
@@ -51,6 +58,8 @@ KFileItemModel::KFileItemModel(QObject* parent) :
     m_roles(),
     m_caseSensitivity(Qt::CaseInsensitive),
     m_itemData(),
+    m_roleStore(),
+    m_sortColumn(KFileItemModelRoleStore::TextColumn),
     m_items(),
     m_filter(),
     m_filteredItems(),
@@ -138,23 +147,49 @@ int KFileItemModel::count() const
 QHash<QByteArray, QVariant> KFileItemModel::data(int index) const
 {
     if (index >= 0 && index < count()) {
-        ItemData* data = m_itemData.at(index);
-        if (data->values.isEmpty()) {
-            data->values = retrieveData(data->item, data->parent);
-        }
+        const ItemData* data = m_itemData.at(index);
+        initRoleValues(data);
 
-        return data->values;
+        // The URL is not stored in m_roleStore, see setRoleValues()
+        QHash<QByteArray, QVariant> values = m_roleStore.values(data->row);
+        values.insert(sharedValue("url"), data->item.url());
+        return values;
     }
     return QHash<QByteArray, QVariant>();
 }
 
+QVariant KFileItemModel::roleValue(int index, const QByteArray& role) const
+{
+    if (index >= 0 && index < count()) {
+        const ItemData* data = m_itemData.at(index);
+        initRoleValues(data);
+
+        if (role == "url") {
+            return data->item.url();
+        }
+        return m_roleStore.value(data->row, role);
+    }
+    return QVariant();
+}
+
+bool KFileItemModel::hasRoleValue(int index, const QByteArray& role) const
+{
+    if (index >= 0 && index < count()) {
+        const ItemData* data = m_itemData.at(index);
+        initRoleValues(data);
+        return role == "url" || m_roleStore.contains(data->row, role);
+    }
+    return false;
+}
+
 bool KFileItemModel::setData(int index, const QHash<QByteArray, QVariant>& values)
 {
     if (index < 0 || index >= count()) {
         return false;
     }
 
-    QHash<QByteArray, QVariant> currentValues = data(index);
+    const ItemData* itemData = m_itemData.at(index);
+    initRoleValues(itemData);
 
     // Determine which roles have been changed
     QSet<QByteArray> changedRoles;
@@ -164,8 +199,8 @@ bool KFileItemModel::setData(int index, const QHash<QByteArray, QVariant>& value
         const QByteArray role = sharedValue(it.key());
         const QVariant value = it.value();
 
-        if (currentValues[role] != value) {
-            currentValues[role] = value;
+        if (m_roleStore.value(itemData->row, role) != value) {
+            m_roleStore.setValue(itemData->row, role, value);
             changedRoles.insert(role);
         }
     }
@@ -174,10 +209,9 @@ bool KFileItemModel::setData(int index, const QHash<QByteArray, QVariant>& value
         return false;
     }
 
-    m_itemData[index]->values = currentValues;
     if (changedRoles.contains("text")) {
         KUrl url = m_itemData[index]->item.url();
-        url.setFileName(currentValues["text"].toString());
+        url.setFileName(m_roleStore.value(itemData->row, "text").toString());
         m_itemData[index]->item.setUrl(url);
     }
 
@@ -453,18 +487,19 @@ void KFileItemModel::setRoles(const QSet<QByteArray>& roles)
         // Update m_data with the changed requested roles
         const int maxIndex = count() - 1;
         for (int i = 0; i <= maxIndex; ++i) {
-            m_itemData[i]->values = retrieveData(m_itemData.at(i)->item, m_itemData.at(i)->parent);
+            const ItemData* itemData = m_itemData.at(i);
+            setRoleValues(itemData, retrieveData(itemData->item, itemData->parent));
         }
 
         emit itemsChanged(KItemRangeList() << KItemRange(0, count()), changedRoles);
     }
 
-    // Clear the 'values' of all filtered items. They will be re-populated with the
-    // correct roles the next time 'values' will be accessed via data(int).
+    // Clear the role values of all filtered items. They will be re-populated with the
+    // correct roles the next time the values will be accessed via data(int).
     QHash<KFileItem, ItemData*>::iterator filteredIt = m_filteredItems.begin();
     const QHash<KFileItem, ItemData*>::iterator filteredEnd = m_filteredItems.end();
     while (filteredIt != filteredEnd) {
-        (*filteredIt)->values.clear();
+        m_roleStore.clearRow((*filteredIt)->row);
         ++filteredIt;
     }
 }
@@ -569,6 +604,7 @@ void KFileItemModel::onSortRoleChanged(const QByteArray& current, const QByteArr
 {
     Q_UNUSED(previous);
     m_sortRole = typeForRole(current);
+    m_sortColumn = KFileItemModelRoleStore::columnForRole(roleForType(m_sortRole));
 
     if (!m_requestRole[m_sortRole]) {
         QSet<QByteArray> newRoles = m_roles;
@@ -727,6 +763,7 @@ void KFileItemModel::slotItemsDeleted(const KFileItemList& items)
             // Probably the item has been filtered.
             QHash<KFileItem, ItemData*>::iterator it = m_filteredItems.find(item);
             if (it != m_filteredItems.end()) {
+                m_roleStore.releaseRow(it.value()->row);
                 delete it.value();
                 m_filteredItems.erase(it);
             }
@@ -759,18 +796,29 @@ void KFileItemModel::slotRefreshItems(const QList<QPair<KFileItem, KFileItem> >&
         const KFileItem& newItem = itemPair.second;
         const int indexForItem = index(oldItem);
         if (indexForItem >= 0) {
+            const ItemData* itemData = m_itemData.at(indexForItem);
             m_itemData[indexForItem]->item = newItem;
 
-            // Keep old values as long as possible if they could not retrieved synchronously yet.
-            // The update of the values will be done asynchronously by KFileItemModelRolesUpdater.
-            QHashIterator<QByteArray, QVariant> it(retrieveData(newItem, m_itemData.at(indexForItem)->parent));
-            QHash<QByteArray, QVariant>& values = m_itemData[indexForItem]->values;
-            while (it.hasNext()) {
-                it.next();
-                const QByteArray& role = it.key();
-                if (values.value(role) != it.value()) {
-                    values.insert(role, it.value());
-                    changedRoles.insert(role);
+            const QHash<QByteArray, QVariant> values = retrieveData(newItem, itemData->parent);
+            if (!m_roleStore.isInitialized(itemData->row)) {
+                setRoleValues(itemData, values);
+                changedRoles.unite(values.keys().toSet());
+            } else {
+                // Keep old values as long as possible if they could not retrieved synchronously yet.
+                // The update of the values will be done asynchronously by KFileItemModelRolesUpdater.
+                QHashIterator<QByteArray, QVariant> it(values);
+                while (it.hasNext()) {
+                    it.next();
+                    const QByteArray& role = it.key();
+                    if (role == "url") {
+                        // The URL is not stored in m_roleStore, see setRoleValues()
+                        if (oldItem.url() != newItem.url()) {
+                            changedRoles.insert(role);
+                        }
+                    } else if (m_roleStore.value(itemData->row, role) != it.value()) {
+                        m_roleStore.setValue(itemData->row, role, it.value());
+                        changedRoles.insert(role);
+                    }
                 }
             }
 
@@ -784,9 +832,9 @@ void KFileItemModel::slotRefreshItems(const QList<QPair<KFileItem, KFileItem> >&
                 ItemData* itemData = it.value();
                 itemData->item = newItem;
 
-                // The data stored in 'values' might have changed. Therefore, we clear
-                // 'values' and re-populate it the next time it is requested via data(int).
-                itemData->values.clear();
+                // The stored role values might have changed. Therefore, we clear
+                // them and re-populate them the next time they are requested via data(int).
+                m_roleStore.clearRow(itemData->row);
 
                 m_filteredItems.erase(it);
                 m_filteredItems.insert(newItem, itemData);
@@ -822,6 +870,9 @@ void KFileItemModel::slotClear()
     qDeleteAll(m_pendingItemsToInsert);
     m_pendingItemsToInsert.clear();
 
+    // The remaining items of m_itemData are deleted below
+    m_roleStore.clear();
+
     const int removedCount = m_itemData.count();
     if (removedCount > 0) {
         qDeleteAll(m_itemData);
@@ -947,6 +998,7 @@ void KFileItemModel::removeItems(const KItemRangeList& itemRanges, RemoveItemsBe
 
         for (int index = range.index; index < range.index + range.count; ++index) {
             if (behavior == DeleteItemData) {
+                m_roleStore.releaseRow(m_itemData.at(index)->row);
                 delete m_itemData.at(index);
             }
 
@@ -999,6 +1051,7 @@ QList<KFileItemModel::ItemData*> KFileItemModel::createItemDataList(const KUrl&
     foreach (const KFileItem& item, items) {
         ItemData* itemData = new ItemData();
         itemData->item = item;
+        itemData->row = m_roleStore.createRow();
         itemData->parent = parentItem;
         itemDataList.append(itemData);
     }
@@ -1015,21 +1068,19 @@ void KFileItemModel::prepareItemsForSorting(QList<ItemData*>& itemDataList)
     case DestinationRole:
     case PathRole:
         // These roles can be determined with retrieveData, and they have to be stored
-        // in the QHash "values" for the sorting.
+        // in m_roleStore for the sorting.
         foreach (ItemData* itemData, itemDataList) {
-            if (itemData->values.isEmpty()) {
-                itemData->values = retrieveData(itemData->item, itemData->parent);
-            }
+            initRoleValues(itemData);
         }
         break;
 
     case TypeRole:
         // At least store the data including the file type for items with known MIME type.
         foreach (ItemData* itemData, itemDataList) {
-            if (itemData->values.isEmpty()) {
+            if (!m_roleStore.isInitialized(itemData->row)) {
                 const KFileItem item = itemData->item;
                 if (item.isDir() || item.isMimeTypeKnown()) {
-                    itemData->values = retrieveData(itemData->item, itemData->parent);
+                    setRoleValues(itemData, retrieveData(itemData->item, itemData->parent));
                 }
             }
         }
@@ -1038,13 +1089,29 @@ void KFileItemModel::prepareItemsForSorting(QList<ItemData*>& itemDataList)
     default:
         // The other roles are either resolved by KFileItemModelRolesUpdater
         // (this includes the SizeRole for directories), or they do not need
-        // to be stored in the QHash "values" for sorting because the data can
+        // to be stored in m_roleStore for sorting because the data can
         // be retrieved directly from the KFileItem (NameRole, SizeRole for files,
         // DateRole).
         break;
     }
 }
 
+void KFileItemModel::initRoleValues(const ItemData* itemData) const
+{
+    if (!m_roleStore.isInitialized(itemData->row)) {
+        setRoleValues(itemData, retrieveData(itemData->item, itemData->parent));
+    }
+}
+
+void KFileItemModel::setRoleValues(const ItemData* itemData, const QHash<QByteArray, QVariant>& values) const
+{
+    // The URL is not stored, as it can be obtained from the KFileItem
+    // cheaply and would be the most expensive value to store.
+    QHash<QByteArray, QVariant> storedValues = values;
+    storedValues.remove("url");
+    m_roleStore.setValues(itemData->row, storedValues);
+}
+
 void KFileItemModel::emitItemsChangedAndTriggerResorting(const KItemRangeList& itemRanges, const QSet<QByteArray>& changedRoles)
 {
     emit itemsChanged(itemRanges, changedRoles);
@@ -1281,14 +1348,217 @@ private:
     const KFileItemModel* m_model;
 };
 
+/**
+ * Helper class for KFileItemModel::sort().
+ */
+class KFileItemModelSortKeyLessThan
+{
+public:
+    KFileItemModelSortKeyLessThan(const KFileItemModel* model) :
+        m_model(model)
+    {
+    }
+
+    bool operator()(const KFileItemModel::SortKey* a, const KFileItemModel::SortKey* b) const
+    {
+        return m_model->sortKeyLessThan(a, b);
+    }
+
+private:
+    const KFileItemModel* m_model;
+};
+
 void KFileItemModel::sort(QList<KFileItemModel::ItemData*>::iterator begin,
                           QList<KFileItemModel::ItemData*>::iterator end) const
 {
-    KFileItemModelLessThan lessThan(this);
+    const int span = end - begin;
+    const int numberOfThreads = QThread::idealThreadCount();
+    if (span < ParallelSortingThreshold || numberOfThreads < 2) {
+        KFileItemModelLessThan lessThan(this);
+        mergeSort(begin, end, lessThan);
+        return;
+    }
+
+    // The comparison functions that access KFileItem are not reentrant (see
+    // https://bugs.kde.org/show_bug.cgi?id=312679). Determine the sort keys
+    // of all items in advance, so that the keys can be sorted by several threads.
+    QVector<SortKey> keys;
+    QVector<const SortKey*> sortedKeys = initSortKeys(begin, end, keys);
 
-    // Use only one thread to prevent problems caused by non-reentrant
-    // comparison functions, see https://bugs.kde.org/show_bug.cgi?id=312679
-    mergeSort(begin, end, lessThan);
+    KFileItemModelSortKeyLessThan lessThan(this);
+    parallelMergeSort(sortedKeys.begin(), sortedKeys.end(), lessThan, numberOfThreads);
+
+    QList<ItemData*>::iterator it = begin;
+    foreach (const SortKey* key, sortedKeys) {
+        *it = key->itemData;
+        ++it;
+    }
+}
+
+QVector<const KFileItemModel::SortKey*> KFileItemModel::initSortKeys(QList<ItemData*>::iterator begin,
+                                                                    QList<ItemData*>::iterator end,
+                                                                    QVector<SortKey>& keys) const
+{
+    // Collect the items and their parents. The parents are required
+    // for comparing items from different expansion levels.
+    QHash<const ItemData*, int> keyIndexes;
+    QList<ItemData*> itemDataList;
+    itemDataList.reserve(end - begin);
+    for (QList<ItemData*>::iterator it = begin; it != end; ++it) {
+        ItemData* itemData = *it;
+        while (itemData && !keyIndexes.contains(itemData)) {
+            keyIndexes.insert(itemData, itemDataList.count());
+            itemDataList.append(itemData);
+            itemData = itemData->parent;
+        }
+    }
+
+    const bool caseInsensitive = (m_caseSensitivity == Qt::CaseInsensitive);
+
+    keys.resize(itemDataList.count());
+    for (int i = 0; i < itemDataList.count(); ++i) {
+        ItemData* itemData = itemDataList.at(i);
+        const KFileItem& item = itemData->item;
+
+        SortKey& key = keys[i];
+        key.itemData = itemData;
+        key.parent = itemData->parent ? &keys.at(keyIndexes.value(itemData->parent)) : 0;
+        key.isDir = item.isDir();
+        key.hasValue = false;
+        key.size = 0;
+
+        switch (m_sortRole) {
+        case NameRole:
+            break;
+
+        case SizeRole:
+            if (key.isDir) {
+                key.hasValue = m_roleStore.hasValue(itemData->row, KFileItemModelRoleStore::SizeColumn);
+                key.size = m_roleStore.sizeValue(itemData->row);
+            } else {
+                key.size = item.size();
+            }
+            break;
+
+        case DateRole:
+            key.dateTime = item.time(KFileItem::ModificationTime);
+            break;
+
+        default:
+            key.value = m_roleStore.stringValue(itemData->row, m_sortColumn);
+            break;
+        }
+
+        key.text = item.text();
+        key.textKey = stringKey(key.text);
+        key.name = item.name(caseInsensitive);
+        key.nameKey = stringKey(key.name);
+    }
+
+    QVector<const SortKey*> result;
+    result.reserve(end - begin);
+    for (QList<ItemData*>::iterator it = begin; it != end; ++it) {
+        result.append(&keys.at(keyIndexes.value(*it)));
+    }
+    return result;
+}
+
+bool KFileItemModel::sortKeyLessThan(const SortKey* a, const SortKey* b) const
+{
+    int result = 0;
+
+    if (a->parent != b->parent) {
+        // Compare the last parents of a and b which are different.
+        while (a->parent != b->parent) {
+            a = a->parent;
+            b = b->parent;
+        }
+    }
+
+    if (m_sortDirsFirst || m_sortRole == SizeRole) {
+        if (a->isDir && !b->isDir) {
+            return true;
+        } else if (!a->isDir && b->isDir) {
+            return false;
+        }
+    }
+
+    result = sortKeyCompare(a, b);
+
+    return (sortOrder() == Qt::AscendingOrder) ? result < 0 : result > 0;
+}
+
+int KFileItemModel::sortKeyCompare(const SortKey* a, const SortKey* b) const
+{
+    int result = 0;
+
+    switch (m_sortRole) {
+    case NameRole:
+        // The name role is handled as default fallback after the switch
+        break;
+
+    case SizeRole:
+        if (a->isDir) {
+            // See "if (m_sortFoldersFirst || m_sortRole == SizeRole)" in KFileItemModel::sortKeyLessThan():
+            Q_ASSERT(b->isDir);
+
+            if (!a->hasValue && !b->hasValue) {
+                result = 0;
+            } else if (!a->hasValue) {
+                result = -1;
+            } else if (!b->hasValue) {
+                result = +1;
+            } else {
+                result = int(a->size) - int(b->size);
+            }
+        } else {
+            // See "if (m_sortFoldersFirst || m_sortRole == SizeRole)" in KFileItemModel::sortKeyLessThan():
+            Q_ASSERT(!b->isDir);
+            if (a->size > b->size) {
+                result = +1;
+            } else if (a->size < b->size) {
+                result = -1;
+            } else {
+                result = 0;
+            }
+        }
+        break;
+
+    case DateRole:
+        if (a->dateTime < b->dateTime) {
+            result = -1;
+        } else if (a->dateTime > b->dateTime) {
+            result = +1;
+        }
+        break;
+
+    default:
+        result = QString::compare(a->value, b->value);
+        break;
+    }
+
+    if (result != 0) {
+        // The current sort role was sufficient to define an order
+        return result;
+    }
+
+    // Fallback #1: Compare the text of the items
+    result = stringKeyCompare(a->textKey, b->textKey, a->text, b->text);
+    if (result != 0) {
+        return result;
+    }
+
+    // Fallback #2: KFileItem::text() may not be unique in case UDS_DISPLAY_NAME is used
+    result = stringKeyCompare(a->nameKey, b->nameKey, a->name, b->name);
+    if (result != 0) {
+        return result;
+    }
+
+    // Fallback #3: It must be assured that the sort order is always unique even if two values have been
+    // equal. In this case a comparison of the URL is done which is unique in all cases
+    // within KDirLister. The URL is not part of the sort key because this fallback is
+    // only reached for items with equal names, and KUrl is thread-safe for const access.
+    return QString::compare(a->itemData->item.url().url(), b->itemData->item.url().url(), Qt::CaseSensitive);
 }
 
 int KFileItemModel::sortRoleCompare(const ItemData* a, const ItemData* b) const
@@ -1308,16 +1578,16 @@ int KFileItemModel::sortRoleCompare(const ItemData* a, const ItemData* b) const
             // See "if (m_sortFoldersFirst || m_sortRole == SizeRole)" in KFileItemModel::lessThan():
             Q_ASSERT(itemB.isDir());
 
-            const QVariant valueA = a->values.value("size");
-            const QVariant valueB = b->values.value("size");
-            if (valueA.isNull() && valueB.isNull()) {
+            const bool hasValueA = m_roleStore.hasValue(a->row, KFileItemModelRoleStore::SizeColumn);
+            const bool hasValueB = m_roleStore.hasValue(b->row, KFileItemModelRoleStore::SizeColumn);
+            if (!hasValueA && !hasValueB) {
                 result = 0;
-            } else if (valueA.isNull()) {
+            } else if (!hasValueA) {
                 result = -1;
-            } else if (valueB.isNull()) {
+            } else if (!hasValueB) {
                 result = +1;
             } else {
-                result = valueA.toInt() - valueB.toInt();
+                result = int(m_roleStore.sizeValue(a->row)) - int(m_roleStore.sizeValue(b->row));
             }
         } else {
             // See "if (m_sortFoldersFirst || m_sortRole == SizeRole)" in KFileItemModel::lessThan():
@@ -1346,12 +1616,10 @@ int KFileItemModel::sortRoleCompare(const ItemData* a, const ItemData* b) const
         break;
     }
 
-    default: {
-        const QByteArray role = roleForType(m_sortRole);
-        result = QString::compare(a->values.value(role).toString(),
-                                  b->values.value(role).toString());
+    default:
+        result = QString::compare(m_roleStore.stringValue(a->row, m_sortColumn),
+                                  m_roleStore.stringValue(b->row, m_sortColumn));
         break;
-    }
 
     }
 
@@ -1380,6 +1648,21 @@ int KFileItemModel::sortRoleCompare(const ItemData* a, const ItemData* b) const
 }
 
 int KFileItemModel::stringCompare(const QString& a, const QString& b) const
+{
+    return stringKeyCompare(stringKey(a), stringKey(b), a, b);
+}
+
+QString KFileItemModel::stringKey(const QString& string) const
+{
+    // Lower-casing the strings once in advance is cheaper than letting
+    // KStringHandler::naturalCompare() do it for each comparison.
+    if (m_naturalSorting && m_caseSensitivity == Qt::CaseInsensitive) {
+        return string.toLower();
+    }
+    return string;
+}
+
+int KFileItemModel::stringKeyCompare(const QString& keyA, const QString& keyB, const QString& a, const QString& b) const
 {
     // Taken from KDirSortFilterProxyModel (kdelibs/kfile/kdirsortfilterproxymodel.*)
     // Copyright (C) 2006 by Peter Penz <peter.penz@gmx.at>
@@ -1387,8 +1670,9 @@ int KFileItemModel::stringCompare(const QString& a, const QString& b) const
     // Copyright (C) 2006 by Martin Pool <mbp@canonical.com>
 
     if (m_caseSensitivity == Qt::CaseInsensitive) {
-        const int result = m_naturalSorting ? KStringHandler::naturalCompare(a, b, Qt::CaseInsensitive)
-                                            : QString::compare(a, b, Qt::CaseInsensitive);
+        // For the natural sorting the keys have been lower-cased by stringKey() already.
+        const int result = m_naturalSorting ? KStringHandler::naturalCompare(keyA, keyB, Qt::CaseSensitive)
+                                            : QString::compare(keyA, keyB, Qt::CaseInsensitive);
         if (result != 0) {
             // Only return the result, if the strings are not equal. If they are equal by a case insensitive
             // comparison, still a deterministic sort order is required. A case sensitive
@@ -1557,7 +1841,7 @@ QList<QPair<int, QVariant> > KFileItemModel::permissionRoleGroups() const
         }
 
         const ItemData* itemData = m_itemData.at(i);
-        const QString newPermissionsString = itemData->values.value("permissions").toString();
+        const QString& newPermissionsString = m_roleStore.stringValue(itemData->row, KFileItemModelRoleStore::PermissionsColumn);
         if (newPermissionsString == permissionsString) {
             continue;
         }
@@ -1621,13 +1905,18 @@ QList<QPair<int, QVariant> > KFileItemModel::genericStringRoleGroups(const QByte
     const int maxIndex = count() - 1;
     QList<QPair<int, QVariant> > groups;
 
+    const KFileItemModelRoleStore::Column column = KFileItemModelRoleStore::columnForRole(role);
+
     bool isFirstGroupValue = true;
     QString groupValue;
     for (int i = 0; i <= maxIndex; ++i) {
         if (isChildItem(i)) {
             continue;
         }
-        const QString newGroupValue = m_itemData.at(i)->values.value(role).toString();
+        const int row = m_itemData.at(i)->row;
+        const QString newGroupValue = KFileItemModelRoleStore::isStringColumn(column)
+                                      ? m_roleStore.stringValue(row, column)
+                                      : m_roleStore.value(row, role).toString();
         if (newGroupValue != groupValue || isFirstGroupValue) {
             groupValue = newGroupValue;
             groups.append(QPair<int, QVariant>(i, newGroupValue));
@@ -25,10 +25,13 @@
 #include <KUrl>
 #include <kitemviews/kitemmodelbase.h>
 #include <kitemviews/private/kfileitemmodelfilter.h>
+#include <kitemviews/private/kfileitemmodelrolestore.h>
 
+#include <QDateTime>
 #include <QHash>
 #include <QSet>
 #include <QTimer>
+#include <QVector>
 
 class KFileItemModelDirLister;
 
@@ -76,6 +79,20 @@ public:
     virtual QHash<QByteArray, QVariant> data(int index) const;
     virtual bool setData(int index, const QHash<QByteArray, QVariant>& values);
 
+    /**
+     * @return The value of the role \a role for the item with the index \a index.
+     *         In contrast to data(int) no hash with the values of all roles
+     *         is created, hence this should be preferred if only single roles
+     *         are required.
+     */
+    QVariant roleValue(int index, const QByteArray& role) const;
+
+    /**
+     * @return True if the item with the index \a index has a value for
+     *         the role \a role. Equivalent to data(index).contains(role).
+     */
+    bool hasRoleValue(int index, const QByteArray& role) const;
+
     /**
      * Sets a separate sorting with directories first (true) or a mixed
      * sorting of files and directories (false).
@@ -266,10 +283,32 @@ private:
     struct ItemData
     {
         KFileItem item;
-        QHash<QByteArray, QVariant> values;
+        int row;                // Row of the role values in m_roleStore
         ItemData* parent;
     };
 
+    /**
+     * Immutable sort data of an item. The keys are determined by
+     * initSortKeys() before the sorting is started. This allows to compare
+     * the items without accessing KFileItem, whose accessors are not reentrant
+     * because of lazily cached values (see https://bugs.kde.org/show_bug.cgi?id=312679),
+     * and hence to sort by several threads.
+     */
+    struct SortKey
+    {
+        ItemData* itemData;
+        const SortKey* parent;
+        bool isDir;
+        bool hasValue;          // False if the directory size has not been determined yet
+        KIO::filesize_t size;
+        QDateTime dateTime;
+        QString value;          // String value of sort roles other than name, size and date
+        QString text;
+        QString textKey;        // See stringKey()
+        QString name;
+        QString nameKey;        // See stringKey()
+    };
+
     enum RemoveItemsBehavior {
         KeepItemData,
         DeleteItemData
@@ -287,12 +326,23 @@ private:
     QList<ItemData*> createItemDataList(const KUrl& parentUrl, const KFileItemList& items) const;
 
     /**
-     * Prepares the items for sorting. Normally, the hash 'values' in ItemData is filled
-     * lazily to save time and memory, but for some sort roles, it is expected that the
-     * sort role data is stored in 'values'.
+     * Prepares the items for sorting. Normally, the role values in m_roleStore are
+     * retrieved lazily to save time and memory, but for some sort roles, it is expected
+     * that the sort role data is stored in m_roleStore.
      */
     void prepareItemsForSorting(QList<ItemData*>& itemDataList);
 
+    /**
+     * Assures that the role values of \a itemData have been retrieved
+     * and stored in m_roleStore.
+     */
+    void initRoleValues(const ItemData* itemData) const;
+
+    /**
+     * Replaces the role values of \a itemData by \a values.
+     */
+    void setRoleValues(const ItemData* itemData, const QHash<QByteArray, QVariant>& values) const;
+
     /**
      * This function is called by setData() and slotRefreshItems(). It emits
      * the itemsChanged() signal, checks if the sort order is still correct,
@@ -346,6 +396,41 @@ private:
 
     int stringCompare(const QString& a, const QString& b) const;
 
+    /**
+     * Determines the sort keys of the items between \a begin and \a end and of
+     * all their parent items. The sort keys are stored in \a keys and the
+     * returned list contains the sort keys of the items in the same order
+     * as the items.
+     */
+    QVector<const SortKey*> initSortKeys(QList<ItemData*>::iterator begin,
+                                         QList<ItemData*>::iterator end,
+                                         QVector<SortKey>& keys) const;
+
+    /**
+     * Equivalent of lessThan() for sort keys. It is reentrant and
+     * can be used by several threads at the same time.
+     */
+    bool sortKeyLessThan(const SortKey* a, const SortKey* b) const;
+
+    /**
+     * Equivalent of sortRoleCompare() for sort keys.
+     */
+    int sortKeyCompare(const SortKey* a, const SortKey* b) const;
+
+    /**
+     * @return The string that is used by stringKeyCompare() for comparing
+     *         \a string. For a case insensitive natural sorting the string
+     *         is lower-cased, otherwise \a string is returned.
+     */
+    QString stringKey(const QString& string) const;
+
+    /**
+     * Equivalent of stringCompare() for strings that have been prepared
+     * by stringKey(). \a keyA and \a keyB are the prepared strings, \a a
+     * and \a b the original ones.
+     */
+    int stringKeyCompare(const QString& keyA, const QString& keyB, const QString& a, const QString& b) const;
+
     bool useMaximumUpdateInterval() const;
 
     QList<QPair<int, QVariant> > nameRoleGroups() const;
@@ -422,6 +507,11 @@ private:
 
     QList<ItemData*> m_itemData;
 
+    // Values of the roles for all items in m_itemData, m_filteredItems and
+    // m_pendingItemsToInsert. Filled lazily by data(), see initRoleValues().
+    mutable KFileItemModelRoleStore m_roleStore;
+    KFileItemModelRoleStore::Column m_sortColumn; // Column in m_roleStore for m_sortRole
+
     // m_items is a cache for the method index(const KUrl&). If it contains N
     // entries, it is guaranteed that these correspond to the first N items in
     // the model, i.e., that (for every i between 0 and N - 1)
@@ -441,6 +531,7 @@ private:
     mutable QList<QPair<int, QVariant> > m_groups;
 
     friend class KFileItemModelLessThan;       // Accesses lessThan() method
+    friend class KFileItemModelSortKeyLessThan; // Accesses sortKeyLessThan() method
     friend class KFileItemModelRolesUpdater;   // Accesses emitSortProgress() method
     friend class KFileItemModelTest;           // For unit testing
     friend class KFileItemModelBenchmark;      // For unit testing
@@ -31,6 +31,7 @@
 #include <KIO/PreviewJob>
 
 #include "private/kdirectorycontentscounter.h"
+#include "private/kfileitembatchpreviewjob.h"
 
 #include <QApplication>
 #include <QPainter>
@@ -74,6 +75,7 @@ KFileItemModelRolesUpdater::KFileItemModelRolesUpdater(KFileItemModel* model, QO
     m_roles(),
     m_resolvableRoles(),
     m_enabledPlugins(),
+    m_batchPreviewPlugins(),
     m_pendingSortRoleItems(),
     m_pendingIndexes(),
     m_pendingPreviewItems(),
@@ -196,6 +198,7 @@ void KFileItemModelRolesUpdater::setEnabledPlugins(const QStringList& list)
 {
     if (m_enabledPlugins != list) {
         m_enabledPlugins = list;
+        m_batchPreviewPlugins.clear();
         if (m_previewShown) {
             updateAllPreviews();
         }
@@ -508,7 +511,7 @@ void KFileItemModelRolesUpdater::resolveNextSortRole()
 
         // Continue if the sort role has already been determined for the
         // item, and the item has not been changed recently.
-        if (!m_changedItems.contains(item) && m_model->data(index).contains(m_model->sortRole())) {
+        if (!m_changedItems.contains(item) && m_model->hasRoleValue(index, m_model->sortRole())) {
             it = m_pendingSortRoleItems.erase(it);
             continue;
         }
@@ -568,7 +571,7 @@ void KFileItemModelRolesUpdater::resolveNextPendingRoles()
                 disconnect(m_model, SIGNAL(itemsChanged(KItemRangeList,QSet<QByteArray>)),
                            this,    SLOT(slotItemsChanged(KItemRangeList,QSet<QByteArray>)));
                 for (int index = 0; index <= m_model->count(); ++index) {
-                    if (m_model->data(index).contains("iconPixmap")) {
+                    if (m_model->hasRoleValue(index, "iconPixmap")) {
                         m_model->setData(index, data);
                     }
                 }
@@ -735,6 +738,40 @@ void KFileItemModelRolesUpdater::startPreviewJob()
         } while (!m_pendingPreviewItems.isEmpty() && timer.elapsed() < MaxBlockTimeout);
     }
 
+    // Local files of plugins which can create several previews at once are
+    // passed to the thumbnail slave in a single batch. The other items are
+    // left for a KIO::PreviewJob started when the batch is finished.
+    if (m_batchPreviewPlugins.isEmpty()) {
+        m_batchPreviewPlugins = KFileItemBatchPreviewJob::enabledPlugins(m_enabledPlugins);
+    }
+    KFileItemList batchItems;
+    KFileItemList otherItems;
+    foreach (const KFileItem& item, itemSubSet) {
+        if (KFileItemBatchPreviewJob::batchPlugin(item, m_batchPreviewPlugins)) {
+            batchItems.append(item);
+        } else {
+            otherItems.append(item);
+        }
+    }
+
+    if (!batchItems.isEmpty()) {
+        for (int i = otherItems.count() - 1; i >= 0; --i) {
+            m_pendingPreviewItems.prepend(otherItems.at(i));
+        }
+
+        KFileItemBatchPreviewJob* job = new KFileItemBatchPreviewJob(batchItems, cacheSize, m_batchPreviewPlugins, this);
+        connect(job,  SIGNAL(gotPreview(KFileItem,QPixmap)),
+                this, SLOT(slotGotPreview(KFileItem,QPixmap)));
+        connect(job,  SIGNAL(failed(KFileItem)),
+                this, SLOT(slotPreviewFailed(KFileItem)));
+        connect(job,  SIGNAL(finished(KJob*)),
+                this, SLOT(slotPreviewJobFinished()));
+        job->start();
+
+        m_previewJob = job;
+        return;
+    }
+
     KIO::PreviewJob* job = new KIO::PreviewJob(itemSubSet, cacheSize, &m_enabledPlugins);
 
     job->setIgnoreMaximumSize(itemSubSet.first().isLocalFile());
@@ -866,7 +903,7 @@ bool KFileItemModelRolesUpdater::applyResolvedRoles(int index, ResolveHint hint)
     if (!item.isMimeTypeKnown() || !item.isFinalIconKnown()) {
         item.determineMimeType();
         iconChanged = true;
-    } else if (!m_model->data(index).contains("iconName")) {
+    } else if (!m_model->hasRoleValue(index, "iconName")) {
         iconChanged = true;
     }
 
@@ -21,6 +21,7 @@
 #define KFILEITEMMODELROLESUPDATER_H
 
 #include <KFileItem>
+#include <KService>
 #include <kitemviews/kitemmodelbase.h>
 
 #include <dolphinprivate_export.h>
@@ -282,6 +283,9 @@ private:
     QSet<QByteArray> m_roles;
     QSet<QByteArray> m_resolvableRoles;
     QStringList m_enabledPlugins;
+    // The enabled ThumbCreator services, used to find the items for a
+    // KFileItemBatchPreviewJob. Determined when the first job is started.
+    KService::List m_batchPreviewPlugins;
 
     // Items for which the sort role still has to be determined.
     QSet<KFileItem> m_pendingSortRoleItems;
@@ -206,10 +206,9 @@ qreal KStandardItemListWidgetInformant::preferredRoleColumnWidth(const QByteArra
                                                                  int index,
                                                                  const KItemListView* view) const
 {
-    const QHash<QByteArray, QVariant> values = view->model()->data(index);
     const KItemListStyleOption& option = view->styleOption();
 
-    const QString text = roleText(role, values);
+    const QString text = itemRoleText(role, index, view);
     qreal width = KStandardItemListWidget::columnPadding(option);
 
     const QFontMetrics& normalFontMetrics = option.fontMetrics;
@@ -233,6 +232,11 @@ QString KStandardItemListWidgetInformant::itemText(int index, const KItemListVie
     return view->model()->data(index).value("text").toString();
 }
 
+QString KStandardItemListWidgetInformant::itemRoleText(const QByteArray& role, int index, const KItemListView* view) const
+{
+    return roleText(role, view->model()->data(index));
+}
+
 bool KStandardItemListWidgetInformant::itemIsLink(int index, const KItemListView* view) const
 {
     return false;
@@ -332,9 +336,8 @@ void KStandardItemListWidgetInformant::calculateCompactLayoutItemSizeHints(QVect
         if (showOnlyTextRole) {
             maximumRequiredWidth = fontMetrics.width(itemText(index, view));
         } else {
-            const QHash<QByteArray, QVariant>& values = view->model()->data(index);
             foreach (const QByteArray& role, visibleRoles) {
-                const QString& text = roleText(role, values);
+                const QString& text = itemRoleText(role, index, view);
                 const qreal requiredWidth = fontMetrics.width(text);
                 maximumRequiredWidth = qMax(maximumRequiredWidth, requiredWidth);
             }
@@ -99,6 +99,15 @@ protected:
     virtual QString roleText(const QByteArray& role,
                              const QHash<QByteArray, QVariant>& values) const;
 
+    /**
+     * @return String representation of the role \a role for the item with the
+     *         index \a index. The default implementation returns
+     *         roleText(role, view->model()->data(index)). Like itemText(), a
+     *         derived class can reimplement this function to prevent the
+     *         construction of the QHash returned by KItemModelBase::data(int).
+     */
+    virtual QString itemRoleText(const QByteArray& role, int index, const KItemListView* view) const;
+
     /**
     * @return A font based on baseFont which is customized for symlinks.
     */
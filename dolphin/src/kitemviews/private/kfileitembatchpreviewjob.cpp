@@ -0,0 +1,251 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include "kfileitembatchpreviewjob.h"
+
+#include <KConfigGroup>
+#include <KDebug>
+#include <KGlobal>
+#include <KIO/Job>
+#include <KServiceTypeTrader>
+#include <KStandardDirs>
+#include <KTemporaryFile>
+#include <kde_file.h>
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QImageWriter>
+#include <QTimer>
+
+namespace {
+    // NOTE: keep in sync with kde-workspace/kioslave/thumbnail/thumbnail.cpp
+    const QByteArray ThumbFormat = QImageWriter::defaultImageFormat();
+    const QString ThumbExt = QLatin1String(".") + ThumbFormat;
+    const int DefaultIconAlpha = 125;
+}
+
+KFileItemBatchPreviewJob::KFileItemBatchPreviewJob(const KFileItemList& items, const QSize& size,
+                                                   const KService::List& plugins, QObject* parent) :
+    KJob(parent),
+    m_items(items),
+    m_plugins(),
+    m_size(size),
+    m_cacheDir(),
+    m_batch(),
+    m_finished(items.count(), false),
+    m_transferJob(0)
+{
+    m_plugins.reserve(items.count());
+    foreach (const KFileItem& item, items) {
+        m_plugins.append(batchPlugin(item, plugins));
+        Q_ASSERT(m_plugins.last());
+    }
+
+    // The thumbnail slave caches thumbnails of 128 x 128 and 256 x 256 pixels
+    if (size == QSize(128, 128)) {
+        m_cacheDir = QDir::homePath() + "/.thumbnails/normal/";
+    } else if (size == QSize(256, 256)) {
+        m_cacheDir = QDir::homePath() + "/.thumbnails/large/";
+    }
+    if (!m_cacheDir.isEmpty()) {
+        KStandardDirs::makeDir(m_cacheDir, 0700);
+    }
+}
+
+KFileItemBatchPreviewJob::~KFileItemBatchPreviewJob()
+{
+}
+
+void KFileItemBatchPreviewJob::start()
+{
+    QTimer::singleShot(0, this, SLOT(slotStart()));
+}
+
+KService::List KFileItemBatchPreviewJob::enabledPlugins(const QStringList& enabledPlugins)
+{
+    KService::List result;
+    const KService::List plugins = KServiceTypeTrader::self()->query(QLatin1String("ThumbCreator"));
+    foreach (const KService::Ptr& plugin, plugins) {
+        if (enabledPlugins.contains(plugin->desktopEntryName())) {
+            result.append(plugin);
+        }
+    }
+    return result;
+}
+
+KService::Ptr KFileItemBatchPreviewJob::batchPlugin(const KFileItem& item, const KService::List& plugins)
+{
+    if (!item.isLocalFile() || item.isDir()) {
+        return KService::Ptr();
+    }
+
+    // Like KIO::PreviewJob, prefer plugins for the exact mime type over
+    // plugins for a group of mime types like "image/*"
+    const QString mimeType = item.mimetype();
+    KService::Ptr plugin;
+    KService::Ptr groupPlugin;
+    foreach (const KService::Ptr& service, plugins) {
+        foreach (const QString& serviceType, service->serviceTypes()) {
+            if (serviceType == mimeType) {
+                plugin = service;
+                break;
+            }
+            if (!groupPlugin && serviceType.endsWith('*')
+                && mimeType.startsWith(serviceType.left(serviceType.length() - 1))) {
+                groupPlugin = service;
+            }
+        }
+        if (plugin) {
+            break;
+        }
+    }
+    if (!plugin) {
+        plugin = groupPlugin;
+    }
+
+    if (plugin && plugin->property("ThreadSafe", QVariant::Bool).toBool()) {
+        return plugin;
+    }
+    return KService::Ptr();
+}
+
+bool KFileItemBatchPreviewJob::doKill()
+{
+    if (m_transferJob) {
+        m_transferJob->kill();
+        m_transferJob = 0;
+    }
+    return true;
+}
+
+void KFileItemBatchPreviewJob::slotStart()
+{
+    for (int i = 0; i < m_items.count(); ++i) {
+        const QString cacheFile = cacheFilePath(m_items.at(i));
+        QImage thumbnail;
+        if (!cacheFile.isEmpty() && thumbnail.load(cacheFile)) {
+            m_finished[i] = true;
+            emit gotPreview(m_items.at(i), QPixmap::fromImage(thumbnail));
+        } else {
+            m_batch.append(i);
+        }
+    }
+
+    if (error()) {
+        // The job has been killed by a receiver of gotPreview()
+        return;
+    }
+    if (m_batch.isEmpty()) {
+        emitResult();
+        return;
+    }
+
+    QByteArray batch;
+    QDataStream stream(&batch, QIODevice::WriteOnly);
+    stream << qint32(m_batch.count());
+    foreach (int index, m_batch) {
+        const KFileItem& item = m_items.at(index);
+        stream << item.localPath() << item.mimetype() << m_plugins.at(index)->library();
+    }
+
+    const KConfigGroup globalConfig(KGlobal::config(), "PreviewSettings");
+    m_transferJob = KIO::get(KUrl("thumbnail:/"), KIO::NoReload, KIO::HideProgressInfo);
+    m_transferJob->addMetaData("width", QString::number(m_size.width()));
+    m_transferJob->addMetaData("height", QString::number(m_size.height()));
+    m_transferJob->addMetaData("iconAlpha", QString::number(globalConfig.readEntry("IconAlpha", DefaultIconAlpha)));
+    m_transferJob->addMetaData("batch", QString::fromLatin1(batch.toBase64()));
+    connect(m_transferJob, SIGNAL(data(KIO::Job*,QByteArray)),
+            this, SLOT(slotData(KIO::Job*,QByteArray)));
+    connect(m_transferJob, SIGNAL(result(KJob*)),
+            this, SLOT(slotResult(KJob*)));
+}
+
+void KFileItemBatchPreviewJob::slotData(KIO::Job* job, const QByteArray& data)
+{
+    Q_UNUSED(job);
+    if (data.isEmpty()) {
+        return;
+    }
+
+    // Each thumbnail is sent as the index of the file in the batch,
+    // followed by the image, which is null if it could not be created
+    QDataStream stream(data);
+    qint32 batchIndex = -1;
+    QImage thumbnail;
+    stream >> batchIndex >> thumbnail;
+    if (stream.status() != QDataStream::Ok || batchIndex < 0 || batchIndex >= m_batch.count()) {
+        kWarning() << "Invalid thumbnail received";
+        return;
+    }
+
+    const int index = m_batch.at(batchIndex);
+    if (m_finished.at(index)) {
+        return;
+    }
+    m_finished[index] = true;
+
+    const KFileItem& item = m_items.at(index);
+    if (thumbnail.isNull()) {
+        emit failed(item);
+        return;
+    }
+
+    const QString cacheFile = cacheFilePath(item);
+    if (!cacheFile.isEmpty() && m_plugins.at(index)->property("CacheThumbnail", QVariant::Bool).toBool()) {
+        const QString tempFileName = KTemporaryFile::filePath(QString::fromLatin1("XXXXXXXXXX%1").arg(ThumbExt));
+        if (thumbnail.save(tempFileName, ThumbFormat)) {
+            KDE::rename(tempFileName, cacheFile);
+        }
+    }
+
+    emit gotPreview(item, QPixmap::fromImage(thumbnail));
+}
+
+void KFileItemBatchPreviewJob::slotResult(KJob* job)
+{
+    m_transferJob = 0;
+    if (job->error()) {
+        kDebug() << "Creating the previews failed:" << job->errorString();
+    }
+
+    for (int i = 0; i < m_items.count(); ++i) {
+        if (!m_finished.at(i)) {
+            m_finished[i] = true;
+            emit failed(m_items.at(i));
+        }
+    }
+    emitResult();
+}
+
+QString KFileItemBatchPreviewJob::cacheFilePath(const KFileItem& item) const
+{
+    if (m_cacheDir.isEmpty()) {
+        return QString();
+    }
+    // NOTE: make sure the name matches the one used by ThumbnailProtocol::createSubThumbnail()
+    // in kde-workspace/kioslave/thumbnail/thumbnail.cpp and by kdelibs/kio/kio/previewjob.cpp
+    const QString path = item.localPath();
+    if (path.startsWith(QDir::homePath() + "/.thumbnails/")) {
+        return QString();
+    }
+    const QString modTime = QString::number(item.time(KFileItem::ModificationTime).toTime_t());
+    return m_cacheDir + QFile::encodeName(path).toHex() + modTime + ThumbExt;
+}
+
+#include "moc_kfileitembatchpreviewjob.cpp"
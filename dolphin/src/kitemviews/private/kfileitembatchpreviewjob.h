@@ -0,0 +1,106 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#ifndef KFILEITEMBATCHPREVIEWJOB_H
+#define KFILEITEMBATCHPREVIEWJOB_H
+
+#include <KFileItem>
+#include <KJob>
+#include <KService>
+
+#include <QPixmap>
+#include <QSize>
+#include <QVector>
+
+namespace KIO {
+    class Job;
+    class TransferJob;
+}
+
+/**
+ * @brief Creates the previews of local files with a single thumbnail slave job.
+ *
+ * KIO::PreviewJob starts one job of the thumbnail slave per file. This job
+ * passes all files to the slave at once with the "batch" metadata entry, so
+ * the slave can create the thumbnails with several threads. This is only
+ * done for ThumbCreator plugins which set the ThreadSafe property, see
+ * batchPlugin(). All other files must be handled by KIO::PreviewJob.
+ *
+ * Like KIO::PreviewJob, the thumbnails are read from and stored in the
+ * thumbnail cache of the thumbnail slave if the plugin allows it.
+ */
+class KFileItemBatchPreviewJob : public KJob
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param items    Local files, batchPlugin() must return a plugin for each of them.
+     * @param size     Maximum size of the previews.
+     * @param plugins  ThumbCreator services as returned by enabledPlugins().
+     */
+    KFileItemBatchPreviewJob(const KFileItemList& items, const QSize& size,
+                             const KService::List& plugins, QObject* parent = 0);
+    virtual ~KFileItemBatchPreviewJob();
+
+    virtual void start();
+
+    /**
+     * @return The ThumbCreator services with the desktop entry names \a enabledPlugins.
+     */
+    static KService::List enabledPlugins(const QStringList& enabledPlugins);
+
+    /**
+     * @return The plugin out of \a plugins which creates the preview of \a item,
+     *         if it may be used for a batch. A null pointer is returned if the
+     *         preview must be created by KIO::PreviewJob.
+     */
+    static KService::Ptr batchPlugin(const KFileItem& item, const KService::List& plugins);
+
+signals:
+    void gotPreview(const KFileItem& item, const QPixmap& preview);
+    void failed(const KFileItem& item);
+
+protected:
+    virtual bool doKill();
+
+private slots:
+    void slotStart();
+    void slotData(KIO::Job* job, const QByteArray& data);
+    void slotResult(KJob* job);
+
+private:
+    /**
+     * @return The file of the thumbnail cache for \a item, or an empty
+     *         string if previews of the requested size are not cached.
+     */
+    QString cacheFilePath(const KFileItem& item) const;
+
+    KFileItemList m_items;
+    // The plugin of each item of m_items
+    KService::List m_plugins;
+    QSize m_size;
+    QString m_cacheDir;
+
+    // Indexes in m_items of the files which have been passed to the slave,
+    // in the order of the batch
+    QVector<int> m_batch;
+    QVector<bool> m_finished;
+    KIO::TransferJob* m_transferJob;
+};
+
+#endif
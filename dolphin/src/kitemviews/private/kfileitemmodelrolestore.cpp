@@ -0,0 +1,479 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include "kfileitemmodelrolestore.h"
+
+namespace {
+    // Value of m_dates for invalid date-times
+    const qint64 InvalidDate = Q_INT64_C(-9223372036854775807) - 1;
+
+    // Approximate size of the heap allocated header of a QString, QList or
+    // QHash node, including the overhead of the allocator
+    const int AllocationOverhead = 4 * sizeof(void*);
+
+    int stringMemoryUsage(const QString& string)
+    {
+        if (string.isNull()) {
+            return 0;
+        }
+        return AllocationOverhead + string.capacity() * sizeof(QChar);
+    }
+}
+
+template <typename T>
+void KFileItemModelRoleStore::reserveColumn(QVector<T>& column, int row)
+{
+    if (row >= column.count()) {
+        column.resize(row + 1);
+    }
+}
+
+KFileItemModelRoleStore::KFileItemModelRoleStore() :
+    m_rowCount(0),
+    m_freeRows(),
+    m_flags(),
+    m_sizes(),
+    m_dates(),
+    m_iconOverlays(),
+    m_otherValues(),
+    m_sharedStrings()
+{
+}
+
+KFileItemModelRoleStore::~KFileItemModelRoleStore()
+{
+}
+
+int KFileItemModelRoleStore::createRow()
+{
+    if (!m_freeRows.isEmpty()) {
+        const int row = m_freeRows.last();
+        m_freeRows.pop_back();
+        return row;
+    }
+
+    m_flags.append(0);
+    return m_rowCount++;
+}
+
+void KFileItemModelRoleStore::releaseRow(int row)
+{
+    clearRow(row);
+    m_freeRows.append(row);
+}
+
+void KFileItemModelRoleStore::clear()
+{
+    m_rowCount = 0;
+    m_freeRows.clear();
+    m_flags.clear();
+    for (int i = 0; i < ColumnCount; ++i) {
+        m_strings[i].clear();
+    }
+    m_sizes.clear();
+    m_dates.clear();
+    m_iconOverlays.clear();
+    m_otherValues.clear();
+    m_sharedStrings.clear();
+}
+
+void KFileItemModelRoleStore::clearRow(int row)
+{
+    const quint32 flags = m_flags.at(row);
+    for (int i = 0; i < ColumnCount; ++i) {
+        const Column column = static_cast<Column>(i);
+        if (flags & valueBit(column)) {
+            removeColumnValue(row, column);
+        }
+    }
+
+    m_flags[row] = 0;
+    m_otherValues.remove(row);
+}
+
+void KFileItemModelRoleStore::setValues(int row, const QHash<QByteArray, QVariant>& values)
+{
+    clearRow(row);
+
+    QHashIterator<QByteArray, QVariant> it(values);
+    while (it.hasNext()) {
+        it.next();
+        setValue(row, it.key(), it.value());
+    }
+
+    m_flags[row] |= InitializedFlag;
+}
+
+QHash<QByteArray, QVariant> KFileItemModelRoleStore::values(int row) const
+{
+    QHash<QByteArray, QVariant> result = m_otherValues.value(row);
+
+    const quint32 flags = m_flags.at(row);
+    for (int i = 0; i < ColumnCount; ++i) {
+        const Column column = static_cast<Column>(i);
+        if (flags & valueBit(column)) {
+            result.insert(roleForColumn(column), columnValue(row, column));
+        }
+    }
+
+    return result;
+}
+
+void KFileItemModelRoleStore::setValue(int row, const QByteArray& role, const QVariant& value)
+{
+    const Column column = columnForRole(role);
+    if (column != NoColumn) {
+        if (setColumnValue(row, column, value)) {
+            QHash<int, QHash<QByteArray, QVariant> >::iterator it = m_otherValues.find(row);
+            if (it != m_otherValues.end()) {
+                it->remove(role);
+                if (it->isEmpty()) {
+                    m_otherValues.erase(it);
+                }
+            }
+            return;
+        }
+
+        // The type of the value does not match with the column
+        if (hasValue(row, column)) {
+            removeColumnValue(row, column);
+        }
+    }
+
+    m_otherValues[row].insert(role, value);
+}
+
+QVariant KFileItemModelRoleStore::value(int row, const QByteArray& role) const
+{
+    const Column column = columnForRole(role);
+    if (column != NoColumn && hasValue(row, column)) {
+        return columnValue(row, column);
+    }
+
+    const QHash<int, QHash<QByteArray, QVariant> >::const_iterator it = m_otherValues.constFind(row);
+    if (it != m_otherValues.constEnd()) {
+        return it->value(role);
+    }
+    return QVariant();
+}
+
+bool KFileItemModelRoleStore::contains(int row, const QByteArray& role) const
+{
+    const Column column = columnForRole(role);
+    if (column != NoColumn && hasValue(row, column)) {
+        return true;
+    }
+
+    const QHash<int, QHash<QByteArray, QVariant> >::const_iterator it = m_otherValues.constFind(row);
+    return it != m_otherValues.constEnd() && it->contains(role);
+}
+
+const QString& KFileItemModelRoleStore::stringValue(int row, Column column) const
+{
+    static const QString emptyString;
+    if (!isStringColumn(column) || !hasValue(row, column)) {
+        return emptyString;
+    }
+    return m_strings[column].at(row);
+}
+
+bool KFileItemModelRoleStore::boolValue(int row, Column column) const
+{
+    return isBoolColumn(column) && hasValue(row, column) && (m_flags.at(row) & boolBit(column));
+}
+
+quint64 KFileItemModelRoleStore::sizeValue(int row) const
+{
+    return hasValue(row, SizeColumn) ? m_sizes.at(row) : 0;
+}
+
+bool KFileItemModelRoleStore::sizeIsItemCount(int row) const
+{
+    return m_flags.at(row) & SizeIsItemCountFlag;
+}
+
+QDateTime KFileItemModelRoleStore::dateValue(int row) const
+{
+    if (!hasValue(row, DateColumn)) {
+        return QDateTime();
+    }
+
+    const qint64 msecs = m_dates.at(row);
+    if (msecs == InvalidDate) {
+        return QDateTime();
+    }
+
+    const QDateTime dateTime = QDateTime::fromMSecsSinceEpoch(msecs);
+    return (m_flags.at(row) & DateIsUtcFlag) ? dateTime.toUTC() : dateTime;
+}
+
+KFileItemModelRoleStore::Column KFileItemModelRoleStore::columnForRole(const QByteArray& role)
+{
+    static QHash<QByteArray, Column> columns;
+    if (columns.isEmpty()) {
+        for (int i = 0; i < ColumnCount; ++i) {
+            const Column column = static_cast<Column>(i);
+            columns.insert(roleForColumn(column), column);
+        }
+    }
+
+    return columns.value(role, NoColumn);
+}
+
+int KFileItemModelRoleStore::memoryUsage() const
+{
+    int usage = sizeof(KFileItemModelRoleStore);
+    usage += m_freeRows.capacity() * sizeof(int);
+    usage += m_flags.capacity() * sizeof(quint32);
+    usage += m_sizes.capacity() * sizeof(quint64);
+    usage += m_dates.capacity() * sizeof(qint64);
+
+    for (int i = 0; i < ColumnCount; ++i) {
+        const Column column = static_cast<Column>(i);
+        usage += m_strings[i].capacity() * sizeof(QString);
+        if (isSharedColumn(column)) {
+            // Counted once below
+            continue;
+        }
+        foreach (const QString& string, m_strings[i]) {
+            usage += stringMemoryUsage(string);
+        }
+    }
+
+    QHash<QString, int>::const_iterator sharedIt = m_sharedStrings.constBegin();
+    for (; sharedIt != m_sharedStrings.constEnd(); ++sharedIt) {
+        usage += AllocationOverhead + sizeof(QString) + sizeof(int) + stringMemoryUsage(sharedIt.key());
+    }
+
+    usage += m_iconOverlays.capacity() * sizeof(QStringList);
+    foreach (const QStringList& overlays, m_iconOverlays) {
+        if (!overlays.isEmpty()) {
+            usage += AllocationOverhead + overlays.count() * sizeof(void*);
+            foreach (const QString& overlay, overlays) {
+                usage += stringMemoryUsage(overlay);
+            }
+        }
+    }
+
+    // The payload of the values in the sparse hash is unknown,
+    // only the hash nodes and the keys are counted
+    QHash<int, QHash<QByteArray, QVariant> >::const_iterator otherIt = m_otherValues.constBegin();
+    for (; otherIt != m_otherValues.constEnd(); ++otherIt) {
+        usage += AllocationOverhead + sizeof(int) + sizeof(QHash<QByteArray, QVariant>);
+        QHash<QByteArray, QVariant>::const_iterator valueIt = otherIt->constBegin();
+        for (; valueIt != otherIt->constEnd(); ++valueIt) {
+            usage += AllocationOverhead + sizeof(QByteArray) + sizeof(QVariant) + valueIt.key().size();
+        }
+    }
+
+    return usage;
+}
+
+QByteArray KFileItemModelRoleStore::roleForColumn(Column column)
+{
+    switch (column) {
+    case TextColumn:         return "text";
+    case SizeColumn:         return "size";
+    case DateColumn:         return "date";
+    case PermissionsColumn:  return "permissions";
+    case OwnerColumn:        return "owner";
+    case GroupColumn:        return "group";
+    case TypeColumn:         return "type";
+    case DestinationColumn:  return "destination";
+    case PathColumn:         return "path";
+    case IsDirColumn:        return "isDir";
+    case IsLinkColumn:       return "isLink";
+    case IconNameColumn:     return "iconName";
+    case IconOverlaysColumn: return "iconOverlays";
+    default:
+        Q_ASSERT(false);
+        break;
+    }
+    return QByteArray();
+}
+
+bool KFileItemModelRoleStore::isStringColumn(Column column)
+{
+    switch (column) {
+    case TextColumn:
+    case PermissionsColumn:
+    case OwnerColumn:
+    case GroupColumn:
+    case TypeColumn:
+    case DestinationColumn:
+    case PathColumn:
+    case IconNameColumn:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool KFileItemModelRoleStore::isSharedColumn(Column column)
+{
+    // Most items share a small number of different values
+    switch (column) {
+    case PermissionsColumn:
+    case OwnerColumn:
+    case GroupColumn:
+    case TypeColumn:
+    case IconNameColumn:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool KFileItemModelRoleStore::isBoolColumn(Column column)
+{
+    return column == IsDirColumn || column == IsLinkColumn;
+}
+
+bool KFileItemModelRoleStore::setColumnValue(int row, Column column, const QVariant& value)
+{
+    quint32& flags = m_flags[row];
+
+    if (isStringColumn(column)) {
+        if (value.type() != QVariant::String) {
+            return false;
+        }
+
+        reserveColumn(m_strings[column], row);
+        if (isSharedColumn(column)) {
+            const QString string = sharedString(value.toString());
+            if (flags & valueBit(column)) {
+                releaseSharedString(m_strings[column].at(row));
+            }
+            m_strings[column][row] = string;
+        } else {
+            m_strings[column][row] = value.toString();
+        }
+    } else if (isBoolColumn(column)) {
+        if (value.type() != QVariant::Bool) {
+            return false;
+        }
+
+        if (value.toBool()) {
+            flags |= boolBit(column);
+        } else {
+            flags &= ~boolBit(column);
+        }
+    } else if (column == SizeColumn) {
+        // Files use KIO::filesize_t, directories an int for the number of items
+        if (value.type() == QVariant::ULongLong) {
+            flags &= ~SizeIsItemCountFlag;
+        } else if (value.type() == QVariant::Int) {
+            flags |= SizeIsItemCountFlag;
+        } else {
+            return false;
+        }
+
+        reserveColumn(m_sizes, row);
+        m_sizes[row] = (flags & SizeIsItemCountFlag) ? quint64(value.toInt()) : value.toULongLong();
+    } else if (column == DateColumn) {
+        if (value.type() != QVariant::DateTime) {
+            return false;
+        }
+
+        const QDateTime dateTime = value.toDateTime();
+        if (dateTime.isValid() && dateTime.timeSpec() == Qt::OffsetFromUTC) {
+            // Not representable by the column
+            return false;
+        }
+
+        if (dateTime.isValid() && dateTime.timeSpec() == Qt::UTC) {
+            flags |= DateIsUtcFlag;
+        } else {
+            flags &= ~DateIsUtcFlag;
+        }
+
+        reserveColumn(m_dates, row);
+        m_dates[row] = dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : InvalidDate;
+    } else if (column == IconOverlaysColumn) {
+        if (value.type() != QVariant::StringList) {
+            return false;
+        }
+
+        reserveColumn(m_iconOverlays, row);
+        m_iconOverlays[row] = value.toStringList();
+    } else {
+        return false;
+    }
+
+    flags |= valueBit(column);
+    return true;
+}
+
+QVariant KFileItemModelRoleStore::columnValue(int row, Column column) const
+{
+    if (isStringColumn(column)) {
+        return m_strings[column].at(row);
+    } else if (isBoolColumn(column)) {
+        return boolValue(row, column);
+    }
+
+    switch (column) {
+    case SizeColumn:
+        if (sizeIsItemCount(row)) {
+            return int(m_sizes.at(row));
+        }
+        return QVariant(static_cast<qulonglong>(m_sizes.at(row)));
+    case DateColumn:
+        return dateValue(row);
+    case IconOverlaysColumn:
+        return m_iconOverlays.at(row);
+    default:
+        break;
+    }
+
+    return QVariant();
+}
+
+void KFileItemModelRoleStore::removeColumnValue(int row, Column column)
+{
+    // Release the memory of implicitly shared values
+    if (isStringColumn(column)) {
+        if (isSharedColumn(column)) {
+            releaseSharedString(m_strings[column].at(row));
+        }
+        m_strings[column][row] = QString();
+    } else if (column == IconOverlaysColumn) {
+        m_iconOverlays[row] = QStringList();
+    }
+
+    m_flags[row] &= ~(valueBit(column) | boolBit(column));
+}
+
+QString KFileItemModelRoleStore::sharedString(const QString& string)
+{
+    QHash<QString, int>::iterator it = m_sharedStrings.find(string);
+    if (it != m_sharedStrings.end()) {
+        ++it.value();
+        return it.key();
+    }
+
+    m_sharedStrings.insert(string, 1);
+    return string;
+}
+
+void KFileItemModelRoleStore::releaseSharedString(const QString& string)
+{
+    QHash<QString, int>::iterator it = m_sharedStrings.find(string);
+    if (it != m_sharedStrings.end() && --it.value() <= 0) {
+        m_sharedStrings.erase(it);
+    }
+}
@@ -0,0 +1,240 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#ifndef KFILEITEMMODELROLESTORE_H
+#define KFILEITEMMODELROLESTORE_H
+
+#include <dolphinprivate_export.h>
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+/**
+ * @brief Column-oriented storage for the role values of KFileItemModel.
+ *
+ * Each item gets a row in the store. The values of the roles that are
+ * provided by KFileItemModel itself are stored in one typed array per
+ * role (a column), which is only allocated if the role is used at all.
+ * Values of other roles (e.g. "iconPixmap" or values that don't match
+ * the type of the column) are kept in a sparse hash.
+ *
+ * Compared to a QHash<QByteArray, QVariant> for each item this saves
+ * the hash nodes and the heap allocated QVariant payloads, and allows
+ * to read single values without copying all values of an item.
+ */
+class DOLPHINPRIVATE_EXPORT KFileItemModelRoleStore
+{
+public:
+    enum Column {
+        NoColumn = -1,
+        TextColumn,
+        SizeColumn,
+        DateColumn,
+        PermissionsColumn,
+        OwnerColumn,
+        GroupColumn,
+        TypeColumn,
+        DestinationColumn,
+        PathColumn,
+        IsDirColumn,
+        IsLinkColumn,
+        IconNameColumn,
+        IconOverlaysColumn,
+        // Mandatory last entry:
+        ColumnCount
+    };
+
+    KFileItemModelRoleStore();
+    ~KFileItemModelRoleStore();
+
+    /**
+     * @return Index of a new empty row. Rows that have been
+     *         released by releaseRow() are reused.
+     */
+    int createRow();
+
+    /**
+     * Removes all values of the row \a row and marks it as unused.
+     */
+    void releaseRow(int row);
+
+    /**
+     * Releases all rows.
+     */
+    void clear();
+
+    /**
+     * @return True if values have been assigned to the row \a row
+     *         by setValues(). Note that a row might be initialized
+     *         even if it contains no values.
+     */
+    bool isInitialized(int row) const;
+
+    /**
+     * Removes all values of the row \a row. Afterwards isInitialized()
+     * returns false for the row.
+     */
+    void clearRow(int row);
+
+    /**
+     * Replaces all values of the row \a row by \a values and marks
+     * the row as initialized.
+     */
+    void setValues(int row, const QHash<QByteArray, QVariant>& values);
+
+    /**
+     * @return All values of the row \a row. Note that the hash is created
+     *         by each call. Use value() or the typed accessors if only
+     *         some roles are required.
+     */
+    QHash<QByteArray, QVariant> values(int row) const;
+
+    void setValue(int row, const QByteArray& role, const QVariant& value);
+    QVariant value(int row, const QByteArray& role) const;
+    bool contains(int row, const QByteArray& role) const;
+
+    /**
+     * @return True if the column \a column of the row \a row has a value.
+     *         Values that are stored in the sparse hash are not considered.
+     */
+    bool hasValue(int row, Column column) const;
+
+    /**
+     * @return Reference to the string stored in the column \a column of
+     *         the row \a row, or to an empty string if the column has no
+     *         value or is no string column. No string is copied.
+     */
+    const QString& stringValue(int row, Column column) const;
+
+    bool boolValue(int row, Column column) const;
+
+    /**
+     * @return Value of the "size" role. For directories this is the number of
+     *         items, see sizeIsItemCount(), and the file size otherwise.
+     */
+    quint64 sizeValue(int row) const;
+    bool sizeIsItemCount(int row) const;
+
+    QDateTime dateValue(int row) const;
+
+    /**
+     * @return Column for the role \a role or NoColumn if the values
+     *         of the role are stored in the sparse hash.
+     */
+    static Column columnForRole(const QByteArray& role);
+
+    /**
+     * @return True if the values of the column \a column can be
+     *         accessed by stringValue().
+     */
+    static bool isStringColumn(Column column);
+
+    /**
+     * @return Approximate number of bytes that are used by the store,
+     *         including the string data. Shared strings are counted once.
+     *         Of the values in the sparse hash only the hash nodes are
+     *         counted. Useful for benchmarks.
+     */
+    int memoryUsage() const;
+
+private:
+    enum Flag {
+        InitializedFlag = 0x80000000,
+        SizeIsItemCountFlag = 0x40000000,
+        DateIsUtcFlag = 0x20000000
+    };
+
+    static QByteArray roleForColumn(Column column);
+    static bool isBoolColumn(Column column);
+
+    /**
+     * @return True if the strings of the column \a column are
+     *         shared by sharedString().
+     */
+    static bool isSharedColumn(Column column);
+    static quint32 valueBit(Column column);
+    static quint32 boolBit(Column column);
+
+    /**
+     * Stores \a value in the column \a column. Returns false if the type of
+     * the value does not match with the column.
+     */
+    bool setColumnValue(int row, Column column, const QVariant& value);
+    QVariant columnValue(int row, Column column) const;
+    void removeColumnValue(int row, Column column);
+
+    /**
+     * @return A copy of \a string that shares its data with equal strings
+     *         of other rows. Used for columns with few distinct values.
+     *         Each call must be balanced by releaseSharedString().
+     */
+    QString sharedString(const QString& string);
+
+    /**
+     * Drops the reference to \a string taken by sharedString(). The string
+     * is removed from m_sharedStrings if no row uses it anymore.
+     */
+    void releaseSharedString(const QString& string);
+
+    template <typename T>
+    static void reserveColumn(QVector<T>& column, int row);
+
+private:
+    int m_rowCount;
+    QVector<int> m_freeRows;
+
+    // Bits 0 to ColumnCount - 1: Column has a value. Bits 16 to 16 + ColumnCount - 1:
+    // value of boolean columns. The highest bits are used for the flags of the row.
+    QVector<quint32> m_flags;
+
+    QVector<QString> m_strings[ColumnCount];
+    QVector<quint64> m_sizes;
+    QVector<qint64> m_dates;
+    QVector<QStringList> m_iconOverlays;
+
+    QHash<int, QHash<QByteArray, QVariant> > m_otherValues;
+    // Strings of the shared columns and the number of values using them
+    QHash<QString, int> m_sharedStrings;
+
+    friend class KFileItemModelRoleStoreTest; // For unit testing
+};
+
+inline bool KFileItemModelRoleStore::isInitialized(int row) const
+{
+    return m_flags.at(row) & InitializedFlag;
+}
+
+inline bool KFileItemModelRoleStore::hasValue(int row, Column column) const
+{
+    return m_flags.at(row) & valueBit(column);
+}
+
+inline quint32 KFileItemModelRoleStore::valueBit(Column column)
+{
+    return 1u << column;
+}
+
+inline quint32 KFileItemModelRoleStore::boolBit(Column column)
+{
+    return 1u << (16 + column);
+}
+
+#endif
@@ -22,8 +22,16 @@
 #ifndef KFILEITEMMODELSORTALGORITHM_H
 #define KFILEITEMMODELSORTALGORITHM_H
 
+#include <QThread>
+
 #include <algorithm>
 
+template <typename RandomAccessIterator, typename LessThan>
+static void merge(RandomAccessIterator begin,
+                  RandomAccessIterator pivot,
+                  RandomAccessIterator end,
+                  LessThan lessThan);
+
 /**
  * Sorts the items using the merge sort algorithm is used to assure a
  * worst-case of O(n * log(n)) and to keep the number of comparisons low.
@@ -51,6 +59,84 @@ static void mergeSort(RandomAccessIterator begin,
     merge(begin, middle, end, lessThan);
 }
 
+template <typename RandomAccessIterator, typename LessThan>
+static void parallelMergeSort(RandomAccessIterator begin,
+                              RandomAccessIterator end,
+                              LessThan lessThan,
+                              int numberOfThreads,
+                              int parallelMergeSortingThreshold = 100);
+
+/**
+ * Helper thread for parallelMergeSort(): Sorts the items between
+ * \a begin and \a end with the given number of threads.
+ */
+template <typename RandomAccessIterator, typename LessThan>
+class KFileItemModelSortThread : public QThread
+{
+public:
+    KFileItemModelSortThread(RandomAccessIterator begin,
+                             RandomAccessIterator end,
+                             LessThan lessThan,
+                             int numberOfThreads,
+                             int parallelMergeSortingThreshold) :
+        QThread(),
+        m_begin(begin),
+        m_end(end),
+        m_lessThan(lessThan),
+        m_numberOfThreads(numberOfThreads),
+        m_parallelMergeSortingThreshold(parallelMergeSortingThreshold)
+    {
+    }
+
+protected:
+    virtual void run()
+    {
+        parallelMergeSort(m_begin, m_end, m_lessThan, m_numberOfThreads, m_parallelMergeSortingThreshold);
+    }
+
+private:
+    const RandomAccessIterator m_begin;
+    const RandomAccessIterator m_end;
+    const LessThan m_lessThan;
+    const int m_numberOfThreads;
+    const int m_parallelMergeSortingThreshold;
+};
+
+/**
+ * Uses up to \a numberOfThreads threads to sort the items between
+ * \a begin and \a end. Only item ranges longer than
+ * \a parallelMergeSortingThreshold are sorted by multiple threads.
+ *
+ * The comparison function \a lessThan must be reentrant.
+ */
+template <typename RandomAccessIterator, typename LessThan>
+static void parallelMergeSort(RandomAccessIterator begin,
+                              RandomAccessIterator end,
+                              LessThan lessThan,
+                              int numberOfThreads,
+                              int parallelMergeSortingThreshold)
+{
+    const int span = end - begin;
+
+    if (numberOfThreads > 1 && span > parallelMergeSortingThreshold) {
+        const int newNumberOfThreads = numberOfThreads / 2;
+        const RandomAccessIterator middle = begin + span / 2;
+
+        // Sort the first half in a separate thread and the second half
+        // (with the remaining threads) in the current one.
+        KFileItemModelSortThread<RandomAccessIterator, LessThan> thread(begin, middle, lessThan,
+                                                                        newNumberOfThreads,
+                                                                        parallelMergeSortingThreshold);
+        thread.start();
+        parallelMergeSort(middle, end, lessThan, numberOfThreads - newNumberOfThreads, parallelMergeSortingThreshold);
+        thread.wait();
+
+        merge(begin, middle, end, lessThan);
+    } else {
+        mergeSort(begin, end, lessThan);
+    }
+}
+
 /**
  * Merges the sorted item ranges between \a begin and \a pivot and
  * between \a pivot and \a end into a single sorted range between
@@ -61,9 +61,15 @@ public:
 private slots:
     void insertAndRemoveManyItems_data();
     void insertAndRemoveManyItems();
+    void sortManyItems_data();
+    void sortManyItems();
+    void roleMemoryUsage_data();
+    void roleMemoryUsage();
 
 private:
+    static int legacyMemoryUsage(const QHash<QByteArray, QVariant>& values);
     static KFileItemList createFileItemList(const QStringList& fileNames, const QString& urlPrefix = QLatin1String("file:///"));
+    static KFileItemList createRandomFileItemList(int count);
 };
 
 KFileItemModelBenchmark::KFileItemModelBenchmark()
@@ -207,6 +213,143 @@ void KFileItemModelBenchmark::insertAndRemoveManyItems()
     }
 }
 
+void KFileItemModelBenchmark::sortManyItems_data()
+{
+    QTest::addColumn<KFileItemList>("items");
+    QTest::addColumn<QByteArray>("sortRole");
+
+    QList<int> sizes;
+    sizes << 10000 << 100000 << 500000;
+
+    QList<QByteArray> sortRoles;
+    sortRoles << "text" << "size" << "date";
+
+    foreach (int n, sizes) {
+        const KFileItemList items = createRandomFileItemList(n);
+
+        foreach (const QByteArray& sortRole, sortRoles) {
+            const int bufferSize = 128;
+            char buffer[bufferSize];
+
+            snprintf(buffer, bufferSize, "%s--n=%i", sortRole.constData(), n);
+            QTest::newRow(buffer) << items << sortRole;
+        }
+    }
+}
+
+void KFileItemModelBenchmark::sortManyItems()
+{
+    QFETCH(KFileItemList, items);
+    QFETCH(QByteArray, sortRole);
+
+    KFileItemModel model;
+    model.m_naturalSorting = true;
+    model.setRoles(QSet<QByteArray>() << "text" << sortRole);
+    model.setSortRole(sortRole);
+
+    QBENCHMARK {
+        model.slotClear();
+        model.slotItemsAdded(items);
+        model.slotCompleted();
+        QCOMPARE(model.count(), items.count());
+    }
+
+    QVERIFY(model.isConsistent());
+
+    // Resorting in the opposite order must result in the reversed list.
+    QList<KFileItem> sortedItems;
+    for (int i = 0; i < model.count(); ++i) {
+        sortedItems << model.fileItem(i);
+    }
+
+    model.setSortOrder(Qt::DescendingOrder);
+    for (int i = 0; i < model.count(); ++i) {
+        QCOMPARE(model.fileItem(i), sortedItems.at(model.count() - 1 - i));
+    }
+}
+
+void KFileItemModelBenchmark::roleMemoryUsage_data()
+{
+    QTest::addColumn<KFileItemList>("items");
+    QTest::addColumn<bool>("legacy");
+
+    QList<int> sizes;
+    sizes << 10000 << 100000;
+
+    foreach (int n, sizes) {
+        const KFileItemList items = createRandomFileItemList(n);
+
+        const int bufferSize = 128;
+        char buffer[bufferSize];
+
+        snprintf(buffer, bufferSize, "role store--n=%i", n);
+        QTest::newRow(buffer) << items << false;
+
+        snprintf(buffer, bufferSize, "hash per item--n=%i", n);
+        QTest::newRow(buffer) << items << true;
+    }
+}
+
+void KFileItemModelBenchmark::roleMemoryUsage()
+{
+    // Compares the memory used for the role values by KFileItemModelRoleStore with
+    // the QHash<QByteArray, QVariant> per item that was used before. QTest has no
+    // metric for memory, the number of bytes is reported as events.
+    QFETCH(KFileItemList, items);
+    QFETCH(bool, legacy);
+
+    KFileItemModel model;
+    model.setRoles(QSet<QByteArray>() << "text" << "size" << "date" << "permissions"
+                                      << "owner" << "group" << "type" << "destination" << "path");
+    model.slotItemsAdded(items);
+    model.slotCompleted();
+    QCOMPARE(model.count(), items.count());
+
+    int usage = 0;
+    if (legacy) {
+        for (int i = 0; i < model.count(); ++i) {
+            usage += legacyMemoryUsage(model.data(i));
+        }
+    } else {
+        usage = model.m_roleStore.memoryUsage();
+    }
+
+    QTest::setBenchmarkResult(usage, QTest::Events);
+}
+
+int KFileItemModelBenchmark::legacyMemoryUsage(const QHash<QByteArray, QVariant>& values)
+{
+    // Same approximations as KFileItemModelRoleStore::memoryUsage(): the header of each heap
+    // allocation is counted as 4 pointers. The keys are shared by all items and not counted.
+    const int allocationOverhead = 4 * sizeof(void*);
+
+    int usage = sizeof(QHash<QByteArray, QVariant>) + allocationOverhead + values.capacity() * sizeof(void*);
+    QHashIterator<QByteArray, QVariant> it(values);
+    while (it.hasNext()) {
+        it.next();
+        usage += allocationOverhead + sizeof(QByteArray) + sizeof(QVariant);
+
+        const QVariant& value = it.value();
+        switch (value.type()) {
+        case QVariant::String:
+            usage += allocationOverhead + value.toString().capacity() * sizeof(QChar);
+            break;
+        case QVariant::StringList:
+            foreach (const QString& string, value.toStringList()) {
+                usage += allocationOverhead + sizeof(void*) + string.capacity() * sizeof(QChar);
+            }
+            break;
+        case QVariant::DateTime:
+            // QDateTimePrivate
+            usage += allocationOverhead + 2 * sizeof(qint64);
+            break;
+        default:
+            break;
+        }
+    }
+    return usage;
+}
+
 KFileItemList KFileItemModelBenchmark::createFileItemList(const QStringList& fileNames, const QString& prefix)
 {
     // Suppress 'file does not exist anymore' messages from KFileItemPrivate::init().
@@ -221,6 +364,32 @@ KFileItemList KFileItemModelBenchmark::createFileItemList(const QStringList& fil
     return result;
 }
 
+KFileItemList KFileItemModelBenchmark::createRandomFileItemList(int count)
+{
+    // Suppress 'file does not exist anymore' messages from KFileItemPrivate::init().
+    qInstallMsgHandler(myMessageOutput);
+
+    const KUrl dirUrl(QLatin1String("file:///"));
+    const long long now = QDateTime::currentDateTime().toTime_t();
+
+    KFileItemList result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        // Mix letters and numbers to give the natural sorting some work
+        const QString name = QString::fromLatin1("File%1-%2.txt").arg(KRandom::random() % count).arg(i);
+
+        KIO::UDSEntry entry;
+        entry.insert(KIO::UDSEntry::UDS_NAME, name);
+        entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, 0100000);    // S_IFREG might not be defined on non-Unix platforms.
+        entry.insert(KIO::UDSEntry::UDS_ACCESS, 0644);
+        entry.insert(KIO::UDSEntry::UDS_SIZE, KRandom::random() % (1 << 24));
+        entry.insert(KIO::UDSEntry::UDS_MODIFICATION_TIME, now - KRandom::random() % (365 * 24 * 3600));
+
+        result << KFileItem(entry, dirUrl, false, true);
+    }
+    return result;
+}
+
 QTEST_KDEMAIN(KFileItemModelBenchmark, NoGUI)
 
 #include "kfileitemmodelbenchmark.moc"
@@ -0,0 +1,163 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#include "kitemviews/private/kfileitemmodelrolestore.h"
+
+#include <kio/global.h>
+
+class KFileItemModelRoleStoreTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testSetValues();
+    void testTypedAccess();
+    void testTypeMismatch();
+    void testReleaseRow();
+    void testSharedStrings();
+};
+
+void KFileItemModelRoleStoreTest::testSetValues()
+{
+    KFileItemModelRoleStore store;
+    const int row = store.createRow();
+    QVERIFY(!store.isInitialized(row));
+
+    QHash<QByteArray, QVariant> values;
+    values.insert("text", "a.txt");
+    values.insert("size", QVariant::fromValue<KIO::filesize_t>(1234));
+    values.insert("date", QDateTime(QDate(2013, 4, 1), QTime(12, 30)));
+    values.insert("isDir", false);
+    values.insert("isLink", true);
+    values.insert("owner", "user");
+    values.insert("iconOverlays", QStringList() << "emblem-symbolic-link");
+    values.insert("iconPixmap", 42);
+
+    store.setValues(row, values);
+    QVERIFY(store.isInitialized(row));
+    QCOMPARE(store.values(row), values);
+
+    foreach (const QByteArray& role, values.keys()) {
+        QVERIFY(store.contains(row, role));
+        QCOMPARE(store.value(row, role), values.value(role));
+    }
+    QVERIFY(!store.contains(row, "group"));
+    QVERIFY(!store.value(row, "group").isValid());
+}
+
+void KFileItemModelRoleStoreTest::testTypedAccess()
+{
+    KFileItemModelRoleStore store;
+    const int fileRow = store.createRow();
+    const int dirRow = store.createRow();
+
+    store.setValue(fileRow, "text", "b.txt");
+    store.setValue(fileRow, "size", QVariant::fromValue<KIO::filesize_t>(Q_UINT64_C(5000000000)));
+    store.setValue(dirRow, "isDir", true);
+    store.setValue(dirRow, "size", 7);
+
+    QCOMPARE(store.stringValue(fileRow, KFileItemModelRoleStore::TextColumn), QString("b.txt"));
+    QVERIFY(store.stringValue(dirRow, KFileItemModelRoleStore::TextColumn).isEmpty());
+
+    QCOMPARE(store.sizeValue(fileRow), Q_UINT64_C(5000000000));
+    QVERIFY(!store.sizeIsItemCount(fileRow));
+    QCOMPARE(store.sizeValue(dirRow), quint64(7));
+    QVERIFY(store.sizeIsItemCount(dirRow));
+    QCOMPARE(store.value(dirRow, "size").type(), QVariant::Int);
+
+    QVERIFY(!store.boolValue(fileRow, KFileItemModelRoleStore::IsDirColumn));
+    QVERIFY(store.boolValue(dirRow, KFileItemModelRoleStore::IsDirColumn));
+
+    const QDateTime utc(QDate(2000, 1, 1), QTime(0, 0), Qt::UTC);
+    store.setValue(fileRow, "date", utc);
+    QCOMPARE(store.dateValue(fileRow), utc);
+    QCOMPARE(store.dateValue(fileRow).timeSpec(), Qt::UTC);
+
+    store.setValue(dirRow, "date", QDateTime());
+    QVERIFY(store.hasValue(dirRow, KFileItemModelRoleStore::DateColumn));
+    QVERIFY(!store.dateValue(dirRow).isValid());
+}
+
+void KFileItemModelRoleStoreTest::testTypeMismatch()
+{
+    KFileItemModelRoleStore store;
+    const int row = store.createRow();
+
+    store.setValue(row, "size", QVariant::fromValue<KIO::filesize_t>(10));
+    QVERIFY(store.hasValue(row, KFileItemModelRoleStore::SizeColumn));
+
+    // A value that does not fit into the column must be kept unchanged
+    store.setValue(row, "size", QString("unknown"));
+    QVERIFY(!store.hasValue(row, KFileItemModelRoleStore::SizeColumn));
+    QCOMPARE(store.value(row, "size"), QVariant(QString("unknown")));
+
+    store.setValue(row, "size", QVariant::fromValue<KIO::filesize_t>(20));
+    QCOMPARE(store.value(row, "size"), QVariant::fromValue<KIO::filesize_t>(20));
+    QCOMPARE(store.values(row).count(), 1);
+}
+
+void KFileItemModelRoleStoreTest::testReleaseRow()
+{
+    KFileItemModelRoleStore store;
+    const int row1 = store.createRow();
+    const int row2 = store.createRow();
+
+    QHash<QByteArray, QVariant> values;
+    values.insert("text", "c");
+    values.insert("iconPixmap", 1);
+    store.setValues(row1, values);
+
+    store.releaseRow(row1);
+    const int row3 = store.createRow();
+    QCOMPARE(row3, row1);
+    QVERIFY(!store.isInitialized(row3));
+    QVERIFY(store.values(row3).isEmpty());
+    QVERIFY(store.values(row2).isEmpty());
+}
+
+void KFileItemModelRoleStoreTest::testSharedStrings()
+{
+    KFileItemModelRoleStore store;
+    const int row1 = store.createRow();
+    const int row2 = store.createRow();
+
+    store.setValue(row1, "owner", "user");
+    store.setValue(row2, "owner", "user");
+    store.setValue(row1, "group", "users");
+    QCOMPARE(store.m_sharedStrings.count(), 2);
+    QCOMPARE(store.m_sharedStrings.value("user"), 2);
+
+    // Overwriting a value releases the old string
+    store.setValue(row2, "owner", "root");
+    QCOMPARE(store.m_sharedStrings.value("user"), 1);
+    QCOMPARE(store.m_sharedStrings.value("root"), 1);
+
+    // A value of the wrong type moves the role out of the column
+    store.setValue(row2, "owner", 42);
+    QVERIFY(!store.m_sharedStrings.contains("root"));
+
+    const int usage = store.memoryUsage();
+    store.releaseRow(row1);
+    QVERIFY(store.m_sharedStrings.isEmpty());
+    QVERIFY(store.memoryUsage() < usage);
+}
+
+QTEST_KDEMAIN(KFileItemModelRoleStoreTest, NoGUI)
+
+#include "kfileitemmodelrolestoretest.moc"
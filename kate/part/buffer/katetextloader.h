@@ -27,6 +27,12 @@
 #include <QtCore/QFile>
 #include <QCryptographicHash>
 
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
 namespace Kate {
 
 /**
@@ -53,6 +59,8 @@ class TextLoader
       , m_converter (0)
       , m_bomFound (false)
       , m_firstRead (true)
+      , m_positionalRead (false)
+      , m_readPosition (0)
     {
       // construct file device
       m_file = new QFile (filename);
@@ -88,10 +96,31 @@ class TextLoader
       m_firstRead = true;
 
       // if already opened, close the file...
+      m_positionalRead = false;
+      m_readPosition = 0;
       if (m_file->isOpen())
         m_file->close ();
 
-      return m_file->open (QIODevice::ReadOnly);
+      if (!m_file->open (QIODevice::ReadOnly))
+        return false;
+
+      /**
+       * regular files are read with pread() straight into our buffer, this skips the
+       * extra copy through the buffer of QIODevice
+       * a mapping of the file would avoid the copy altogether, but accessing it behind
+       * the end of a file that another process truncates meanwhile raises SIGBUS,
+       * pread() just returns less data then
+       * we fall back to normal reading otherwise, e.g. for pipes
+       */
+      struct stat st;
+      if (fstat (m_file->handle (), &st) == 0 && S_ISREG (st.st_mode)) {
+        m_positionalRead = true;
+#if defined(POSIX_FADV_SEQUENTIAL)
+        posix_fadvise (m_file->handle (), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+      }
+
+      return true;
     }
 
     /**
@@ -161,19 +190,20 @@ class TextLoader
             m_text.remove (0, m_lastLineStart);
 
             // try to read new data
-            const int c = m_file->read(m_buffer.data(), m_buffer.size());
+            const char *data = m_buffer.constData ();
+            const int c = readChunk ();
 
             // if any text is there, append it....
             if (c > 0)
             {
               // update hash sum
-              m_digest.addData (m_buffer.data(), c);
+              m_digest.addData (data, c);
 
               // detect byte order marks & codec for byte order markers on first read
               int bomBytes = 0;
               if (m_firstRead) {
                 // use first 16 bytes max to allow BOM detection of codec
-                QByteArray bom (m_buffer.data(), qMin (16, c));
+                QByteArray bom (data, qMin (16, c));
                 QTextCodec *codecForByteOrderMark = QTextCodec::codecForUtfText (bom, 0);
 
                 // if codec != null, we found a BOM!
@@ -212,7 +242,7 @@ class TextLoader
                 m_converter = new QTextConverter(m_codec->name());
                 m_converter->setFlags(QTextConverter::ConvertInvalidToNull);
               }
-              QString unicode = m_converter->toUnicode (m_buffer.constData() + bomBytes, c - bomBytes);
+              QString unicode = m_converter->toUnicode (data + bomBytes, c - bomBytes);
 
               // detect broken encoding
               for (int i = 0; i < unicode.size(); ++i) {
@@ -254,6 +284,17 @@ class TextLoader
 	  }
         }
 
+        /**
+         * skip all chars that can't end a line at once
+         */
+        const int lineBreak = findLineBreak (m_text.unicode(), m_position, m_text.length());
+        if (lineBreak > m_position) {
+          m_lastWasEndOfLine = false;
+          m_lastWasR = false;
+          m_position = lineBreak;
+          continue;
+        }
+
         if (m_text.at(m_position) == lf)
         {
           m_lastWasEndOfLine = true;
@@ -328,6 +369,66 @@ class TextLoader
       return m_digest.result ();
     }
 
+  private:
+    /**
+     * Find the next char that might end a line, see readLine().
+     * Checks four chars at once, most chars are neither below 0x0e nor a line separator.
+     * @param text unicode data to search in
+     * @param from position to start the search at
+     * @param to end of the unicode data
+     * @return position of the first line break candidate or @p to if there is none
+     */
+    static int findLineBreak (const QChar *text, int from, int to)
+    {
+      static const quint64 ones = Q_UINT64_C(0x0001000100010001);
+      static const quint64 highs = Q_UINT64_C(0x8000800080008000);
+      static const quint64 separators = ones * QChar::LineSeparator;
+
+      int i = from;
+      while (i < to) {
+        if (i + 4 <= to) {
+          quint64 chars;
+          memcpy (&chars, text + i, sizeof (chars));
+
+          // no char < 0x0e (covers \n and \r) and no line separator? next four
+          const quint64 eq = chars ^ separators;
+          if (!((chars - ones * 0x0e) & ~chars & highs) && !((eq - ones) & ~eq & highs)) {
+            i += 4;
+            continue;
+          }
+        }
+
+        // candidate found, e.g. a tab, check the chars one by one
+        const int end = qMin (i + 4, to);
+        for (; i < end; ++i) {
+          const ushort c = text[i].unicode();
+          if (c == '\n' || c == '\r' || c == QChar::LineSeparator)
+            return i;
+        }
+      }
+
+      return to;
+    }
+
+    /**
+     * Read the next chunk of the file into m_buffer.
+     * @return number of bytes read, 0 at the end of the file, -1 on errors
+     */
+    int readChunk ()
+    {
+      if (!m_positionalRead)
+        return m_file->read (m_buffer.data(), m_buffer.size());
+
+      ssize_t c;
+      do {
+        c = pread (m_file->handle (), m_buffer.data(), size_t (m_buffer.size()), off_t (m_readPosition));
+      } while (c < 0 && errno == EINTR);
+
+      if (c > 0)
+        m_readPosition += c;
+      return int (c);
+    }
+
   private:
     QTextCodec *m_codec;
     bool m_eof;
@@ -336,13 +437,15 @@ class TextLoader
     int m_position;
     int m_lastLineStart;
     TextBuffer::EndOfLineMode m_eol;
-    QIODevice *m_file;
+    QFile *m_file;
     QByteArray m_buffer;
     QCryptographicHash m_digest;
     QString m_text;
     QTextConverter *m_converter;
     bool m_bomFound;
     bool m_firstRead;
+    bool m_positionalRead;
+    qint64 m_readPosition;
 };
 
 }
@@ -39,6 +39,7 @@
 #include <QtCore/QFile>
 #include <QtCore/QTextStream>
 #include <QtCore/QTimer>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QTextCodec>
 #include <QtCore/qdatetime.h>
 
@@ -49,6 +50,22 @@
  */
 static const int KATE_MAX_DYNAMIC_CONTEXTS = 512;
 
+/**
+ * Delay before the background highlighting starts, in ms.
+ * Keeps it out of the way of loading, typing and the first paint.
+ */
+static const int KATE_BACKGROUND_HIGHLIGHT_DELAY = 250;
+
+/**
+ * Time one slice of background highlighting may take, in ms
+ */
+static const int KATE_BACKGROUND_HIGHLIGHT_SLICE = 10;
+
+/**
+ * Lines highlighted between two checks of the slice time
+ */
+static const int KATE_BACKGROUND_HIGHLIGHT_CHUNK = 256;
+
 /**
  * Create an empty buffer. (with one block with one empty line)
  */
@@ -62,6 +79,9 @@ KateBuffer::KateBuffer(KateDocument *doc)
    m_lineHighlighted (0),
    m_maxDynamicContexts (KATE_MAX_DYNAMIC_CONTEXTS)
 {
+  m_backgroundHighlightTimer.setSingleShot (true);
+  connect (&m_backgroundHighlightTimer, SIGNAL(timeout()), this, SLOT(backgroundHighlight()));
+
   // we need kate global to stay alive
   KateGlobal::incRef ();
 }
@@ -137,6 +157,11 @@ void KateBuffer::editEnd ()
       editTagLineStart,
       editTagLineEnd,
       true);
+
+  /**
+   * the edit might have changed the highlighting up to the end
+   */
+  scheduleBackgroundHighlight ();
 }
 
 void KateBuffer::clear()
@@ -150,6 +175,7 @@ void KateBuffer::clear()
 
   // back to line 0 with hl
   m_lineHighlighted = 0;
+  m_backgroundHighlightTimer.stop ();
 }
 
 bool KateBuffer::openFile (const QString &m_file, bool enforceTextCodec)
@@ -280,14 +306,19 @@ void KateBuffer::ensureHighlighted (int line, int lookAhead)
     return;
 
   // already hl up-to-date for this line?
-  if (line < m_lineHighlighted)
+  if (line < m_lineHighlighted) {
+    scheduleBackgroundHighlight ();
     return;
+  }
 
   // update hl until this line + max lookAhead
   int end = qMin(line + lookAhead, lines ()-1);
 
   // ensure we have enough highlighted
   doHighlight ( m_lineHighlighted, end, false );
+
+  // continue behind the requested lines in the background
+  scheduleBackgroundHighlight ();
 }
 
 void KateBuffer::wrapLine (const KTextEditor::Cursor &position)
@@ -381,6 +412,53 @@ void KateBuffer::setHighlight(int hlMode)
 void KateBuffer::invalidateHighlighting()
 {
   m_lineHighlighted = 0;
+  scheduleBackgroundHighlight ();
+}
+
+void KateBuffer::scheduleBackgroundHighlight ()
+{
+  // already scheduled
+  if (m_backgroundHighlightTimer.isActive())
+    return;
+
+  // nothing to do
+  if (!m_highlight || m_highlight->noHighlighting() || m_lineHighlighted >= lines())
+    return;
+
+  // no views, nobody will look at the lines, highlight them on demand
+  if (m_doc->views().isEmpty())
+    return;
+
+  m_backgroundHighlightTimer.start (KATE_BACKGROUND_HIGHLIGHT_DELAY);
+}
+
+void KateBuffer::backgroundHighlight ()
+{
+  // no hl around or no views left, no stuff to do
+  if (!m_highlight || m_highlight->noHighlighting() || m_doc->views().isEmpty())
+    return;
+
+  // never interfere with a running editing transaction, try again later
+  if (editingTransactions () > 0) {
+    m_backgroundHighlightTimer.start (KATE_BACKGROUND_HIGHLIGHT_DELAY);
+    return;
+  }
+
+  QElapsedTimer slice;
+  slice.start ();
+
+  while (m_lineHighlighted < lines() && slice.elapsed() < KATE_BACKGROUND_HIGHLIGHT_SLICE) {
+    const int start = m_lineHighlighted;
+    doHighlight (start, qMin (start + KATE_BACKGROUND_HIGHLIGHT_CHUNK, lines()) - 1, false);
+
+    // doHighlight always makes progress, but better safe than an endless loop
+    if (m_lineHighlighted <= start)
+      return;
+  }
+
+  // more to do? next slice after the pending events are processed
+  if (m_lineHighlighted < lines())
+    m_backgroundHighlightTimer.start (0);
 }
 
 void KateBuffer::doHighlight (int startLine, int endLine, bool invalidate)
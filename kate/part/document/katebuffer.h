@@ -25,6 +25,7 @@
 #include "katepartinterfaces_export.h"
 
 #include <QtCore/QObject>
+#include <QtCore/QTimer>
 
 class KateLineInfo;
 class KateDocument;
@@ -152,6 +153,13 @@ class KATEPARTINTERFACES_EXPORT KateBuffer : public Kate::TextBuffer
      */
     void ensureHighlighted(int line, int lookAhead = 64);
 
+    /**
+     * Number of lines from the start of the buffer with valid highlighting.
+     * Lines after this one get highlighted on demand or in the background.
+     * @return number of highlighted lines
+     */
+    int highlightedLines () const { return m_lineHighlighted; }
+
     /**
      * Return the total number of lines in the buffer.
      */
@@ -216,6 +224,21 @@ class KATEPARTINTERFACES_EXPORT KateBuffer : public Kate::TextBuffer
      */
     void doHighlight (int from, int to, bool invalidate);
 
+    /**
+     * Start the background highlighting, if there are lines left
+     * to highlight and someone is going to look at them.
+     */
+    void scheduleBackgroundHighlight ();
+
+  private Q_SLOTS:
+    /**
+     * Highlight the next lines after the highlighted area for a short
+     * time slice, reschedules itself until the end of the buffer is reached.
+     * The lines shown in the views are highlighted on demand by
+     * ensureHighlighted() in between the slices, so they always go first.
+     */
+    void backgroundHighlight ();
+
   Q_SIGNALS:
     /**
      * Emitted when the highlighting of a certain range has
@@ -257,6 +280,11 @@ class KATEPARTINTERFACES_EXPORT KateBuffer : public Kate::TextBuffer
      * number of dynamic contexts causing a full invalidation
      */
     int m_maxDynamicContexts;
+
+    /**
+     * timer triggering the next slice of background highlighting
+     */
+    QTimer m_backgroundHighlightTimer;
 };
 
 #endif
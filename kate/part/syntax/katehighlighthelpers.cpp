@@ -33,6 +33,8 @@
 #include "kateextendedattribute.h"
 
 #include <QtCore/QSet>
+
+#include <string.h>
 //END
 
 //BEGIN KateHlItem
@@ -278,25 +280,86 @@ KateHlKeyword::KateHlKeyword (int attribute, KateHlContextModification context,
 {
   alwaysStartEnable = false;
   customStartEnable = true;
-  foreach (const QChar &c, delims)
-    deliminators << c;
+
+  for (int i = 0; i < 256; ++i)
+    latin1Deliminators[i] = false;
+
+  foreach (const QChar &c, delims) {
+    if (c.unicode() < 256)
+      latin1Deliminators[c.unicode()] = true;
+    else
+      deliminators << c;
+  }
 }
 
 KateHlKeyword::~KateHlKeyword ()
 {
-  qDeleteAll(dict);
 }
 
 QSet<QString> KateHlKeyword::allKeywords() const
 {
   QSet<QString> result;
-  foreach ( const QSet<QString>* v, dict ) {
-    if ( ! v ) {
-      continue;
+  foreach (const QString &word, words)
+    result.insert(word);
+  return result;
+}
+
+uint KateHlKeyword::hashWord(const QChar *word, int len)
+{
+  // FNV-1a over the utf16 code units
+  uint hash = 2166136261u;
+  for (int i = 0; i < len; ++i) {
+    hash ^= word[i].unicode();
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+bool KateHlKeyword::containsWord(const QChar *word, int len, uint hash) const
+{
+  if (table.isEmpty())
+    return false;
+
+  const int mask = table.size() - 1;
+  for (int i = hash & mask; table[i]; i = (i + 1) & mask) {
+    const int index = table[i] - 1;
+    if (wordHashes[index] == hash && words[index].length() == len
+        && memcmp(words[index].unicode(), word, len * sizeof(QChar)) == 0)
+      return true;
+  }
+
+  return false;
+}
+
+void KateHlKeyword::insertWord(const QString &word)
+{
+  const uint hash = hashWord(word.unicode(), word.length());
+  if (containsWord(word.unicode(), word.length(), hash))
+    return;
+
+  words.append(word);
+  wordHashes.append(hash);
+
+  // keep the table at most half full, rehash if needed
+  if (words.size() * 2 > table.size()) {
+    int size = 16;
+    while (size < words.size() * 2)
+      size *= 2;
+
+    table.fill(0, size);
+    for (int index = 0; index < words.size() - 1; ++index) {
+      int i = wordHashes[index] & (size - 1);
+      while (table[i])
+        i = (i + 1) & (size - 1);
+      table[i] = index + 1;
     }
-    result.unite(*v);
   }
-  return result;
+
+  const int mask = table.size() - 1;
+  int i = hash & mask;
+  while (table[i])
+    i = (i + 1) & mask;
+  table[i] = words.size();
 }
 
 void KateHlKeyword::addList(const QStringList& list)
@@ -311,49 +374,79 @@ void KateHlKeyword::addList(const QStringList& list)
     if (maxLen < len)
       maxLen = len;
 
-    if (len >= dict.size())
-    {
-      uint oldSize = dict.size();
-      dict.resize (len+1);
-
-      for (int m=oldSize; m < dict.size(); ++m)
-        dict[m] = 0;
-    }
-
-    if (!dict[len])
-      dict[len] = new QSet<QString> ();
-
     if (!_insensitive)
-      dict[len]->insert(list[i]);
+      insertWord(list[i]);
     else
-      dict[len]->insert(list[i].toLower());
+      insertWord(list[i].toLower());
   }
 }
 
 int KateHlKeyword::checkHgl(const QString& text, int offset, int len)
 {
-  int offset2 = offset;
+  const QChar *word = text.unicode() + offset;
   int wordLen = 0;
 
-  while ((len > wordLen) && !deliminators.contains(text[offset2]))
+  // find the end of the word and hash it on the fly, only ASCII
+  // can be folded per char the same way QString::toLower() does
+  uint hash = 2166136261u;
+  bool folded = true;
+
+  while ((len > wordLen) && !isDeliminator(word[wordLen]))
   {
-    offset2++;
+    ushort c = word[wordLen].unicode();
+    if (_insensitive) {
+      if (c >= 'A' && c <= 'Z')
+        c += 'a' - 'A';
+      else if (c >= 0x80)
+        folded = false;
+    }
+
+    hash ^= c;
+    hash *= 16777619u;
+
     wordLen++;
 
     if (wordLen > maxLen) return 0;
   }
 
-  if (wordLen < minLen || !dict[wordLen]) return 0;
+  if (wordLen < minLen) return 0;
 
   if (!_insensitive)
   {
-    if (dict[wordLen]->contains(QString::fromRawData(text.unicode() + offset, wordLen)) )
-      return offset2;
+    if (containsWord(word, wordLen, hash))
+      return offset + wordLen;
+  }
+  else if (folded)
+  {
+    // compare against the folded word without creating it
+    if (table.isEmpty())
+      return 0;
+
+    const int mask = table.size() - 1;
+    for (int i = hash & mask; table[i]; i = (i + 1) & mask) {
+      const QString &keyword = words[table[i] - 1];
+      if (wordHashes[table[i] - 1] != hash || keyword.length() != wordLen)
+        continue;
+
+      int k = 0;
+      for (; k < wordLen; ++k) {
+        ushort c = word[k].unicode();
+        if (c >= 'A' && c <= 'Z')
+          c += 'a' - 'A';
+        if (keyword[k].unicode() != c)
+          break;
+      }
+
+      if (k == wordLen)
+        return offset + wordLen;
+    }
   }
   else
   {
-    if (dict[wordLen]->contains(QString::fromRawData(text.unicode() + offset, wordLen).toLower()) )
-      return offset2;
+    // non ASCII chars need the full unicode case folding
+    const QString lower = QString::fromRawData(word, wordLen).toLower();
+    if (lower.length() == wordLen && containsWord(lower.unicode(), wordLen, hashWord(lower.unicode(), wordLen)))
+      return offset + wordLen;
   }
 
   return 0;
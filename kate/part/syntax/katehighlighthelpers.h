@@ -192,8 +192,23 @@ class KateHlKeyword : public KateHlItem
     QSet<QString> allKeywords() const;
 
   private:
-    QVector< QSet<QString>* > dict;
+    // hash of the word, folded to lower case for insensitive lists,
+    // matching on the raw QChar data of the line without copying it
+    static uint hashWord(const QChar *word, int len);
+    bool containsWord(const QChar *word, int len, uint hash) const;
+    void insertWord(const QString &word);
+    inline bool isDeliminator(const QChar &c) const
+    {
+      return (c.unicode() < 256) ? latin1Deliminators[c.unicode()] : deliminators.contains(c);
+    }
+
+    // keywords, lower case for insensitive lists, and their hashes
+    QVector<QString> words;
+    QVector<uint> wordHashes;
+    // open addressing hash table, index into words + 1 or 0 if empty
+    QVector<int> table;
     bool _insensitive;
+    bool latin1Deliminators[256];
     QSet<QChar> deliminators;
     int minLen;
     int maxLen;
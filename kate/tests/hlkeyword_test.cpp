@@ -0,0 +1,163 @@
+/* This file is part of the KDE libraries
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "hlkeyword_test.h"
+#include "moc_hlkeyword_test.cpp"
+
+#include <qtest_kde.h>
+
+#include <katehighlighthelpers.h>
+
+QTEST_KDEMAIN_CORE(HlKeywordTest)
+
+static const QString delims = QString::fromLatin1(" \t.():;,");
+
+// returns the end of the keyword starting at offset in text, or 0
+static int match(KateHlKeyword &keyword, const QString &text, int offset = 0)
+{
+  return keyword.checkHgl(text, offset, text.length() - offset);
+}
+
+void HlKeywordTest::testCaseSensitive()
+{
+  KateHlKeyword keyword(0, KateHlContextModification(), 0, 0, false, delims);
+  keyword.addList(QStringList() << "if" << "else" << "while" << "return");
+
+  QCOMPARE(match(keyword, "if"), 2);
+  QCOMPARE(match(keyword, "if (x)"), 2);
+  QCOMPARE(match(keyword, "while(true)"), 5);
+  QCOMPARE(match(keyword, "x;return;", 2), 8);
+
+  QCOMPARE(match(keyword, "If"), 0);
+  QCOMPARE(match(keyword, "WHILE"), 0);
+  QCOMPARE(match(keyword, "iff"), 0);
+  QCOMPARE(match(keyword, "els"), 0);
+  QCOMPARE(match(keyword, "x"), 0);
+
+  // duplicates are only stored once
+  keyword.addList(QStringList() << "if" << "else");
+  QCOMPARE(keyword.allKeywords().count(), 4);
+  QCOMPARE(match(keyword, "else"), 4);
+
+  // many keywords make the table grow
+  QStringList many;
+  for (int i = 0; i < 1000; ++i)
+    many << QString("kw%1").arg(i);
+  keyword.addList(many);
+  QCOMPARE(keyword.allKeywords().count(), 1004);
+  for (int i = 0; i < 1000; ++i)
+    QCOMPARE(match(keyword, QString("kw%1 ").arg(i)), QString("kw%1").arg(i).length());
+  QCOMPARE(match(keyword, "kw1000"), 0);
+  QCOMPARE(match(keyword, "return"), 6);
+}
+
+void HlKeywordTest::testCaseInsensitive()
+{
+  KateHlKeyword keyword(0, KateHlContextModification(), 0, 0, true, delims);
+  keyword.addList(QStringList() << "Select" << "FROM" << "where");
+
+  QCOMPARE(match(keyword, "select"), 6);
+  QCOMPARE(match(keyword, "SELECT *"), 6);
+  QCOMPARE(match(keyword, "SeLeCt"), 6);
+  QCOMPARE(match(keyword, "from t"), 4);
+  QCOMPARE(match(keyword, "x WHERE y", 2), 7);
+
+  QCOMPARE(match(keyword, "selected"), 0);
+  QCOMPARE(match(keyword, "fro"), 0);
+
+  // the keywords are stored in lower case
+  QVERIFY(keyword.allKeywords().contains("select"));
+  QVERIFY(keyword.allKeywords().contains("from"));
+}
+
+void HlKeywordTest::testNonAscii()
+{
+  KateHlKeyword sensitive(0, KateHlContextModification(), 0, 0, false, delims);
+  sensitive.addList(QStringList() << QString::fromUtf8("größe") << QString::fromUtf8("Ändern"));
+
+  QCOMPARE(match(sensitive, QString::fromUtf8("größe")), 5);
+  QCOMPARE(match(sensitive, QString::fromUtf8("Ändern;")), 6);
+  QCOMPARE(match(sensitive, QString::fromUtf8("GRÖßE")), 0);
+  QCOMPARE(match(sensitive, QString::fromUtf8("ändern")), 0);
+
+  KateHlKeyword insensitive(0, KateHlContextModification(), 0, 0, true, delims);
+  insensitive.addList(QStringList() << QString::fromUtf8("Größe") << QString::fromUtf8("naïve")
+                                    << QString::fromUtf8("σοφία"));
+
+  // non ASCII chars in the text use the full case folding
+  QCOMPARE(match(insensitive, QString::fromUtf8("größe")), 5);
+  QCOMPARE(match(insensitive, QString::fromUtf8("GRÖßE")), 5);
+  QCOMPARE(match(insensitive, QString::fromUtf8("NAÏVE")), 5);
+  QCOMPARE(match(insensitive, QString::fromUtf8("ΣΟΦΊΑ")), 5);
+  QCOMPARE(match(insensitive, QString::fromUtf8("NAIVE")), 0);
+  QCOMPARE(match(insensitive, QString::fromUtf8("Größer")), 0);
+}
+
+void HlKeywordTest::testDeliminators()
+{
+  // a non Latin-1 deliminator is looked up outside of the Latin-1 table
+  KateHlKeyword keyword(0, KateHlContextModification(), 0, 0, false, delims + QChar(0x2192));
+  keyword.addList(QStringList() << "if" << "do");
+
+  QCOMPARE(match(keyword, "if(x)"), 2);
+  QCOMPARE(match(keyword, "if\tx"), 2);
+  QCOMPARE(match(keyword, "(if)", 1), 3);
+  QCOMPARE(match(keyword, QString("if") + QChar(0x2192)), 2);
+
+  // chars which are not deliminators continue the word
+  QCOMPARE(match(keyword, "if_"), 0);
+  QCOMPARE(match(keyword, "if-"), 0);
+  QCOMPARE(match(keyword, "if1"), 0);
+  QCOMPARE(match(keyword, QString("if") + QChar(0x2190)), 0);
+
+  // the word ends at the end of the given length
+  QCOMPARE(keyword.checkHgl("dox", 0, 2), 2);
+  QCOMPARE(keyword.checkHgl("xdo", 1, 2), 3);
+}
+
+void HlKeywordTest::testKeywordLength()
+{
+  KateHlKeyword keyword(0, KateHlContextModification(), 0, 0, false, delims);
+
+  // nothing matches an empty list
+  QCOMPARE(match(keyword, "a"), 0);
+
+  keyword.addList(QStringList() << "ab" << "abcdef");
+
+  // shorter than the shortest keyword
+  QCOMPARE(match(keyword, "a"), 0);
+  QCOMPARE(match(keyword, "a b"), 0);
+
+  // the shortest and the longest keyword
+  QCOMPARE(match(keyword, "ab"), 2);
+  QCOMPARE(match(keyword, "abcdef"), 6);
+  QCOMPARE(match(keyword, "abcdef."), 6);
+
+  // longer than the longest keyword
+  QCOMPARE(match(keyword, "abcdefg"), 0);
+  QCOMPARE(match(keyword, "abcdefabcdef"), 0);
+
+  // lengths in between which are no keywords
+  QCOMPARE(match(keyword, "abc"), 0);
+  QCOMPARE(match(keyword, "abcde"), 0);
+
+  // a single char keyword lowers the minimum
+  keyword.addList(QStringList() << "x");
+  QCOMPARE(match(keyword, "x"), 1);
+  QCOMPARE(match(keyword, "a"), 0);
+}
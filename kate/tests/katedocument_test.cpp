@@ -23,6 +23,7 @@
 #include <qtest_kde.h>
 
 #include <katedocument.h>
+#include <katebuffer.h>
 #include <ktexteditor/movingcursor.h>
 #include <kateconfig.h>
 #include <ktemporaryfile.h>
@@ -354,4 +355,64 @@ void KateDocumentTest::testDefStyleNum()
   QCOMPARE(doc.defStyleNum(0, 0), -1);
 }
 
+void KateDocumentTest::testHighlightingPerformance_data()
+{
+    QTest::addColumn<QString>("mode");
+    QTest::addColumn<QString>("block");
+
+    QTest::newRow("XML") << "XML"
+        << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+           "<!-- generated test data -->\n"
+           "<rows count=\"3\">\n"
+           "  <row id=\"1\" name=\"foo\">some &amp; text</row>\n"
+           "  <row id=\"2\"><![CDATA[ raw <data> ]]></row>\n"
+           "  <row id=\"3\" name='bar'/>\n"
+           "</rows>\n";
+    QTest::newRow("SQL") << "SQL"
+        << "-- generated test data\n"
+           "CREATE TABLE rows (id INTEGER PRIMARY KEY, name VARCHAR(64));\n"
+           "INSERT INTO rows (id, name) VALUES (1, 'foo'), (2, 'bar');\n"
+           "/* multi line\n"
+           "   comment */\n"
+           "SELECT id, name FROM rows WHERE name LIKE '%o%' ORDER BY id;\n";
+    QTest::newRow("C++") << "C++"
+        << "// generated test data\n"
+           "#include <vector>\n"
+           "/* multi line\n"
+           "   comment */\n"
+           "template <typename T> int count(const std::vector<T> &v) {\n"
+           "  int n = 0x10; // hex\n"
+           "  for (int i = 0; i < v.size(); ++i) n += 1.5e3;\n"
+           "  return n + 'c' + sizeof(\"string \\\" escape\");\n"
+           "}\n";
+}
+
+void KateDocumentTest::testHighlightingPerformance()
+{
+    QFETCH(QString, mode);
+    QFETCH(QString, block);
+
+    const int blocks = 5000;
+
+    KateDocument doc(false, false, false);
+
+    QString text;
+    text.reserve(block.size() * blocks);
+    for (int i = 0; i < blocks; ++i) {
+        text.append(block);
+    }
+
+    doc.setText(text);
+    QVERIFY(doc.setHighlightingMode(mode));
+    QCOMPARE(doc.highlightingMode(), mode);
+
+    // highlight everything, as a jump to the end of the document does
+    QBENCHMARK {
+        doc.buffer().invalidateHighlighting();
+        doc.buffer().ensureHighlighted(doc.lines() - 1, 0);
+    }
+
+    QCOMPARE(doc.buffer().highlightedLines(), doc.lines());
+}
+
 #include "katedocument_test.moc"
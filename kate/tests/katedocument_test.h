@@ -46,6 +46,9 @@ private Q_SLOTS:
   void testDigest();
 
   void testDefStyleNum();
+
+  void testHighlightingPerformance_data();
+  void testHighlightingPerformance();
 };
 
 #endif // KATE_DOCUMENT_TEST_H
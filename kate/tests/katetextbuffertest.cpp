@@ -23,9 +23,40 @@
 #include "katetextbuffer.h"
 #include "katetextcursor.h"
 #include "katetextfolding.h"
+#include "katetextloader.h"
 
 #include <QtCore/qdir.h>
 
+#ifdef Q_OS_LINUX
+// value in kB of a field of /proc/self/status like "VmHWM:", -1 if unknown
+static int memoryStatus(const QByteArray &field)
+{
+  QFile status("/proc/self/status");
+  if (!status.open(QIODevice::ReadOnly))
+    return -1;
+
+  foreach (const QByteArray &line, status.readAll().split('\n')) {
+    if (line.startsWith(field))
+      return line.mid(field.size()).trimmed().split(' ').first().toInt();
+  }
+  return -1;
+}
+#endif
+
+// writes ~64 MB of log file like lines, returns the number of lines
+static int writeLogFile(const QString &file_path)
+{
+  const QByteArray line = "2013-01-01 12:00:00 [info]\tsome component: some message with a number 1234567890\n";
+  QFile f(file_path);
+  if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return -1;
+  const QByteArray block = line.repeated(1024);
+  const int blocks = 64 * 1024 * 1024 / block.size();
+  for (int i = 0; i < blocks; ++i)
+    f.write(block);
+  return blocks * 1024;
+}
+
 QTEST_MAIN(KateTextBufferTest)
 
 KateTextBufferTest::KateTextBufferTest()
@@ -449,3 +480,123 @@ void KateTextBufferTest::saveFileInUnwritableFolder()
   Q_ASSERT(f.remove());
   Q_ASSERT(QDir::temp().rmdir(folder_name));
 }
+
+void KateTextBufferTest::loadFileTest()
+{
+  // lines crossing the boundaries of the read chunks, all kinds of line ends
+  QStringList lines;
+  QByteArray data;
+  for (int i = 0; i < 20000; ++i) {
+    const QString line = QString("line\t%1 %2").arg(i).arg(QString(i % 97, QChar('x')));
+    lines << line;
+    data += line.toUtf8();
+    data += (i % 3 == 0) ? "\r\n" : (i % 3 == 1) ? "\n" : "\r";
+  }
+  data += "last line \xe2\x80\xa8" "separated";
+  lines << QString::fromUtf8("last line ") << QString::fromUtf8("separated");
+
+  const QString file_path = QDir::tempPath() + QString("/katetest_load_%1").arg(QCoreApplication::applicationPid());
+  QFile f(file_path);
+  QVERIFY(f.open(QIODevice::WriteOnly | QIODevice::Truncate));
+  f.write(data);
+  f.close();
+
+  Kate::TextBuffer buffer(0, 64);
+  buffer.setTextCodec(QTextCodec::codecForName("UTF-8"));
+  buffer.setFallbackTextCodec(QTextCodec::codecForName("UTF-8"));
+  bool encodingErrors, tooLongLinesWrapped;
+  QVERIFY(buffer.load(file_path, encodingErrors, tooLongLinesWrapped, true));
+  QVERIFY(!encodingErrors);
+
+  QCOMPARE(buffer.lines(), lines.size());
+  for (int i = 0; i < lines.size(); ++i)
+    QCOMPARE(buffer.line(i)->string(), lines.at(i));
+
+  QVERIFY(f.remove());
+}
+
+void KateTextBufferTest::loadTruncatedFileTest()
+{
+  const QString file_path = QDir::tempPath() + QString("/katetest_truncated_%1").arg(QCoreApplication::applicationPid());
+  QFile f(file_path);
+  QVERIFY(f.open(QIODevice::WriteOnly | QIODevice::Truncate));
+  for (int i = 0; i < 100000; ++i)
+    f.write(QString("line %1\n").arg(i).toLatin1());
+  f.close();
+
+  Kate::TextLoader loader(file_path);
+  QVERIFY(loader.open(QTextCodec::codecForName("UTF-8")));
+
+  int offset, length;
+  QVERIFY(loader.readLine(offset, length));
+  QCOMPARE(QString(loader.unicode() + offset, length), QString("line 0"));
+
+  // the file shrinks while it is loaded, the rest must be read without crashing
+  QVERIFY(QFile::resize(file_path, 1000));
+
+  int lines = 1;
+  while (!loader.eof()) {
+    loader.readLine(offset, length);
+    ++lines;
+  }
+  QVERIFY(lines < 100000);
+
+  QVERIFY(QFile::remove(file_path));
+}
+
+void KateTextBufferTest::loadFileBenchmark()
+{
+  const QString file_path = QDir::tempPath() + QString("/katetest_bench_%1").arg(QCoreApplication::applicationPid());
+  const int lines = writeLogFile(file_path);
+  QVERIFY(lines > 0);
+
+  Kate::TextBuffer buffer(0, 64);
+  buffer.setTextCodec(QTextCodec::codecForName("UTF-8"));
+  buffer.setFallbackTextCodec(QTextCodec::codecForName("UTF-8"));
+
+  QBENCHMARK {
+    bool encodingErrors, tooLongLinesWrapped;
+    QVERIFY(buffer.load(file_path, encodingErrors, tooLongLinesWrapped, true));
+  }
+
+  QCOMPARE(buffer.lines(), lines + 1);
+
+  buffer.clear();
+  QVERIFY(QFile::remove(file_path));
+}
+
+void KateTextBufferTest::loadFileMemoryBenchmark()
+{
+#ifndef Q_OS_LINUX
+  QSKIP("the peak resident set size is only known on Linux", SkipAll);
+#else
+  const QString file_path = QDir::tempPath() + QString("/katetest_bench_%1").arg(QCoreApplication::applicationPid());
+  const int lines = writeLogFile(file_path);
+  QVERIFY(lines > 0);
+
+  Kate::TextBuffer buffer(0, 64);
+  buffer.setTextCodec(QTextCodec::codecForName("UTF-8"));
+  buffer.setFallbackTextCodec(QTextCodec::codecForName("UTF-8"));
+
+  // reset the peak to the current resident set size, needs Linux 4.0
+  QFile clearRefs("/proc/self/clear_refs");
+  if (clearRefs.open(QIODevice::WriteOnly))
+    clearRefs.write("5");
+  clearRefs.close();
+  const int before = memoryStatus("VmRSS:");
+
+  bool encodingErrors, tooLongLinesWrapped;
+  QVERIFY(buffer.load(file_path, encodingErrors, tooLongLinesWrapped, true));
+  QCOMPARE(buffer.lines(), lines + 1);
+
+  const int peak = memoryStatus("VmHWM:");
+  QVERIFY(before > 0 && peak > 0);
+
+  // QTest has no metric for memory, the growth of the peak
+  // resident set size in kB is reported as events
+  QTest::setBenchmarkResult(peak - before, QTest::Events);
+
+  buffer.clear();
+  QVERIFY(QFile::remove(file_path));
+#endif
+}
@@ -40,6 +40,10 @@ class KateTextBufferTest : public QObject
     void foldingTest();
     void nestedFoldingTest();
     void saveFileInUnwritableFolder();
+    void loadFileTest();
+    void loadTruncatedFileTest();
+    void loadFileBenchmark();
+    void loadFileMemoryBenchmark();
 };
 
 #endif // KATEBUFFERTEST_H
@@ -29,6 +29,7 @@
 #include <ktemporaryfile.h>
 #include <katebuffer.h>
 #include <QTextStream>
+#include <QElapsedTimer>
 
 using namespace KTextEditor;
 
@@ -89,6 +90,58 @@ void KateViewTest::testCursorToCoordinates()
     view->cursorToCoordinate(Cursor(-1, 0));
 }
 
+// records the time until the first paint event of the watched widgets
+class FirstPaintWatcher : public QObject
+{
+public:
+    FirstPaintWatcher() : firstPaint(-1) { timer.start(); }
+
+    virtual bool eventFilter(QObject *watched, QEvent *event)
+    {
+        if (event->type() == QEvent::Paint && firstPaint < 0)
+            firstPaint = timer.elapsed();
+        return QObject::eventFilter(watched, event);
+    }
+
+    QElapsedTimer timer;
+    qint64 firstPaint;
+};
+
+void KateViewTest::benchmarkFirstPaint()
+{
+    // ~64 MB of log file like lines
+    KTemporaryFile file;
+    file.setSuffix(".log");
+    file.open();
+    const QByteArray block = QByteArray("2013-01-01 12:00:00 [info]\tsome component: some message with a number 1234567890\n").repeated(1024);
+    for (int i = 0; i < 64 * 1024 * 1024 / block.size(); ++i) {
+        file.write(block);
+    }
+    file.close();
+
+    KateDocument doc(false, false, false);
+    KateView* view = static_cast<KateView*>(doc.createView(0));
+    view->show();
+    QTest::qWaitForWindowShown(view);
+
+    FirstPaintWatcher watcher;
+    foreach (QWidget *widget, view->findChildren<QWidget*>()) {
+        widget->installEventFilter(&watcher);
+    }
+
+    // loading is synchronous, the first paint happens when the events are processed afterwards
+    watcher.timer.restart();
+    QVERIFY(doc.openUrl(KUrl(file.fileName())));
+    const qint64 loaded = watcher.timer.elapsed();
+    while (watcher.firstPaint < 0 && watcher.timer.elapsed() < loaded + 5000) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
+    }
+    QVERIFY(watcher.firstPaint >= 0);
+
+    QTest::setBenchmarkResult(watcher.firstPaint, QTest::WalltimeMilliseconds);
+    delete view;
+}
+
 void KateViewTest::testReloadMultipleViews()
 {
     KTemporaryFile file;
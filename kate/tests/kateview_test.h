@@ -45,6 +45,8 @@ private Q_SLOTS:
 
   void testSelection();
   void testKillline();
+
+  void benchmarkFirstPaint();
 };
 
 #endif // KATE_VIEW_TEST_H
@@ -25,7 +25,10 @@
 
 #include <QFile>
 #include <QTimer>
+#include <QEventLoop>
 #include <QLibrary>
+#include <QTextStream>
+#include <QThread>
 #include <QtDBus/QtDBus>
 
 #include <kapplication.h>
@@ -37,6 +40,7 @@
 #include <kconfiggroup.h>
 #include <klocale.h>
 #include <kservicetypetrader.h>
+#include <kstandarddirs.h>
 #include <kglobalsettings.h>
 
 #ifdef Q_WS_X11
@@ -97,6 +101,7 @@ bool KCMInit::runModule(const QString &libName, KService::Ptr service)
 
 void KCMInit::runModules( int phase )
 {
+  KService::List ordered;
   for(KService::List::Iterator it = list.begin();
       it != list.end();
       ++it) {
@@ -116,16 +121,138 @@ void KCMInit::runModules( int phase )
       if( phase != -1 && libphase != phase )
           continue;
 
+      if (alreadyInitialized.contains(library))
+          continue;
+      alreadyInitialized.append(library);
+
+      // modules which have to run one after another are run in this process,
+      // all the others can run at the same time in worker processes
+      if (parallel && !service->property("X-KDE-Init-Ordered", QVariant::Bool).toBool()) {
+          Worker worker;
+          worker.service = service;
+          worker.phase = libphase;
+          worker.process = 0;
+          waitingWorkers.append(worker);
+      } else {
+          ordered.append(service);
+      }
+  }
+
+  startWorkers();
+
+  foreach (const KService::Ptr &service, ordered) {
+      QVariant vphase = service->property("X-KDE-Init-Phase", QVariant::Int );
+      QElapsedTimer timer;
+      timer.start();
       // try to load the library
-      if (!alreadyInitialized.contains(library)) {
-          runModule(library, service);
-          alreadyInitialized.append(library);
+      runModule(service->library(), service);
+      moduleDone(service, vphase.isValid() ? vphase.toInt() : 1, timer.elapsed(), false);
+  }
+
+  // the phase is only done when all workers are done
+  if (!runningWorkers.isEmpty() || !waitingWorkers.isEmpty()) {
+      QEventLoop loop;
+      workerLoop = &loop;
+      QTimer::singleShot( 30 * 1000, &loop, SLOT(quit())); // protection
+      loop.exec( QEventLoop::ExcludeUserInputEvents );
+      workerLoop = 0;
+      if (!runningWorkers.isEmpty() || !waitingWorkers.isEmpty()) {
+          kWarning() << "Timeout while waiting for" << (runningWorkers.count() + waitingWorkers.count()) << "modules";
+          // the next phase must not overlap with this one, the modules which have not
+          // been started yet are initialized here and the running workers are left alone
+          while (!waitingWorkers.isEmpty()) {
+              Worker worker = waitingWorkers.takeFirst();
+              worker.timer.start();
+              runModule(worker.service->library(), worker.service);
+              moduleDone(worker.service, worker.phase, worker.timer.elapsed(), false);
+          }
+          foreach (const Worker &worker, runningWorkers) {
+              kWarning() << "Not waiting any longer for" << worker.service->library();
+              disconnect(worker.process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(workerFinished()));
+              connect(worker.process, SIGNAL(finished(int,QProcess::ExitStatus)), worker.process, SLOT(deleteLater()));
+          }
+          runningWorkers.clear();
       }
   }
+
+  if (startup)
+      writeProfile();
+}
+
+void KCMInit::startWorkers()
+{
+  while (!waitingWorkers.isEmpty() && runningWorkers.count() < maxWorkers) {
+      Worker worker = waitingWorkers.takeFirst();
+      worker.timer.start();
+      worker.process = new QProcess(this);
+      connect(worker.process, SIGNAL(finished(int,QProcess::ExitStatus)), SLOT(workerFinished()));
+      // "kcminit <module>" runs just that module
+      worker.process->start(QCoreApplication::applicationFilePath(), QStringList() << worker.service->storageId());
+      if (!worker.process->waitForStarted()) {
+          kWarning() << "Could not start worker for" << worker.service->library() << ", initializing it here";
+          delete worker.process;
+          runModule(worker.service->library(), worker.service);
+          moduleDone(worker.service, worker.phase, worker.timer.elapsed(), false);
+          continue;
+      }
+      runningWorkers.append(worker);
+  }
+}
+
+void KCMInit::workerFinished()
+{
+  QProcess* process = static_cast<QProcess*>(sender());
+  for (int i = 0; i < runningWorkers.count(); ++i) {
+      if (runningWorkers.at(i).process != process)
+          continue;
+      const Worker worker = runningWorkers.takeAt(i);
+      if (process->exitStatus() != QProcess::NormalExit || process->exitCode() != 0)
+          kWarning() << "Worker for" << worker.service->library() << "failed";
+      moduleDone(worker.service, worker.phase, worker.timer.elapsed(), true);
+      break;
+  }
+  process->deleteLater();
+
+  startWorkers();
+  if (workerLoop && runningWorkers.isEmpty() && waitingWorkers.isEmpty())
+      workerLoop->quit();
+}
+
+void KCMInit::moduleDone( KService::Ptr service, int phase, qint64 msecs, bool worker )
+{
+  const QString name = service->desktopEntryName();
+  kDebug() << "Initialized" << name << "in" << msecs << "ms" << (worker ? "(worker)" : "");
+  times.insert(name, int(msecs));
+  profile.append(QString("%1\t%2\t%3\t%4").arg(phase).arg(msecs).arg(name)
+                 .arg(worker ? QLatin1String("worker") : QLatin1String("kcminit")));
+  emit moduleInitialized(name, phase, int(msecs));
+}
+
+void KCMInit::writeProfile()
+{
+  // phase, milliseconds, module and where it ran, one module per line
+  QFile file(KStandardDirs::locateLocal("tmp", "kcminit-startup-profile"));
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+      kWarning() << "Could not write startup profile" << file.fileName();
+      return;
+  }
+  QTextStream stream(&file);
+  foreach (const QString &line, profile)
+      stream << line << '\n';
+}
+
+QVariantMap KCMInit::moduleTimes() const
+{
+  return times;
 }
 
 KCMInit::KCMInit( KCmdLineArgs* args )
+  : workerLoop( 0 )
 {
+  KConfigGroup config( KGlobal::config(), "General" );
+  parallel = startup && config.readEntry( "ParallelModules", false );
+  maxWorkers = qMax( 1, config.readEntry( "MaxWorkers", QThread::idealThreadCount() ));
+
   QDBusConnection::sessionBus().registerObject("/kcminit", this,
       QDBusConnection::ExportScriptableSlots|QDBusConnection::ExportScriptableSignals);
   QString arg;
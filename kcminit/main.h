@@ -22,7 +22,12 @@
 
 #include <kservice.h>
 
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QVariantMap>
+
 class KCmdLineArgs;
+class QEventLoop;
 
 class KCMInit : public QObject
 {
@@ -31,17 +36,42 @@ class KCMInit : public QObject
 	public Q_SLOTS: //dbus
         Q_SCRIPTABLE void runPhase1();
         Q_SCRIPTABLE void runPhase2();
+        // milliseconds each module took to initialize, by module name
+        Q_SCRIPTABLE QVariantMap moduleTimes() const;
     Q_SIGNALS: //dbus signal
 	Q_SCRIPTABLE void phase1Done();
 	Q_SCRIPTABLE void phase2Done();
+	Q_SCRIPTABLE void moduleInitialized( const QString &module, int phase, int msecs );
     public:
         KCMInit( KCmdLineArgs* args );
         virtual ~KCMInit();
+    private Q_SLOTS:
+        void workerFinished();
     private:
         bool runModule(const QString &libName, KService::Ptr service);
         void runModules( int phase );
+        void startWorkers();
+        void moduleDone( KService::Ptr service, int phase, qint64 msecs, bool worker );
+        void writeProfile();
         KService::List list;
         QStringList alreadyInitialized;
+
+        // modules without X-KDE-Init-Ordered are run in worker processes
+        // in parallel, if enabled
+        struct Worker {
+            KService::Ptr service;
+            int phase;
+            QProcess* process;
+            QElapsedTimer timer;
+        };
+        bool parallel;
+        int maxWorkers;
+        QList<Worker> waitingWorkers;
+        QList<Worker> runningWorkers;
+        QEventLoop* workerLoop;
+
+        QVariantMap times;
+        QStringList profile;
 };
 
 #endif // MAIN_H
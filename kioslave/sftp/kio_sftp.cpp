@@ -32,6 +32,7 @@
 #include <QtCore/QDir>
 #include <QtCore/QFile>
 #include <QtCore/QObject>
+#include <QtCore/QScopedPointer>
 #include <QtCore/QString>
 #include <QtCore/QDateTime>
 #include <QtGui/QApplication>
@@ -56,13 +57,16 @@
 #define KIO_SFTP_SPECIAL_TIMEOUT 30
 #define ZERO_STRUCTP(x) do { if ((x) != NULL) memset((char *)(x), 0, sizeof(*(x))); } while(0)
 
-// How big should each data packet be? Definitely not bigger than 64kb or
-// you will overflow the 2 byte size variable in a sftp packet.
-#define MAX_XFER_BUF_SIZE (60 * 1024)
 #define KIO_SFTP_DB 7120
 // Maximum amount of data which can be sent from the KIOSlave in one chunk
 // see TransferJob::slotDataReq (max_size variable) for the value
 #define MAX_TRANSFER_SIZE (14 * 1024 * 1024)
+// Number of write requests in flight while uploading, can be changed
+// with the MaxPendingWrites entry of the slave configuration
+#define DEFAULT_MAX_PENDING_WRITES 16
+// How long the entries of a listed directory are used for stat() and
+// mimetype() before the server is asked again, in milliseconds
+#define ENTRY_CACHE_TIMEOUT 5000
 
 using namespace KIO;
 
@@ -337,6 +341,73 @@ void sftpProtocol::reportError(const KUrl &url, const int err)
     }
 }
 
+// Adds the type, access and size of sb to entry and, depending on details,
+// also owner, group and times
+static void insertAttributes(UDSEntry &entry, const sftp_attributes sb, int details)
+{
+    switch (sb->type) {
+        case SSH_FILEXFER_TYPE_REGULAR:
+            entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFREG);
+            break;
+        case SSH_FILEXFER_TYPE_DIRECTORY:
+            entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFDIR);
+            break;
+        case SSH_FILEXFER_TYPE_SYMLINK:
+            entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFLNK);
+            break;
+        case SSH_FILEXFER_TYPE_SPECIAL:
+        case SSH_FILEXFER_TYPE_UNKNOWN:
+            break;
+    }
+
+    entry.insert(KIO::UDSEntry::UDS_ACCESS, sb->permissions & 07777);
+    entry.insert(KIO::UDSEntry::UDS_SIZE, sb->size);
+
+    if (details > 0) {
+        if (sb->owner) {
+            entry.insert(KIO::UDSEntry::UDS_USER, QString::fromUtf8(sb->owner));
+        } else {
+            entry.insert(KIO::UDSEntry::UDS_USER, QString::number(sb->uid));
+        }
+
+        if (sb->group) {
+            entry.insert(KIO::UDSEntry::UDS_GROUP, QString::fromUtf8(sb->group));
+        } else {
+            entry.insert(KIO::UDSEntry::UDS_GROUP, QString::number(sb->gid));
+        }
+
+        entry.insert(KIO::UDSEntry::UDS_ACCESS_TIME, sb->atime);
+        entry.insert(KIO::UDSEntry::UDS_MODIFICATION_TIME, sb->mtime);
+        entry.insert(KIO::UDSEntry::UDS_CREATION_TIME, sb->createtime);
+    }
+}
+
+bool sftpProtocol::cachedUDSEntry(const QByteArray &path, UDSEntry &entry, int details)
+{
+    if (mEntryCache.isEmpty()) {
+        return false;
+    }
+    if (mEntryCacheTime.elapsed() > ENTRY_CACHE_TIMEOUT) {
+        clearEntryCache();
+        return false;
+    }
+    if (details > mEntryCacheDetails) {
+        return false;
+    }
+
+    QHash<QByteArray, UDSEntry>::const_iterator it = mEntryCache.constFind(path);
+    if (it == mEntryCache.constEnd()) {
+        return false;
+    }
+    entry = it.value();
+    return true;
+}
+
+void sftpProtocol::clearEntryCache()
+{
+    mEntryCache.clear();
+}
+
 bool sftpProtocol::createUDSEntry(const QString &filename, const QByteArray &path,
                                   UDSEntry &entry, short int details)
 {
@@ -451,7 +522,8 @@ QString sftpProtocol::canonicalizePath(const QString &path)
 
 sftpProtocol::sftpProtocol(const QByteArray &app_socket)
     : SlaveBase("kio_sftp", app_socket),
-    mConnected(false), mPort(-1), mSession(NULL), mSftp(NULL), mPublicKeyAuthInfo(0)
+    mConnected(false), mPort(-1), mSession(NULL), mSftp(NULL), mPublicKeyAuthInfo(0),
+    mEntryCacheDetails(0)
 {
     kDebug(KIO_SFTP_DB) << "pid = " << getpid();
 
@@ -915,6 +987,8 @@ void sftpProtocol::closeConnection()
 {
     kDebug(KIO_SFTP_DB);
 
+    clearEntryCache();
+
     if (mSftp) {
         sftp_free(mSftp);
         mSftp = NULL;
@@ -974,33 +1048,58 @@ void sftpProtocol::open(const KUrl &url, QIODevice::OpenMode mode)
 
     const QString path = url.path();
     const QByteArray path_c = path.toUtf8();
-
-    sftp_attributes sb = sftp_lstat(mSftp, path_c.constData());
-    if (sb == NULL) {
-        reportError(url, sftp_get_error(mSftp));
-        return;
+    KIO::filesize_t fileSize = 0;
+    UDSEntry cachedEntry;
+
+    if (mode & QIODevice::WriteOnly) {
+        clearEntryCache();
+    } else if (cachedUDSEntry(path_c, cachedEntry, 0)) {
+        // The file has just been listed
+        switch (cachedEntry.numberValue(KIO::UDSEntry::UDS_FILE_TYPE)) {
+            case S_IFDIR: {
+                error(KIO::ERR_IS_DIRECTORY, url.prettyUrl());
+                return;
+            }
+            case S_IFREG:
+            case S_IFLNK: {
+                break;
+            }
+            default: {
+                error(KIO::ERR_CANNOT_OPEN_FOR_READING, url.prettyUrl());
+                return;
+            }
+        }
+        fileSize = cachedEntry.numberValue(KIO::UDSEntry::UDS_SIZE);
     }
 
-    switch (sb->type) {
-        case SSH_FILEXFER_TYPE_DIRECTORY: {
-            error(KIO::ERR_IS_DIRECTORY, url.prettyUrl());
-            sftp_attributes_free(sb);
-            return;
-        }
-        case SSH_FILEXFER_TYPE_SPECIAL:
-        case SSH_FILEXFER_TYPE_UNKNOWN: {
-            error(KIO::ERR_CANNOT_OPEN_FOR_READING, url.prettyUrl());
-            sftp_attributes_free(sb);
+    if (cachedEntry.count() == 0) {
+        sftp_attributes sb = sftp_lstat(mSftp, path_c.constData());
+        if (sb == NULL) {
+            reportError(url, sftp_get_error(mSftp));
             return;
         }
-        case SSH_FILEXFER_TYPE_SYMLINK:
-        case SSH_FILEXFER_TYPE_REGULAR: {
-            break;
+
+        switch (sb->type) {
+            case SSH_FILEXFER_TYPE_DIRECTORY: {
+                error(KIO::ERR_IS_DIRECTORY, url.prettyUrl());
+                sftp_attributes_free(sb);
+                return;
+            }
+            case SSH_FILEXFER_TYPE_SPECIAL:
+            case SSH_FILEXFER_TYPE_UNKNOWN: {
+                error(KIO::ERR_CANNOT_OPEN_FOR_READING, url.prettyUrl());
+                sftp_attributes_free(sb);
+                return;
+            }
+            case SSH_FILEXFER_TYPE_SYMLINK:
+            case SSH_FILEXFER_TYPE_REGULAR: {
+                break;
+            }
         }
-    }
 
-    KIO::filesize_t fileSize = sb->size;
-    sftp_attributes_free(sb);
+        fileSize = sb->size;
+        sftp_attributes_free(sb);
+    }
 
     int flags = 0;
 
@@ -1249,6 +1348,8 @@ sftpProtocol::StatusCode sftpProtocol::sftpPut(const KUrl& url, int permissions,
                         << ", overwrite =" << (flags & KIO::Overwrite)
                         << ", resume =" << (flags & KIO::Resume);
 
+    clearEntryCache();
+
     if (!sftpLogin()) {
         return sftpProtocol::ServerError;
     }
@@ -1264,6 +1365,7 @@ sftpProtocol::StatusCode sftpProtocol::sftpPut(const KUrl& url, int permissions,
     const bool bOrigExists = (sb != NULL);
     bool bPartExists = false;
     const bool bMarkPartial = config()->readEntry("MarkPartial", true);
+    const ushort maxPendingWrites = qBound(1, config()->readEntry("MaxPendingWrites", DEFAULT_MAX_PENDING_WRITES), 256);
 
     // Don't change permissions of the original file
     if (bOrigExists) {
@@ -1316,6 +1418,7 @@ sftpProtocol::StatusCode sftpProtocol::sftpPut(const KUrl& url, int permissions,
     QByteArray dest;
     int result = -1;
     sftp_file file = NULL;
+    QScopedPointer<PutRequest> request;
     StatusCode cs = sftpProtocol::Success;
     KIO::fileoffset_t totalBytesSent = 0;
 
@@ -1390,9 +1493,12 @@ sftpProtocol::StatusCode sftpProtocol::sftpPut(const KUrl& url, int permissions,
                     result = -1;
                     continue;
                 } // file
+
+                request.reset(new PutRequest(file, maxWriteLength(mSftp), maxPendingWrites));
             } // dest.isEmpty
 
-            ssize_t bytesWritten = sftp_write(file, buffer.data(), buffer.size());
+            // An empty buffer ends the upload, so wait for all pending writes
+            const ssize_t bytesWritten = buffer.isEmpty() ? request->flush() : request->write(buffer);
             if (bytesWritten < 0) {
                 errorCode = KIO::ERR_COULD_NOT_WRITE;
                 result = -1;
@@ -1409,6 +1515,7 @@ sftpProtocol::StatusCode sftpProtocol::sftpPut(const KUrl& url, int permissions,
         kDebug(KIO_SFTP_DB) << "Error during 'put'. Aborting.";
 
         if (file != NULL) {
+            request.reset();
             sftp_close(file);
 
             sftp_attributes attr = sftp_stat(mSftp, dest.constData());
@@ -1429,6 +1536,7 @@ sftpProtocol::StatusCode sftpProtocol::sftpPut(const KUrl& url, int permissions,
         return sftpProtocol::Success;
     }
 
+    request.reset();
     if (sftp_close(file) < 0) {
         kWarning(KIO_SFTP_DB) << "Error when closing file descriptor";
         error(KIO::ERR_COULD_NOT_WRITE, dest_orig);
@@ -1719,6 +1827,12 @@ void sftpProtocol::stat(const KUrl& url)
     const int details = sDetails.isEmpty() ? 2 : sDetails.toInt();
 
     UDSEntry entry;
+    if (cachedUDSEntry(path, entry, details)) {
+        statEntry(entry);
+        finished();
+        return;
+    }
+
     entry.clear();
     if (!createUDSEntry(url.fileName(), path, entry, details)) {
         error(KIO::ERR_DOES_NOT_EXIST, url.prettyUrl());
@@ -1738,6 +1852,13 @@ void sftpProtocol::mimetype(const KUrl& url)
         return;
     }
 
+    UDSEntry entry;
+    if (cachedUDSEntry(url.path().toUtf8(), entry, 0) && entry.isDir()) {
+        mimeType(QLatin1String("inode/directory"));
+        finished();
+        return;
+    }
+
     // open() feeds the mimetype
     open(url, QIODevice::ReadOnly);
     close();
@@ -1788,101 +1909,98 @@ void sftpProtocol::listDir(const KUrl& url)
     sftp_attributes dirent = NULL;
     const QString sDetails = metaData(QLatin1String("details"));
     const int details = sDetails.isEmpty() ? 2 : sDetails.toInt();
+    const QByteArray dirPath = path.endsWith('/') ? path : path + '/';
     UDSEntry entry;
 
+    // Resolving symlinks needs extra round trips, so they are
+    // resolved after all other entries have been sent
+    QList<sftp_attributes> symlinks;
+
+    clearEntryCache();
+    mEntryCacheDetails = details;
+    mEntryCacheTime.start();
+
     kDebug(KIO_SFTP_DB) << "readdir: " << path << ", details: " << QString::number(details);
 
     for (;;) {
-        mode_t access;
-        mode_t type;
-        char *link;
-
         dirent = sftp_readdir(mSftp, dp);
         if (dirent == NULL) {
             break;
         }
 
-        entry.clear();
-        entry.insert(KIO::UDSEntry::UDS_NAME, QFile::decodeName(dirent->name));
-
         if (dirent->type == SSH_FILEXFER_TYPE_SYMLINK) {
-            QByteArray file = path + '/' + QFile::decodeName(dirent->name).toUtf8();
-
-            entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFREG);
-
-            link = sftp_readlink(mSftp, file.constData());
-            if (link == NULL) {
-                sftp_attributes_free(dirent);
-                error(KIO::ERR_INTERNAL, i18n("Could not read link: %1", QString::fromUtf8(file)));
-                return;
-            }
-            entry.insert(KIO::UDSEntry::UDS_LINK_DEST, QFile::decodeName(link));
-            delete link;
-            // A symlink -> follow it only if details > 1
-            if (details > 1) {
-                sftp_attributes sb = sftp_stat(mSftp, file.constData());
-                if (sb == NULL) {
-                    // It is a link pointing to nowhere
-                    type = S_IFMT - 1;
-                    access = S_IRWXU | S_IRWXG | S_IRWXO;
-                    entry.insert( KIO::UDSEntry::UDS_FILE_TYPE, type);
-                    entry.insert( KIO::UDSEntry::UDS_ACCESS, access);
-                    entry.insert( KIO::UDSEntry::UDS_SIZE, 0LL );
-
-                    goto notype;
-                }
-                sftp_attributes_free(dirent);
-                dirent = sb;
-            }
+            symlinks.append(dirent);
+            continue;
         }
 
-        switch (dirent->type) {
-            case SSH_FILEXFER_TYPE_REGULAR: {
-                entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFREG);
-                break;
-            }
-            case SSH_FILEXFER_TYPE_DIRECTORY: {
-                entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFDIR);
-                break;
-            }
-            case SSH_FILEXFER_TYPE_SYMLINK: {
-                entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFLNK);
-                break;
-            }
-            case SSH_FILEXFER_TYPE_SPECIAL:
-            case SSH_FILEXFER_TYPE_UNKNOWN: {
-                break;
-            }
-        }
+        const QString name = QFile::decodeName(dirent->name);
+        entry.clear();
+        entry.insert(KIO::UDSEntry::UDS_NAME, name);
+        insertAttributes(entry, dirent, details);
 
-        access = dirent->permissions & 07777;
-        entry.insert(KIO::UDSEntry::UDS_ACCESS, access);
+        mEntryCache.insert(dirPath + name.toUtf8(), entry);
+        sftp_attributes_free(dirent);
+        listEntry(entry, false);
+    } // for ever
+    sftp_closedir(dp);
 
-        entry.insert(KIO::UDSEntry::UDS_SIZE, dirent->size);
+    // Several links often point to the same file, it is only stat'ed once
+    QHash<QString, UDSEntry> linkTargets;
 
-notype:
-        if (details > 0) {
-            if (dirent->owner) {
-                entry.insert(KIO::UDSEntry::UDS_USER, QString::fromUtf8(dirent->owner));
-            } else {
-                entry.insert(KIO::UDSEntry::UDS_USER, QString::number(dirent->uid));
+    while (!symlinks.isEmpty()) {
+        dirent = symlinks.takeFirst();
+        const QString name = QFile::decodeName(dirent->name);
+        const QByteArray file = dirPath + name.toUtf8();
+
+        char *link = sftp_readlink(mSftp, file.constData());
+        if (link == NULL) {
+            sftp_attributes_free(dirent);
+            foreach (sftp_attributes sb, symlinks) {
+                sftp_attributes_free(sb);
             }
+            error(KIO::ERR_INTERNAL, i18n("Could not read link: %1", QString::fromUtf8(file)));
+            return;
+        }
+        const QString linkDest = QFile::decodeName(link);
+        delete link;
 
-            if (dirent->group) {
-                entry.insert(KIO::UDSEntry::UDS_GROUP, QString::fromUtf8(dirent->group));
+        entry.clear();
+        // A symlink -> follow it only if details > 1
+        if (details > 1) {
+            const QString target = QDir::cleanPath(QDir::isAbsolutePath(linkDest) ?
+                                                   linkDest : QString::fromUtf8(dirPath) + linkDest);
+            const QByteArray target_c = target.toUtf8();
+            QHash<QByteArray, UDSEntry>::const_iterator cached = mEntryCache.constFind(target_c);
+            if (cached != mEntryCache.constEnd() && !cached.value().isLink()) {
+                // The link points to a file of this directory
+                entry = cached.value();
+            } else if (linkTargets.contains(target)) {
+                entry = linkTargets.value(target);
             } else {
-                entry.insert(KIO::UDSEntry::UDS_GROUP, QString::number(dirent->gid));
+                sftp_attributes sb = sftp_stat(mSftp, file.constData());
+                if (sb == NULL) {
+                    // It is a link pointing to nowhere
+                    insertAttributes(entry, dirent, details);
+                    entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFMT - 1);
+                    entry.insert(KIO::UDSEntry::UDS_ACCESS, S_IRWXU | S_IRWXG | S_IRWXO);
+                    entry.insert(KIO::UDSEntry::UDS_SIZE, 0LL);
+                } else {
+                    insertAttributes(entry, sb, details);
+                    sftp_attributes_free(sb);
+                    linkTargets.insert(target, entry);
+                }
             }
-
-            entry.insert(KIO::UDSEntry::UDS_ACCESS_TIME, dirent->atime);
-            entry.insert(KIO::UDSEntry::UDS_MODIFICATION_TIME, dirent->mtime);
-            entry.insert(KIO::UDSEntry::UDS_CREATION_TIME, dirent->createtime);
+        } else {
+            insertAttributes(entry, dirent, details);
         }
+        entry.insert(KIO::UDSEntry::UDS_NAME, name);
+        entry.insert(KIO::UDSEntry::UDS_LINK_DEST, linkDest);
 
+        mEntryCache.insert(file, entry);
         sftp_attributes_free(dirent);
         listEntry(entry, false);
-    } // for ever
-    sftp_closedir(dp);
+    }
+
     listEntry(entry, true); // ready
 
     finished();
@@ -1892,6 +2010,8 @@ void sftpProtocol::mkdir(const KUrl &url, int permissions)
 {
     kDebug(KIO_SFTP_DB) << "create directory: " << url;
 
+    clearEntryCache();
+
     if (!sftpLogin()) {
         return;
     }
@@ -1942,6 +2062,8 @@ void sftpProtocol::rename(const KUrl& src, const KUrl& dest, KIO::JobFlags flags
 {
     kDebug(KIO_SFTP_DB) << "rename " << src << " to " << dest << flags;
 
+    clearEntryCache();
+
     if (!sftpLogin()) {
         return;
     }
@@ -1990,6 +2112,8 @@ void sftpProtocol::symlink(const QString &target, const KUrl &dest, KIO::JobFlag
                         << ", overwrite = " << (flags & KIO::Overwrite)
                         << ", resume = " << (flags & KIO::Resume);
 
+    clearEntryCache();
+
     if (!sftpLogin()) {
         return;
     }
@@ -2028,6 +2152,8 @@ void sftpProtocol::chmod(const KUrl& url, int permissions)
 {
     kDebug(KIO_SFTP_DB) << "change permission of " << url << " to " << QString::number(permissions);
 
+    clearEntryCache();
+
     if (!sftpLogin()) {
         return;
     }
@@ -2046,6 +2172,8 @@ void sftpProtocol::del(const KUrl &url, bool isfile)
 {
     kDebug(KIO_SFTP_DB) << "deleting " << (isfile ? "file: " : "directory: ") << url;
 
+    clearEntryCache();
+
     if (!sftpLogin()) {
         return;
     }
@@ -30,8 +30,14 @@
 #include <libssh/sftp.h>
 #include <libssh/callbacks.h>
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
 #include <QtCore/QQueue>
 
+// How big should each data packet be? Definitely not bigger than 64kb or
+// you will overflow the 2 byte size variable in a sftp packet.
+#define MAX_XFER_BUF_SIZE (60 * 1024)
+
 namespace KIO {
   class AuthInfo;
 }
@@ -67,6 +73,53 @@ public:
   void log_callback(int priority, const char *function, const char *buffer,
                     void *userdata);
 
+  /**
+   * PutRequest writes a file with several SFTP write requests in flight.
+   * Every write request has to wait for the reply of the server, so writing
+   * one chunk after another limits the transfer speed to one chunk per round trip.
+   */
+  class PutRequest {
+  public:
+    /**
+     * Creates a new PutRequest object.
+     * @param file the sftp_file object which should be written.
+     * @param chunkSize the maximum size of a single write request.
+     * @param maxPendingRequests the maximum number of requests in flight.
+     */
+    PutRequest(sftp_file file, size_t chunkSize, ushort maxPendingRequests);
+    /**
+     * Waits for the pending requests, the file is not closed.
+     */
+    ~PutRequest();
+
+    /**
+     * Splits data into chunks and starts writing them. If too many requests
+     * are pending, waits for the oldest ones first.
+     * @return the number of bytes confirmed by the server or -1 on error.
+     */
+    ssize_t write(const QByteArray &data);
+    /**
+     * Waits for all pending requests.
+     * @return the number of bytes confirmed by the server or -1 on error.
+     */
+    ssize_t flush();
+  private:
+    ssize_t waitForRequest();
+  private:
+    sftp_file mFile;
+    size_t mChunkSize;
+    ushort mMaxPendingRequests;
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+    QQueue<sftp_aio> pendingRequests;
+#endif
+  };
+
+  /**
+   * The size of the write requests of a PutRequest for sftp, at most
+   * MAX_XFER_BUF_SIZE and not more than the server accepts.
+   */
+  static size_t maxWriteLength(sftp_session sftp);
+
 private: // Private variables
   /** True if ioslave is connected to sftp server. */
   bool mConnected;
@@ -115,6 +168,17 @@ private: // Private variables
    */
   KIO::AuthInfo* mPublicKeyAuthInfo;
 
+  /**
+   * Entries of the last listed directory by path. The stat() and mimetype()
+   * calls which usually follow a listing use them instead of asking the
+   * server again. Any change on the server clears the cache.
+   */
+  QHash<QByteArray, KIO::UDSEntry> mEntryCache;
+  /** The details level of the cached entries */
+  int mEntryCacheDetails;
+  /** Time since the cached directory was listed */
+  QElapsedTimer mEntryCacheTime;
+
   /**
    * GetRequest encapsulates several SFTP get requests into a single object.
    * As SFTP messages are limited to MAX_XFER_BUF_SIZE several requests
@@ -177,6 +241,8 @@ private: // private methods
 
   bool createUDSEntry(const QString &filename, const QByteArray &path,
                       KIO::UDSEntry &entry, short int details);
+  bool cachedUDSEntry(const QByteArray &path, KIO::UDSEntry &entry, int details);
+  void clearEntryCache();
 
   QString canonicalizePath(const QString &path);
   void requiresUserNameRedirection();
@@ -0,0 +1,116 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License (LGPL) as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "kio_sftp.h"
+
+sftpProtocol::PutRequest::PutRequest(sftp_file file, size_t chunkSize, ushort maxPendingRequests)
+    : mFile(file), mChunkSize(chunkSize), mMaxPendingRequests(maxPendingRequests)
+{
+}
+
+ssize_t sftpProtocol::PutRequest::write(const QByteArray &data)
+{
+    const char *buf = data.constData();
+    size_t len = data.size();
+    ssize_t totalWritten = 0;
+
+    while (len > 0) {
+        const size_t chunkSize = qMin(len, mChunkSize);
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+        while (pendingRequests.count() >= mMaxPendingRequests) {
+            const ssize_t written = waitForRequest();
+            if (written < 0) {
+                return -1;
+            }
+            totalWritten += written;
+        }
+
+        sftp_aio aio = NULL;
+        const ssize_t sent = sftp_aio_begin_write(mFile, buf, chunkSize, &aio);
+        if (sent <= 0) {
+            return -1;
+        }
+        pendingRequests.enqueue(aio);
+#else
+        // libssh has no asynchronous writes before 0.11
+        const ssize_t sent = sftp_write(mFile, buf, chunkSize);
+        if (sent <= 0) {
+            return -1;
+        }
+        totalWritten += sent;
+#endif
+        buf += sent;
+        len -= sent;
+    }
+
+    return totalWritten;
+}
+
+ssize_t sftpProtocol::PutRequest::flush()
+{
+    ssize_t totalWritten = 0;
+
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+    while (!pendingRequests.isEmpty()) {
+        const ssize_t written = waitForRequest();
+        if (written < 0) {
+            return -1;
+        }
+        totalWritten += written;
+    }
+#endif
+
+    return totalWritten;
+}
+
+ssize_t sftpProtocol::PutRequest::waitForRequest()
+{
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+    // sftp_aio_wait_write frees the request
+    sftp_aio aio = pendingRequests.dequeue();
+    return sftp_aio_wait_write(&aio);
+#else
+    return 0;
+#endif
+}
+
+sftpProtocol::PutRequest::~PutRequest()
+{
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+    // Wait for pending writes, the server replies to them anyway
+    while (!pendingRequests.isEmpty()) {
+        waitForRequest();
+    }
+#endif
+}
+
+size_t sftpProtocol::maxWriteLength(sftp_session sftp)
+{
+    size_t length = MAX_XFER_BUF_SIZE;
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+    // Asynchronous writes fail if they are larger than the server allows
+    sftp_limits_t limits = sftp_limits(sftp);
+    if (limits) {
+        if (limits->max_write_length > 0 && limits->max_write_length < length) {
+            length = limits->max_write_length;
+        }
+        sftp_limits_free(limits);
+    }
+#endif
+    return length;
+}
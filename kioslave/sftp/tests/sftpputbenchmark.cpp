@@ -0,0 +1,296 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License (LGPL) as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Measures the upload throughput of sftpProtocol::PutRequest with different
+ * numbers of pending write requests at different round trip times. One
+ * pending request is the same as the blocking writes kio_sftp used before.
+ *
+ * The benchmark needs a sshd on the local machine which accepts the
+ * public key of the current user (e.g. from ssh-agent). The latency is
+ * simulated by a proxy between libssh and the sshd, which delays the
+ * data in both directions.
+ *
+ * Environment variables:
+ *   SFTP_BENCHMARK_PORT  port of the sshd, default 22
+ *   SFTP_BENCHMARK_DIR   remote directory for the test file, default /tmp
+ */
+
+#include "kio_sftp.h"
+
+#include <qtest_kde.h>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QQueue>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+
+#include <fcntl.h>
+
+namespace {
+    const int UploadSize = 8 * 1024 * 1024;
+}
+
+/**
+ * Forwards one TCP connection to the sshd, delaying the data by half
+ * of the round trip time in each direction.
+ */
+class LatencyForwarder : public QObject
+{
+    Q_OBJECT
+
+public:
+    LatencyForwarder(QTcpServer *server, quint16 targetPort, int latency);
+
+private slots:
+    void newConnection();
+    void readClient();
+    void readTarget();
+    void deliver();
+
+private:
+    void enqueue(QTcpSocket *to, const QByteArray &data);
+
+    struct Packet {
+        QTcpSocket *to;
+        QByteArray data;
+        qint64 due;
+    };
+
+    QTcpServer *m_server;
+    quint16 m_targetPort;
+    int m_delay;
+    QTcpSocket *m_client;
+    QTcpSocket *m_target;
+    QQueue<Packet> m_packets;
+    QElapsedTimer m_clock;
+    QTimer m_timer;
+};
+
+LatencyForwarder::LatencyForwarder(QTcpServer *server, quint16 targetPort, int latency)
+    : m_server(server), m_targetPort(targetPort), m_delay(latency / 2), m_client(0), m_target(0)
+{
+    m_clock.start();
+    m_timer.setSingleShot(true);
+    connect(&m_timer, SIGNAL(timeout()), SLOT(deliver()));
+    connect(m_server, SIGNAL(newConnection()), SLOT(newConnection()));
+}
+
+void LatencyForwarder::newConnection()
+{
+    m_client = m_server->nextPendingConnection();
+    m_target = new QTcpSocket(this);
+    m_target->connectToHost(QHostAddress::LocalHost, m_targetPort);
+    connect(m_client, SIGNAL(readyRead()), SLOT(readClient()));
+    connect(m_target, SIGNAL(readyRead()), SLOT(readTarget()));
+}
+
+void LatencyForwarder::readClient()
+{
+    enqueue(m_target, m_client->readAll());
+}
+
+void LatencyForwarder::readTarget()
+{
+    enqueue(m_client, m_target->readAll());
+}
+
+void LatencyForwarder::enqueue(QTcpSocket *to, const QByteArray &data)
+{
+    Packet packet;
+    packet.to = to;
+    packet.data = data;
+    packet.due = m_clock.elapsed() + m_delay;
+    m_packets.enqueue(packet);
+    if (!m_timer.isActive()) {
+        deliver();
+    }
+}
+
+void LatencyForwarder::deliver()
+{
+    // All packets have the same delay, so they are due in the order they arrived
+    const qint64 now = m_clock.elapsed();
+    while (!m_packets.isEmpty() && m_packets.head().due <= now) {
+        const Packet packet = m_packets.dequeue();
+        packet.to->write(packet.data);
+    }
+    if (!m_packets.isEmpty()) {
+        m_timer.start(m_packets.head().due - now);
+    }
+}
+
+class LatencyProxy : public QThread
+{
+public:
+    LatencyProxy(quint16 targetPort, int latency)
+        : m_targetPort(targetPort), m_latency(latency), m_port(0)
+    {
+    }
+
+    /**
+     * Starts the proxy and returns the port it is listening on.
+     */
+    quint16 listen()
+    {
+        start();
+        m_ready.acquire();
+        return m_port;
+    }
+
+protected:
+    virtual void run()
+    {
+        QTcpServer server;
+        server.listen(QHostAddress::LocalHost);
+        LatencyForwarder forwarder(&server, m_targetPort, m_latency);
+        m_port = server.serverPort();
+        m_ready.release();
+        exec();
+    }
+
+private:
+    quint16 m_targetPort;
+    int m_latency;
+    quint16 m_port;
+    QSemaphore m_ready;
+};
+
+class SftpPutBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void benchmarkPut_data();
+    void benchmarkPut();
+
+private:
+    bool upload(sftp_file file, size_t chunkSize, const QByteArray &data, int pendingWrites);
+
+    quint16 m_sshdPort;
+    QByteArray m_remoteDir;
+};
+
+void SftpPutBenchmark::initTestCase()
+{
+    m_sshdPort = qgetenv("SFTP_BENCHMARK_PORT").isEmpty() ? 22 : qgetenv("SFTP_BENCHMARK_PORT").toUShort();
+    m_remoteDir = qgetenv("SFTP_BENCHMARK_DIR").isEmpty() ? QByteArray("/tmp") : qgetenv("SFTP_BENCHMARK_DIR");
+}
+
+void SftpPutBenchmark::benchmarkPut_data()
+{
+    QTest::addColumn<int>("latency");
+    QTest::addColumn<int>("pendingWrites");
+
+    const int latencies[] = { 0, 20, 100 };
+    const int pendingWrites[] = { 1, 4, 16, 64 };
+    for (uint i = 0; i < sizeof(latencies) / sizeof(latencies[0]); ++i) {
+        for (uint j = 0; j < sizeof(pendingWrites) / sizeof(pendingWrites[0]); ++j) {
+            const QByteArray name = QByteArray::number(latencies[i]) + "ms/"
+                                  + QByteArray::number(pendingWrites[j]) + " pending";
+            QTest::newRow(name.constData()) << latencies[i] << pendingWrites[j];
+        }
+    }
+}
+
+void SftpPutBenchmark::benchmarkPut()
+{
+    QFETCH(int, latency);
+    QFETCH(int, pendingWrites);
+
+#if LIBSSH_VERSION_INT < SSH_VERSION_INT(0, 11, 0)
+    if (pendingWrites > 1) {
+        QSKIP("libssh has no asynchronous writes before 0.11", SkipSingle);
+    }
+#endif
+
+    LatencyProxy proxy(m_sshdPort, latency);
+    unsigned int port = proxy.listen();
+
+    ssh_session session = ssh_new();
+    ssh_options_set(session, SSH_OPTIONS_HOST, "127.0.0.1");
+    ssh_options_set(session, SSH_OPTIONS_PORT, &port);
+    if (ssh_connect(session) != SSH_OK
+        || ssh_userauth_publickey_auto(session, NULL, NULL) != SSH_AUTH_SUCCESS) {
+        ssh_free(session);
+        proxy.quit();
+        proxy.wait();
+        QSKIP("Could not log into the local sshd", SkipAll);
+    }
+    sftp_session sftp = sftp_new(session);
+    QVERIFY(sftp);
+    QCOMPARE(sftp_init(sftp), SSH_OK);
+
+    // Same as kio_sftp, the chunks must not be larger than the server allows
+    const size_t chunkSize = sftpProtocol::maxWriteLength(sftp);
+    const QByteArray path = m_remoteDir + "/sftpputbenchmark.tmp";
+    const QByteArray data(UploadSize, 'x');
+    QElapsedTimer timer;
+    bool ok = false;
+
+    QBENCHMARK_ONCE {
+        timer.start();
+        sftp_file file = sftp_open(sftp, path.constData(), O_CREAT | O_TRUNC | O_WRONLY, 0600);
+        if (file) {
+            ok = upload(file, chunkSize, data, pendingWrites);
+            ok = sftp_close(file) == SSH_OK && ok;
+        }
+    }
+    const qint64 elapsed = qMax<qint64>(timer.elapsed(), 1);
+
+    sftp_unlink(sftp, path.constData());
+    sftp_free(sftp);
+    ssh_disconnect(session);
+    ssh_free(session);
+    proxy.quit();
+    proxy.wait();
+
+    QVERIFY(ok);
+    qDebug() << latency << "ms," << pendingWrites << "pending," << chunkSize << "bytes per request:"
+             << (UploadSize / 1024.0) / elapsed * 1000 / 1024 << "MB/s";
+}
+
+bool SftpPutBenchmark::upload(sftp_file file, size_t chunkSize, const QByteArray &data, int pendingWrites)
+{
+    sftpProtocol::PutRequest request(file, chunkSize, pendingWrites);
+    ssize_t totalWritten = 0;
+
+    // kio_sftp gets the data of a local file in blocks of MAX_XFER_BUF_SIZE
+    for (int offset = 0; offset < data.size(); offset += MAX_XFER_BUF_SIZE) {
+        const ssize_t written = request.write(data.mid(offset, MAX_XFER_BUF_SIZE));
+        if (written < 0) {
+            return false;
+        }
+        totalWritten += written;
+    }
+    const ssize_t written = request.flush();
+    if (written < 0) {
+        return false;
+    }
+    totalWritten += written;
+    return totalWritten == data.size();
+}
+
+QTEST_KDEMAIN_CORE(SftpPutBenchmark)
+
+#include "sftpputbenchmark.moc"
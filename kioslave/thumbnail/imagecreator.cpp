@@ -20,8 +20,11 @@
 #include "imagecreatorsettings.h"
 
 #include <QImage>
+#include <QImageReader>
 #include <QCheckBox>
+#include <QMutex>
 #include <kdemacros.h>
+#include <kglobal.h>
 #include <klocale.h>
 #include <kexiv2.h>
 
@@ -33,12 +36,22 @@ extern "C"
     }
 }
 
+// Exiv2 is not thread-safe, but the creator may be used by several workers of the thumbnail slave at
+// once, so all KExiv2 calls are serialized. Decoding the image is not.
+K_GLOBAL_STATIC(QMutex, s_exiv2Mutex)
+
 ImageCreator::ImageCreator()
 {
+    // the creator may be used by the workers of the thumbnail slave, read the
+    // settings in the thread which creates it
+    ImageCreatorSettings::self();
 }
 
 bool ImageCreator::create(const QString &path, int width, int height, QImage &img)
 {
+    // exiv is destroyed before locker, so the lock is held while it is destroyed
+    QMutexLocker locker(s_exiv2Mutex);
+
     // use preview from Exiv2 metadata if possible
     KExiv2 exiv(path);
     img = exiv.preview();
@@ -50,19 +63,39 @@ bool ImageCreator::create(const QString &path, int width, int height, QImage &im
     }
 
     // create image preview otherwise
-    if (img.isNull() && !img.load(path)) {
-        return false;
+    if (img.isNull()) {
+        locker.unlock();
+        const bool loaded = load(path, width, height, img);
+        locker.relock();
+        if (!loaded) {
+            return false;
+        }
     }
 
-    ImageCreatorSettings* settings = ImageCreatorSettings::self();
-    settings->readConfig();
-    if (settings->rotate()) {
+    // the settings have been read by the constructor, the creator lives as long as the slave so
+    // there is no need to read them for every thumbnail
+    if (ImageCreatorSettings::rotate()) {
         exiv.rotateImage(img);
     }
 
     return true;
 }
 
+bool ImageCreator::load(const QString &path, int width, int height, QImage &img)
+{
+    QImageReader reader(path);
+    const QSize size = reader.size();
+    // the image might be rotated later, so it has to cover the requested size in both
+    // orientations
+    const int maxSize = qMax(width, height);
+    if (size.isValid() && (size.width() > maxSize || size.height() > maxSize)) {
+        // decode just as large as needed, the JPEG decoder for example skips most of the work by
+        // scaling while decoding
+        reader.setScaledSize(size.scaled(maxSize, maxSize, Qt::KeepAspectRatio));
+    }
+    return reader.read(&img);
+}
+
 ThumbCreator::Flags ImageCreator::flags() const
 {
     return ThumbCreator::None;
@@ -30,6 +30,12 @@ public:
     ThumbCreator::Flags flags() const final;
     QWidget *createConfigurationWidget() final;
     void writeConfiguration(const QWidget *configurationWidget) final;
+
+    /**
+     * Loads the image at @p path, scaled down while decoding to fit into a square of
+     * max(@p width, @p height) if the image is larger.
+     */
+    static bool load(const QString &path, int width, int height, QImage &img);
 };
 
 #endif // IMAGECREATOR_H
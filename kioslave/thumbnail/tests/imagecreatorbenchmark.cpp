@@ -0,0 +1,147 @@
+/*  This file is part of the KDE project
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License version 2, as published by the Free Software Foundation.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include "imagecreator.h"
+
+#include <QDir>
+#include <QImage>
+#include <QImageWriter>
+#include <QPainter>
+#include <QLinearGradient>
+#include <ktempdir.h>
+#include <qtest_kde.h>
+
+// Thumbnails a directory of large JPEG files, like Dolphin does when browsing a folder of photos.
+// The directory can be given with the THUMBNAIL_BENCHMARK_DIR environment variable, otherwise a
+// few 24 megapixel images are created.
+class ImageCreatorBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkFullDecode_data();
+    void benchmarkFullDecode();
+    void benchmarkCreate_data();
+    void benchmarkCreate();
+
+private:
+    void addSizes();
+    static void scaleDownImage(QImage &img, int maxWidth, int maxHeight);
+
+    KTempDir *m_tempDir;
+    QStringList m_files;
+};
+
+void ImageCreatorBenchmark::initTestCase()
+{
+    m_tempDir = 0;
+    QString path = QString::fromLocal8Bit(qgetenv("THUMBNAIL_BENCHMARK_DIR"));
+    if (path.isEmpty()) {
+        if (!QImageWriter::supportedImageFormats().contains("jpeg")) {
+            QSKIP("No JPEG support", SkipAll);
+        }
+        m_tempDir = new KTempDir();
+        path = m_tempDir->name();
+        for (int i = 0; i < 4; ++i) {
+            QImage image(6000, 4000, QImage::Format_RGB32);
+            QPainter painter(&image);
+            QLinearGradient gradient(0, 0, image.width(), image.height());
+            gradient.setColorAt(0, QColor::fromHsv(i * 80, 255, 255));
+            gradient.setColorAt(1, QColor::fromHsv(i * 80 + 40, 128, 64));
+            painter.fillRect(image.rect(), gradient);
+            for (int j = 0; j < 200; ++j) {
+                painter.setPen(QColor::fromHsv((i * 80 + j * 7) % 360, 200, 200));
+                painter.drawEllipse(QPoint((j * 389) % image.width(), (j * 211) % image.height()), 50 + j, 30 + j);
+            }
+            painter.end();
+            QVERIFY(image.save(path + QString("image%1.jpg").arg(i), "JPEG", 90));
+        }
+    }
+
+    const QDir dir(path);
+    foreach (const QString &file, dir.entryList(QStringList() << "*.jpg" << "*.jpeg" << "*.JPG" << "*.JPEG", QDir::Files)) {
+        m_files.append(dir.absoluteFilePath(file));
+    }
+    if (m_files.isEmpty()) {
+        QSKIP("No JPEG files to thumbnail", SkipAll);
+    }
+}
+
+void ImageCreatorBenchmark::cleanupTestCase()
+{
+    delete m_tempDir;
+}
+
+void ImageCreatorBenchmark::addSizes()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("128") << 128;
+    QTest::newRow("256") << 256;
+}
+
+void ImageCreatorBenchmark::scaleDownImage(QImage &img, int maxWidth, int maxHeight)
+{
+    // same as ThumbnailProtocol::scaleDownImage()
+    if (img.width() > maxWidth || img.height() > maxHeight) {
+        img = img.scaled(maxWidth, maxHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+}
+
+void ImageCreatorBenchmark::benchmarkFullDecode_data()
+{
+    addSizes();
+}
+
+void ImageCreatorBenchmark::benchmarkFullDecode()
+{
+    // the way thumbnails were created before
+    QFETCH(int, size);
+    QBENCHMARK {
+        foreach (const QString &file, m_files) {
+            QImage img;
+            QVERIFY(img.load(file));
+            scaleDownImage(img, size, size);
+        }
+    }
+}
+
+void ImageCreatorBenchmark::benchmarkCreate_data()
+{
+    addSizes();
+}
+
+void ImageCreatorBenchmark::benchmarkCreate()
+{
+    QFETCH(int, size);
+    ImageCreator creator;
+    QBENCHMARK {
+        foreach (const QString &file, m_files) {
+            QImage img;
+            QVERIFY(creator.create(file, size, size, img));
+            scaleDownImage(img, size, size);
+            QVERIFY(img.width() == size || img.height() == size);
+        }
+    }
+}
+
+QTEST_KDEMAIN(ImageCreatorBenchmark, GUI)
+
+#include "imagecreatorbenchmark.moc"
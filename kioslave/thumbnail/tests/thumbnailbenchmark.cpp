@@ -0,0 +1,194 @@
+/*  This file is part of the KDE project
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License version 2, as published by the Free Software Foundation.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QImageWriter>
+#include <QPainter>
+#include <kio/job.h>
+#include <kmimetype.h>
+#include <kprotocolinfo.h>
+#include <ktempdir.h>
+#include <qtest_kde.h>
+
+// Compares requesting the thumbnails of a folder one file per job, like
+// KIO::PreviewJob does, with batched requests to the installed kio_thumbnail.
+// The directory can be given with the THUMBNAIL_BENCHMARK_DIR environment
+// variable, otherwise THUMBNAIL_BENCHMARK_COUNT (10000 by default) images are
+// created.
+class ThumbnailBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkSingle();
+    void benchmarkBatch_data();
+    void benchmarkBatch();
+
+    void slotData(KIO::Job *job, const QByteArray &data);
+
+private:
+    KIO::TransferJob* createJob(const QString &path);
+    void report(qint64 elapsed);
+
+    KTempDir *m_tempDir;
+    QStringList m_files;
+    QStringList m_mimeTypes;
+    bool m_batched;
+    int m_created;
+};
+
+void ThumbnailBenchmark::initTestCase()
+{
+    m_tempDir = 0;
+    if (!KProtocolInfo::isKnownProtocol(QString("thumbnail"))) {
+        QSKIP("kio_thumbnail is not installed", SkipAll);
+    }
+
+    QString path = QString::fromLocal8Bit(qgetenv("THUMBNAIL_BENCHMARK_DIR"));
+    if (path.isEmpty()) {
+        if (!QImageWriter::supportedImageFormats().contains("jpeg")) {
+            QSKIP("No JPEG support", SkipAll);
+        }
+        int count = qgetenv("THUMBNAIL_BENCHMARK_COUNT").toInt();
+        if (count <= 0) {
+            count = 10000;
+        }
+        m_tempDir = new KTempDir();
+        path = m_tempDir->name();
+        QImage image(1024, 768, QImage::Format_RGB32);
+        for (int i = 0; i < count; ++i) {
+            image.fill(QColor::fromHsv(i % 360, 200, 200).rgb());
+            QPainter painter(&image);
+            painter.drawText(image.rect(), Qt::AlignCenter, QString::number(i));
+            painter.end();
+            QVERIFY(image.save(path + QString("image%1.jpg").arg(i), "JPEG", 90));
+        }
+    }
+
+    const QDir dir(path);
+    foreach (const QString &file, dir.entryList(QDir::Files, QDir::Name)) {
+        const QString filePath = dir.absoluteFilePath(file);
+        const QString mimeType = KMimeType::findByPath(filePath)->name();
+        if (mimeType.startsWith(QLatin1String("image/"))) {
+            m_files.append(filePath);
+            m_mimeTypes.append(mimeType);
+        }
+    }
+    if (m_files.isEmpty()) {
+        QSKIP("No images to thumbnail", SkipAll);
+    }
+}
+
+void ThumbnailBenchmark::cleanupTestCase()
+{
+    delete m_tempDir;
+}
+
+KIO::TransferJob* ThumbnailBenchmark::createJob(const QString &path)
+{
+    // same metadata as KIO::PreviewJob
+    KUrl url;
+    url.setProtocol("thumbnail");
+    url.setPath(path);
+    KIO::TransferJob *job = KIO::get(url, KIO::NoReload, KIO::HideProgressInfo);
+    job->addMetaData("width", "256");
+    job->addMetaData("height", "256");
+    job->addMetaData("iconSize", "48");
+    job->addMetaData("iconAlpha", "125");
+    connect(job, SIGNAL(data(KIO::Job*,QByteArray)), SLOT(slotData(KIO::Job*,QByteArray)));
+    return job;
+}
+
+void ThumbnailBenchmark::slotData(KIO::Job *job, const QByteArray &data)
+{
+    Q_UNUSED(job);
+    QDataStream stream(data);
+    if (m_batched) {
+        qint32 index;
+        stream >> index;
+    }
+    QImage img;
+    stream >> img;
+    if (!img.isNull()) {
+        ++m_created;
+    }
+}
+
+void ThumbnailBenchmark::report(qint64 elapsed)
+{
+    QCOMPARE(m_created, m_files.count());
+    qDebug() << m_created << "thumbnails," << m_created * 1000.0 / qMax<qint64>(elapsed, 1) << "per second";
+}
+
+void ThumbnailBenchmark::benchmarkSingle()
+{
+    m_batched = false;
+    m_created = 0;
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE {
+        timer.start();
+        for (int i = 0; i < m_files.count(); ++i) {
+            KIO::TransferJob *job = createJob(m_files.at(i));
+            job->addMetaData("mimeType", m_mimeTypes.at(i));
+            job->addMetaData("plugin", "imagethumbnail");
+            job->exec();
+        }
+    }
+    report(timer.elapsed());
+}
+
+void ThumbnailBenchmark::benchmarkBatch_data()
+{
+    QTest::addColumn<int>("batchSize");
+
+    QTest::newRow("50") << 50;
+    QTest::newRow("200") << 200;
+    QTest::newRow("1000") << 1000;
+}
+
+void ThumbnailBenchmark::benchmarkBatch()
+{
+    QFETCH(int, batchSize);
+    m_batched = true;
+    m_created = 0;
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE {
+        timer.start();
+        for (int i = 0; i < m_files.count(); i += batchSize) {
+            const int count = qMin(batchSize, m_files.count() - i);
+            QByteArray batch;
+            QDataStream stream(&batch, QIODevice::WriteOnly);
+            stream << qint32(count);
+            for (int j = i; j < i + count; ++j) {
+                stream << m_files.at(j) << m_mimeTypes.at(j) << QString("imagethumbnail");
+            }
+            KIO::TransferJob *job = createJob(QString("/"));
+            job->addMetaData("batch", QString::fromLatin1(batch.toBase64()));
+            job->exec();
+        }
+    }
+    report(timer.elapsed());
+}
+
+QTEST_KDEMAIN(ThumbnailBenchmark, GUI)
+
+#include "thumbnailbenchmark.moc"
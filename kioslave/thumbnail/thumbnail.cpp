@@ -19,6 +19,7 @@
 */
 
 #include "thumbnail.h"
+#include "thumbnailworkers.h"
 #include "config-unix.h" // For HAVE_NICE
 
 #include <QBuffer>
@@ -27,7 +28,6 @@
 #include <QImage>
 #include <QPainter>
 #include <QPixmap>
-#include <QLibrary>
 #include <QDirIterator>
 #include <QImageWriter>
 
@@ -68,6 +68,14 @@
 //                Provided by the application to save an addition KTrader
 //                query here.
 //                The data returned is the image in PNG format.
+// batch        - creates the thumbnails of several files at once instead of the
+//                file of the URL. Base64 encoded QDataStream with the number of
+//                files, followed by the path, mime type and plugin of each file.
+//                width, height, iconSize and iconAlpha apply to all of them.
+//                The thumbnails are created by a pool of threads if the plugin
+//                has the ThreadSafe property set, one data() is sent per file
+//                as soon as it has been created: the index of the file in the
+//                batch followed by the image, which is null if it failed.
 
 using namespace KIO;
 
@@ -106,23 +114,26 @@ int main(int argc, char **argv)
 ThumbnailProtocol::ThumbnailProtocol(const QByteArray &app)
     : SlaveBase("thumbnail", app),
       m_iconSize(0),
-      m_maxFileSize(0)
+      m_maxFileSize(0),
+      m_workers(0)
 {
 
 }
 
 ThumbnailProtocol::~ThumbnailProtocol()
 {
+    delete m_workers;
     qDeleteAll( m_creators );
     m_creators.clear();
 }
 
 void ThumbnailProtocol::get(const KUrl &url)
 {
+    const QString batch = metaData("batch");
     m_mimeType = metaData("mimeType");
     kDebug(7115) << "Wanting MIME Type:" << m_mimeType;
 
-    if (m_mimeType.isEmpty()) {
+    if (batch.isEmpty() && m_mimeType.isEmpty()) {
         error(KIO::ERR_INTERNAL, i18n("No MIME Type specified."));
         return;
     }
@@ -146,35 +157,67 @@ void ThumbnailProtocol::get(const KUrl &url)
 
     m_iconAlpha = metaData("iconAlpha").toInt();
 
+    if (!batch.isEmpty()) {
+        createThumbnails(batch);
+        return;
+    }
+
     QImage img;
+    QString errorText;
+    if (!createThumbnail(url, metaData("plugin"), img, errorText)) {
+        error(KIO::ERR_INTERNAL, errorText);
+        return;
+    }
+
+    QByteArray imgData;
+    QDataStream stream( &imgData, QIODevice::WriteOnly );
+    //kDebug(7115) << "IMAGE TO STREAM";
+    stream << img;
+    mimeType("application/octet-stream");
+    data(imgData);
+    finished();
+}
+
+bool ThumbnailProtocol::createThumbnail(const KUrl &url, const QString &plugin, QImage &img, QString &errorText)
+{
     ThumbCreator::Flags flags = ThumbCreator::None;
 
-    QString plugin = metaData("plugin");
     if ((plugin.isEmpty() || plugin == "directorythumbnail") && m_mimeType == "inode/directory") {
         img = thumbForDirectory(url);
         if(img.isNull()) {
-            error(KIO::ERR_INTERNAL, i18n("Cannot create thumbnail for directory"));
-            return;
+            errorText = i18n("Cannot create thumbnail for directory");
+            return false;
         }
     } else {
         if (plugin.isEmpty()) {
-            error(KIO::ERR_INTERNAL, i18n("No plugin specified."));
-            return;
+            errorText = i18n("No plugin specified.");
+            return false;
         }
 
         ThumbCreator* creator = getThumbCreator(plugin);
         if(!creator) {
-            error(KIO::ERR_INTERNAL, i18n("Cannot load ThumbCreator %1", plugin));
-            return;
+            errorText = i18n("Cannot load ThumbCreator %1", plugin);
+            return false;
         }
 
         if (!creator->create(url.path(), m_width, m_height, img)) {
-            error(KIO::ERR_INTERNAL, i18n("Cannot create thumbnail for %1", url.path()));
-            return;
+            errorText = i18n("Cannot create thumbnail for %1", url.path());
+            return false;
         }
         flags = creator->flags();
     }
 
+    decorateThumbnail(img, flags);
+
+    if (img.isNull()) {
+        errorText = i18n("Failed to create a thumbnail.");
+        return false;
+    }
+    return true;
+}
+
+void ThumbnailProtocol::decorateThumbnail(QImage &img, ThumbCreator::Flags flags)
+{
     scaleDownImage(img, m_width, m_height);
 
     if (flags & ThumbCreator::DrawFrame) {
@@ -209,21 +252,115 @@ void ThumbnailProtocol::get(const KUrl &url)
             p.drawImage(x, y, icon);
         }
     }
+}
 
-    if (img.isNull()) {
-        error(KIO::ERR_INTERNAL, i18n("Failed to create a thumbnail."));
+void ThumbnailProtocol::createThumbnails(const QString &batch)
+{
+    QList<ThumbnailRequest> requests;
+    const QByteArray batchData = QByteArray::fromBase64(batch.toLatin1());
+    QDataStream stream(batchData);
+    qint32 count = 0;
+    stream >> count;
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        ThumbnailRequest request;
+        request.index = i;
+        request.width = m_width;
+        request.height = m_height;
+        stream >> request.path >> request.mimeType >> request.plugin;
+        requests.append(request);
+    }
+    if (stream.status() != QDataStream::Ok) {
+        error(KIO::ERR_INTERNAL, i18n("Invalid thumbnail batch."));
         return;
     }
 
-    QByteArray imgData;
-    QDataStream stream( &imgData, QIODevice::WriteOnly );
-    //kDebug(7115) << "IMAGE TO STREAM";
-    stream << img;
+    if (!m_workers) {
+        const KService::List plugins = KServiceTypeTrader::self()->query(QLatin1String("ThumbCreator"));
+        foreach (const KService::Ptr &service, plugins) {
+            if (service->property("ThreadSafe", QVariant::Bool).toBool()) {
+                m_threadSafePlugins.insert(service->library());
+            }
+        }
+        m_workers = new ThumbnailWorkers();
+    }
+
+    // Files of the plugins which can be used by several threads are handed to
+    // the workers, the others are created here while the workers are busy
+    QSet<QString> threadedPlugins;
+    foreach (const ThumbnailRequest &request, requests) {
+        if (m_threadSafePlugins.contains(request.plugin) && request.mimeType != "inode/directory") {
+            threadedPlugins.insert(request.plugin);
+        }
+    }
+    foreach (const QString &plugin, threadedPlugins) {
+        if (!m_workers->addCreator(plugin)) {
+            threadedPlugins.remove(plugin);
+        }
+    }
+
+    QList<ThumbnailRequest> mainThreadRequests;
+    foreach (const ThumbnailRequest &request, requests) {
+        if (threadedPlugins.contains(request.plugin) && request.mimeType != "inode/directory") {
+            m_workers->addRequest(request);
+        } else {
+            mainThreadRequests.append(request);
+        }
+    }
+    kDebug(7115) << "Creating" << requests.count() << "thumbnails," << mainThreadRequests.count() << "in the main thread";
+
     mimeType("application/octet-stream");
-    data(imgData);
+
+    ThumbnailRequest result;
+    foreach (ThumbnailRequest request, mainThreadRequests) {
+        if (wasKilled()) {
+            m_workers->cancel();
+            return;
+        }
+        QString errorText;
+        m_mimeType = request.mimeType;
+        if (!createThumbnail(KUrl(request.path), request.plugin, request.image, errorText)) {
+            kDebug(7115) << errorText;
+            request.image = QImage();
+        }
+        sendThumbnail(request.index, request.image);
+
+        // pass on what the workers have finished in the meantime
+        while (m_workers->takeResult(result, false)) {
+            sendResult(result);
+        }
+    }
+
+    while (m_workers->takeResult(result, true)) {
+        if (wasKilled()) {
+            m_workers->cancel();
+            return;
+        }
+        sendResult(result);
+    }
+
     finished();
 }
 
+void ThumbnailProtocol::sendResult(ThumbnailRequest &request)
+{
+    if (request.created) {
+        // the icon overlay depends on the mime type
+        m_mimeType = request.mimeType;
+        decorateThumbnail(request.image, request.flags);
+    } else {
+        request.image = QImage();
+    }
+    sendThumbnail(request.index, request.image);
+}
+
+void ThumbnailProtocol::sendThumbnail(int index, const QImage &img)
+{
+    QByteArray imgData;
+    QDataStream stream(&imgData, QIODevice::WriteOnly);
+    stream << qint32(index) << img;
+    data(imgData);
+}
+
 QString ThumbnailProtocol::pluginForMimeType(const QString& mimeType) {
     KService::List offers = KMimeTypeTrader::self()->query( mimeType, QLatin1String("ThumbCreator"));
     if (!offers.isEmpty()) {
@@ -502,15 +639,7 @@ ThumbCreator* ThumbnailProtocol::getThumbCreator(const QString& plugin)
 {
     ThumbCreator *creator = m_creators[plugin];
     if (!creator) {
-        // Don't use KPluginFactory here, this is not a QObject and
-        // neither is ThumbCreator
-        QLibrary library(plugin);
-        if (library.load()) {
-            newCreator create = (newCreator)library.resolve("new_creator");
-            if (create) {
-                creator = create();
-            }
-        }
+        creator = ThumbnailWorkers::loadCreator(plugin);
         if (!creator) {
             return 0;
         }
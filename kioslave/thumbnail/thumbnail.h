@@ -25,6 +25,7 @@
 #include <QSet>
 
 #include <kio/slavebase.h>
+#include <kio/thumbcreator.h>
 
 // NOTE: keep in sync with:
 // kde-workspace/dolphin/src/settings/general/previewssettingspage.cpp
@@ -35,7 +36,8 @@ enum PreviewDefaults {
     IconAlpha = 125
 };
 
-class ThumbCreator;
+struct ThumbnailRequest;
+class ThumbnailWorkers;
 
 class ThumbnailProtocol : public KIO::SlaveBase
 {
@@ -55,6 +57,25 @@ protected:
     QString pluginForMimeType(const QString& mimeType);
 
 private:
+    /**
+     * Creates the thumbnail of \p url for the current mime type and size,
+     * including its frame and icon overlay.
+     */
+    bool createThumbnail(const KUrl &url, const QString &plugin, QImage &img, QString &errorText);
+
+    /**
+     * Scales down \p img and draws the frame or icon overlay requested by \p flags.
+     */
+    void decorateThumbnail(QImage &img, ThumbCreator::Flags flags);
+
+    /**
+     * Creates the thumbnails for the files of the "batch" metadata entry
+     * and sends each of them as soon as it has been created.
+     */
+    void createThumbnails(const QString &batch);
+    void sendResult(ThumbnailRequest &request);
+    void sendThumbnail(int index, const QImage &img);
+
     /**
      * Creates a sub thumbnail for the directory thumbnail. If a cached
      * version of the sub thumbnail is available, the cached version will be used.
@@ -89,6 +110,9 @@ private:
     QSet<QString> m_propagationDirectories;
     QString m_thumbBasePath;
     qint64 m_maxFileSize;
+    // Plugins whose creators can be used by the workers
+    QSet<QString> m_threadSafePlugins;
+    ThumbnailWorkers *m_workers;
 };
 
 #endif
@@ -0,0 +1,172 @@
+/*  This file is part of the KDE libraries
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include "thumbnailworkers.h"
+
+#include <QLibrary>
+
+#include <kdebug.h>
+
+ThumbnailRequest::ThumbnailRequest()
+    : index(0),
+      width(0),
+      height(0),
+      created(false),
+      flags(ThumbCreator::None)
+{
+}
+
+ThumbnailWorker::ThumbnailWorker(ThumbnailWorkers *workers)
+    : m_workers(workers)
+{
+}
+
+ThumbnailWorker::~ThumbnailWorker()
+{
+    qDeleteAll(m_creators);
+}
+
+void ThumbnailWorker::run()
+{
+    QMutexLocker locker(&m_workers->m_mutex);
+    forever {
+        while (m_workers->m_requests.isEmpty() && !m_workers->m_stop) {
+            m_workers->m_requestAdded.wait(&m_workers->m_mutex);
+        }
+        if (m_workers->m_stop) {
+            return;
+        }
+
+        ThumbnailRequest request = m_workers->m_requests.dequeue();
+        ThumbCreator *creator = m_creators.value(request.plugin);
+        locker.unlock();
+
+        if (creator && creator->create(request.path, request.width, request.height, request.image)) {
+            request.created = true;
+            request.flags = creator->flags();
+            // same as ThumbnailProtocol::scaleDownImage(), the smooth scaling
+            // is expensive enough to be done here
+            if (request.image.width() > request.width || request.image.height() > request.height) {
+                request.image = request.image.scaled(request.width, request.height,
+                                                     Qt::KeepAspectRatio, Qt::SmoothTransformation);
+            }
+        }
+
+        locker.relock();
+        m_workers->m_results.enqueue(request);
+        m_workers->m_resultAdded.wakeAll();
+    }
+}
+
+ThumbnailWorkers::ThumbnailWorkers()
+    : m_pending(0),
+      m_stop(false)
+{
+    const int count = qMax(QThread::idealThreadCount(), 1);
+    for (int i = 0; i < count; ++i) {
+        ThumbnailWorker *thread = new ThumbnailWorker(this);
+        thread->start(QThread::LowPriority);
+        m_threads.append(thread);
+    }
+    kDebug(7115) << "Started" << count << "thumbnail workers";
+}
+
+ThumbnailWorkers::~ThumbnailWorkers()
+{
+    cancel();
+    m_mutex.lock();
+    m_stop = true;
+    m_requestAdded.wakeAll();
+    m_mutex.unlock();
+    foreach (ThumbnailWorker *thread, m_threads) {
+        thread->wait();
+    }
+    qDeleteAll(m_threads);
+}
+
+ThumbCreator* ThumbnailWorkers::loadCreator(const QString &plugin)
+{
+    // Don't use KPluginFactory here, this is not a QObject and
+    // neither is ThumbCreator
+    QLibrary library(plugin);
+    if (library.load()) {
+        newCreator create = (newCreator)library.resolve("new_creator");
+        if (create) {
+            return create();
+        }
+    }
+    return 0;
+}
+
+bool ThumbnailWorkers::addCreator(const QString &plugin)
+{
+    Q_ASSERT(m_pending == 0);
+    foreach (ThumbnailWorker *thread, m_threads) {
+        if (thread->m_creators.contains(plugin)) {
+            continue;
+        }
+        // The creators are created here rather than by the workers, so that
+        // everything they set up in their constructor belongs to the main thread
+        ThumbCreator *creator = loadCreator(plugin);
+        if (!creator) {
+            return false;
+        }
+        thread->m_creators.insert(plugin, creator);
+    }
+    return true;
+}
+
+void ThumbnailWorkers::addRequest(const ThumbnailRequest &request)
+{
+    QMutexLocker locker(&m_mutex);
+    m_requests.enqueue(request);
+    ++m_pending;
+    m_requestAdded.wakeOne();
+}
+
+bool ThumbnailWorkers::hasPendingRequests()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pending > 0;
+}
+
+bool ThumbnailWorkers::takeResult(ThumbnailRequest &result, bool wait)
+{
+    QMutexLocker locker(&m_mutex);
+    while (wait && m_results.isEmpty() && m_pending > 0) {
+        m_resultAdded.wait(&m_mutex);
+    }
+    if (m_results.isEmpty()) {
+        return false;
+    }
+    result = m_results.dequeue();
+    --m_pending;
+    return true;
+}
+
+void ThumbnailWorkers::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    m_pending -= m_requests.count();
+    m_requests.clear();
+    while (m_results.count() < m_pending) {
+        m_resultAdded.wait(&m_mutex);
+    }
+    m_results.clear();
+    m_pending = 0;
+}
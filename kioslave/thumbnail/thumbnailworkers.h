@@ -0,0 +1,129 @@
+/*  This file is part of the KDE libraries
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#ifndef _THUMBNAILWORKERS_H_
+#define _THUMBNAILWORKERS_H_
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QQueue>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+#include <QImage>
+
+#include <kio/thumbcreator.h>
+
+/**
+ * One file of a batched thumbnail request
+ */
+struct ThumbnailRequest
+{
+    ThumbnailRequest();
+
+    // position of the file in the batch, reported back to the client
+    int index;
+    QString path;
+    QString mimeType;
+    QString plugin;
+    int width;
+    int height;
+
+    // set once the thumbnail has been created
+    bool created;
+    QImage image;
+    ThumbCreator::Flags flags;
+};
+
+class ThumbnailWorkers;
+
+class ThumbnailWorker : public QThread
+{
+public:
+    ThumbnailWorker(ThumbnailWorkers *workers);
+    virtual ~ThumbnailWorker();
+
+protected:
+    virtual void run();
+
+private:
+    friend class ThumbnailWorkers;
+
+    ThumbnailWorkers *m_workers;
+    // Each worker has its own creators, ThumbCreator instances are not meant
+    // to be used by several threads at once
+    QHash<QString, ThumbCreator*> m_creators;
+};
+
+/**
+ * Pool of threads creating thumbnails with ThumbCreators which have the
+ * ThreadSafe property set. The decoration of the thumbnails (frame and
+ * icon overlay) needs KIconLoader and is left to the main thread.
+ */
+class ThumbnailWorkers
+{
+public:
+    ThumbnailWorkers();
+    ~ThumbnailWorkers();
+
+    /**
+     * Makes sure that every worker can create thumbnails with @p plugin.
+     * Must only be called while no requests are pending.
+     * @return false if the plugin could not be loaded
+     */
+    bool addCreator(const QString &plugin);
+
+    void addRequest(const ThumbnailRequest &request);
+
+    /**
+     * True if there are requests which have not been taken by takeResult() yet.
+     */
+    bool hasPendingRequests();
+
+    /**
+     * Takes the next finished request. If @p wait is true, it blocks until
+     * a request has been finished.
+     * @return false if there was no finished request
+     */
+    bool takeResult(ThumbnailRequest &result, bool wait);
+
+    /**
+     * Drops all requests which have not been started yet and waits for
+     * the others, without reporting them.
+     */
+    void cancel();
+
+    /**
+     * Loads the ThumbCreator from the plugin library @p plugin.
+     */
+    static ThumbCreator* loadCreator(const QString &plugin);
+
+private:
+    friend class ThumbnailWorker;
+
+    QList<ThumbnailWorker*> m_threads;
+    QMutex m_mutex;
+    QWaitCondition m_requestAdded;
+    QWaitCondition m_resultAdded;
+    QQueue<ThumbnailRequest> m_requests;
+    QQueue<ThumbnailRequest> m_results;
+    // requests added, but not taken yet
+    int m_pending;
+    bool m_stop;
+};
+
+#endif
@@ -21,13 +21,20 @@
 
 #include "discspaceutil.h"
 
-#include <QtCore/QDirIterator>
-#include <QtCore/QFileInfo>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QFile>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
 
 #include <kdiskfreespaceinfo.h>
 #include <kdebug.h>
 #include <kde_file.h>
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 DiscSpaceUtil::DiscSpaceUtil( const QString &directory )
     : mDirectory( directory ),
       mFullSize( 0 )
@@ -35,36 +42,116 @@ DiscSpaceUtil::DiscSpaceUtil( const QString &directory )
     calculateFullSize();
 }
 
-qulonglong DiscSpaceUtil::sizeOfPath( const QString &path )
+// Sums up the sizes in the directory dirfd, which is closed afterwards.
+// Using the descriptors of the parent directories saves resolving the
+// full path of every file, which matters for large trashed source trees.
+static qulonglong sizeOfDirectory( int dirfd )
 {
-    QFileInfo info( path );
-    if ( !info.exists() ) {
+    DIR *dir = ::fdopendir( dirfd );
+    if ( !dir ) {
+        ::close( dirfd );
         return 0;
     }
 
-    if ( info.isSymLink() ) {
-        // QFileInfo::size does not return the actual size of a symlink. #253776
-        KDE_struct_stat buff;
-        return static_cast<qulonglong>(KDE::lstat(path, &buff) == 0 ? buff.st_size : 0);
-    } else if ( info.isFile() ) {
-        return info.size();
-    } else if ( info.isDir() ) {
-        QDirIterator it( path, QDirIterator::NoIteratorFlags );
-
-        qulonglong sum = 0;
-        while ( it.hasNext() ) {
-            const QFileInfo info = it.next();
-
-            if (info.fileName() != QLatin1String(".") && info.fileName() != QLatin1String(".."))
-                sum += sizeOfPath( info.absoluteFilePath() );
+    qulonglong sum = 0;
+    struct dirent *entry;
+    while ( ( entry = ::readdir( dir ) ) != 0 ) {
+        const char *name = entry->d_name;
+        if ( qstrcmp( name, "." ) == 0 || qstrcmp( name, ".." ) == 0 )
+            continue;
+
+        struct stat buff;
+        if ( ::fstatat( dirfd, name, &buff, AT_SYMLINK_NOFOLLOW ) != 0 )
+            continue;
+
+        if ( S_ISDIR( buff.st_mode ) ) {
+            const int fd = ::openat( dirfd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC );
+            if ( fd != -1 )
+                sum += sizeOfDirectory( fd );
+        } else if ( S_ISREG( buff.st_mode ) || S_ISLNK( buff.st_mode ) ) {
+            // the size of a symlink is the length of its target, not the size of the file. #253776
+            sum += buff.st_size;
         }
+    }
+    ::closedir( dir );
 
-        return sum;
+    return sum;
+}
+
+qulonglong DiscSpaceUtil::sizeOfPath( const QString &path )
+{
+    const QByteArray path_c = QFile::encodeName( path );
+    KDE_struct_stat buff;
+    if ( KDE_lstat( path_c.constData(), &buff ) != 0 ) {
+        return 0;
+    }
+
+    if ( S_ISDIR( buff.st_mode ) ) {
+        const int fd = ::open( path_c.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+        return fd != -1 ? sizeOfDirectory( fd ) : 0;
+    } else if ( S_ISREG( buff.st_mode ) || S_ISLNK( buff.st_mode ) ) {
+        return static_cast<qulonglong>( buff.st_size );
     } else {
         return 0;
     }
 }
 
+namespace {
+    class SizeOfPathThread : public QThread
+    {
+      public:
+        SizeOfPathThread( const QStringList &paths, qulonglong *sizes, QAtomicInt *next )
+            : mPaths( paths ), mSizes( sizes ), mNext( next )
+        {
+        }
+
+        void walk()
+        {
+            forever {
+                const int i = mNext->fetchAndAddOrdered( 1 );
+                if ( i >= mPaths.count() )
+                    return;
+                mSizes[ i ] = DiscSpaceUtil::sizeOfPath( mPaths.at( i ) );
+            }
+        }
+
+      protected:
+        virtual void run()
+        {
+            walk();
+        }
+
+      private:
+        const QStringList &mPaths;
+        qulonglong *mSizes;
+        QAtomicInt *mNext;
+    };
+}
+
+QList<qulonglong> DiscSpaceUtil::sizeOfPaths( const QStringList &paths )
+{
+    QVector<qulonglong> sizes( paths.count(), 0 );
+    QAtomicInt next( 0 );
+
+    const int threadCount = qMin( QThread::idealThreadCount(), paths.count() );
+    QList<SizeOfPathThread*> threads;
+    for ( int i = 1; i < threadCount; ++i ) {
+        SizeOfPathThread *thread = new SizeOfPathThread( paths, sizes.data(), &next );
+        thread->start();
+        threads.append( thread );
+    }
+
+    // this thread walks as well
+    SizeOfPathThread( paths, sizes.data(), &next ).walk();
+
+    foreach ( SizeOfPathThread *thread, threads ) {
+        thread->wait();
+    }
+    qDeleteAll( threads );
+
+    return sizes.toList();
+}
+
 double DiscSpaceUtil::usage( qulonglong size ) const
 {
     if ( mFullSize == 0 )
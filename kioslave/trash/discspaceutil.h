@@ -22,7 +22,8 @@
 #ifndef DISCSPACEUTIL_H
 #define DISCSPACEUTIL_H
 
-#include <QtCore/QString>
+#include <QtCore/QList>
+#include <QtCore/QStringList>
 
 /**
  * A small utility class to access and calculate
@@ -62,6 +63,12 @@ class DiscSpaceUtil
      */
     static qulonglong sizeOfPath( const QString &path );
 
+    /**
+     * Returns the sizes of the given paths in bytes, in the same order.
+     * The paths are walked by several threads at once.
+     */
+    static QList<qulonglong> sizeOfPaths( const QStringList &paths );
+
   private:
     void calculateFullSize();
 
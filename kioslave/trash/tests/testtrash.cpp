@@ -19,6 +19,8 @@
 
 #include "kio_trash.h"
 #include "testtrash.h"
+#include "discspaceutil.h"
+#include "trashsizecache.h"
 
 #include <kprotocolinfo.h>
 #include <ktemporaryfile.h>
@@ -507,6 +509,20 @@ void TestTrash::trashBrokenSymlinkFromHome()
     trashSymlink( homeTmpDir() + fileName, fileName, true );
 }
 
+// Returns the size of fileId in the directorysizes file of the trash, -1 if it's not listed
+static qlonglong directorySizesEntry( const QString& trashDir, const QString& fileId )
+{
+    QFile file( trashDir + QString::fromLatin1("/directorysizes") );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return -1;
+    while ( !file.atEnd() ) {
+        const QList<QByteArray> fields = file.readLine().trimmed().split( ' ' );
+        if ( fields.count() == 3 && QFile::decodeName( QByteArray::fromPercentEncoding( fields.at( 2 ) ) ) == fileId )
+            return fields.at( 0 ).toLongLong();
+    }
+    return -1;
+}
+
 void TestTrash::trashDirectory( const QString& origPath, const QString& fileId )
 {
     kDebug() << fileId;
@@ -538,6 +554,7 @@ void TestTrash::trashDirectory( const QString& origPath, const QString& fileId )
     QVERIFY( files.size() == 12 );
     QVERIFY( !QFile::exists( origPath ) );
     QVERIFY(QFile::exists(m_trashDir + QString::fromLatin1("/files/") + fileId + QString::fromLatin1("/subdir/subfile")));
+    QCOMPARE(directorySizesEntry(m_trashDir, fileId), qlonglong(24));
 }
 
 void TestTrash::trashDirectoryFromHome()
@@ -639,6 +656,7 @@ void TestTrash::delDirectory()
     QVERIFY( !file.exists() );
     QFileInfo info( m_trashDir + QString::fromLatin1("/info/trashDirFromHome.trashinfo") );
     QVERIFY( !info.exists() );
+    QCOMPARE( directorySizesEntry( m_trashDir, QString::fromLatin1("trashDirFromHome") ), qlonglong(-1) );
 
     // trash it again, we'll need it later
     QString dirName = QString::fromLatin1("trashDirFromHome");
@@ -1129,6 +1147,82 @@ void TestTrash::testTrashSize()
     QVERIFY(job->totalSize() < 1000000000 /*1GB*/); // #157023
 }
 
+void TestTrash::testSizeOfPaths()
+{
+    const QString dir = homeTmpDir() + QString::fromLatin1("sizeOfPaths");
+    QVERIFY( QDir().mkpath( dir + QString::fromLatin1("/a/b") ) );
+    QVERIFY( QDir().mkpath( dir + QString::fromLatin1("/c") ) );
+    createTestFile( dir + QString::fromLatin1("/a/file") );
+    createTestFile( dir + QString::fromLatin1("/a/b/file1") );
+    createTestFile( dir + QString::fromLatin1("/a/b/file2") );
+    createTestFile( dir + QString::fromLatin1("/c/file") );
+    const QString linkTarget = QString::fromLatin1("file");
+    QVERIFY( ::symlink( QFile::encodeName( linkTarget ), QFile::encodeName( dir + QString::fromLatin1("/c/link") ) ) == 0 );
+
+    QCOMPARE( DiscSpaceUtil::sizeOfPath( dir + QString::fromLatin1("/a") ), qulonglong(36) );
+    // the size of a symlink is the length of its target
+    QCOMPARE( DiscSpaceUtil::sizeOfPath( dir + QString::fromLatin1("/c/link") ), qulonglong(linkTarget.length()) );
+
+    const QStringList paths = QStringList() << dir + QString::fromLatin1("/a")
+                                            << dir + QString::fromLatin1("/c")
+                                            << dir + QString::fromLatin1("/a/file")
+                                            << dir + QString::fromLatin1("/doesnotexist");
+    const QList<qulonglong> sizes = DiscSpaceUtil::sizeOfPaths( paths );
+    QCOMPARE( sizes.count(), paths.count() );
+    QCOMPARE( sizes.at( 0 ), qulonglong(36) );
+    QCOMPARE( sizes.at( 1 ), qulonglong(12 + linkTarget.length()) );
+    QCOMPARE( sizes.at( 2 ), qulonglong(12) );
+    QCOMPARE( sizes.at( 3 ), qulonglong(0) );
+    QCOMPARE( DiscSpaceUtil::sizeOfPath( dir ), sizes.at( 0 ) + sizes.at( 1 ) );
+
+    removeDirRecursive( dir );
+}
+
+void TestTrash::testEntrySizes()
+{
+    // a trash directory of its own, the size cache of the real one must not be touched
+    const QString trashDir = homeTmpDir() + QString::fromLatin1("entrySizes");
+    QVERIFY( QDir().mkpath( trashDir + QString::fromLatin1("/files/listed/sub") ) );
+    QVERIFY( QDir().mkpath( trashDir + QString::fromLatin1("/files/unlisted") ) );
+    QVERIFY( QDir().mkpath( trashDir + QString::fromLatin1("/info") ) );
+    createTestFile( trashDir + QString::fromLatin1("/files/file") );
+    createTestFile( trashDir + QString::fromLatin1("/files/listed/sub/file") );
+    createTestFile( trashDir + QString::fromLatin1("/files/unlisted/file") );
+    createTestFile( trashDir + QString::fromLatin1("/info/listed.trashinfo") );
+    createTestFile( trashDir + QString::fromLatin1("/info/unlisted.trashinfo") );
+
+    // the size of "listed" is taken from the directory sizes, so make it differ from the real one
+    const uint mtime = QFileInfo( trashDir + QString::fromLatin1("/info/listed.trashinfo") ).lastModified().toTime_t();
+    QFile directorySizes( trashDir + QString::fromLatin1("/directorysizes") );
+    QVERIFY( directorySizes.open( QIODevice::WriteOnly ) );
+    directorySizes.write( "1000 " + QByteArray::number( mtime ) + " listed\n" );
+    directorySizes.close();
+
+    TrashSizeCache trashSize( trashDir );
+    const QStringList fileIds = QStringList() << QString::fromLatin1("file")
+                                              << QString::fromLatin1("listed")
+                                              << QString::fromLatin1("unlisted");
+    const QHash<QString, qulonglong> sizes = trashSize.entrySizes( fileIds );
+    QCOMPARE( sizes.count(), 3 );
+    QCOMPARE( sizes.value( QString::fromLatin1("file") ), qulonglong(12) );
+    QCOMPARE( sizes.value( QString::fromLatin1("listed") ), qulonglong(1000) );
+    QCOMPARE( sizes.value( QString::fromLatin1("unlisted") ), qulonglong(12) );
+    // the walked directory is not walked again next time
+    QCOMPARE( directorySizesEntry( trashDir, QString::fromLatin1("unlisted") ), qlonglong(12) );
+    Q_FOREACH( const QString& fileId, fileIds )
+        QCOMPARE( sizes.value( fileId ), trashSize.entrySize( fileId ) );
+
+    // removing several files at once drops all their directory sizes
+    QCOMPARE( trashSize.size(), qulonglong(1024) );
+    removeDirRecursive( trashDir + QString::fromLatin1("/files/listed") );
+    removeDirRecursive( trashDir + QString::fromLatin1("/files/unlisted") );
+    trashSize.remove( QStringList() << QString::fromLatin1("listed") << QString::fromLatin1("unlisted"), 1012 );
+    QCOMPARE( trashSize.size(), qulonglong(12) );
+    QVERIFY( !QFile::exists( trashDir + QString::fromLatin1("/directorysizes") ) );
+
+    removeDirRecursive( trashDir );
+}
+
 static void checkIcon( const KUrl& url, const QString& expectedIcon )
 {
     QString icon = KMimeType::iconNameForUrl( url );
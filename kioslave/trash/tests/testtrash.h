@@ -89,6 +89,8 @@ private Q_SLOTS:
 
     void emptyTrash();
     void testTrashSize();
+    void testSizeOfPaths();
+    void testEntrySizes();
 
 protected Q_SLOTS:
     void slotEntries( KIO::Job*, const KIO::UDSEntryList& );
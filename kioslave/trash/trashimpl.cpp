@@ -305,11 +305,11 @@ bool TrashImpl::deleteInfo( int trashId, const QString& fileId )
 bool TrashImpl::moveToTrash( const QString& origPath, int trashId, const QString& fileId )
 {
     kDebug() ;
-    if ( !adaptTrashSize( origPath, trashId ) )
-        return false;
-
     const qulonglong pathSize = DiscSpaceUtil::sizeOfPath( origPath );
 
+    if ( !adaptTrashSize( pathSize, trashId ) )
+        return false;
+
     TrashSizeCache trashSize( trashDirectoryPath( trashId ) );
     trashSize.initialize();
 
@@ -324,7 +324,7 @@ bool TrashImpl::moveToTrash( const QString& origPath, int trashId, const QString
         return false;
     }
 
-    trashSize.add( pathSize );
+    trashSize.add( fileId, pathSize );
 
     fileAdded();
     return true;
@@ -337,15 +337,16 @@ bool TrashImpl::moveFromTrash( const QString& dest, int trashId, const QString&
         src += QLatin1Char('/');
         src += relativePath;
     }
-    const qulonglong pathSize = DiscSpaceUtil::sizeOfPath( src );
-
     TrashSizeCache trashSize( trashDirectoryPath( trashId ) );
     trashSize.initialize();
 
+    const qulonglong pathSize = relativePath.isEmpty() ? trashSize.entrySize( fileId )
+                                                       : DiscSpaceUtil::sizeOfPath( src );
+
     if ( !move( src, dest ) )
         return false;
 
-    trashSize.remove( pathSize );
+    trashSize.remove( fileId, pathSize );
 
     return true;
 }
@@ -384,11 +385,11 @@ void TrashImpl::jobFinished(KJob* job)
 bool TrashImpl::copyToTrash( const QString& origPath, int trashId, const QString& fileId )
 {
     kDebug() ;
-    if ( !adaptTrashSize( origPath, trashId ) )
-        return false;
-
     const qulonglong pathSize = DiscSpaceUtil::sizeOfPath( origPath );
 
+    if ( !adaptTrashSize( pathSize, trashId ) )
+        return false;
+
     TrashSizeCache trashSize( trashDirectoryPath( trashId ) );
     trashSize.initialize();
 
@@ -396,7 +397,7 @@ bool TrashImpl::copyToTrash( const QString& origPath, int trashId, const QString
     if ( !copy( origPath, dest ) )
         return false;
 
-    trashSize.add( pathSize );
+    trashSize.add( fileId, pathSize );
 
     fileAdded();
     return true;
@@ -478,8 +479,6 @@ bool TrashImpl::del( int trashId, const QString& fileId )
     QString info = infoPath(trashId, fileId);
     QString file = filesPath(trashId, fileId);
 
-    const qulonglong fileSize = DiscSpaceUtil::sizeOfPath( file );
-
     QByteArray info_c = QFile::encodeName(info);
 
     KDE_struct_stat buff;
@@ -494,10 +493,12 @@ bool TrashImpl::del( int trashId, const QString& fileId )
     TrashSizeCache trashSize( trashDirectoryPath( trashId ) );
     trashSize.initialize();
 
+    const qulonglong fileSize = trashSize.entrySize( fileId );
+
     if ( !synchronousDel( file, true, QFileInfo(file).isDir() ) )
         return false;
 
-    trashSize.remove( fileSize );
+    trashSize.remove( fileId, fileSize );
 
     QFile::remove( info );
     fileRemoved();
@@ -1037,7 +1038,7 @@ bool TrashImpl::parseURL( const KUrl& url, int& trashId, QString& fileId, QStrin
     return true;
 }
 
-bool TrashImpl::adaptTrashSize( const QString& origPath, int trashId )
+bool TrashImpl::adaptTrashSize( qulonglong additionalSize, int trashId )
 {
     KConfig config(QString::fromLatin1("ktrashrc"));
 
@@ -1066,10 +1067,7 @@ bool TrashImpl::adaptTrashSize( const QString& origPath, int trashId )
 
     if ( useSizeLimit ) { // check if size limit exceeded
 
-        // calculate size of the files to be put into the trash
-        qulonglong additionalSize = DiscSpaceUtil::sizeOfPath( origPath );
-
-        const TrashSizeCache trashSize( trashPath );
+        TrashSizeCache trashSize( trashPath );
         DiscSpaceUtil util(trashPath + QString::fromLatin1("/files/"));
         if ( util.usage( trashSize.size() + additionalSize ) >= percent ) {
             if ( actionType == 0 ) { // warn the user only
@@ -1093,23 +1091,52 @@ bool TrashImpl::adaptTrashSize( const QString& origPath, int trashId )
                 // some other files from the trash
 
                 QDir dir(trashPath + QString::fromLatin1("/files"));
-                QFileInfoList infoList;
+                QStringList fileIds;
                 if ( actionType == 1 )  // delete oldest files first
-                    infoList = dir.entryInfoList( QDir::Files | QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Time | QDir::Reversed );
+                    fileIds = dir.entryList( QDir::Files | QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Time | QDir::Reversed );
                 else if ( actionType == 2 ) // delete biggest files first
-                    infoList = dir.entryInfoList( QDir::Files | QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Size );
+                    fileIds = dir.entryList( QDir::Files | QDir::AllDirs | QDir::NoDotAndDotDot );
                 else
                     qWarning( "Should never happen!" );
 
-                bool deleteFurther = true;
-                for ( int i = 0; (i < infoList.count()) && deleteFurther; ++i ) {
-                    const QFileInfo info = infoList.at( i );
+                // QDir::Size does not know the size of the directories, take it from the trash size cache.
+                // Sorting needs all sizes, they are read at once then. Otherwise only the
+                // sizes of the files which are actually deleted are needed
+                QHash<QString, qulonglong> sizes;
+                if ( actionType == 2 ) {
+                    sizes = trashSize.entrySizes( fileIds );
+                    QMultiMap<qulonglong, QString> filesBySize;
+                    Q_FOREACH( const QString& fileId, fileIds )
+                        filesBySize.insert( sizes.value( fileId ), fileId );
+                    fileIds.clear();
+                    QMapIterator<qulonglong, QString> it( filesBySize );
+                    it.toBack();
+                    while ( it.hasPrevious() )
+                        fileIds.append( it.previous().value() );
+                }
 
-                    del( trashId, info.fileName() ); // delete trashed file
+                // The trash size cache is only updated once the files have been deleted
+                qulonglong currentSize = trashSize.size();
+                qulonglong removedSize = 0;
+                QStringList removedFileIds;
+                for ( int i = 0; i < fileIds.count(); ++i ) {
+                    const QString& fileId = fileIds.at( i );
+                    const QString file = filesPath( trashId, fileId );
+                    const qulonglong fileSize = actionType == 2 ? sizes.value( fileId ) : trashSize.entrySize( fileId );
+                    if ( !synchronousDel( file, true, QFileInfo( file ).isDir() ) )
+                        continue;
+                    QFile::remove( infoPath( trashId, fileId ) );
+
+                    removedFileIds.append( fileId );
+                    removedSize += fileSize;
+                    currentSize -= qMin( currentSize, fileSize );
+                    if ( util.usage( currentSize + additionalSize ) < percent ) // check whether we have enough space now
+                        break;
+                }
 
-                    const TrashSizeCache trashSize( trashPath );
-                    if ( util.usage( trashSize.size() + additionalSize ) < percent ) // check whether we have enough space now
-                         deleteFurther = false;
+                if ( !removedFileIds.isEmpty() ) {
+                    trashSize.remove( removedFileIds, removedSize );
+                    fileRemoved();
                 }
             }
         }
@@ -120,7 +120,8 @@ private:
     void fileAdded();
     void fileRemoved();
 
-    bool adaptTrashSize( const QString& origPath, int trashId );
+    /// Makes room for @p additionalSize bytes in the trash, according to the size and time limits
+    bool adaptTrashSize( qulonglong additionalSize, int trashId );
 
     // Warning, returns error code, not a bool
     int testDir( const QString& name ) const;
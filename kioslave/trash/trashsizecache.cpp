@@ -25,17 +25,23 @@
 
 #include <kconfig.h>
 #include <kconfiggroup.h>
+#include <kdebug.h>
+#include <kde_file.h>
 #include <klockfile.h>
 #include <kglobal.h>
+#include <ksavefile.h>
 #include <kstandarddirs.h>
 
 #include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QStringList>
 
 static QString s_trahslockname = QString::fromLatin1( "trash" );
 
 TrashSizeCache::TrashSizeCache( const QString &path )
     : mTrashSizeCachePath( path + QDir::separator() + QString::fromLatin1( "metadata" ) ),
       mTrashPath( path ),
+      mDirectorySizesPath( path + QDir::separator() + QString::fromLatin1( "directorysizes" ) ),
       mTrashSizeGroup( QLatin1String( "Cached" ) ),
       mTrashSizeKey( QLatin1String( "Size" ) )
 {
@@ -47,7 +53,7 @@ void TrashSizeCache::initialize()
     currentSize( true );
 }
 
-void TrashSizeCache::add( qulonglong value )
+void TrashSizeCache::add( const QString &fileId, qulonglong value )
 {
     KLockFile lock( s_trahslockname );
     lock.lock();
@@ -60,9 +66,22 @@ void TrashSizeCache::add( qulonglong value )
 
     group.writeEntry( mTrashSizeKey, size );
     config.sync();
+
+    // Only directories are listed in the directory sizes, the size
+    // of a file is known from a single stat
+    KDE_struct_stat buff;
+    const QString filePath = mTrashPath + QString::fromLatin1( "/files/" ) + fileId;
+    if ( KDE_lstat( QFile::encodeName( filePath ), &buff ) == 0 && S_ISDIR( buff.st_mode ) ) {
+        DirectorySizes sizes = readDirectorySizes();
+        DirectorySize entry;
+        entry.size = value;
+        entry.mtime = infoModificationTime( fileId );
+        sizes.insert( fileId, entry );
+        writeDirectorySizes( sizes );
+    }
 }
 
-void TrashSizeCache::remove( qulonglong value )
+void TrashSizeCache::remove( const QString &fileId, qulonglong value )
 {
     KLockFile lock( s_trahslockname );
     lock.lock();
@@ -71,10 +90,47 @@ void TrashSizeCache::remove( qulonglong value )
     KConfigGroup group = config.group( mTrashSizeGroup );
 
     qulonglong size = currentSize( false );
-    size -= value;
+    size -= qMin( size, value );
 
     group.writeEntry( mTrashSizeKey, size );
     config.sync();
+
+    DirectorySizes sizes = readDirectorySizes();
+    DirectorySizes::iterator it = sizes.find( fileId );
+    if ( it != sizes.end() ) {
+        const QString filePath = mTrashPath + QString::fromLatin1( "/files/" ) + fileId;
+        if ( QFile::exists( filePath ) && value < it->size ) {
+            // a part of the directory has been restored
+            it->size -= value;
+        } else {
+            sizes.erase( it );
+        }
+        writeDirectorySizes( sizes );
+    }
+}
+
+void TrashSizeCache::remove( const QStringList &fileIds, qulonglong value )
+{
+    KLockFile lock( s_trahslockname );
+    lock.lock();
+
+    KConfig config( mTrashSizeCachePath );
+    KConfigGroup group = config.group( mTrashSizeGroup );
+
+    qulonglong size = currentSize( false );
+    size -= qMin( size, value );
+
+    group.writeEntry( mTrashSizeKey, size );
+    config.sync();
+
+    DirectorySizes sizes = readDirectorySizes();
+    bool changed = false;
+    foreach ( const QString &fileId, fileIds ) {
+        changed |= ( sizes.remove( fileId ) > 0 );
+    }
+    if ( changed ) {
+        writeDirectorySizes( sizes );
+    }
 }
 
 void TrashSizeCache::clear()
@@ -87,6 +143,8 @@ void TrashSizeCache::clear()
 
     group.writeEntry( mTrashSizeKey, (qulonglong)0 );
     config.sync();
+
+    QFile::remove( mDirectorySizesPath );
 }
 
 qulonglong TrashSizeCache::size() const
@@ -94,6 +152,65 @@ qulonglong TrashSizeCache::size() const
     return currentSize( true );
 }
 
+qulonglong TrashSizeCache::entrySize( const QString &fileId ) const
+{
+    const QString filePath = mTrashPath + QString::fromLatin1( "/files/" ) + fileId;
+    KDE_struct_stat buff;
+    if ( KDE_lstat( QFile::encodeName( filePath ), &buff ) == 0 && S_ISDIR( buff.st_mode ) ) {
+        const DirectorySizes sizes = readDirectorySizes();
+        DirectorySizes::const_iterator it = sizes.constFind( fileId );
+        if ( it != sizes.constEnd() && isValid( fileId, *it ) ) {
+            return it->size;
+        }
+
+        const qulonglong size = DiscSpaceUtil::sizeOfPath( filePath );
+        QHash<QString, qulonglong> walked;
+        walked.insert( fileId, size );
+        storeDirectorySizes( walked );
+        return size;
+    }
+
+    return DiscSpaceUtil::sizeOfPath( filePath );
+}
+
+QHash<QString, qulonglong> TrashSizeCache::entrySizes( const QStringList &fileIds ) const
+{
+    const QString filesPath = mTrashPath + QString::fromLatin1( "/files/" );
+    const DirectorySizes dirSizes = readDirectorySizes();
+
+    QHash<QString, qulonglong> sizes;
+    QStringList walkFileIds;
+    QStringList walkPaths;
+    foreach ( const QString &fileId, fileIds ) {
+        KDE_struct_stat buff;
+        if ( KDE_lstat( QFile::encodeName( filesPath + fileId ), &buff ) != 0 ) {
+            sizes.insert( fileId, 0 );
+            continue;
+        }
+        if ( S_ISDIR( buff.st_mode ) ) {
+            DirectorySizes::const_iterator it = dirSizes.constFind( fileId );
+            if ( it != dirSizes.constEnd() && isValid( fileId, *it ) ) {
+                sizes.insert( fileId, it->size );
+            } else {
+                walkFileIds.append( fileId );
+                walkPaths.append( filesPath + fileId );
+            }
+        } else {
+            sizes.insert( fileId, DiscSpaceUtil::sizeOfPath( filesPath + fileId ) );
+        }
+    }
+
+    const QList<qulonglong> walkSizes = DiscSpaceUtil::sizeOfPaths( walkPaths );
+    QHash<QString, qulonglong> walked;
+    for ( int i = 0; i < walkFileIds.count(); ++i ) {
+        walked.insert( walkFileIds.at( i ), walkSizes.at( i ) );
+    }
+    storeDirectorySizes( walked );
+    sizes.unite( walked );
+
+    return sizes;
+}
+
 qulonglong TrashSizeCache::currentSize( bool doLocking ) const
 {
     KLockFile lock( s_trahslockname );
@@ -108,7 +225,7 @@ qulonglong TrashSizeCache::currentSize( bool doLocking ) const
     if ( !group.hasKey( mTrashSizeKey ) ) {
         // For the first call to the trash size cache, we have to calculate
         // the current size.
-        const qulonglong size = DiscSpaceUtil::sizeOfPath( mTrashPath + QString::fromLatin1( "/files/" ) );
+        const qulonglong size = calculateSize();
 
         group.writeEntry( mTrashSizeKey, size );
         config.sync();
@@ -122,3 +239,138 @@ qulonglong TrashSizeCache::currentSize( bool doLocking ) const
 
     return value;
 }
+
+qulonglong TrashSizeCache::calculateSize() const
+{
+    const QString filesPath = mTrashPath + QString::fromLatin1( "/files/" );
+    const QStringList fileIds = QDir( filesPath ).entryList( QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot );
+
+    // Directories with a valid size in the directory sizes are not walked again,
+    // the others are walked in parallel
+    const DirectorySizes oldSizes = readDirectorySizes();
+    DirectorySizes sizes;
+    QStringList walkFileIds;
+    QStringList walkPaths;
+    qulonglong size = 0;
+    foreach ( const QString &fileId, fileIds ) {
+        KDE_struct_stat buff;
+        if ( KDE_lstat( QFile::encodeName( filesPath + fileId ), &buff ) != 0 ) {
+            continue;
+        }
+        if ( S_ISDIR( buff.st_mode ) ) {
+            DirectorySizes::const_iterator it = oldSizes.constFind( fileId );
+            if ( it != oldSizes.constEnd() && isValid( fileId, *it ) ) {
+                sizes.insert( fileId, *it );
+                size += it->size;
+            } else {
+                walkFileIds.append( fileId );
+                walkPaths.append( filesPath + fileId );
+            }
+        } else if ( S_ISREG( buff.st_mode ) || S_ISLNK( buff.st_mode ) ) {
+            size += buff.st_size;
+        }
+    }
+
+    const QList<qulonglong> walkSizes = DiscSpaceUtil::sizeOfPaths( walkPaths );
+    for ( int i = 0; i < walkFileIds.count(); ++i ) {
+        DirectorySize entry;
+        entry.size = walkSizes.at( i );
+        entry.mtime = infoModificationTime( walkFileIds.at( i ) );
+        sizes.insert( walkFileIds.at( i ), entry );
+        size += entry.size;
+    }
+
+    writeDirectorySizes( sizes );
+
+    return size;
+}
+
+qlonglong TrashSizeCache::infoModificationTime( const QString &fileId ) const
+{
+    const QString infoPath = mTrashPath + QString::fromLatin1( "/info/" ) + fileId + QString::fromLatin1( ".trashinfo" );
+    KDE_struct_stat buff;
+    if ( KDE_lstat( QFile::encodeName( infoPath ), &buff ) != 0 ) {
+        return -1;
+    }
+    return buff.st_mtime;
+}
+
+bool TrashSizeCache::isValid( const QString &fileId, const DirectorySize &entry ) const
+{
+    // The trashinfo file is written when the directory is trashed, so
+    // a different modification time means that the entry is outdated
+    const qlonglong mtime = infoModificationTime( fileId );
+    return mtime != -1 && mtime == entry.mtime;
+}
+
+void TrashSizeCache::storeDirectorySizes( const QHash<QString, qulonglong> &walked ) const
+{
+    if ( walked.isEmpty() ) {
+        return;
+    }
+
+    KLockFile lock( s_trahslockname );
+    lock.lock();
+
+    // Read the file again under the lock, it may have been changed by another
+    // trash slave while the directories were walked
+    DirectorySizes sizes = readDirectorySizes();
+    QHash<QString, qulonglong>::const_iterator it = walked.constBegin();
+    for ( ; it != walked.constEnd(); ++it ) {
+        DirectorySize entry;
+        entry.size = it.value();
+        entry.mtime = infoModificationTime( it.key() );
+        if ( entry.mtime != -1 ) {
+            sizes.insert( it.key(), entry );
+        }
+    }
+    writeDirectorySizes( sizes );
+}
+
+TrashSizeCache::DirectorySizes TrashSizeCache::readDirectorySizes() const
+{
+    DirectorySizes sizes;
+    QFile file( mDirectorySizesPath );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return sizes;
+    }
+
+    // Each line has the format "size mtime percent-encoded-name"
+    while ( !file.atEnd() ) {
+        const QList<QByteArray> fields = file.readLine().trimmed().split( ' ' );
+        if ( fields.count() != 3 ) {
+            continue;
+        }
+        bool sizeOk = false;
+        bool mtimeOk = false;
+        DirectorySize entry;
+        entry.size = fields.at( 0 ).toULongLong( &sizeOk );
+        entry.mtime = fields.at( 1 ).toLongLong( &mtimeOk );
+        if ( sizeOk && mtimeOk ) {
+            sizes.insert( QFile::decodeName( QByteArray::fromPercentEncoding( fields.at( 2 ) ) ), entry );
+        }
+    }
+
+    return sizes;
+}
+
+void TrashSizeCache::writeDirectorySizes( const DirectorySizes &sizes ) const
+{
+    if ( sizes.isEmpty() ) {
+        QFile::remove( mDirectorySizesPath );
+        return;
+    }
+
+    KSaveFile file( mDirectorySizesPath );
+    if ( !file.open() ) {
+        kWarning() << "Could not write" << mDirectorySizesPath << file.errorString();
+        return;
+    }
+
+    DirectorySizes::const_iterator it = sizes.constBegin();
+    for ( ; it != sizes.constEnd(); ++it ) {
+        file.write( QByteArray::number( it->size ) + ' ' + QByteArray::number( it->mtime ) + ' '
+                    + QFile::encodeName( it.key() ).toPercentEncoding() + '\n' );
+    }
+    file.finalize();
+}
@@ -22,7 +22,9 @@
 #ifndef TRASHSIZECACHE_H
 #define TRASHSIZECACHE_H
 
+#include <QtCore/QHash>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 
 #include <kconfig.h>
 
@@ -36,6 +38,11 @@
  * The trash size cache is kept in the ktrashrc configuration file and
  * updated by the moveToTrash/moveFromTrash/copyToTrash and emptyTrash
  * methods in the TrashImpl object.
+ *
+ * Additionally the sizes of the trashed directories are kept in the
+ * directorysizes file of the trash, as described by the freedesktop.org
+ * trash specification. Removing a directory from the trash or
+ * recalculating the trash size does not need to walk the directory then.
  */
 class TrashSizeCache
 {
@@ -52,14 +59,24 @@ class TrashSizeCache
         void initialize();
 
         /**
-         * Increases the size of the trash by @p value.
+         * Increases the size of the trash by the @p value bytes of the
+         * trashed file @p fileId.
+         */
+        void add( const QString &fileId, qulonglong value );
+
+        /**
+         * Decreases the size of the trash by @p value bytes, which have been
+         * removed from the trashed file @p fileId. Either the whole file
+         * has been removed or a part of the trashed directory has been restored.
          */
-        void add( qulonglong value );
+        void remove( const QString &fileId, qulonglong value );
 
         /**
-         * Decreases the size of the trash by @p value.
+         * Decreases the size of the trash by @p value bytes, which have been
+         * taken by the trashed files @p fileIds. All of them have been removed
+         * from the trash. The directory sizes are only rewritten once.
          */
-        void remove( qulonglong value );
+        void remove( const QStringList &fileIds, qulonglong value );
 
         /**
          * Sets the trash size to 0 bytes.
@@ -71,11 +88,39 @@ class TrashSizeCache
          */
         qulonglong size() const;
 
+        /**
+         * Returns the size of the trashed file @p fileId. The size of
+         * directories is taken from the directory sizes if possible,
+         * otherwise the directory is walked and its size is stored there.
+         */
+        qulonglong entrySize( const QString &fileId ) const;
+
+        /**
+         * Returns the sizes of the trashed files @p fileIds, like entrySize(),
+         * but reads the directory sizes only once. Directories without a valid
+         * entry are walked in parallel and their sizes are stored.
+         */
+        QHash<QString, qulonglong> entrySizes( const QStringList &fileIds ) const;
+
     private:
+        struct DirectorySize
+        {
+            qulonglong size;
+            qlonglong mtime;
+        };
+        typedef QHash<QString, DirectorySize> DirectorySizes;
+
         qulonglong currentSize( bool doLocking ) const;
+        qulonglong calculateSize() const;
+        qlonglong infoModificationTime( const QString &fileId ) const;
+        bool isValid( const QString &fileId, const DirectorySize &entry ) const;
+        void storeDirectorySizes( const QHash<QString, qulonglong> &walked ) const;
+        DirectorySizes readDirectorySizes() const;
+        void writeDirectorySizes( const DirectorySizes &sizes ) const;
 
         QString mTrashSizeCachePath;
         QString mTrashPath;
+        QString mDirectorySizesPath;
         const QString mTrashSizeGroup;
         const QString mTrashSizeKey;
 };
@@ -24,6 +24,7 @@
 
 #include <KDebug>
 
+#include "historyjournal.h"
 #include "historystringitem.h"
 #include "klipperpopup.h"
 
@@ -32,7 +33,8 @@ History::History( QObject* parent )
       m_top(0L),
       m_popup( new KlipperPopup( this ) ),
       m_topIsUserSelected( false ),
-      m_nextCycle(0L)
+      m_nextCycle(0L),
+      m_journal(0L)
 {
     connect( this, SIGNAL(changed()), m_popup, SLOT(slotHistoryChanged()) );
 
@@ -72,6 +74,9 @@ void History::forceInsert( HistoryItem* item ) {
     item->insertBetweeen(m_top ? m_items[m_top->previous_uuid()] : 0L, m_top);
     m_items.insert( item->uuid(), item );
     m_top = item;
+    if ( m_journal ) {
+        m_journal->logInsert( item );
+    }
     emit changed();
     trim();
 }
@@ -85,6 +90,9 @@ void History::trim() {
     while ( i-- ) {
         items_t::iterator it = bottom;
         bottom = m_items.find((*bottom)->previous_uuid());
+        if ( m_journal ) {
+            m_journal->logRemove( it.key() );
+        }
         // FIXME: managing memory manually is tedious; use smart pointer instead
         delete *it;
         m_items.erase(it);
@@ -104,6 +112,9 @@ void History::remove( const HistoryItem* newItem ) {
     if (it == m_items.end()) {
         return;
     }
+    if ( m_journal ) {
+        m_journal->logRemove( it.key() );
+    }
 
     if (*it == m_top) {
         m_top = m_items[m_top->next_uuid()];
@@ -118,6 +129,9 @@ void History::slotClear() {
     qDeleteAll(m_items);
     m_items.clear();
     m_top = 0L;
+    if ( m_journal ) {
+        m_journal->logClear();
+    }
     emit changed();
 }
 
@@ -145,6 +159,9 @@ void History::slotMoveToTop(const QByteArray& uuid) {
     m_items[(*it)->previous_uuid()]->chain(m_items[(*it)->next_uuid()]);
     (*it)->insertBetweeen(m_items[m_top->previous_uuid()], m_top);
     m_top = *it;
+    if ( m_journal ) {
+        m_journal->logMoveToTop( m_top->uuid() );
+    }
     emit changed();
     emit topChanged();
 }
@@ -182,6 +199,9 @@ void History::cycleNext() {
             m_top = m_nextCycle;
             m_nextCycle = next;
         }
+        if ( m_journal ) {
+            m_journal->logOrder( items() );
+        }
         emit changed();
         emit topChanged();
     }
@@ -214,6 +234,9 @@ void History::cyclePrev() {
             m_nextCycle = m_top;
             m_top = prev;
         }
+        if ( m_journal ) {
+            m_journal->logOrder( items() );
+        }
         emit changed();
         emit topChanged();
     }
@@ -238,6 +261,20 @@ const HistoryItem* History::prevInCycle() const
 
 }
 
+QList<const HistoryItem*> History::items() const
+{
+    QList<const HistoryItem*> result;
+    const HistoryItem* item = m_top;
+    while ( item ) {
+        result.append( item );
+        item = find( item->next_uuid() );
+        if ( item == m_top ) {
+            break;
+        }
+    }
+    return result;
+}
+
 const HistoryItem* History::find(const QByteArray& uuid) const
 {
     items_t::const_iterator it = m_items.find(uuid);
@@ -28,6 +28,7 @@
 
 #include <QAction>
 class KlipperPopup;
+class HistoryJournal;
 
 class History : public QObject
 {
@@ -67,6 +68,11 @@ public:
      */
     const HistoryItem* first() const;
 
+    /**
+     * All items of the history, youngest first
+     */
+    QList<const HistoryItem*> items() const;
+
     /**
      * Get item identified by uuid
      */
@@ -104,6 +110,17 @@ public:
         return m_topIsUserSelected;
     }
 
+    /**
+     * Set the journal which records all changes of the history,
+     * or 0 to stop recording them.
+     */
+    void setJournal( HistoryJournal* journal ) { m_journal = journal; }
+
+    /**
+     * The journal which records the changes, may be 0
+     */
+    HistoryJournal* journal() const { return m_journal; }
+
     /**
      * Cycle to next item
      */
@@ -178,6 +195,11 @@ private:
      * history. May be 0, if history is empty
      */
     HistoryItem* m_nextCycle;
+
+    /**
+     * Records the changes of the history, may be 0
+     */
+    HistoryJournal* m_journal;
 };
 
 inline const HistoryItem* History::first() const { return m_top; }
@@ -20,47 +20,123 @@
 #include "klipper.h"
 #include "historyimageitem.h"
 
+#include <QtCore/QBuffer>
+#include <QtCore/QCache>
+#include <QtCore/QFile>
 #include <QtCore/QMimeData>
+#include <QtGui/QImageReader>
 #include <QCryptographicHash>
 
 #include <KDebug>
 
 namespace {
-    QByteArray compute_uuid(const QPixmap& data) {
+    // The thumbnails of the popup, the cost is in kilobytes
+    const int thumbnail_cache_size = 4096;
+    const QSize thumbnail_size( 256, 256 );
+
+    QCache<QByteArray, QPixmap>& thumbnail_cache() {
+        static QCache<QByteArray, QPixmap> cache( thumbnail_cache_size );
+        return cache;
+    }
+
+    QByteArray compress(const QImage& image) {
         QByteArray buffer;
-        QDataStream out(&buffer, QIODevice::WriteOnly);
-        out << data;
-        return QCryptographicHash::hash(buffer, KlipperHashAlgorithm);
+        QBuffer device(&buffer);
+        device.open(QIODevice::WriteOnly);
+        image.save(&device, "PNG");
+        return buffer;
     }
 
 }
 
-HistoryImageItem::HistoryImageItem( const QPixmap& data )
-    : HistoryItem(compute_uuid(data))
+HistoryImageItem::HistoryImageItem( const QImage& data )
+    : HistoryImageItem( compress( data ), data.size(), data.depth() )
+{
+}
+
+HistoryImageItem::HistoryImageItem( const QByteArray& data, const QSize& size, int depth )
+    : HistoryItem(QCryptographicHash::hash(data, KlipperHashAlgorithm))
     , m_data( data )
+    , m_size( size )
+    , m_depth( depth )
+{
+}
+
+HistoryImageItem::HistoryImageItem( const QByteArray& uuid, const QString& fileName, const QSize& size, int depth )
+    : HistoryItem( uuid )
+    , m_fileName( fileName )
+    , m_size( size )
+    , m_depth( depth )
 {
 }
 
+HistoryImageItem::~HistoryImageItem()
+{
+    thumbnail_cache().remove( uuid() );
+}
+
 QString HistoryImageItem::text() const {
     if ( m_text.isNull() ) {
         m_text = QString( "%1x%2x%3 %4" )
-                 .arg( m_data.width() )
-                 .arg( m_data.height() )
-                 .arg( m_data.depth() );
+                 .arg( m_size.width() )
+                 .arg( m_size.height() )
+                 .arg( m_depth );
     }
     return m_text;
 
 }
 
+QPixmap HistoryImageItem::image() const {
+    if ( QPixmap* thumbnail = thumbnail_cache().object( uuid() ) ) {
+        return *thumbnail;
+    }
+    QBuffer device;
+    device.setData( data() );
+    QImageReader reader( &device, "PNG" );
+    if ( m_size.width() > thumbnail_size.width() || m_size.height() > thumbnail_size.height() ) {
+        reader.setScaledSize( m_size.scaled( thumbnail_size, Qt::KeepAspectRatio ) );
+    }
+    const QImage image = reader.read();
+    if ( image.isNull() ) {
+        kWarning() << "Failed to decode history image:" << reader.errorString() ;
+        return QPixmap();
+    }
+    const QPixmap thumbnail = QPixmap::fromImage( image );
+    thumbnail_cache().insert( uuid(), new QPixmap( thumbnail ), qMax( 1, image.byteCount() / 1024 ) );
+    return thumbnail;
+}
+
 /* virtual */
 void HistoryImageItem::write( QDataStream& stream ) const {
-    stream << QString( "image" ) << m_data;
+    stream << QString( "pngimage" ) << m_size << qint32( m_depth ) << data();
+}
+
+QByteArray HistoryImageItem::data() const
+{
+    if ( m_fileName.isEmpty() ) {
+        return m_data;
+    }
+    // Not cached, the image is only needed for pasting
+    // and for the thumbnail, which is cached anyway
+    QFile file( m_fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        kWarning() << "Failed to read history image:" << file.errorString() ;
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+void HistoryImageItem::loadData() const
+{
+    if ( !m_fileName.isEmpty() ) {
+        m_data = data();
+        m_fileName.clear();
+    }
 }
 
 QMimeData* HistoryImageItem::mimeData() const
 {
     QMimeData *data = new QMimeData();
-    data->setImageData(m_data.toImage());
+    data->setImageData(QImage::fromData(this->data(), "PNG"));
     return data;
 }
-
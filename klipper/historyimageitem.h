@@ -22,31 +22,75 @@
 
 #include "historyitem.h"
 
+#include <QtCore/QSize>
+#include <QtGui/QImage>
+
 /**
  * A image entry in the clipboard history.
+ *
+ * The image is kept PNG compressed, it is only decoded completely
+ * when the item is pasted. The popup gets a small thumbnail instead.
+ * Items restored from the history journal don't keep the image in
+ * memory at all, it is read from the image file when it is needed.
  */
 class HistoryImageItem : public HistoryItem
 {
 public:
-    HistoryImageItem( const QPixmap& data );
-    virtual ~HistoryImageItem() {}
+    HistoryImageItem( const QImage& data );
+    /**
+     * @param data the PNG compressed image
+     * @param size size of the image
+     * @param depth depth of the image
+     */
+    HistoryImageItem( const QByteArray& data, const QSize& size, int depth );
+    /**
+     * @param uuid the hash of the PNG compressed image
+     * @param fileName file containing the PNG compressed image,
+     * which is read whenever the image is needed
+     * @param size size of the image
+     * @param depth depth of the image
+     */
+    HistoryImageItem( const QByteArray& uuid, const QString& fileName, const QSize& size, int depth );
+    virtual ~HistoryImageItem();
     virtual QString text() const;
     virtual bool operator==( const HistoryItem& rhs) const {
         if ( const HistoryImageItem* casted_rhs = dynamic_cast<const HistoryImageItem*>( &rhs ) ) {
-            return &casted_rhs->m_data == &m_data; // Not perfect, but better than nothing.
+            return casted_rhs->uuid() == uuid();
         }
         return false;
     }
-    virtual const QPixmap& image() const { return m_data; }
+    virtual QPixmap image() const;
     virtual QMimeData* mimeData() const;
 
     virtual void write( QDataStream& stream ) const;
 
+    /**
+     * The PNG compressed image, read from the image file if necessary.
+     */
+    QByteArray data() const;
+
+    /**
+     * The file the image is read from, empty if it is kept in memory.
+     */
+    const QString& fileName() const { return m_fileName; }
+
+    /**
+     * Reads the image from the image file and keeps it in memory,
+     * so the item no longer depends on the file.
+     */
+    void loadData() const;
+
+    const QSize& size() const { return m_size; }
+    int depth() const { return m_depth; }
+
 private:
     /**
-     *
+     * The PNG compressed image, empty if it is read from m_fileName
      */
-    const QPixmap m_data;
+    mutable QByteArray m_data;
+    mutable QString m_fileName;
+    const QSize m_size;
+    const int m_depth;
     /**
      * Cache for m_data's string representation
      */
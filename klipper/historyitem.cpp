@@ -58,7 +58,7 @@ HistoryItem* HistoryItem::create(const QMimeData *data)
     if (data->hasImage())
     {
         QImage image = qvariant_cast<QImage>(data->imageData());
-        return new HistoryImageItem(QPixmap::fromImage(image));
+        return new HistoryImageItem(image);
     }
 
     return 0; // Failed.
@@ -83,8 +83,16 @@ HistoryItem* HistoryItem::create(QDataStream &dataStream)
         dataStream >> text;
         return new HistoryStringItem( text );
     }
+    if ( type == "pngimage" ) {
+        QSize size;
+        qint32 depth = 0;
+        QByteArray data;
+        dataStream >> size >> depth >> data;
+        return new HistoryImageItem( data, size, depth );
+    }
     if ( type == "image" ) {
-        QPixmap image;
+        // written by older versions
+        QImage image;
         dataStream >> image;
         return new HistoryImageItem( image );
     }
@@ -49,11 +49,12 @@ public:
     }
 
     /**
-     * Return the current item as pixmap
-     * A text would be returned as a null pixmap,
+     * Return the current item as pixmap for the popup
+     * An image is returned as a thumbnail, a text
+     * would be returned as a null pixmap,
      * which is also the default implementation
      */
-    inline virtual const QPixmap& image() const;
+    inline virtual QPixmap image() const;
 
     /**
      * Returns a pointer to a QMimeData suitable for QClipboard::setMimeData().
@@ -113,9 +114,8 @@ private:
 };
 
 inline
-const QPixmap& HistoryItem::image() const {
-    static QPixmap nullPixmap;
-    return nullPixmap;
+QPixmap HistoryItem::image() const {
+    return QPixmap();
 }
 
 inline
@@ -0,0 +1,518 @@
+/* This file is part of the KDE project
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "historyjournal.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QQueue>
+#include <QtCore/QSet>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+
+#include <KDebug>
+#include <KSaveFile>
+
+#include "historyitem.h"
+#include "historyimageitem.h"
+
+namespace {
+    const quint32 journal_magic = 0x4b4c4a4e; // "KLJN"
+    const quint8 journal_version = 2;
+
+    // The journal is compacted once it has more than twice as many
+    // records as items, plus some slack for small histories
+    const int compaction_slack = 64;
+}
+
+/**
+ * Writes the image files of the journal, so that copying a large
+ * image does not block klipper while it is saved.
+ */
+class HistoryBlobWriter : public QThread
+{
+public:
+    HistoryBlobWriter();
+    virtual ~HistoryBlobWriter();
+
+    void write( const QString& fileName, const QByteArray& data );
+    /**
+     * True if fileName is about to be written
+     */
+    bool isPending( const QString& fileName );
+    /**
+     * Waits until all files have been written
+     */
+    void flush();
+    /**
+     * Drops the files which have not been written yet
+     * and waits for the one being written
+     */
+    void cancel();
+
+protected:
+    virtual void run();
+
+private:
+    struct Blob {
+        QString fileName;
+        QByteArray data;
+    };
+
+    QMutex m_mutex;
+    QWaitCondition m_blobAdded;
+    QWaitCondition m_blobWritten;
+    QQueue<Blob> m_blobs;
+    // the blob being written, empty if none
+    QString m_current;
+    bool m_stop;
+};
+
+HistoryBlobWriter::HistoryBlobWriter()
+    : m_stop( false )
+{
+}
+
+HistoryBlobWriter::~HistoryBlobWriter()
+{
+    flush();
+    m_mutex.lock();
+    m_stop = true;
+    m_blobAdded.wakeAll();
+    m_mutex.unlock();
+    wait();
+}
+
+void HistoryBlobWriter::write( const QString& fileName, const QByteArray& data )
+{
+    QMutexLocker locker( &m_mutex );
+    Blob blob;
+    blob.fileName = fileName;
+    blob.data = data;
+    m_blobs.enqueue( blob );
+    m_blobAdded.wakeOne();
+    if ( !isRunning() ) {
+        start( QThread::LowPriority );
+    }
+}
+
+bool HistoryBlobWriter::isPending( const QString& fileName )
+{
+    QMutexLocker locker( &m_mutex );
+    if ( m_current == fileName ) {
+        return true;
+    }
+    foreach ( const Blob& blob, m_blobs ) {
+        if ( blob.fileName == fileName ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void HistoryBlobWriter::flush()
+{
+    QMutexLocker locker( &m_mutex );
+    while ( !m_blobs.isEmpty() || !m_current.isEmpty() ) {
+        m_blobWritten.wait( &m_mutex );
+    }
+}
+
+void HistoryBlobWriter::cancel()
+{
+    QMutexLocker locker( &m_mutex );
+    m_blobs.clear();
+    while ( !m_current.isEmpty() ) {
+        m_blobWritten.wait( &m_mutex );
+    }
+}
+
+void HistoryBlobWriter::run()
+{
+    QMutexLocker locker( &m_mutex );
+    forever {
+        while ( m_blobs.isEmpty() && !m_stop ) {
+            m_blobAdded.wait( &m_mutex );
+        }
+        if ( m_blobs.isEmpty() ) {
+            return;
+        }
+        const Blob blob = m_blobs.dequeue();
+        m_current = blob.fileName;
+        locker.unlock();
+
+        // the same image might have been queued twice
+        if ( !QFile::exists( blob.fileName ) ) {
+            KSaveFile file( blob.fileName );
+            if ( !file.open() || file.write( blob.data ) != blob.data.size() || !file.finalize() ) {
+                kWarning() << "Failed to save history image:" << file.errorString() ;
+            }
+        }
+
+        locker.relock();
+        m_current.clear();
+        m_blobWritten.wakeAll();
+    }
+}
+
+HistoryJournal::HistoryJournal( const QString& directory )
+    : m_directory( directory )
+    , m_fileName( QDir( directory ).filePath( "history4.journal" ) )
+    , m_blobWriter( new HistoryBlobWriter )
+    , m_recordCount( 0 )
+    , m_itemCount( 0 )
+    , m_outdated( false )
+{
+}
+
+HistoryJournal::~HistoryJournal()
+{
+    // writes the pending image files
+    delete m_blobWriter;
+}
+
+bool HistoryJournal::exists() const
+{
+    return QFile::exists( m_fileName );
+}
+
+QString HistoryJournal::blobFileName( const QByteArray& hash ) const
+{
+    return QDir( m_directory ).filePath( "images/" + QString::fromLatin1( hash.toHex() ) );
+}
+
+void HistoryJournal::writeHeader( QIODevice* device ) const
+{
+    QDataStream stream( device );
+    stream << journal_magic << journal_version;
+}
+
+QList<HistoryItem*> HistoryJournal::load( int maxItems )
+{
+    static const char* const failed_load_warning =
+        "Failed to load history journal. Clipboard history cannot be read.";
+    QList<HistoryItem*> items;
+    m_file.close();
+    m_recordCount = 0;
+    m_itemCount = 0;
+    m_outdated = false;
+
+    QFile file( m_fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        kWarning() << failed_load_warning << ": " << file.errorString() ;
+        return items;
+    }
+    QDataStream stream( &file );
+    quint32 magic = 0;
+    quint8 version = 0;
+    stream >> magic >> version;
+    if ( stream.status() != QDataStream::Ok || magic != journal_magic || version != journal_version ) {
+        kWarning() << failed_load_warning << ": " << "Unknown format" ;
+        // start a new journal, the history is written by the next compaction
+        file.close();
+        QFile::remove( m_fileName );
+        m_outdated = true;
+        return items;
+    }
+
+    // Only collect the records here, the items are created
+    // once it is known which of them are still in the history
+    QList<QByteArray> order; // youngest first
+    QHash<QByteArray, QByteArray> insertRecords;
+    qint64 validSize = file.pos();
+    while ( !stream.atEnd() ) {
+        QByteArray record;
+        quint16 checksum = 0;
+        stream >> record >> checksum;
+        if ( stream.status() != QDataStream::Ok || checksum != qChecksum( record.constData(), record.size() ) ) {
+            // Most likely klipper was killed while writing the record
+            kWarning() << "Ignoring incomplete record in history journal" ;
+            break;
+        }
+        validSize = file.pos();
+        ++m_recordCount;
+
+        QDataStream record_stream( record );
+        quint8 type = 0;
+        QByteArray uuid;
+        record_stream >> type;
+        switch ( type ) {
+        case InsertRecord:
+            record_stream >> uuid;
+            order.removeOne( uuid );
+            order.prepend( uuid );
+            insertRecords.insert( uuid, record );
+            break;
+        case RemoveRecord:
+            record_stream >> uuid;
+            order.removeOne( uuid );
+            insertRecords.remove( uuid );
+            break;
+        case MoveToTopRecord:
+            record_stream >> uuid;
+            if ( order.removeOne( uuid ) ) {
+                order.prepend( uuid );
+            }
+            break;
+        case OrderRecord: {
+            QList<QByteArray> uuids;
+            record_stream >> uuids;
+            order.clear();
+            foreach ( const QByteArray& id, uuids ) {
+                if ( insertRecords.contains( id ) ) {
+                    order.append( id );
+                }
+            }
+            break;
+        }
+        default:
+            kWarning() << "Unknown record in history journal:" << type ;
+            break;
+        }
+    }
+    const qint64 size = file.size();
+    file.close();
+    if ( validSize < size ) {
+        // Don't append new records after the broken one
+        file.resize( validSize );
+    }
+
+    for ( int i = 0; i < order.count() && items.count() < maxItems; ++i ) {
+        HistoryItem* item = createItem( insertRecords.value( order.at( i ) ) );
+        if ( !item ) {
+            continue;
+        }
+        if ( item->uuid() != order.at( i ) ) {
+            // the following records would refer to the wrong item
+            m_outdated = true;
+        }
+        items.append( item );
+    }
+    m_itemCount = items.count();
+    if ( m_itemCount != order.count() ) {
+        m_outdated = true;
+    }
+
+    openForAppend();
+    return items;
+}
+
+HistoryItem* HistoryJournal::createItem( const QByteArray& record ) const
+{
+    QDataStream record_stream( record );
+    quint8 type;
+    QByteArray uuid;
+    QByteArray blobHash;
+    QByteArray payload;
+    record_stream >> type >> uuid >> blobHash >> payload;
+    QDataStream payload_stream( payload );
+    if ( !blobHash.isEmpty() ) {
+        // The image itself is only read when it is needed
+        const QString blobName = blobFileName( blobHash );
+        if ( !QFile::exists( blobName ) ) {
+            kWarning() << "Failed to restore history item: Missing image" << blobName ;
+            return 0;
+        }
+        QSize size;
+        qint32 depth = 0;
+        payload_stream >> size >> depth;
+        return new HistoryImageItem( uuid, blobName, size, depth );
+    }
+    return HistoryItem::create( payload_stream );
+}
+
+QByteArray HistoryJournal::insertRecord( const HistoryItem* item, QByteArray* blobHash )
+{
+    QByteArray payload;
+    QDataStream payload_stream( &payload, QIODevice::WriteOnly );
+
+    QByteArray hash;
+    if ( const HistoryImageItem* image = dynamic_cast<const HistoryImageItem*>( item ) ) {
+        // Images are large and often copied repeatedly, store them once per
+        // content. The uuid of an image item is the hash of the image.
+        hash = item->uuid();
+        const QString blobName = blobFileName( hash );
+        if ( image->fileName() != blobName && !QFile::exists( blobName ) && !m_blobWriter->isPending( blobName ) ) {
+            QDir( m_directory ).mkpath( "images" );
+            m_blobWriter->write( blobName, image->data() );
+        }
+        payload_stream << image->size() << qint32( image->depth() );
+    } else {
+        item->write( payload_stream );
+    }
+    if ( blobHash ) {
+        *blobHash = hash;
+    }
+
+    QByteArray record;
+    QDataStream record_stream( &record, QIODevice::WriteOnly );
+    record_stream << quint8( InsertRecord ) << item->uuid() << hash << payload;
+    return record;
+}
+
+bool HistoryJournal::openForAppend()
+{
+    if ( m_file.isOpen() ) {
+        return true;
+    }
+    QDir().mkpath( m_directory );
+    m_file.setFileName( m_fileName );
+    if ( !m_file.open( QIODevice::WriteOnly | QIODevice::Append ) ) {
+        kWarning() << "Failed to open history journal:" << m_file.errorString() ;
+        return false;
+    }
+    if ( m_file.size() == 0 ) {
+        writeHeader( &m_file );
+    }
+    return true;
+}
+
+void HistoryJournal::append( const QByteArray& record )
+{
+    if ( !openForAppend() ) {
+        return;
+    }
+    QDataStream stream( &m_file );
+    stream << record << qChecksum( record.constData(), record.size() );
+    m_file.flush();
+    ++m_recordCount;
+}
+
+void HistoryJournal::logInsert( const HistoryItem* item )
+{
+    append( insertRecord( item, 0 ) );
+    ++m_itemCount;
+}
+
+void HistoryJournal::logRemove( const QByteArray& uuid )
+{
+    QByteArray record;
+    QDataStream record_stream( &record, QIODevice::WriteOnly );
+    record_stream << quint8( RemoveRecord ) << uuid;
+    append( record );
+    m_itemCount = qMax( m_itemCount - 1, 0 );
+}
+
+void HistoryJournal::logMoveToTop( const QByteArray& uuid )
+{
+    QByteArray record;
+    QDataStream record_stream( &record, QIODevice::WriteOnly );
+    record_stream << quint8( MoveToTopRecord ) << uuid;
+    append( record );
+}
+
+void HistoryJournal::logOrder( const QList<const HistoryItem*>& items )
+{
+    QList<QByteArray> uuids;
+    foreach ( const HistoryItem* item, items ) {
+        uuids.append( item->uuid() );
+    }
+    QByteArray record;
+    QDataStream record_stream( &record, QIODevice::WriteOnly );
+    record_stream << quint8( OrderRecord ) << uuids;
+    append( record );
+    m_itemCount = uuids.count();
+}
+
+void HistoryJournal::logClear()
+{
+    clear();
+    openForAppend();
+}
+
+bool HistoryJournal::needsCompaction() const
+{
+    return m_outdated || m_recordCount > 2 * m_itemCount + compaction_slack;
+}
+
+bool HistoryJournal::compact( const QList<const HistoryItem*>& items )
+{
+    static const char* const failed_save_warning =
+        "Failed to compact history journal.";
+    QDir().mkpath( m_directory );
+    KSaveFile file( m_fileName );
+    if ( !file.open() ) {
+        kWarning() << failed_save_warning << file.errorString() ;
+        return false;
+    }
+    writeHeader( &file );
+
+    // Insert the items oldest first, so that replaying
+    // the journal yields the same order
+    QDataStream stream( &file );
+    QList<QByteArray> blobs;
+    for ( int i = items.count() - 1; i >= 0; --i ) {
+        QByteArray blobHash;
+        const QByteArray record = insertRecord( items.at( i ), &blobHash );
+        stream << record << qChecksum( record.constData(), record.size() );
+        if ( !blobHash.isEmpty() ) {
+            blobs.append( blobHash );
+        }
+    }
+    if ( stream.status() != QDataStream::Ok ) {
+        kWarning() << failed_save_warning << file.errorString() ;
+        file.abort();
+        return false;
+    }
+    if ( !file.finalize() ) {
+        kWarning() << failed_save_warning << file.errorString() ;
+        return false;
+    }
+
+    // The old file has been replaced
+    m_file.close();
+    m_recordCount = items.count();
+    m_itemCount = items.count();
+    m_outdated = false;
+    // The temporary files of the images being written must not be removed
+    m_blobWriter->flush();
+    removeBlobs( blobs );
+    openForAppend();
+    return true;
+}
+
+void HistoryJournal::clear()
+{
+    m_blobWriter->cancel();
+    m_file.close();
+    QFile::remove( m_fileName );
+    removeBlobs( QList<QByteArray>() );
+    m_recordCount = 0;
+    m_itemCount = 0;
+    m_outdated = false;
+}
+
+void HistoryJournal::removeBlobs( const QList<QByteArray>& keep ) const
+{
+    QSet<QString> keepNames;
+    foreach ( const QByteArray& hash, keep ) {
+        keepNames.insert( QString::fromLatin1( hash.toHex() ) );
+    }
+    QDir dir( QDir( m_directory ).filePath( "images" ) );
+    foreach ( const QString& name, dir.entryList( QDir::Files ) ) {
+        if ( !keepNames.contains( name ) ) {
+            dir.remove( name );
+        }
+    }
+}
+
+void HistoryJournal::flush()
+{
+    m_blobWriter->flush();
+}
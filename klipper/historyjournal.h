@@ -0,0 +1,156 @@
+/* This file is part of the KDE project
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#ifndef HISTORYJOURNAL_H
+#define HISTORYJOURNAL_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+class HistoryBlobWriter;
+class HistoryItem;
+
+/**
+ * Append-only storage of the clipboard history.
+ *
+ * Instead of writing the complete history on every save, each change
+ * of the history is appended to a journal file as a small record.
+ * The payload of image items is not part of the journal, it is stored
+ * once in a separate file named after the hash of its content, so
+ * the same image is never written twice.
+ *
+ * Image files are written by a separate thread, the journal record
+ * of an image is only useful once its file exists.
+ *
+ * Since the journal grows with every change, it is rewritten from the
+ * current history ("compacted") once it contains much more records than
+ * history items. Loading replays the records and only deserializes the
+ * items which are still part of the history. Image items only remember
+ * their file, the image is read when it is needed.
+ */
+class HistoryJournal
+{
+public:
+    /**
+     * @param directory directory for the journal and the image files
+     */
+    explicit HistoryJournal( const QString& directory );
+    ~HistoryJournal();
+
+    /**
+     * True if a journal has been written to the directory.
+     */
+    bool exists() const;
+
+    /**
+     * Replays the journal and creates the items of the resulting history,
+     * youngest first. At most maxItems items are created.
+     * Afterwards new records are appended to the journal.
+     */
+    QList<HistoryItem*> load( int maxItems );
+
+    /**
+     * Records that item was inserted at the top of the history.
+     */
+    void logInsert( const HistoryItem* item );
+
+    /**
+     * Records that the item identified by uuid was removed.
+     */
+    void logRemove( const QByteArray& uuid );
+
+    /**
+     * Records that the item identified by uuid was moved to the top.
+     */
+    void logMoveToTop( const QByteArray& uuid );
+
+    /**
+     * Records the complete order of the items of the history, youngest first,
+     * used if the history was reordered e.g. by cycling through it.
+     */
+    void logOrder( const QList<const HistoryItem*>& items );
+
+    /**
+     * Records that the history was cleared. This truncates the journal
+     * and removes all image files, so no cleared data is kept on disk.
+     */
+    void logClear();
+
+    /**
+     * True if the journal contains so many outdated records that it
+     * should be rewritten by compact().
+     */
+    bool needsCompaction() const;
+
+    /**
+     * Rewrites the journal so that it only contains items, youngest first,
+     * and removes the image files which are not used anymore.
+     */
+    bool compact( const QList<const HistoryItem*>& items );
+
+    /**
+     * Removes the journal and all image files. Images which have not been
+     * written yet are dropped.
+     */
+    void clear();
+
+    /**
+     * Waits until all image files have been written.
+     */
+    void flush();
+
+private:
+    enum RecordType {
+        InsertRecord = 1,
+        RemoveRecord,
+        MoveToTopRecord,
+        OrderRecord
+    };
+
+    QString blobFileName( const QByteArray& hash ) const;
+    /**
+     * Serializes item for an InsertRecord. The payload of images is
+     * not part of the record, it is queued for writing to a blob file.
+     */
+    QByteArray insertRecord( const HistoryItem* item, QByteArray* blobHash );
+    HistoryItem* createItem( const QByteArray& record ) const;
+    bool openForAppend();
+    void append( const QByteArray& record );
+    void writeHeader( QIODevice* device ) const;
+    void removeBlobs( const QList<QByteArray>& keep ) const;
+
+    QString m_directory;
+    QString m_fileName;
+    QFile m_file;
+    HistoryBlobWriter* m_blobWriter;
+    /**
+     * Number of records in the journal
+     */
+    int m_recordCount;
+    /**
+     * Number of items in the history described by the journal
+     */
+    int m_itemCount;
+    /**
+     * True if the journal does not describe the loaded history exactly
+     */
+    bool m_outdated;
+};
+
+#endif
@@ -31,7 +31,6 @@
 #include <KAboutData>
 #include <KLocale>
 #include <KMessageBox>
-#include <KSaveFile>
 #include <KSessionManager>
 #include <KStandardDirs>
 #include <KDebug>
@@ -51,6 +50,8 @@
 #include "version.h"
 #include "history.h"
 #include "historyitem.h"
+#include "historyimageitem.h"
+#include "historyjournal.h"
 #include "historystringitem.h"
 #include "klipperpopup.h"
 
@@ -135,6 +136,9 @@ Klipper::Klipper(QObject* parent, const KSharedConfigPtr& config)
 
 
     m_history = new History( this );
+    // don't use "appdata", klipper is also a kicker applet
+    m_journal = new HistoryJournal( KStandardDirs::locateLocal( "data", "klipper/" ) );
+    connect( m_history, SIGNAL(changed()), SLOT(slotHistoryChanged()) );
 
     // we need that collection, otherwise KToggleAction is not happy :}
     m_collection = new KActionCollection( this );
@@ -163,6 +167,8 @@ Klipper::Klipper(QObject* parent, const KSharedConfigPtr& config)
     // load previous history if configured
     if (m_bKeepContents) {
         loadHistory();
+        // start recording the changes of the history
+        saveHistory();
     }
 
     m_qrencodeexe = KStandardDirs::findExe("qrencode");
@@ -240,6 +246,8 @@ Klipper::~Klipper()
 {
     delete m_sessionManager;
     delete m_myURLGrabber;
+    m_history->setJournal( 0L );
+    delete m_journal;
 }
 
 // DBUS
@@ -304,6 +312,7 @@ void Klipper::loadSettings()
     if (!firstrun && m_bKeepContents && !KlipperSettings::keepClipboardContents()) {
         saveHistory(true);
     }
+    const bool startKeeping = !firstrun && !m_bKeepContents && KlipperSettings::keepClipboardContents();
     firstrun=false;
 
     m_bKeepContents = KlipperSettings::keepClipboardContents();
@@ -319,6 +328,9 @@ void Klipper::loadSettings()
     // this will cause it to loadSettings too
     setURLGrabberEnabled(m_bURLGrabber);
     history()->setMaxSize( KlipperSettings::maxClipItems() );
+    if (startKeeping) {
+        saveHistory();
+    }
 }
 
 void Klipper::saveSettings() const
@@ -346,6 +358,40 @@ void Klipper::showPopupMenu( QMenu* menu )
 }
 
 bool Klipper::loadHistory() {
+    // Restoring the history must not be recorded
+    history()->setJournal( 0L );
+
+    // The list is youngest-first to keep the most important
+    // clipboard items at the top
+    QList<HistoryItem*> items;
+    const bool fromJournal = m_journal->exists();
+    if ( fromJournal ) {
+        items = m_journal->load( history()->maxSize() );
+    } else if ( !loadHistoryFile( items ) ) {
+        return false;
+    }
+
+    history()->slotClear();
+
+    // The history is created oldest first
+    for ( int i = items.count() - 1; i >= 0; --i ) {
+        history()->forceInsert( items.at( i ) );
+    }
+
+    // The history file of older versions is replaced
+    // by a journal on the next save
+    if ( fromJournal ) {
+        history()->setJournal( m_journal );
+    }
+
+    if ( !history()->empty() ) {
+        setClipboard( *history()->first(), Clipboard | Selection );
+    }
+
+    return true;
+}
+
+bool Klipper::loadHistoryFile( QList<HistoryItem*>& items ) {
     static const char* const failed_load_warning =
         "Failed to load history resource. Clipboard history cannot be read.";
     // don't use "appdata", klipper is also a kicker applet
@@ -376,65 +422,52 @@ bool Klipper::loadHistory() {
     qint8 version;
     history_stream >> version;
 
-    // The list needs to be reversed, as it is saved
-    // youngest-first to keep the most important clipboard
-    // items at the top, but the history is created oldest
-    // first.
-    QList<HistoryItem*> reverseList;
     for ( HistoryItem* item = HistoryItem::create( history_stream );
           item;
           item = HistoryItem::create( history_stream ) )
     {
-        reverseList.prepend( item );
-    }
-
-    history()->slotClear();
-
-    for ( QList<HistoryItem*>::const_iterator it = reverseList.constBegin();
-          it != reverseList.constEnd();
-          ++it )
-    {
-        history()->forceInsert( *it );
-    }
-
-    if ( !history()->empty() ) {
-        setClipboard( *history()->first(), Clipboard | Selection );
+        items.append( item );
     }
 
     return true;
 }
 
 void Klipper::saveHistory(bool empty) {
-    static const char* const failed_save_warning =
-        "Failed to save history. Clipboard history cannot be saved.";
     // don't use "appdata", klipper is also a kicker applet
-    QString history_file_name( KStandardDirs::locateLocal( "data", "klipper/history4.lst" ) );
-    if ( history_file_name.isNull() || history_file_name.isEmpty() ) {
-        kWarning() << failed_save_warning ;
+    const QString history_file_name( KStandardDirs::locateLocal( "data", "klipper/history4.lst" ) );
+    if (empty) {
+        // Don't leave anything of the history on disk, the restored
+        // images have to be read before their files are removed
+        history()->setJournal( 0L );
+        foreach ( const HistoryItem* item, history()->items() ) {
+            if ( const HistoryImageItem* image = dynamic_cast<const HistoryImageItem*>( item ) ) {
+                image->loadData();
+            }
+        }
+        m_journal->clear();
+        QFile::remove( history_file_name );
         return;
     }
-    KSaveFile history_file( history_file_name );
-    if ( !history_file.open() ) {
-        kWarning() << failed_save_warning ;
+
+    // The journal already contains every change of the history, it only
+    // has to be written completely if it is not used yet or grew too much
+    if ( history()->journal() && !m_journal->needsCompaction() ) {
         return;
     }
-    QByteArray data;
-    QDataStream history_stream( &data, QIODevice::WriteOnly );
-    history_stream << klipper_version_int;
-
-    if (!empty) {
-        const HistoryItem *item = history()->first();
-        if (item) {
-            do {
-                history_stream << item;
-                item = history()->find(item->next_uuid());
-            } while (item != history()->first());
-        }
+    if ( !m_journal->compact( history()->items() ) ) {
+        kWarning() << "Failed to save history. Clipboard history cannot be saved." ;
+        return;
     }
+    history()->setJournal( m_journal );
+    QFile::remove( history_file_name );
+}
 
-    QByteArray hash = QCryptographicHash::hash( data, KlipperHashAlgorithm ).toHex();
-    QDataStream ds ( &history_file );
-    ds << hash << data;
+void Klipper::slotHistoryChanged()
+{
+    // Rewrite the journal from time to time, so it does not grow without bounds
+    if ( history()->journal() && m_journal->needsCompaction() ) {
+        saveHistory();
+    }
 }
 
 // save session on shutdown. Don't simply use the c'tor, as that may not be called.
@@ -442,6 +475,8 @@ void Klipper::saveSession()
 {
     if ( m_bKeepContents ) { // save the clipboard eventually
         saveHistory();
+        // the destructor might not be called either
+        m_journal->flush();
     }
     saveSettings();
 }
@@ -1044,7 +1079,9 @@ void Klipper::slotAskClearHistory()
     if (clearHist == KMessageBox::Yes) {
       history()->slotClear();
       slotClearClipboard();
-      saveHistory();
+      if ( m_bKeepContents ) {
+          saveHistory();
+      }
     }
 
 }
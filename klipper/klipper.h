@@ -43,6 +43,7 @@ class KActionCollection;
 class URLGrabber;
 class History;
 class HistoryItem;
+class HistoryJournal;
 class KlipperSessionManager;
 
 class Klipper : public QObject
@@ -103,6 +104,8 @@ protected:
 
     /**
      * Save history to disk
+     * All changes of the history are written to the history journal right
+     * away, so this only rewrites the journal if it has grown too much.
      * @empty save empty history instead of actual history
      */
     void saveHistory(bool empty = false);
@@ -150,7 +153,13 @@ private Q_SLOTS:
 
     void loadSettings();
 
+    void slotHistoryChanged();
+
 private:
+    /**
+     * Reads the history file of older klipper versions, youngest item first.
+     */
+    bool loadHistoryFile( QList<HistoryItem*>& items );
 
     static void updateTimestamp();
 
@@ -159,6 +168,7 @@ private:
     QElapsedTimer m_showTimer;
 
     History* m_history;
+    HistoryJournal* m_journal;
     int m_overflowCounter;
 
     KToggleAction* m_toggleURLGrabAction;
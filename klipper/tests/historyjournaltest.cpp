@@ -0,0 +1,286 @@
+/* This file is part of the KDE project
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtGui/QImage>
+#include <qtest_kde.h>
+
+#include <KTempDir>
+
+#include "historyjournal.h"
+#include "historyimageitem.h"
+#include "historystringitem.h"
+
+class HistoryJournalTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init()
+    {
+        m_dir = new KTempDir();
+        QVERIFY( m_dir->exists() );
+    }
+
+    void cleanup()
+    {
+        delete m_dir;
+        m_dir = 0;
+    }
+
+    void testReplay()
+    {
+        HistoryStringItem a( "a" );
+        HistoryStringItem b( "b" );
+        HistoryStringItem c( "c" );
+        HistoryStringItem d( "d" );
+        {
+            HistoryJournal journal( m_dir->name() );
+            QVERIFY( !journal.exists() );
+            journal.logInsert( &a );
+            journal.logInsert( &b );
+            journal.logInsert( &c );
+            journal.logMoveToTop( a.uuid() );
+            journal.logRemove( b.uuid() );
+            journal.logInsert( &d );
+            QVERIFY( journal.exists() );
+        }
+
+        HistoryJournal journal( m_dir->name() );
+        QList<HistoryItem*> items = journal.load( 10 );
+        QCOMPARE( texts( items ), QStringList() << "d" << "a" << "c" );
+        QVERIFY( !journal.needsCompaction() );
+        qDeleteAll( items );
+
+        // Records are appended to the replayed journal
+        QList<const HistoryItem*> order;
+        order << &c << &d << &a;
+        journal.logOrder( order );
+        items = journal.load( 10 );
+        QCOMPARE( texts( items ), QStringList() << "c" << "d" << "a" );
+        qDeleteAll( items );
+
+        // Only the youngest items are created
+        items = journal.load( 2 );
+        QCOMPARE( texts( items ), QStringList() << "c" << "d" );
+        QVERIFY( journal.needsCompaction() );
+        qDeleteAll( items );
+    }
+
+    void testTruncatedRecord()
+    {
+        HistoryStringItem a( "a" );
+        HistoryStringItem b( "b" );
+        HistoryStringItem c( "c" );
+        qint64 validSize = 0;
+        {
+            HistoryJournal journal( m_dir->name() );
+            journal.logInsert( &a );
+            journal.logInsert( &b );
+            validSize = QFileInfo( journalFileName() ).size();
+            journal.logInsert( &c );
+        }
+
+        // klipper got killed while writing the last record
+        QFile file( journalFileName() );
+        QVERIFY( file.size() > validSize + 2 );
+        QVERIFY( file.resize( file.size() - 2 ) );
+
+        HistoryJournal journal( m_dir->name() );
+        QList<HistoryItem*> items = journal.load( 10 );
+        QCOMPARE( texts( items ), QStringList() << "b" << "a" );
+        qDeleteAll( items );
+        // The broken record is cut off, so new records can be appended
+        QCOMPARE( QFileInfo( journalFileName() ).size(), validSize );
+
+        journal.logInsert( &c );
+        items = journal.load( 10 );
+        QCOMPARE( texts( items ), QStringList() << "c" << "b" << "a" );
+        qDeleteAll( items );
+    }
+
+    void testCorruptRecord()
+    {
+        HistoryStringItem a( "a" );
+        HistoryStringItem b( "b" );
+        {
+            HistoryJournal journal( m_dir->name() );
+            journal.logInsert( &a );
+            journal.logInsert( &b );
+        }
+
+        // Damage the text of the last record, so its checksum does not match
+        QFile file( journalFileName() );
+        QVERIFY( file.open( QIODevice::ReadWrite ) );
+        QByteArray data = file.readAll();
+        const int pos = data.lastIndexOf( 'b' );
+        QVERIFY( pos > 0 );
+        data[pos] = 'x';
+        QVERIFY( file.seek( 0 ) );
+        QCOMPARE( file.write( data ), qint64( data.size() ) );
+        file.close();
+
+        HistoryJournal journal( m_dir->name() );
+        QList<HistoryItem*> items = journal.load( 10 );
+        QCOMPARE( texts( items ), QStringList() << "a" );
+        qDeleteAll( items );
+    }
+
+    void testUnknownFormat()
+    {
+        QFile file( journalFileName() );
+        QVERIFY( file.open( QIODevice::WriteOnly ) );
+        file.write( "history4.lst" );
+        file.close();
+
+        HistoryJournal journal( m_dir->name() );
+        QVERIFY( journal.exists() );
+        QVERIFY( journal.load( 10 ).isEmpty() );
+        QVERIFY( !journal.exists() );
+        QVERIFY( journal.needsCompaction() );
+    }
+
+    void testCompaction()
+    {
+        HistoryStringItem a( "a" );
+        HistoryStringItem b( "b" );
+        HistoryJournal journal( m_dir->name() );
+        journal.logInsert( &a );
+        journal.logInsert( &b );
+        int records = 2;
+        while ( !journal.needsCompaction() ) {
+            journal.logMoveToTop( a.uuid() );
+            journal.logMoveToTop( b.uuid() );
+            records += 2;
+            QVERIFY( records < 1000 );
+        }
+        const qint64 size = QFileInfo( journalFileName() ).size();
+
+        QList<const HistoryItem*> order;
+        order << &a << &b;
+        QVERIFY( journal.compact( order ) );
+        QVERIFY( !journal.needsCompaction() );
+        QVERIFY( QFileInfo( journalFileName() ).size() < size );
+
+        QList<HistoryItem*> items = journal.load( 10 );
+        QCOMPARE( texts( items ), QStringList() << "a" << "b" );
+        qDeleteAll( items );
+    }
+
+    void testImages()
+    {
+        QImage image( 32, 16, QImage::Format_RGB32 );
+        image.fill( Qt::red );
+        HistoryImageItem red( image );
+        image.fill( Qt::blue );
+        HistoryImageItem blue( image );
+        HistoryImageItem blueAgain( image );
+        HistoryStringItem text( "text" );
+
+        HistoryJournal journal( m_dir->name() );
+        journal.logInsert( &red );
+        journal.logInsert( &blue );
+        journal.logRemove( blue.uuid() );
+        journal.logInsert( &blueAgain );
+        journal.logInsert( &text );
+        journal.flush();
+        // Each image is stored once
+        QCOMPARE( imageFiles().count(), 2 );
+
+        QList<HistoryItem*> items = journal.load( 10 );
+        QCOMPARE( items.count(), 3 );
+        HistoryImageItem* loaded = dynamic_cast<HistoryImageItem*>( items.at( 1 ) );
+        QVERIFY( loaded );
+        QCOMPARE( loaded->uuid(), blue.uuid() );
+        QCOMPARE( loaded->size(), QSize( 32, 16 ) );
+        QCOMPARE( loaded->depth(), image.depth() );
+        // The image is read from its file when it is needed
+        QVERIFY( !loaded->fileName().isEmpty() );
+        QCOMPARE( loaded->data(), blue.data() );
+
+        // Compacting does not need to read the images
+        QList<const HistoryItem*> order;
+        order << items.at( 0 ) << items.at( 1 );
+        QVERIFY( journal.compact( order ) );
+        QCOMPARE( imageFiles(), QStringList() << QString::fromLatin1( blue.uuid().toHex() ) );
+
+        // Items which are still used keep their image after clearing
+        loaded->loadData();
+        journal.clear();
+        QVERIFY( !journal.exists() );
+        QVERIFY( imageFiles().isEmpty() );
+        QVERIFY( loaded->fileName().isEmpty() );
+        QCOMPARE( loaded->data(), blue.data() );
+        qDeleteAll( items );
+    }
+
+    void testMissingImage()
+    {
+        QImage image( 8, 8, QImage::Format_RGB32 );
+        image.fill( Qt::green );
+        HistoryImageItem green( image );
+        HistoryStringItem text( "text" );
+        {
+            HistoryJournal journal( m_dir->name() );
+            journal.logInsert( &green );
+            journal.logInsert( &text );
+        }
+        foreach ( const QString& name, imageFiles() ) {
+            QVERIFY( QDir( imageDir() ).remove( name ) );
+        }
+
+        HistoryJournal journal( m_dir->name() );
+        QList<HistoryItem*> items = journal.load( 10 );
+        QCOMPARE( texts( items ), QStringList() << "text" );
+        QVERIFY( journal.needsCompaction() );
+        qDeleteAll( items );
+    }
+
+private:
+    QString journalFileName() const
+    {
+        return QDir( m_dir->name() ).filePath( "history4.journal" );
+    }
+
+    QString imageDir() const
+    {
+        return QDir( m_dir->name() ).filePath( "images" );
+    }
+
+    QStringList imageFiles() const
+    {
+        return QDir( imageDir() ).entryList( QDir::Files );
+    }
+
+    static QStringList texts( const QList<HistoryItem*>& items )
+    {
+        QStringList result;
+        foreach ( const HistoryItem* item, items ) {
+            result.append( item->text() );
+        }
+        return result;
+    }
+
+    KTempDir* m_dir;
+};
+
+QTEST_KDEMAIN( HistoryJournalTest, NoGUI )
+
+#include "historyjournaltest.moc"
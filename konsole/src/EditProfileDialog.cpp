@@ -964,6 +964,9 @@ void EditProfileDialog::setupScrollingPage(const Profile::Ptr profile)
     const int historySize = profile->historySize();
     _ui->historySizeWidget->setLineCount(historySize);
 
+    // setup scrollback storage check box
+    _ui->historySizeWidget->setMappedHistory(profile->property<bool>(Profile::MappedHistory));
+
     // setup scrollpageamount type radio
     int scrollFullPage = profile->property<int>(Profile::ScrollFullPage);
 
@@ -978,6 +981,8 @@ void EditProfileDialog::setupScrollingPage(const Profile::Ptr profile)
     // signals and slots
     connect(_ui->historySizeWidget, SIGNAL(historySizeChanged(int)),
             this, SLOT(historySizeChanged(int)));
+    connect(_ui->historySizeWidget, SIGNAL(mappedHistoryChanged(bool)),
+            this, SLOT(mappedHistoryChanged(bool)));
 }
 
 void EditProfileDialog::historySizeChanged(int lineCount)
@@ -988,6 +993,10 @@ void EditProfileDialog::historyModeChanged(Enum::HistoryModeEnum mode)
 {
     updateTempProfileProperty(Profile::HistoryMode, mode);
 }
+void EditProfileDialog::mappedHistoryChanged(bool mapped)
+{
+    updateTempProfileProperty(Profile::MappedHistory, mapped);
+}
 void EditProfileDialog::hideScrollBar()
 {
     updateTempProfileProperty(Profile::ScrollBarPosition, Enum::ScrollBarHidden);
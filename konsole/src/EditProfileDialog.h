@@ -140,6 +140,7 @@ private slots:
     void historyModeChanged(Enum::HistoryModeEnum mode);
 
     void historySizeChanged(int);
+    void mappedHistoryChanged(bool);
 
     void hideScrollBar();
     void showScrollBarLeft();
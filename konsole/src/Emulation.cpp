@@ -196,6 +196,12 @@ void Emulation::receiveChar(int c)
     }
 }
 
+void Emulation::receiveChars(const ushort* chars, int length)
+{
+    for (int i = 0; i < length; i++)
+        receiveChar(chars[i]);
+}
+
 void Emulation::sendKeyEvent(QKeyEvent* ev)
 {
     emit stateSet(NOTIFYNORMAL);
@@ -231,8 +237,7 @@ void Emulation::receiveData(const char* text, int length)
     QString unicodeText = _decoder->toUnicode(text, length);
 
     //send characters to terminal emulator
-    for (int i = 0; i < unicodeText.length(); i++)
-        receiveChar(unicodeText[i].unicode());
+    receiveChars(unicodeText.utf16(), unicodeText.length());
 
     //look for z-modem indicator
     //-- someone who understands more about z-modems that I do may be able to move
@@ -252,6 +257,11 @@ void Emulation::writeToStream(TerminalCharacterDecoder* decoder ,
     _currentScreen->writeLinesToStream(decoder, startLine, endLine);
 }
 
+const HistorySearchIndex& Emulation::historySearchIndex() const
+{
+    return _currentScreen->historySearchIndex();
+}
+
 int Emulation::lineCount() const
 {
     // sum number of lines currently on _screen plus number of lines in history
@@ -267,6 +277,7 @@ void Emulation::showBulk()
 
     _currentScreen->resetScrolledLines();
     _currentScreen->resetDroppedLines();
+    _currentScreen->resetDirtyLines();
 }
 
 void Emulation::bufferedUpdate()
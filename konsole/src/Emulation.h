@@ -35,6 +35,7 @@
 namespace Konsole
 {
 class KeyboardTranslator;
+class HistorySearchIndex;
 class HistoryType;
 class Screen;
 class ScreenWindow;
@@ -164,6 +165,13 @@ public:
      */
     virtual void writeToStream(TerminalCharacterDecoder* decoder, int startLine, int endLine);
 
+    /**
+     * Returns the search index of the history of the current screen.
+     * The lines of the index correspond to the first lines of the output,
+     * see writeToStream().
+     */
+    const HistorySearchIndex& historySearchIndex() const;
+
     /** Returns the codec used to decode incoming characters.  See setCodec() */
     const QTextCodec* codec() const {
         return _codec;
@@ -423,6 +431,17 @@ protected:
      */
     virtual void receiveChar(int ch);
 
+    /**
+     * Processes a block of incoming characters.  See receiveData()
+     *
+     * The default implementation calls receiveChar() for each character.
+     * Emulations can reimplement it to handle runs of characters at once.
+     *
+     * @p chars An array of unicode character codes.
+     * @p length The number of characters in @p chars
+     */
+    virtual void receiveChars(const ushort* chars, int length);
+
     /**
      * Sets the active screen.  The terminal has two screens, primary and alternate.
      * The primary screen is used by default.  When certain interactive programs such
@@ -25,6 +25,7 @@
 #include <QApplication>
 #include <QtGui/QClipboard>
 #include <QtCore/QString>
+#include <QtCore/QtAlgorithms>
 #include <QtCore/QTextStream>
 
 // KDE
@@ -191,20 +192,20 @@ void Filter::getLineColumn(int position , int& startLine , int& startColumn)
     Q_ASSERT(_linePositions);
     Q_ASSERT(_buffer);
 
-    for (int i = 0 ; i < _linePositions->count() ; i++) {
-        int nextLine = 0;
+    if (position < 0 || position > _buffer->length())
+        return;
 
-        if (i == _linePositions->count() - 1)
-            nextLine = _buffer->length() + 1;
-        else
-            nextLine = _linePositions->value(i + 1);
+    // the line positions are sorted, the line is the last one which
+    // starts at or before 'position'
+    QList<int>::const_iterator iter = qUpperBound(_linePositions->constBegin(),
+                                      _linePositions->constEnd(),
+                                      position);
+    if (iter == _linePositions->constBegin())
+        return;
 
-        if (_linePositions->value(i) <= position && position < nextLine) {
-            startLine = i;
-            startColumn = string_width(buffer()->mid(_linePositions->value(i), position - _linePositions->value(i)));
-            return;
-        }
-    }
+    const int i = (iter - _linePositions->constBegin()) - 1;
+    startLine = i;
+    startColumn = string_width(buffer()->mid(_linePositions->value(i), position - _linePositions->value(i)));
 }
 
 /*void Filter::addLine(const QString& text)
@@ -291,6 +292,7 @@ void Filter::HotSpot::setType(Type type)
 }
 
 RegExpFilter::RegExpFilter()
+    : _lineMatchesCached(false)
 {
 }
 
@@ -316,6 +318,12 @@ QStringList RegExpFilter::HotSpot::capturedTexts() const
 void RegExpFilter::setRegExp(const QRegExp& regExp)
 {
     _searchText = regExp;
+    _lineMatches.clear();
+}
+void RegExpFilter::setLineMatchesCached(bool cached)
+{
+    _lineMatchesCached = cached;
+    _lineMatches.clear();
 }
 QRegExp RegExpFilter::regExp() const
 {
@@ -327,34 +335,69 @@ QRegExp RegExpFilter::regExp() const
 }*/
 void RegExpFilter::process()
 {
-    int pos = 0;
     const QString* text = buffer();
 
     Q_ASSERT(text);
 
     // ignore any regular expressions which match an empty string.
-    // otherwise the while loop below will run indefinitely
+    // otherwise the loop in findMatches() will run indefinitely
     static const QString emptyString("");
     if (_searchText.exactMatch(emptyString))
         return;
 
-    while (pos >= 0) {
-        pos = _searchText.indexIn(*text, pos);
+    if (!_lineMatchesCached) {
+        addHotSpots(0, findMatches(*text));
+        return;
+    }
 
-        if (pos >= 0) {
-            int startLine = 0;
-            int endLine = 0;
-            int startColumn = 0;
-            int endColumn = 0;
+    // the matches are looked up by the text of the line, so that the
+    // lines which are still visible after the output has been scrolled
+    // or updated do not need to be searched again
+    QHash<QString, QList<Match> > lineMatches;
+
+    int lineStart = 0;
+    while (lineStart < text->length()) {
+        int lineEnd = text->indexOf(QLatin1Char('\n'), lineStart);
+        if (lineEnd == -1)
+            lineEnd = text->length();
+
+        if (lineEnd > lineStart) {
+            const QString line = text->mid(lineStart, lineEnd - lineStart);
+
+            QHash<QString, QList<Match> >::const_iterator iter = lineMatches.constFind(line);
+            if (iter == lineMatches.constEnd()) {
+                QHash<QString, QList<Match> >::const_iterator cached = _lineMatches.constFind(line);
+                if (cached != _lineMatches.constEnd())
+                    iter = lineMatches.insert(line, cached.value());
+                else
+                    iter = lineMatches.insert(line, findMatches(line));
+            }
+
+            addHotSpots(lineStart, iter.value());
+        }
+
+        lineStart = lineEnd + 1;
+    }
 
-            getLineColumn(pos, startLine, startColumn);
-            getLineColumn(pos + _searchText.matchedLength(), endLine, endColumn);
+    // only remember the lines of this pass
+    _lineMatches = lineMatches;
+}
+
+QList<RegExpFilter::Match> RegExpFilter::findMatches(const QString& text)
+{
+    QList<Match> matches;
+
+    int pos = 0;
+    while (pos >= 0) {
+        pos = _searchText.indexIn(text, pos);
 
-            RegExpFilter::HotSpot* spot = newHotSpot(startLine, startColumn,
-                                          endLine, endColumn);
-            spot->setCapturedTexts(_searchText.capturedTexts());
+        if (pos >= 0) {
+            Match match;
+            match.position = pos;
+            match.length = _searchText.matchedLength();
+            match.capturedTexts = _searchText.capturedTexts();
+            matches << match;
 
-            addHotSpot(spot);
             pos += _searchText.matchedLength();
 
             // if matchedLength == 0, the program will get stuck in an infinite loop
@@ -362,6 +405,27 @@ void RegExpFilter::process()
                 pos = -1;
         }
     }
+
+    return matches;
+}
+
+void RegExpFilter::addHotSpots(int offset, const QList<Match>& matches)
+{
+    foreach(const Match& match, matches) {
+        int startLine = 0;
+        int endLine = 0;
+        int startColumn = 0;
+        int endColumn = 0;
+
+        getLineColumn(offset + match.position, startLine, startColumn);
+        getLineColumn(offset + match.position + match.length, endLine, endColumn);
+
+        RegExpFilter::HotSpot* spot = newHotSpot(startLine, startColumn,
+                                      endLine, endColumn);
+        spot->setCapturedTexts(match.capturedTexts);
+
+        addHotSpot(spot);
+    }
 }
 
 RegExpFilter::HotSpot* RegExpFilter::newHotSpot(int startLine, int startColumn,
@@ -443,6 +507,9 @@ const QRegExp UrlFilter::CompleteUrlRegExp('(' + FullUrlRegExp.pattern() + '|' +
 UrlFilter::UrlFilter()
 {
     setRegExp(CompleteUrlRegExp);
+
+    // URLs and email addresses do not contain line breaks
+    setLineMatchesCached(true);
 }
 UrlFilter::HotSpot::~HotSpot()
 {
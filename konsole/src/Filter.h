@@ -21,6 +21,7 @@
 #define FILTER_H
 
 // Qt
+#include <QtCore/QHash>
 #include <QtCore/QList>
 #include <QtCore/QObject>
 #include <QtCore/QStringList>
@@ -213,6 +214,17 @@ public:
     /** Returns the regular expression which the filter searches for in blocks of text */
     QRegExp regExp() const;
 
+    /**
+     * Sets whether the filter searches each line of the text buffer separately
+     * and remembers the matches found on each line until the next call to process().
+     *
+     * Lines with the same text as in the previous call to process() are not searched
+     * again then, for example after the output has been scrolled.  This is only
+     * suitable for regular expressions which can not match line breaks and do not
+     * use anchors.  Defaults to false.
+     */
+    void setLineMatchesCached(bool cached);
+
     /**
      * Reimplemented to search the filter's text buffer for text matching regExp()
      *
@@ -230,7 +242,23 @@ protected:
             int endLine, int endColumn);
 
 private:
+    struct Match {
+        int position;
+        int length;
+        QStringList capturedTexts;
+    };
+
+    // returns the matches for the regular expression in 'text'
+    QList<Match> findMatches(const QString& text);
+    // adds hotspots for 'matches', whose positions are relative to the
+    // position 'offset' in the buffer
+    void addHotSpots(int offset, const QList<Match>& matches);
+
     QRegExp _searchText;
+
+    bool _lineMatchesCached;
+    // matches found on each line by the last call to process()
+    QHash<QString, QList<Match> > _lineMatches;
 };
 
 class FilterObject;
@@ -29,6 +29,10 @@
 #include <unistd.h>
 #include <errno.h>
 
+// Qt
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+
 // KDE
 #include <kde_file.h>
 #include <KDebug>
@@ -37,6 +41,18 @@
 // Reasonable line size
 static const int LINE_SIZE = 1024;
 
+// Size of the blocks of MappedHistoryScroll. A line with the maximum
+// length of 0xFFFF characters and formats always fits into one block.
+static const int MAPPED_BLOCK_SIZE = 1024 * 1024;
+
+// Number of full blocks of MappedHistoryScroll which are kept uncompressed
+static const int MAPPED_UNCOMPRESSED_BLOCKS = 2;
+
+// Number of compressed blocks of MappedHistoryScroll which are kept
+// uncompressed after reading them, scrolling back and forth over a block
+// boundary would otherwise uncompress the same blocks again and again
+static const int MAPPED_CACHED_BLOCKS = 4;
+
 using namespace Konsole;
 
 /*
@@ -546,6 +562,482 @@ bool CompactHistoryScroll::isWrappedLine(int lineNumber)
     return _lines[lineNumber]->isWrapped();
 }
 
+////////////////////////////////////////////////////////////////
+// Mapped History Scroll ///////////////////////////////////////
+////////////////////////////////////////////////////////////////
+
+namespace Konsole
+{
+/*
+   Compresses blocks of a MappedHistoryScroll. The thread is only
+   running while there are blocks to compress, so that idle sessions
+   don't keep a thread around.
+*/
+class MappedHistoryCompressor : public QThread
+{
+public:
+    struct Job {
+        int serial;
+        QByteArray data;
+    };
+
+    MappedHistoryCompressor() : _running(false) {}
+
+    void enqueue(int serial, const QByteArray& data) {
+        QMutexLocker locker(&_mutex);
+        const Job job = {serial, data};
+        _jobs.append(job);
+        if (!_running) {
+            _running = true;
+            // the previous run() might still be returning
+            wait();
+            start(QThread::LowestPriority);
+        }
+    }
+
+    QList<Job> takeResults() {
+        QMutexLocker locker(&_mutex);
+        QList<Job> results;
+        results.swap(_results);
+        return results;
+    }
+
+    void cancel() {
+        QMutexLocker locker(&_mutex);
+        _jobs.clear();
+    }
+
+protected:
+    virtual void run() {
+        while (true) {
+            Job job;
+            {
+                QMutexLocker locker(&_mutex);
+                if (_jobs.isEmpty()) {
+                    _running = false;
+                    return;
+                }
+                job = _jobs.takeFirst();
+            }
+
+            job.data = qCompress(job.data, 1);
+
+            QMutexLocker locker(&_mutex);
+            _results.append(job);
+        }
+    }
+
+private:
+    QMutex _mutex;
+    QList<Job> _jobs;
+    QList<Job> _results;
+    bool _running;
+};
+}
+
+static qint64 roundToPageSize(qint64 size)
+{
+    static const qint64 pageSize = sysconf(_SC_PAGESIZE);
+    return (size + pageSize - 1) / pageSize * pageSize;
+}
+
+MappedHistoryScroll::MappedHistoryScroll(int maxLineCount)
+    : HistoryScroll(new MappedHistoryType(maxLineCount))
+    , _fd(-1)
+    , _fileSize(0)
+    , _firstBlockSerial(0)
+    , _nextCompressionSerial(0)
+    , _pendingCompressions(0)
+    , _compressor(new MappedHistoryCompressor())
+    , _cachedBlocks(MAPPED_CACHED_BLOCKS)
+    , _firstLine(0)
+    , _maxLineCount(maxLineCount)
+{
+    const QString tmpFormat = KStandardDirs::locateLocal("tmp", QString())
+                              + "konsole-XXXXXX.history";
+    _tmpFile.setFileTemplate(tmpFormat);
+    if (_tmpFile.open()) {
+        _tmpFile.setAutoRemove(true);
+        _fd = _tmpFile.handle();
+    }
+}
+
+MappedHistoryScroll::~MappedHistoryScroll()
+{
+    _compressor->cancel();
+    _compressor->wait();
+    delete _compressor;
+
+    foreach (Block* block, _blocks) {
+        if (block->data)
+            munmap(block->data, block->size);
+        delete block;
+    }
+}
+
+int MappedHistoryScroll::getLines()
+{
+    return _lines.size() - _firstLine;
+}
+
+int MappedHistoryScroll::getLineLen(int lineNumber)
+{
+    if (lineNumber < 0 || lineNumber >= getLines())
+        return 0;
+
+    return lineEntry(lineNumber).length;
+}
+
+bool MappedHistoryScroll::isWrappedLine(int lineNumber)
+{
+    if (lineNumber < 0 || lineNumber >= getLines())
+        return false;
+
+    return lineEntry(lineNumber).wrapped;
+}
+
+void MappedHistoryScroll::getCells(int lineNumber, int startColumn, int count, Character buffer[])
+{
+    if (count == 0) return;
+    Q_ASSERT(lineNumber >= 0 && lineNumber < getLines());
+
+    const LineEntry& line = lineEntry(lineNumber);
+    Q_ASSERT(startColumn >= 0 && startColumn + count <= line.length);
+
+    const quint8* data = blockData(line.block);
+    if (!data) {
+        for (int i = 0; i < count; i++)
+            buffer[i] = Character();
+        return;
+    }
+
+    const CharacterFormat* formats = reinterpret_cast<const CharacterFormat*>(data + line.position);
+    const quint16* text = reinterpret_cast<const quint16*>(formats + line.formatCount);
+
+    // Only the requested columns are decoded, so look up the format
+    // of the first requested column
+    int formatPos = 0;
+    int last = line.formatCount;
+    while (last - formatPos > 1) {
+        const int middle = (formatPos + last) / 2;
+        if (formats[middle].startPos <= startColumn)
+            formatPos = middle;
+        else
+            last = middle;
+    }
+
+    for (int i = startColumn; i < startColumn + count; i++) {
+        while ((formatPos + 1) < line.formatCount && i >= formats[formatPos + 1].startPos)
+            formatPos++;
+
+        Character& c = buffer[i - startColumn];
+        c.character = text[i];
+        c.rendition = formats[formatPos].rendition;
+        c.foregroundColor = formats[formatPos].fgColor;
+        c.backgroundColor = formats[formatPos].bgColor;
+        c.isRealCharacter = formats[formatPos].isRealCharacter;
+    }
+}
+
+void MappedHistoryScroll::addCellsVector(const TextLine& cells)
+{
+    addCells(cells.constData(), cells.size());
+}
+
+void MappedHistoryScroll::addCells(const Character a[], int count)
+{
+    applyCompressedBlocks();
+
+    // CharacterFormat::startPos limits the length of a line
+    const int length = qMin(count, 0xFFFF);
+
+    int formatCount = (length > 0) ? 1 : 0;
+    for (int i = 1; i < length; i++) {
+        if (!a[i].equalsFormat(a[i - 1]) || a[i].isRealCharacter != a[i - 1].isRealCharacter)
+            formatCount++;
+    }
+
+    // keep the records aligned for CharacterFormat
+    const int size = (formatCount * sizeof(CharacterFormat) + length * sizeof(quint16) + 3) & ~3;
+
+    Block* block = _blocks.isEmpty() ? 0 : _blocks.last();
+    if (!block || block->size - block->used < size)
+        block = appendBlock();
+
+    LineEntry line;
+    line.block = _firstBlockSerial + _blocks.size() - 1;
+    line.position = block->used;
+    line.length = length;
+    line.formatCount = formatCount;
+    line.wrapped = false;
+
+    CharacterFormat* formats = reinterpret_cast<CharacterFormat*>(block->data + block->used);
+    quint16* text = reinterpret_cast<quint16*>(formats + formatCount);
+    int j = 0;
+    for (int i = 0; i < length; i++) {
+        if (i == 0 || !a[i].equalsFormat(a[i - 1]) || a[i].isRealCharacter != a[i - 1].isRealCharacter) {
+            formats[j].setFormat(a[i]);
+            formats[j].startPos = i;
+            j++;
+        }
+        text[i] = a[i].character;
+    }
+
+    block->used += size;
+    block->lineCount++;
+    _lines.append(line);
+
+    if (_maxLineCount >= 0) {
+        while (getLines() > _maxLineCount)
+            removeFirstLine();
+    }
+}
+
+void MappedHistoryScroll::addLine(bool previousWrapped)
+{
+    if (getLines() > 0)
+        _lines.last().wrapped = previousWrapped;
+}
+
+void MappedHistoryScroll::setMaxNbLines(int lineCount)
+{
+    _maxLineCount = lineCount;
+
+    delete _historyType;
+    _historyType = new MappedHistoryType(lineCount);
+
+    if (_maxLineCount >= 0) {
+        while (getLines() > _maxLineCount)
+            removeFirstLine();
+    }
+}
+
+void MappedHistoryScroll::waitForCompression()
+{
+    _compressor->wait();
+    applyCompressedBlocks();
+}
+
+int MappedHistoryScroll::compressedBlockCount() const
+{
+    int count = 0;
+    foreach (const Block* block, _blocks) {
+        if (block->compressedSize > 0)
+            count++;
+    }
+    return count;
+}
+
+const MappedHistoryScroll::LineEntry& MappedHistoryScroll::lineEntry(int lineNumber) const
+{
+    return _lines.at(_firstLine + lineNumber);
+}
+
+MappedHistoryScroll::Block* MappedHistoryScroll::block(int serial) const
+{
+    const int index = serial - _firstBlockSerial;
+    return (index >= 0 && index < _blocks.size()) ? _blocks.at(index) : 0;
+}
+
+const quint8* MappedHistoryScroll::blockData(int serial)
+{
+    const Block* compressedBlock = block(serial);
+    Q_ASSERT(compressedBlock);
+    if (compressedBlock->data)
+        return compressedBlock->data;
+
+    const QByteArray* cached = _cachedBlocks.object(serial);
+    if (!cached) {
+        QByteArray compressed(compressedBlock->compressedSize, Qt::Uninitialized);
+        const ssize_t rc = pread(_fd, compressed.data(), compressed.size(), compressedBlock->offset);
+        if (rc != compressed.size()) {
+            perror("MappedHistoryScroll::blockData.read");
+            return 0;
+        }
+        QByteArray* uncompressed = new QByteArray(qUncompress(compressed));
+        if (uncompressed->isEmpty()) {
+            kWarning() << "uncompressing history block failed.";
+            delete uncompressed;
+            return 0;
+        }
+        // evicts the least recently used block if the cache is full
+        _cachedBlocks.insert(serial, uncompressed);
+        cached = uncompressed;
+    }
+    return reinterpret_cast<const quint8*>(cached->constData());
+}
+
+MappedHistoryScroll::Block* MappedHistoryScroll::appendBlock()
+{
+    Block* block = new Block;
+    block->offset = -1;
+    block->size = MAPPED_BLOCK_SIZE;
+    block->used = 0;
+    block->lineCount = 0;
+    block->compressedSize = 0;
+    block->data = 0;
+    block->compressing = false;
+
+    if (_fd >= 0)
+        block->offset = allocateRange(block->size);
+
+    if (block->offset >= 0) {
+        void* data = mmap(0, block->size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, block->offset);
+        if (data == MAP_FAILED) {
+            kWarning() << "mmap'ing history block failed.  errno = " << errno;
+            releaseRange(block->offset, block->size);
+            block->offset = -1;
+        } else {
+            block->data = static_cast<quint8*>(data);
+        }
+    }
+
+    if (!block->data) {
+        // keep the block in memory like CompactHistoryBlock does
+        void* data = mmap(0, block->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        Q_ASSERT(data != MAP_FAILED);
+        block->data = static_cast<quint8*>(data);
+    }
+
+    _blocks.append(block);
+    scheduleCompression();
+    return block;
+}
+
+void MappedHistoryScroll::releaseBlock(Block* block)
+{
+    if (block->data)
+        munmap(block->data, block->size);
+    if (block->offset >= 0)
+        releaseRange(block->offset, block->size);
+    delete block;
+}
+
+void MappedHistoryScroll::removeFirstLine()
+{
+    block(_lines.at(_firstLine).block)->lineCount--;
+    _firstLine++;
+
+    // the last block is kept for adding further lines
+    while (_blocks.size() > 1 && _blocks.first()->lineCount == 0) {
+        _cachedBlocks.remove(_firstBlockSerial);
+        releaseBlock(_blocks.takeFirst());
+        _firstBlockSerial++;
+    }
+
+    if (_firstLine >= 1024 && _firstLine * 2 >= _lines.size()) {
+        _lines.remove(0, _firstLine);
+        _firstLine = 0;
+    }
+}
+
+void MappedHistoryScroll::scheduleCompression()
+{
+    const int lastSerial = _firstBlockSerial + _blocks.size() - 1;
+    _nextCompressionSerial = qMax(_nextCompressionSerial, _firstBlockSerial);
+
+    while (_nextCompressionSerial < lastSerial - MAPPED_UNCOMPRESSED_BLOCKS) {
+        Block* candidate = block(_nextCompressionSerial);
+        if (candidate->offset >= 0) {
+            // the block is not changed anymore, so the copy can be
+            // compressed without locking
+            candidate->compressing = true;
+            _compressor->enqueue(_nextCompressionSerial,
+                                 QByteArray(reinterpret_cast<const char*>(candidate->data), candidate->used));
+            _pendingCompressions++;
+        }
+        _nextCompressionSerial++;
+    }
+}
+
+void MappedHistoryScroll::applyCompressedBlocks()
+{
+    if (_pendingCompressions == 0)
+        return;
+
+    const QList<MappedHistoryCompressor::Job> results = _compressor->takeResults();
+    foreach (const MappedHistoryCompressor::Job& job, results) {
+        _pendingCompressions--;
+
+        Block* compressedBlock = block(job.serial);
+        if (!compressedBlock)
+            continue; // the lines of the block have been dropped meanwhile
+        compressedBlock->compressing = false;
+
+        // not worth the costs of uncompressing the block again
+        if (job.data.size() > compressedBlock->used / 4 * 3)
+            continue;
+
+        const qint64 size = roundToPageSize(job.data.size());
+        const qint64 offset = allocateRange(size);
+        if (offset < 0)
+            continue;
+
+        const ssize_t rc = pwrite(_fd, job.data.constData(), job.data.size(), offset);
+        if (rc != job.data.size()) {
+            perror("MappedHistoryScroll::applyCompressedBlocks.write");
+            releaseRange(offset, size);
+            continue;
+        }
+
+        munmap(compressedBlock->data, compressedBlock->size);
+        releaseRange(compressedBlock->offset, compressedBlock->size);
+        compressedBlock->data = 0;
+        compressedBlock->offset = offset;
+        compressedBlock->size = size;
+        compressedBlock->compressedSize = job.data.size();
+    }
+}
+
+qint64 MappedHistoryScroll::allocateRange(qint64 size)
+{
+    QMap<qint64, qint64>::iterator it;
+    for (it = _freeRanges.begin(); it != _freeRanges.end(); ++it) {
+        if (it.value() >= size) {
+            const qint64 offset = it.key();
+            const qint64 remaining = it.value() - size;
+            _freeRanges.erase(it);
+            if (remaining > 0)
+                _freeRanges.insert(offset + size, remaining);
+            return offset;
+        }
+    }
+
+    const qint64 offset = _fileSize;
+    if (ftruncate(_fd, offset + size) < 0) {
+        perror("MappedHistoryScroll::allocateRange.truncate");
+        return -1;
+    }
+    _fileSize += size;
+    return offset;
+}
+
+void MappedHistoryScroll::releaseRange(qint64 offset, qint64 size)
+{
+    // merge with the adjacent free ranges
+    QMap<qint64, qint64>::iterator it = _freeRanges.lowerBound(offset);
+    if (it != _freeRanges.end() && offset + size == it.key()) {
+        size += it.value();
+        it = _freeRanges.erase(it);
+    }
+    if (it != _freeRanges.begin()) {
+        --it;
+        if (it.key() + it.value() == offset) {
+            offset = it.key();
+            size += it.value();
+            _freeRanges.erase(it);
+        }
+    }
+
+    // give the space at the end of the file back
+    if (offset + size == _fileSize && ftruncate(_fd, offset) == 0) {
+        _fileSize = offset;
+        return;
+    }
+
+    _freeRanges.insert(offset, size);
+}
+
 //////////////////////////////////////////////////////////////////////
 // History Types
 //////////////////////////////////////////////////////////////////////
@@ -654,3 +1146,49 @@ HistoryScroll* CompactHistoryType::scroll(HistoryScroll* old) const
     }
     return new CompactHistoryScroll(_maxLines);
 }
+
+//////////////////////////////
+
+MappedHistoryType::MappedHistoryType(int maxLines)
+    : _maxLines(maxLines)
+{
+}
+
+bool MappedHistoryType::isEnabled() const
+{
+    return true;
+}
+
+int MappedHistoryType::maximumLineCount() const
+{
+    return _maxLines;
+}
+
+bool MappedHistoryType::isMemoryMapped() const
+{
+    return true;
+}
+
+HistoryScroll* MappedHistoryType::scroll(HistoryScroll* old) const
+{
+    MappedHistoryScroll* oldBuffer = dynamic_cast<MappedHistoryScroll*>(old);
+    if (oldBuffer) {
+        oldBuffer->setMaxNbLines(_maxLines);
+        return oldBuffer;
+    }
+
+    MappedHistoryScroll* newScroll = new MappedHistoryScroll(_maxLines);
+
+    QVector<Character> line;
+    const int lines = (old != 0) ? old->getLines() : 0;
+    for (int i = 0; i < lines; i++) {
+        const int size = old->getLineLen(i);
+        line.resize(size);
+        old->getCells(i, 0, size, line.data());
+        newScroll->addCellsVector(line);
+        newScroll->addLine(old->isWrappedLine(i));
+    }
+
+    delete old;
+    return newScroll;
+}
@@ -25,7 +25,10 @@
 #include <sys/mman.h>
 
 // Qt
+#include <QtCore/QByteArray>
+#include <QtCore/QCache>
 #include <QtCore/QList>
+#include <QtCore/QMap>
 #include <QtCore/QVector>
 #include <QtCore/QTemporaryFile>
 
@@ -312,6 +315,101 @@ private:
     unsigned int _maxLineCount;
 };
 
+//////////////////////////////////////////////////////////////////////
+// History using memory mapped storage
+// Lines are encoded like CompactHistoryLine does and appended to
+// fixed-sized blocks of a temporary file, which are mmap'ed. The file
+// is used as a ring: blocks whose lines have all been dropped are
+// reused. Blocks which are not among the most recent ones are
+// compressed in a background thread.
+//////////////////////////////////////////////////////////////////////
+class MappedHistoryCompressor;
+
+class KONSOLEPRIVATE_EXPORT MappedHistoryScroll : public HistoryScroll
+{
+public:
+    /**
+     * Constructs a history which stores up to @p maxLineCount lines,
+     * or an unlimited number of lines if @p maxLineCount is -1.
+     */
+    explicit MappedHistoryScroll(int maxLineCount = -1);
+    virtual ~MappedHistoryScroll();
+
+    virtual int  getLines();
+    virtual int  getLineLen(int lineno);
+    virtual void getCells(int lineno, int colno, int count, Character res[]);
+    virtual bool isWrappedLine(int lineno);
+
+    virtual void addCells(const Character a[], int count);
+    virtual void addCellsVector(const TextLine& cells);
+    virtual void addLine(bool previousWrapped = false);
+
+    void setMaxNbLines(int lineCount);
+
+    /**
+     * Waits until all blocks which are queued for compression have been
+     * compressed and moved into the file. Mainly useful for tests.
+     */
+    void waitForCompression();
+
+    /** Returns the number of blocks which are stored compressed. */
+    int compressedBlockCount() const;
+
+private:
+    struct Block {
+        qint64 offset;      // position in the file, -1 for anonymous memory
+        qint64 size;        // number of bytes reserved for the block
+        int used;           // number of bytes used by encoded lines
+        int lineCount;      // number of lines of the history in this block
+        int compressedSize; // size of the compressed data, 0 if uncompressed
+        quint8* data;       // mmap'ed data, 0 if the block is compressed
+        bool compressing;
+    };
+
+    struct LineEntry {
+        int block;          // serial number of the block
+        quint32 position;   // position of the encoded line in the block
+        quint16 length;
+        quint16 formatCount;
+        bool wrapped;
+    };
+
+    const LineEntry& lineEntry(int lineNumber) const;
+    Block* block(int serial) const;
+    const quint8* blockData(int serial);
+
+    Block* appendBlock();
+    void releaseBlock(Block* block);
+    void removeFirstLine();
+
+    void scheduleCompression();
+    void applyCompressedBlocks();
+
+    // allocation of page aligned ranges of the file
+    qint64 allocateRange(qint64 size);
+    void releaseRange(qint64 offset, qint64 size);
+
+    QTemporaryFile _tmpFile;
+    int _fd;
+    qint64 _fileSize;
+    QMap<qint64, qint64> _freeRanges;
+
+    QList<Block*> _blocks;
+    int _firstBlockSerial;
+    int _nextCompressionSerial;
+    int _pendingCompressions;
+    MappedHistoryCompressor* _compressor;
+
+    // recently uncompressed blocks by serial number, least recently used
+    // ones are dropped first
+    QCache<int, QByteArray> _cachedBlocks;
+
+    // lines before _firstLine have been dropped already
+    QVector<LineEntry> _lines;
+    int _firstLine;
+    int _maxLineCount;
+};
+
 //////////////////////////////////////////////////////////////////////
 // History type
 //////////////////////////////////////////////////////////////////////
@@ -343,6 +441,12 @@ public:
     bool isUnlimited() const {
         return maximumLineCount() == -1;
     }
+    /**
+     * Returns true if the history is kept in a memory mapped file.
+     */
+    virtual bool isMemoryMapped() const {
+        return false;
+    }
 };
 
 class KONSOLEPRIVATE_EXPORT HistoryTypeNone : public HistoryType
@@ -383,6 +487,25 @@ public:
 protected:
     unsigned int _maxLines;
 };
+
+class KONSOLEPRIVATE_EXPORT MappedHistoryType : public HistoryType
+{
+public:
+    /**
+     * Constructs a history type which stores up to @p maxLines lines in
+     * a memory mapped file, or an unlimited number if @p maxLines is -1.
+     */
+    explicit MappedHistoryType(int maxLines = -1);
+
+    virtual bool isEnabled() const;
+    virtual int maximumLineCount() const;
+    virtual bool isMemoryMapped() const;
+
+    virtual HistoryScroll* scroll(HistoryScroll *) const;
+
+protected:
+    int _maxLines;
+};
 }
 
 #endif // HISTORY_H
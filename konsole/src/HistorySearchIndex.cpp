@@ -0,0 +1,211 @@
+/*
+    This file is part of Konsole, an X terminal.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "HistorySearchIndex.h"
+
+// Qt
+#include <QtCore/QString>
+
+// Konsole
+#include "Character.h"
+#include "ExtendedCharTable.h"
+
+using namespace Konsole;
+
+static bool isWordCharacter(ushort c)
+{
+    return QChar(c).isLetterOrNumber();
+}
+
+static ushort foldCase(ushort c)
+{
+    return QChar(c).toLower().unicode();
+}
+
+static quint32 trigramHash(ushort a, ushort b, ushort c)
+{
+    quint32 hash = ((quint32(a) << 16) | b) * 0x9E3779B1u;
+    hash ^= (c + 0x7F4A7C15u) * 0x85EBCA77u;
+    hash ^= hash >> 15;
+    return hash;
+}
+
+HistorySearchIndex::HistorySearchIndex()
+    : _firstBlock(0)
+    , _firstLineOffset(0)
+    , _lineCount(0)
+    , _unindexedLines(0)
+    , _wordLength(0)
+{
+}
+
+void HistorySearchIndex::addLine(const Character* characters, int count, bool wrapped)
+{
+    // start a new block
+    if ((_firstLineOffset + _lineCount) % LinesPerBlock == 0)
+        _filters.insert(_filters.end(), FilterWords, 0);
+    _lineCount++;
+
+    // feed the characters in the same way as PlainTextDecoder
+    // writes them when the history is searched
+    for (int i = 0; i < count; i++) {
+        const Character& c = characters[i];
+        if (c.rendition & RE_EXTENDED_CHAR) {
+            ushort extendedCharLength = 0;
+            const ushort* chars = ExtendedCharTable::instance.lookupExtendedChar(c.character, extendedCharLength);
+            for (int j = 0; chars && j < extendedCharLength; j++)
+                addCharacter(chars[j]);
+        } else if (c.isRealCharacter) {
+            addCharacter(c.character);
+        }
+    }
+
+    if (!wrapped)
+        _wordLength = 0;
+}
+
+void HistorySearchIndex::removeFirstLine()
+{
+    if (_unindexedLines > 0) {
+        _unindexedLines--;
+        return;
+    }
+
+    Q_ASSERT(_lineCount > 0);
+
+    _lineCount--;
+    _firstLineOffset++;
+
+    if (_firstLineOffset == LinesPerBlock) {
+        _firstLineOffset = 0;
+        _firstBlock++;
+
+        // release the removed blocks once they make up half of the filters
+        if (_firstBlock >= 1024 && _firstBlock * FilterWords * 2 >= _filters.size()) {
+            _filters.remove(0, _firstBlock * FilterWords);
+            _firstBlock = 0;
+        }
+    }
+}
+
+void HistorySearchIndex::clear(int unindexedLines)
+{
+    _filters.clear();
+    _firstBlock = 0;
+    _firstLineOffset = 0;
+    _lineCount = 0;
+    _unindexedLines = unindexedLines;
+    _wordLength = 0;
+}
+
+int HistorySearchIndex::lineCount() const
+{
+    return _unindexedLines + _lineCount;
+}
+
+bool HistorySearchIndex::mayContain(int line, const QVector<quint32>& trigrams) const
+{
+    Q_ASSERT(line >= 0 && line < lineCount());
+
+    if (trigrams.isEmpty() || line < _unindexedLines)
+        return true;
+    line -= _unindexedLines;
+
+    const int block = (_firstLineOffset + line) / LinesPerBlock;
+    const int blockCount = (_firstLineOffset + _lineCount + LinesPerBlock - 1) / LinesPerBlock;
+
+    // A match which starts in the block might continue in the next block.
+    // The lines of the last block might be continued on the screen.
+    return blockPairMayContain(block, trigrams)
+           || block + 1 == blockCount
+           || blockPairMayContain(block + 1, trigrams);
+}
+
+QVector<quint32> HistorySearchIndex::trigrams(const QString& text)
+{
+    QVector<quint32> result;
+
+    ushort word[2];
+    int wordLength = 0;
+    for (int i = 0; i < text.length(); i++) {
+        const ushort c = text.at(i).unicode();
+        if (!isWordCharacter(c)) {
+            wordLength = 0;
+            continue;
+        }
+
+        const ushort folded = foldCase(c);
+        if (wordLength == 2) {
+            const quint32 trigram = trigramHash(word[0], word[1], folded);
+            if (!result.contains(trigram))
+                result.append(trigram);
+            word[0] = word[1];
+            word[1] = folded;
+        } else {
+            word[wordLength++] = folded;
+        }
+    }
+
+    return result;
+}
+
+bool HistorySearchIndex::blockContains(int block, quint32 trigram) const
+{
+    const quint32* filter = _filters.constData() + (_firstBlock + block) * FilterWords;
+    const int bit1 = trigram % FilterBits;
+    const int bit2 = (trigram >> 11) % FilterBits;
+    return (filter[bit1 / 32] & (1u << (bit1 % 32))) && (filter[bit2 / 32] & (1u << (bit2 % 32)));
+}
+
+bool HistorySearchIndex::blockPairMayContain(int block, const QVector<quint32>& trigrams) const
+{
+    // true if each trigram is contained in the block or in the block before it
+    foreach (quint32 trigram, trigrams) {
+        if (!blockContains(block, trigram) && (block == 0 || !blockContains(block - 1, trigram)))
+            return false;
+    }
+    return true;
+}
+
+void HistorySearchIndex::addTrigram(quint32 trigram)
+{
+    quint32* filter = _filters.data() + (_filters.size() - FilterWords);
+    const int bit1 = trigram % FilterBits;
+    const int bit2 = (trigram >> 11) % FilterBits;
+    filter[bit1 / 32] |= 1u << (bit1 % 32);
+    filter[bit2 / 32] |= 1u << (bit2 % 32);
+}
+
+void HistorySearchIndex::addCharacter(ushort c)
+{
+    if (!isWordCharacter(c)) {
+        _wordLength = 0;
+        return;
+    }
+
+    const ushort folded = foldCase(c);
+    if (_wordLength == 2) {
+        addTrigram(trigramHash(_word[0], _word[1], folded));
+        _word[0] = _word[1];
+        _word[1] = folded;
+    } else {
+        _word[_wordLength++] = folded;
+    }
+}
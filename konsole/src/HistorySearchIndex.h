@@ -0,0 +1,115 @@
+/*
+    This file is part of Konsole, an X terminal.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+#ifndef HISTORYSEARCHINDEX_H
+#define HISTORYSEARCHINDEX_H
+
+// Qt
+#include <QtCore/QVector>
+
+#include "konsoleprivate_export.h"
+
+class QString;
+
+namespace Konsole
+{
+class Character;
+
+/**
+ * An index of the lines in the history which allows a search to skip
+ * lines that cannot contain the search text.
+ *
+ * The index is updated incrementally as lines are added to the history,
+ * see Screen::addHistLine().  The lines are grouped into blocks of
+ * LinesPerBlock lines.  For each block, the trigrams of the words in its
+ * lines are recorded in a small Bloom filter, using lower case characters.
+ * A word continues across the end of a wrapped line.
+ *
+ * mayContain() answers whether a line might contain a text with the given
+ * trigrams(), which is never false for a line that contains the text.
+ *
+ * When the history is replaced, the lines which it already has are not
+ * indexed, see clear().  They are always reported as possible matches.
+ *
+ * The index is implicitly shared, so a copy of it can be searched in
+ * another thread while the original is updated.
+ */
+class KONSOLEPRIVATE_EXPORT HistorySearchIndex
+{
+public:
+    HistorySearchIndex();
+
+    /**
+     * Adds a line to the end of the index.  @p wrapped specifies whether
+     * the line continues on the next line.
+     */
+    void addLine(const Character* characters, int count, bool wrapped);
+
+    /** Removes the first line from the index. */
+    void removeFirstLine();
+
+    /**
+     * Removes all lines from the index.  The index then starts with
+     * @p unindexedLines lines for which mayContain() is always true.
+     */
+    void clear(int unindexedLines = 0);
+
+    /** Returns the number of lines in the index, including the unindexed ones. */
+    int lineCount() const;
+
+    /**
+     * Returns true if the line @p line might contain a text whose
+     * trigrams() are @p trigrams.  A match that starts in the line may
+     * continue in the following lines.
+     *
+     * If @p trigrams is empty, true is returned for every line.
+     */
+    bool mayContain(int line, const QVector<quint32>& trigrams) const;
+
+    /**
+     * Returns the trigrams of the words in @p text, which can be
+     * passed to mayContain().
+     */
+    static QVector<quint32> trigrams(const QString& text);
+
+private:
+    // blocks are addressed from _firstBlock on
+    bool blockContains(int block, quint32 trigram) const;
+    bool blockPairMayContain(int block, const QVector<quint32>& trigrams) const;
+    void addTrigram(quint32 trigram);
+    void addCharacter(ushort c);
+
+    static const int LinesPerBlock = 16;
+    static const int FilterBits = 2048;
+    static const int FilterWords = FilterBits / 32;
+
+    QVector<quint32> _filters; // FilterWords per block
+    int _firstBlock;           // blocks before _firstBlock have been removed
+    int _firstLineOffset;      // lines removed from the first block
+    int _lineCount;            // number of indexed lines
+    int _unindexedLines;       // lines in front of the indexed ones
+
+    // last characters of the current word, which is continued
+    // if a line is wrapped
+    ushort _word[2];
+    int _wordLength;
+};
+}
+
+#endif // HISTORYSEARCHINDEX_H
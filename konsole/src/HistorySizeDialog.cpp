@@ -73,4 +73,14 @@ void HistorySizeDialog::setLineCount(int lines)
     _ui->historySizeWidget->setLineCount(lines);
 }
 
+void HistorySizeDialog::setMappedHistory(bool mapped)
+{
+    _ui->historySizeWidget->setMappedHistory(mapped);
+}
+
+bool HistorySizeDialog::isMappedHistory() const
+{
+    return _ui->historySizeWidget->isMappedHistory();
+}
+
 #include "moc_HistorySizeDialog.cpp"
@@ -53,6 +53,12 @@ public:
     /** See HistorySizeWidget::lineCount. */
     int lineCount() const;
 
+    /** See HistorySizeWidget::setMappedHistory. */
+    void setMappedHistory(bool mapped);
+
+    /** See HistorySizeWidget::isMappedHistory. */
+    bool isMappedHistory() const;
+
 private:
     Ui::HistorySizeDialog* _ui;
 };
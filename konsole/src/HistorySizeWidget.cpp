@@ -65,6 +65,10 @@ HistorySizeWidget::HistorySizeWidget(QWidget* parent)
 
     connect(_ui->historyLineSpinner, SIGNAL(valueChanged(int)),
             this, SIGNAL(historySizeChanged(int)));
+
+    _ui->mappedHistoryButton->setEnabled(false);
+    connect(_ui->mappedHistoryButton, SIGNAL(toggled(bool)),
+            this, SIGNAL(mappedHistoryChanged(bool)));
 }
 
 HistorySizeWidget::~HistorySizeWidget()
@@ -76,6 +80,7 @@ void HistorySizeWidget::buttonClicked(QAbstractButton*) const
 {
     Enum::HistoryModeEnum selectedMode = mode();
     _ui->unlimitedWarningWidget->setVisible(Enum::UnlimitedHistory == selectedMode);
+    _ui->mappedHistoryButton->setEnabled(Enum::NoHistory != selectedMode);
     emit historyModeChanged(selectedMode);
 }
 
@@ -89,6 +94,7 @@ void HistorySizeWidget::setMode(Enum::HistoryModeEnum aMode)
         _ui->unlimitedHistoryButton->setChecked(true);
     }
     _ui->unlimitedWarningWidget->setVisible(Enum::UnlimitedHistory == aMode);
+    _ui->mappedHistoryButton->setEnabled(Enum::NoHistory != aMode);
 }
 
 Enum::HistoryModeEnum HistorySizeWidget::mode() const
@@ -115,4 +121,14 @@ int HistorySizeWidget::lineCount() const
     return _ui->historyLineSpinner->value();
 }
 
+void HistorySizeWidget::setMappedHistory(bool mapped)
+{
+    _ui->mappedHistoryButton->setChecked(mapped);
+}
+
+bool HistorySizeWidget::isMappedHistory() const
+{
+    return _ui->mappedHistoryButton->isChecked();
+}
+
 #include "moc_HistorySizeWidget.cpp"
@@ -62,6 +62,15 @@ public:
      */
     int lineCount() const;
 
+    /** Specifies whether the history is kept in a memory mapped file. */
+    void setMappedHistory(bool mapped);
+
+    /**
+     * Returns true if the user chose to keep the history in a memory
+     * mapped file.  This is only valid when mode() != NoHistory.
+     */
+    bool isMappedHistory() const;
+
 signals:
     /** Emitted when the history mode is changed. */
     void historyModeChanged(Enum::HistoryModeEnum) const;
@@ -69,6 +78,9 @@ signals:
     /** Emitted when the history size is changed. */
     void historySizeChanged(int) const;
 
+    /** Emitted when the choice of keeping the history in a memory mapped file is changed. */
+    void mappedHistoryChanged(bool) const;
+
 private slots:
     void buttonClicked(QAbstractButton*) const;
 
@@ -85,6 +85,7 @@ const Profile::PropertyInfo Profile::DefaultPropertyNames[] = {
     // Scrolling
     , { HistoryMode , "HistoryMode" , SCROLLING_GROUP , QVariant::Int }
     , { HistorySize , "HistorySize" , SCROLLING_GROUP , QVariant::Int }
+    , { MappedHistory , "MappedHistory" , SCROLLING_GROUP , QVariant::Bool }
     , { ScrollBarPosition , "ScrollBarPosition" , SCROLLING_GROUP , QVariant::Int }
     , { ScrollFullPage , "ScrollFullPage" , SCROLLING_GROUP , QVariant::Bool }
 
@@ -167,6 +168,7 @@ FallbackProfile::FallbackProfile()
 
     setProperty(HistoryMode, Enum::FixedSizeHistory);
     setProperty(HistorySize, 1000);
+    setProperty(MappedHistory, false);
     setProperty(ScrollBarPosition, Enum::ScrollBarRight);
     setProperty(ScrollFullPage, false);
 
@@ -141,6 +141,12 @@ public:
          * FixedSizeHistory
          */
         HistorySize,
+        /** (bool) Specifies whether the output remembered by terminal
+         * sessions using this profile is kept compressed in a memory mapped
+         * temporary file instead of memory.  Only used if the HistoryMode
+         * property is FixedSizeHistory or UnlimitedHistory.
+         */
+        MappedHistory,
         /** (ScrollBarPositionEnum) Specifies the position of the scroll bar
          * in terminal displays using this profile.
          *
@@ -67,6 +67,7 @@ Screen::Screen(int lines, int columns):
     _history(new HistoryScrollNone()),
     _cuX(0),
     _cuY(0),
+    _dirtyCursorLine(0),
     _currentRendition(DEFAULT_RENDITION),
     _topMargin(0),
     _bottomMargin(0),
@@ -83,6 +84,10 @@ Screen::Screen(int lines, int columns):
     for (int i = 0; i < _lines + 1; i++)
         _lineProperties[i] = LINE_DEFAULT;
 
+    _dirtyLeft.resize(_lines + 1);
+    _dirtyRight.resize(_lines + 1);
+    setAllLinesDirty();
+
     initTabStops();
     clearSelection();
     reset();
@@ -212,6 +217,8 @@ void Screen::deleteChars(int n)
 
     for (int i = 0; i < n; i++)
         _screenLines[_cuY].append(spaceWithCurrentAttrs);
+
+    setLineDirty(_cuY, _cuX, _columns - 1);
 }
 
 void Screen::insertChars(int n)
@@ -225,6 +232,8 @@ void Screen::insertChars(int n)
 
     if (_screenLines[_cuY].count() > _columns)
         _screenLines[_cuY].resize(_columns);
+
+    setLineDirty(_cuY, _cuX, _columns - 1);
 }
 
 void Screen::deleteLines(int n)
@@ -241,6 +250,9 @@ void Screen::insertLines(int n)
 
 void Screen::setMode(int m)
 {
+    if (m == MODE_Screen && !_currentModes[m])
+        setAllLinesDirty();
+
     _currentModes[m] = true;
     switch (m) {
     case MODE_Origin :
@@ -252,6 +264,9 @@ void Screen::setMode(int m)
 
 void Screen::resetMode(int m)
 {
+    if (m == MODE_Screen && _currentModes[m])
+        setAllLinesDirty();
+
     _currentModes[m] = false;
     switch (m) {
     case MODE_Origin :
@@ -268,6 +283,9 @@ void Screen::saveMode(int m)
 
 void Screen::restoreMode(int m)
 {
+    if (m == MODE_Screen && _currentModes[m] != _savedModes[m])
+        setAllLinesDirty();
+
     _currentModes[m] = _savedModes[m];
 }
 
@@ -320,6 +338,9 @@ void Screen::resizeImage(int new_lines, int new_columns)
     for (int i = _lines; (i > 0) && (i < new_lines + 1); i++)
         _lineProperties[i] = LINE_DEFAULT;
 
+    _dirtyLeft.resize(new_lines + 1);
+    _dirtyRight.resize(new_lines + 1);
+
     clearSelection();
 
     delete[] _screenLines;
@@ -336,6 +357,7 @@ void Screen::resizeImage(int new_lines, int new_columns)
     _bottomMargin = _lines - 1;
     initTabStops();
     clearSelection();
+    setAllLinesDirty();
 }
 
 void Screen::setDefaultMargins()
@@ -555,6 +577,7 @@ void Screen::backspace()
     if (BS_CLEARS) {
         _screenLines[_cuY][_cuX].character = ' ';
         _screenLines[_cuY][_cuX].rendition = _screenLines[_cuY][_cuX].rendition & ~RE_EXTENDED_CHAR;
+        setLineDirty(_cuY, _cuX, _cuX);
     }
 }
 
@@ -663,6 +686,8 @@ void Screen::displayCharacter(unsigned short c)
             return;
         }
 
+        setLineDirty(charToCombineWithY, charToCombineWithX, charToCombineWithX);
+
         Character& currentChar = _screenLines[charToCombineWithY][charToCombineWithX];
         if ((currentChar.rendition & RE_EXTENDED_CHAR) == 0) {
             const ushort chars[2] = { currentChar.character, c };
@@ -706,6 +731,8 @@ void Screen::displayCharacter(unsigned short c)
     // check if selection is still valid.
     checkSelection(_lastPos, _lastPos);
 
+    setLineDirty(_cuY, _cuX, _cuX + w - 1);
+
     Character& currentChar = _screenLines[_cuY][_cuX];
 
     currentChar.character = c;
@@ -734,6 +761,56 @@ void Screen::displayCharacter(unsigned short c)
     _cuX = newCursorX;
 }
 
+void Screen::displayCharacters(const unsigned short* chars, int count)
+{
+    if (getMode(MODE_Insert)) {
+        for (int i = 0; i < count; i++)
+            displayCharacter(chars[i]);
+        return;
+    }
+
+    while (count > 0) {
+        if (_cuX >= _columns) {
+            if (getMode(MODE_Wrap)) {
+                _lineProperties[_cuY] = (LineProperty)(_lineProperties[_cuY] | LINE_WRAPPED);
+                nextLine();
+            } else {
+                // Each character would overwrite the last column, only
+                // the last one remains visible.
+                _cuX = _columns - 1;
+                chars += count - 1;
+                count = 1;
+            }
+        }
+
+        const int n = qMin(count, _columns - _cuX);
+
+        // ensure current line vector has enough elements
+        if (_screenLines[_cuY].size() < _cuX + n) {
+            _screenLines[_cuY].resize(_cuX + n);
+        }
+
+        // check if selection is still valid.
+        checkSelection(loc(_cuX, _cuY), loc(_cuX + n - 1, _cuY));
+
+        setLineDirty(_cuY, _cuX, _cuX + n - 1);
+
+        Character* currentChar = _screenLines[_cuY].data() + _cuX;
+        for (int i = 0; i < n; i++, currentChar++) {
+            currentChar->character = chars[i];
+            currentChar->foregroundColor = _effectiveForeground;
+            currentChar->backgroundColor = _effectiveBackground;
+            currentChar->rendition = _effectiveRendition;
+            currentChar->isRealCharacter = true;
+        }
+
+        _cuX += n;
+        _lastPos = loc(_cuX - 1, _cuY);
+        chars += n;
+        count -= n;
+    }
+}
+
 int Screen::scrolledLines() const
 {
     return _scrolledLines;
@@ -862,6 +939,8 @@ void Screen::clearImage(int loca, int loce, char c)
         const int endCol = (y == bottomLine) ? loce % _columns : _columns - 1;
         const int startCol = (y == topLine) ? loca % _columns : 0;
 
+        setLineDirty(y, startCol, endCol);
+
         QVector<Character>& line = _screenLines[y];
 
         if (isDefaultCh && endCol == _columns - 1) {
@@ -900,6 +979,9 @@ void Screen::moveImage(int dest, int sourceBegin, int sourceEnd)
         }
     }
 
+    for (int i = 0; i <= lines; i++)
+        setLineDirty((dest / _columns) + i, 0, _columns - 1);
+
     if (_lastPos != -1) {
         const int diff = dest - sourceBegin; // Scroll by this amount
         _lastPos += diff;
@@ -1028,6 +1110,10 @@ void Screen::setBackColor(int space, int color)
 
 void Screen::clearSelection()
 {
+    // the selected characters are displayed with reversed colors
+    if (_selTopLeft != -1)
+        setAllLinesDirty();
+
     _selBottomRight = -1;
     _selTopLeft = -1;
     _selBegin = -1;
@@ -1305,6 +1391,12 @@ void Screen::addHistLine()
 
         const int newHistLines = _history->getLines();
 
+        // keep the search index in sync with the history
+        if (newHistLines == oldHistLines && _searchIndex.lineCount() > 0)
+            _searchIndex.removeFirstLine();
+        if (newHistLines > 0)
+            _searchIndex.addLine(_screenLines[0].constData(), _screenLines[0].count(), _lineProperties[0] & LINE_WRAPPED);
+
         const bool beginIsTL = (_selBegin == _selTopLeft);
 
         // If the history is full, increment the count
@@ -1361,6 +1453,16 @@ void Screen::setScroll(const HistoryType& t , bool copyPreviousScroll)
         _history = t.scroll(0);
         delete oldScroll;
     }
+
+    // Indexing the kept lines could take seconds for a long history, so
+    // only the lines added from now on are indexed.  Searches check the
+    // kept lines without the help of the index.
+    _searchIndex.clear(_history->getLines());
+}
+
+const HistorySearchIndex& Screen::historySearchIndex() const
+{
+    return _searchIndex;
 }
 
 bool Screen::hasScroll() const
@@ -1379,6 +1481,50 @@ void Screen::setLineProperty(LineProperty property , bool enable)
         _lineProperties[_cuY] = (LineProperty)(_lineProperties[_cuY] | property);
     else
         _lineProperties[_cuY] = (LineProperty)(_lineProperties[_cuY] & ~property);
+
+    setLineDirty(_cuY, 0, _columns - 1);
+}
+
+void Screen::getDirtyColumns(int line, int& left, int& right) const
+{
+    Q_ASSERT(line >= 0 && line < _lines);
+
+    // Moving the cursor or toggling MODE_Cursor does not mark anything,
+    // the lines of the old and new cursor position are reported instead
+    if (line == _cuY || line == _dirtyCursorLine) {
+        left = 0;
+        right = _columns - 1;
+        return;
+    }
+
+    left = _dirtyLeft[line];
+    right = _dirtyRight[line];
+}
+
+void Screen::resetDirtyLines()
+{
+    _dirtyCursorLine = _cuY;
+
+    for (int i = 0; i < _dirtyLeft.count(); i++) {
+        _dirtyLeft[i] = _columns;
+        _dirtyRight[i] = -1;
+    }
+}
+
+void Screen::setLineDirty(int line, int left, int right)
+{
+    Q_ASSERT(line >= 0 && line < _dirtyLeft.count());
+
+    _dirtyLeft[line] = qMin(_dirtyLeft[line], qMax(0, left));
+    _dirtyRight[line] = qMax(_dirtyRight[line], qMin(_columns - 1, right));
+}
+
+void Screen::setAllLinesDirty()
+{
+    for (int i = 0; i < _dirtyLeft.count(); i++) {
+        _dirtyLeft[i] = 0;
+        _dirtyRight[i] = _columns - 1;
+    }
 }
 void Screen::fillWithDefaultChar(Character* dest, int count)
 {
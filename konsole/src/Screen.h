@@ -31,6 +31,8 @@
 
 // Konsole
 #include "Character.h"
+#include "HistorySearchIndex.h"
+#include "konsoleprivate_export.h"
 
 #define MODE_Origin    0
 #define MODE_Wrap      1
@@ -70,7 +72,7 @@ class HistoryScroll;
     using selectedText().  When getImage() is used to retrieve the visible image,
     characters which are part of the selection have their colors inverted.
 */
-class Screen
+class KONSOLEPRIVATE_EXPORT Screen
 {
 public:
     /** Construct a new screen image of size @p lines by @p columns. */
@@ -345,6 +347,20 @@ public:
      */
     void displayCharacter(unsigned short c);
 
+    /**
+     * Displays a run of characters at the current cursor position, with
+     * the same result as calling displayCharacter() for each of them.
+     *
+     * All characters in @p chars must be printable and have a width
+     * of one column, e.g. printable US-ASCII characters.  This allows to
+     * fill the current line up to the right edge in one step and to
+     * wrap only once per line.
+     *
+     * @param chars The characters to display
+     * @param count The number of characters in @p chars
+     */
+    void displayCharacters(const unsigned short* chars, int count);
+
     /**
      * Resizes the image to a new fixed size of @p new_lines by @p new_columns.
      * In the case that @p new_columns is smaller than the current number of columns,
@@ -400,6 +416,11 @@ public:
      * in a history buffer.
      */
     bool hasScroll() const;
+    /**
+     * Returns the search index of the lines in the history buffer, which
+     * is updated as lines are added to the history.
+     */
+    const HistorySearchIndex& historySearchIndex() const;
 
     /**
      * Sets the start of the selection.
@@ -555,6 +576,23 @@ public:
      */
     void resetDroppedLines();
 
+    /**
+     * Returns the range of columns of the screen line @p line which have been
+     * changed since the last call to resetDirtyLines() in @p left and @p right.
+     * If the line has not been changed then @p left is greater than @p right.
+     *
+     * Lines which have been moved by scrolling the image are reported as
+     * changed completely.  So are the lines which contain the cursor now
+     * and at the last call to resetDirtyLines(), as the cursor might have
+     * been moved or shown or hidden.
+     */
+    void getDirtyColumns(int line, int& left, int& right) const;
+
+    /**
+     * Marks all lines of the screen as unchanged, see getDirtyColumns()
+     */
+    void resetDirtyLines();
+
     /**
       * Fills the buffer @p dest with @p count instances of the default (ie. blank)
       * Character style.
@@ -625,6 +663,11 @@ private:
 
     void addHistLine();
 
+    // marks the columns 'left' to 'right' of the screen line 'line' as changed
+    void setLineDirty(int line, int left, int right);
+    // marks all lines of the screen as changed
+    void setAllLinesDirty();
+
     void initTabStops();
 
     void updateEffectiveRendition();
@@ -657,12 +700,20 @@ private:
 
     QVector<LineProperty> _lineProperties;
 
+    // range of changed columns of each line since the last call to
+    // resetDirtyLines(), the line is unchanged if left > right
+    QVector<int> _dirtyLeft;
+    QVector<int> _dirtyRight;
+
     // history buffer ---------------
     HistoryScroll* _history;
+    HistorySearchIndex _searchIndex;
 
     // cursor location
     int _cuX;
     int _cuY;
+    // line of the cursor at the last call to resetDirtyLines()
+    int _dirtyCursorLine;
 
     // cursor color and rendition info
     CharacterColor _currentForeground;
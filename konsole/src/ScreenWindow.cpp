@@ -30,6 +30,8 @@ ScreenWindow::ScreenWindow(Screen* screen, QObject* parent)
     , _windowBuffer(0)
     , _windowBufferSize(0)
     , _bufferNeedsUpdate(true)
+    , _allLinesDirty(true)
+    , _showsScreen(false)
     , _windowLines(1)
     , _currentLine(0)
     , _currentResultLine(-1)
@@ -48,6 +50,7 @@ void ScreenWindow::setScreen(Screen* screen)
     Q_ASSERT(screen);
 
     _screen = screen;
+    _allLinesDirty = true;
 }
 
 Screen* ScreenWindow::screen() const
@@ -64,6 +67,7 @@ Character* ScreenWindow::getImage()
         _windowBufferSize = size;
         _windowBuffer = new Character[size];
         _bufferNeedsUpdate = true;
+        _allLinesDirty = true;
     }
 
     if (!_bufferNeedsUpdate)
@@ -140,6 +144,7 @@ void ScreenWindow::setSelectionStart(int column , int line , bool columnMode)
     _screen->setSelectionStart(column , line + currentLine() , columnMode);
 
     _bufferNeedsUpdate = true;
+    _allLinesDirty = true;
     emit selectionChanged();
 }
 
@@ -148,6 +153,7 @@ void ScreenWindow::setSelectionEnd(int column , int line)
     _screen->setSelectionEnd(column , line + currentLine());
 
     _bufferNeedsUpdate = true;
+    _allLinesDirty = true;
     emit selectionChanged();
 }
 
@@ -159,6 +165,7 @@ void ScreenWindow::setSelectionByLineRange(int start, int end)
     _screen->setSelectionEnd(windowColumns() , end);
 
     _bufferNeedsUpdate = true;
+    _allLinesDirty = true;
     emit selectionChanged();
 }
 
@@ -171,12 +178,15 @@ void ScreenWindow::clearSelection()
 {
     _screen->clearSelection();
 
+    _allLinesDirty = true;
     emit selectionChanged();
 }
 
 void ScreenWindow::setWindowLines(int lines)
 {
     Q_ASSERT(lines > 0);
+    if (_windowLines != lines)
+        _allLinesDirty = true;
     _windowLines = lines;
 }
 int ScreenWindow::windowLines() const
@@ -259,6 +269,8 @@ void ScreenWindow::scrollTo(int line)
     _scrollCount += delta;
 
     _bufferNeedsUpdate = true;
+    if (delta != 0)
+        _allLinesDirty = true;
 
     emit scrolled(_currentLine);
 }
@@ -293,6 +305,29 @@ QRect ScreenWindow::scrollRegion() const
         return QRect(0, 0, windowColumns(), windowLines());
 }
 
+bool ScreenWindow::allLinesDirty() const
+{
+    return _allLinesDirty;
+}
+
+void ScreenWindow::getDirtyColumns(int line, int& left, int& right) const
+{
+    if (_allLinesDirty || line < 0 || line >= _dirtyLeft.count()) {
+        left = 0;
+        right = windowColumns() - 1;
+    } else {
+        left = _dirtyLeft[line];
+        right = _dirtyRight[line];
+    }
+}
+
+void ScreenWindow::resetDirtyLines()
+{
+    _allLinesDirty = false;
+    _dirtyLeft.fill(windowColumns(), windowLines());
+    _dirtyRight.fill(-1, windowLines());
+}
+
 void ScreenWindow::notifyOutputChanged()
 {
     // move window to the bottom of the screen and update scroll count
@@ -314,6 +349,24 @@ void ScreenWindow::notifyOutputChanged()
         _currentLine = qMin(_currentLine , _screen->getHistLines());
     }
 
+    // the changes of the screen only describe the changes of this window
+    // if the window has been showing exactly the lines of the screen
+    const bool showsScreen = (currentLine() == _screen->getHistLines() &&
+                              windowLines() == _screen->getLines());
+
+    if (showsScreen && _showsScreen && _dirtyLeft.count() == windowLines()) {
+        for (int line = 0; line < windowLines(); line++) {
+            int left;
+            int right;
+            _screen->getDirtyColumns(line, left, right);
+            _dirtyLeft[line] = qMin(_dirtyLeft[line], left);
+            _dirtyRight[line] = qMax(_dirtyRight[line], right);
+        }
+    } else {
+        _allLinesDirty = true;
+    }
+    _showsScreen = showsScreen;
+
     _bufferNeedsUpdate = true;
 
     emit outputChanged();
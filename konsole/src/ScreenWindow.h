@@ -113,6 +113,29 @@ public:
      */
     QRect scrollRegion() const;
 
+    /**
+     * Returns true if the whole window has to be considered as changed since
+     * the last call to resetDirtyLines(), for example because the window
+     * was scrolled, the selection was changed or the window does not show
+     * the lines of the screen.
+     */
+    bool allLinesDirty() const;
+
+    /**
+     * Returns the range of columns of the window line @p line which have been
+     * changed since the last call to resetDirtyLines() in @p left and @p right.
+     * If the line has not been changed then @p left is greater than @p right.
+     *
+     * Like scrollCount(), this allows views to compare and repaint only the
+     * parts of the window which may have changed.  See Screen::getDirtyColumns()
+     */
+    void getDirtyColumns(int line, int& left, int& right) const;
+
+    /**
+     * Marks all lines of the window as unchanged, see getDirtyColumns()
+     */
+    void resetDirtyLines();
+
 
     /**
      * What line the next search will start from
@@ -269,6 +292,12 @@ private:
     int _windowBufferSize;
     bool _bufferNeedsUpdate;
 
+    bool _allLinesDirty; // see allLinesDirty()
+    bool _showsScreen; // true if the window showed exactly the lines of the screen
+    // when notifyOutputChanged() was called the last time
+    QVector<int> _dirtyLeft; // see getDirtyColumns()
+    QVector<int> _dirtyRight;
+
     int  _windowLines;
     int  _currentLine; // see scrollTo() , currentLine()
     int _currentResultLine;
@@ -196,6 +196,11 @@ SessionController::SessionController(Session* session , TerminalDisplay* view, Q
     _interactionTimer->setSingleShot(true);
     _interactionTimer->setInterval(500);
     connect(_interactionTimer, SIGNAL(timeout()), this, SLOT(snapshot()));
+
+    _searchFilterTimer = new QTimer(this);
+    _searchFilterTimer->setSingleShot(true);
+    _searchFilterTimer->setInterval(50);
+    connect(_searchFilterTimer, SIGNAL(timeout()), this, SLOT(updateSearchFilter()));
     connect(_view, SIGNAL(keyPressedSignal(QKeyEvent*)), this, SLOT(interactionHandler()));
 
     // take a snapshot of the session state periodically in the background
@@ -1165,15 +1170,24 @@ void SessionController::listenForScreenWindowUpdates()
         return;
 
     connect(_view->screenWindow(), SIGNAL(outputChanged()), this,
-            SLOT(updateSearchFilter()));
+            SLOT(requireSearchFilterUpdate()));
     connect(_view->screenWindow(), SIGNAL(scrolled(int)), this,
-            SLOT(updateSearchFilter()));
+            SLOT(requireSearchFilterUpdate()));
     connect(_view->screenWindow(), SIGNAL(currentResultLineChanged()), _view,
             SLOT(update()));
 
     _listenForScreenWindowUpdates = true;
 }
 
+void SessionController::requireSearchFilterUpdate()
+{
+    // this method is called every time the screen window's output changes,
+    // so while output is streaming the search filter is updated at most
+    // once per interval of the timer instead of after each update
+    if (!_searchFilterTimer->isActive())
+        _searchFilterTimer->start();
+}
+
 void SessionController::updateSearchFilter()
 {
     if (_searchFilter && _searchBar) {
@@ -1320,9 +1334,13 @@ void SessionController::beginSearch(const QString& text , int direction)
         }
     }
 
+    // a search which is still running is outdated
+    delete _searchTask;
+
     if (!regExp.isEmpty()) {
         _view->screenWindow()->setCurrentResultLine(-1);
         SearchHistoryTask* task = new SearchHistoryTask(this);
+        _searchTask = task;
 
         connect(task, SIGNAL(completed(bool)), this, SLOT(searchCompleted(bool)));
 
@@ -1406,6 +1424,7 @@ void SessionController::showHistoryOptions()
     } else {
         dialog->setMode(Enum::NoHistory);
     }
+    dialog->setMappedHistory(currentHistory.isMemoryMapped());
 
     QPointer<Session> guard(_session);
     int result = dialog->exec();
@@ -1413,7 +1432,7 @@ void SessionController::showHistoryOptions()
         return;
 
     if (result) {
-        scrollBackOptionsChanged(dialog->mode(), dialog->lineCount());
+        scrollBackOptionsChanged(dialog->mode(), dialog->lineCount(), dialog->isMappedHistory());
     }
 }
 void SessionController::sessionResizeRequest(const QSize& size)
@@ -1421,17 +1440,23 @@ void SessionController::sessionResizeRequest(const QSize& size)
     //kDebug() << "View resize requested to " << size;
     _view->setSize(size.width(), size.height());
 }
-void SessionController::scrollBackOptionsChanged(int mode, int lines)
+void SessionController::scrollBackOptionsChanged(int mode, int lines, bool mapped)
 {
     switch (mode) {
     case Enum::NoHistory:
         _session->setHistoryType(HistoryTypeNone());
         break;
     case Enum::FixedSizeHistory:
-        _session->setHistoryType(CompactHistoryType(lines));
+        if (mapped)
+            _session->setHistoryType(MappedHistoryType(lines));
+        else
+            _session->setHistoryType(CompactHistoryType(lines));
         break;
     case Enum::UnlimitedHistory:
-        _session->setHistoryType(HistoryTypeFile());
+        if (mapped)
+            _session->setHistoryType(MappedHistoryType());
+        else
+            _session->setHistoryType(HistoryTypeFile());
         break;
     }
 }
@@ -1862,6 +1887,9 @@ void SearchHistoryTask::execute()
         iter.next();
         executeOnScreenWindow(iter.key() , iter.value());
     }
+
+    if (_searches.isEmpty() && autoDelete())
+        deleteLater();
 }
 
 void SearchHistoryTask::executeOnScreenWindow(SessionPtr session , ScreenWindowPtr window)
@@ -1869,119 +1897,121 @@ void SearchHistoryTask::executeOnScreenWindow(SessionPtr session , ScreenWindowP
     Q_ASSERT(session);
     Q_ASSERT(window);
 
-    Emulation* emulation = session->emulation();
+    if (_regExp.isEmpty()) {
+        emit completed(false);
+        return;
+    }
 
-    if (!_regExp.isEmpty()) {
-        int pos = -1;
-        const bool forwards = (_direction == ForwardsSearch);
-        const int lastLine = window->lineCount() - 1;
+    const bool forwards = (_direction == ForwardsSearch);
+    const int lastLine = window->lineCount() - 1;
 
-        int startLine;
-        if (forwards && (_startLine == lastLine)) {
-            startLine = 0;
-        } else if (!forwards && (_startLine == 0)) {
-            startLine = lastLine;
-        } else {
-            startLine = _startLine + (forwards ? 1 : -1);
-        }
+    int startLine;
+    if (forwards && (_startLine == lastLine)) {
+        startLine = 0;
+    } else if (!forwards && (_startLine == 0)) {
+        startLine = lastLine;
+    } else {
+        startLine = _startLine + (forwards ? 1 : -1);
+    }
+    startLine = qBound(0, startLine, lastLine);
 
-        QString string;
+    // only searches for plain text can skip lines using the index
+    QVector<quint32> trigrams;
+    if (_regExp.patternSyntax() == QRegExp::FixedString)
+        trigrams = HistorySearchIndex::trigrams(_regExp.pattern());
 
-        //text stream to read history into string for pattern or regular expression searching
-        QTextStream searchStream(&string);
+    const int id = _nextSearchId++;
 
-        PlainTextDecoder decoder;
-        decoder.setRecordLinePositions(true);
+    Search search;
+    search.session = session;
+    search.window = window;
+    search.thread = new SearchHistoryThread(id, session->emulation()->historySearchIndex(), trigrams,
+                                            _regExp, lastLine + 1, startLine, forwards);
 
-        //setup first and last lines depending on search direction
-        int line = startLine;
+    connect(search.thread, SIGNAL(linesRequested(int,int,int)), this, SLOT(provideLines(int,int,int)));
+    connect(search.thread, SIGNAL(matchFound(int,int)), this, SLOT(matchFound(int,int)));
+    connect(search.thread, SIGNAL(searchFinished(int)), this, SLOT(searchFinished(int)));
 
-        //read through and search history in blocks of 10K lines.
-        //this balances the need to retrieve lots of data from the history each time
-        //(for efficient searching)
-        //without using silly amounts of memory if the history is very large.
-        const int maxDelta = qMin(window->lineCount(), 10000);
-        int delta = forwards ? maxDelta : -maxDelta;
+    _searches.insert(id, search);
+    search.thread->start();
+}
 
-        int endLine = line;
-        bool hasWrapped = false;  // set to true when we reach the top/bottom
-        // of the output and continue from the other
-        // end
+void SearchHistoryTask::provideLines(int id, int fromLine, int toLine)
+{
+    if (!_searches.contains(id))
+        return; // the search is finished already
 
-        //loop through history in blocks of <delta> lines.
-        do {
-            // ensure that application does not appear to hang
-            // if searching through a lengthy output
-            QApplication::processEvents();
+    const Search search = _searches.value(id);
+    if (!search.session || !search.window) {
+        finishSearch(id, false);
+        return;
+    }
 
-            // calculate lines to search in this iteration
-            if (hasWrapped) {
-                if (endLine == lastLine)
-                    line = 0;
-                else if (endLine == 0)
-                    line = lastLine;
+    // the output might have been changed since the search was started
+    const int line = qMin(fromLine, toLine);
+    const int endLine = qMin(qMax(fromLine, toLine), search.window->lineCount() - 1);
+    if (line > endLine) {
+        search.thread->addLines(line, QString(), QList<int>());
+        return;
+    }
 
-                endLine += delta;
+    QString string;
 
-                if (forwards)
-                    endLine = qMin(startLine , endLine);
-                else
-                    endLine = qMax(startLine , endLine);
-            } else {
-                endLine += delta;
-
-                if (endLine > lastLine) {
-                    hasWrapped = true;
-                    endLine = lastLine;
-                } else if (endLine < 0) {
-                    hasWrapped = true;
-                    endLine = 0;
-                }
-            }
+    //text stream to read history into string for pattern or regular expression searching
+    QTextStream searchStream(&string);
 
-            decoder.begin(&searchStream);
-            emulation->writeToStream(&decoder, qMin(endLine, line) , qMax(endLine, line));
-            decoder.end();
+    PlainTextDecoder decoder;
+    decoder.setRecordLinePositions(true);
 
-            // line number search below assumes that the buffer ends with a new-line
-            string.append('\n');
+    decoder.begin(&searchStream);
+    search.session->emulation()->writeToStream(&decoder, line, endLine);
+    decoder.end();
 
-            if (forwards)
-                pos = string.indexOf(_regExp);
-            else
-                pos = string.lastIndexOf(_regExp);
+    // line number search in the thread assumes that the buffer ends with a new-line
+    string.append('\n');
 
-            //if a match is found, position the cursor on that line and update the screen
-            if (pos != -1) {
-                int newLines = 0;
-                QList<int> linePositions = decoder.linePositions();
-                while (newLines < linePositions.count() && linePositions[newLines] <= pos)
-                    newLines++;
+    search.thread->addLines(line, string, decoder.linePositions());
+}
 
-                // ignore the new line at the start of the buffer
-                newLines--;
+void SearchHistoryTask::matchFound(int id, int line)
+{
+    if (!_searches.contains(id))
+        return;
 
-                int findPos = qMin(line, endLine) + newLines;
+    const Search search = _searches.value(id);
+    if (search.window)
+        highlightResult(search.window, line);
 
-                highlightResult(window, findPos);
+    finishSearch(id, !search.window.isNull());
+}
 
-                emit completed(true);
+void SearchHistoryTask::searchFinished(int id)
+{
+    // all lines have been searched without a match
+    if (_searches.contains(id))
+        finishSearch(id, false);
+}
 
-                return;
-            }
+void SearchHistoryTask::finishSearch(int id, bool success)
+{
+    const Search search = _searches.take(id);
 
-            //clear the current block of text and move to the next one
-            string.clear();
-            line = endLine;
-        } while (startLine != endLine);
+    search.thread->abort();
+    search.thread->wait();
+    search.thread->deleteLater();
 
-        // if no match was found, clear selection to indicate this
-        window->clearSelection();
-        window->notifyOutputChanged();
+    // if no match was found, clear selection to indicate this
+    if (!success && search.window) {
+        search.window->clearSelection();
+        search.window->notifyOutputChanged();
     }
 
-    emit completed(false);
+    emit completed(success);
+
+    if (_searches.isEmpty() && autoDelete())
+        deleteLater();
 }
+
 void SearchHistoryTask::highlightResult(ScreenWindowPtr window , int findPos)
 {
     //work out how many lines into the current block of text the search result was found
@@ -2009,7 +2039,16 @@ SearchHistoryTask::SearchHistoryTask(QObject* parent)
     : SessionTask(parent)
     , _direction(BackwardsSearch)
     , _startLine(0)
+    , _nextSearchId(0)
+{
+}
+SearchHistoryTask::~SearchHistoryTask()
 {
+    foreach (const Search& search, _searches) {
+        search.thread->abort();
+        search.thread->wait();
+        delete search.thread;
+    }
 }
 void SearchHistoryTask::setSearchDirection(SearchDirection direction)
 {
@@ -2032,6 +2071,152 @@ QRegExp SearchHistoryTask::regExp() const
     return _regExp;
 }
 
+SearchHistoryThread::SearchHistoryThread(int id, const HistorySearchIndex& index, const QVector<quint32>& trigrams,
+                                         const QRegExp& regExp, int lineCount, int startLine, bool forwards,
+                                         QObject* parent)
+    : QThread(parent)
+    , _id(id)
+    , _index(index)
+    , _trigrams(trigrams)
+    , _regExp(regExp)
+    , _lineCount(lineCount)
+    , _startLine(startLine)
+    , _forwards(forwards)
+    , _aborted(0)
+{
+}
+void SearchHistoryThread::addLines(int fromLine, const QString& text, const QList<int>& linePositions)
+{
+    Lines lines;
+    lines.fromLine = fromLine;
+    lines.text = text;
+    lines.linePositions = linePositions;
+
+    QMutexLocker locker(&_mutex);
+    _lines.enqueue(lines);
+    _linesAdded.wakeOne();
+}
+void SearchHistoryThread::abort()
+{
+    QMutexLocker locker(&_mutex);
+    _aborted.fetchAndStoreOrdered(1);
+    _linesAdded.wakeOne();
+}
+void SearchHistoryThread::run()
+{
+    const int lastLine = _lineCount - 1;
+
+    // search from the start line to the end of the output, then
+    // continue at the other end of the output
+    QList< QPair<int, int> > ranges;
+    if (lastLine >= 0) {
+        if (_forwards) {
+            findCandidates(_startLine, lastLine, ranges);
+            if (_startLine > 0)
+                findCandidates(0, _startLine - 1, ranges);
+        } else {
+            findCandidates(_startLine, 0, ranges);
+            if (_startLine < lastLine)
+                findCandidates(lastLine, _startLine + 1, ranges);
+        }
+    }
+
+    // QRegExp keeps the state of the last match, so the thread uses its own copy
+    const QRegExp regExp(_regExp);
+
+    // The next range is requested before the current one is matched,
+    // so that the GUI thread reads it in the meantime
+    int requested = 0;
+    for (int i = 0; i < ranges.count() && !isAborted(); i++) {
+        while (requested < ranges.count() && requested <= i + 1) {
+            emit linesRequested(_id, ranges.at(requested).first, ranges.at(requested).second);
+            requested++;
+        }
+
+        Lines lines;
+        if (!takeLines(lines))
+            return;
+
+        const int line = findMatch(lines, regExp);
+        if (line != -1) {
+            emit matchFound(_id, line);
+            return;
+        }
+    }
+
+    if (!isAborted())
+        emit searchFinished(_id);
+}
+bool SearchHistoryThread::isAborted() const
+{
+    // Qt 4 has no atomic load, adding 0 reads the value with a full barrier
+    return _aborted.fetchAndAddOrdered(0) != 0;
+}
+bool SearchHistoryThread::isCandidate(int line) const
+{
+    // the lines on the screen are not indexed
+    return line >= _index.lineCount() || _index.mayContain(line, _trigrams);
+}
+void SearchHistoryThread::findCandidates(int fromLine, int toLine, QList< QPair<int, int> >& ranges) const
+{
+    // balances the costs of reading many lines at once against
+    // the responsiveness of the user interface
+    const int maxLines = 10000;
+
+    const int step = (fromLine <= toLine) ? 1 : -1;
+    int rangeStart = -1;
+
+    for (int line = fromLine; !isAborted(); line += step) {
+        const bool candidate = isCandidate(line);
+        if (candidate && rangeStart == -1)
+            rangeStart = line;
+
+        const bool atEnd = (line == toLine);
+        if (rangeStart != -1 && (!candidate || atEnd || qAbs(line - rangeStart) + 1 >= maxLines)) {
+            ranges.append(qMakePair(rangeStart, candidate ? line : line - step));
+            rangeStart = -1;
+        }
+
+        if (atEnd)
+            break;
+    }
+}
+bool SearchHistoryThread::takeLines(Lines& lines)
+{
+    QMutexLocker locker(&_mutex);
+    while (_lines.isEmpty() && !isAborted())
+        _linesAdded.wait(&_mutex);
+
+    if (isAborted())
+        return false;
+
+    lines = _lines.dequeue();
+    return true;
+}
+int SearchHistoryThread::findMatch(const Lines& lines, const QRegExp& regExp) const
+{
+    if (lines.text.isEmpty())
+        return -1;
+
+    int pos;
+    if (_forwards)
+        pos = lines.text.indexOf(regExp);
+    else
+        pos = lines.text.lastIndexOf(regExp);
+
+    if (pos == -1)
+        return -1;
+
+    int newLines = 0;
+    while (newLines < lines.linePositions.count() && lines.linePositions[newLines] <= pos)
+        newLines++;
+
+    // ignore the new line at the start of the buffer
+    newLines--;
+
+    return lines.fromLine + newLines;
+}
+
 QString SessionController::userTitle() const
 {
     if (_session) {
@@ -22,11 +22,17 @@
 #define SESSIONCONTROLLER_H
 
 // Qt
+#include <QtCore/QAtomicInt>
 #include <QtCore/QList>
 #include <QtCore/QSet>
 #include <QtCore/QPointer>
 #include <QtCore/QString>
 #include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QQueue>
+#include <QtCore/QRegExp>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
 
 // KDE
 #include <KIcon>
@@ -35,6 +41,7 @@
 // Konsole
 #include "ViewProperties.h"
 #include "Profile.h"
+#include "HistorySearchIndex.h"
 
 namespace KIO
 {
@@ -63,6 +70,7 @@ class ProfileList;
 class UrlFilter;
 class RegExpFilter;
 class EditProfileDialog;
+class SearchHistoryTask;
 
 // SaveHistoryTask
 class TerminalCharacterDecoder;
@@ -273,12 +281,13 @@ private slots:
 
     void requireUrlFilterUpdate();
     void highlightMatches(bool highlight);
-    void scrollBackOptionsChanged(int mode , int lines);
+    void scrollBackOptionsChanged(int mode , int lines , bool mapped);
     void sessionResizeRequest(const QSize& size);
     void trackOutput(QKeyEvent* event);  // move view to end of current output
     // when a key press occurs in the
     // display area
 
+    void requireSearchFilterUpdate();
     void updateSearchFilter();
 
     void zmodemDownload();
@@ -329,11 +338,13 @@ private:
     KAction* _findPreviousAction;
 
     QTimer* _interactionTimer;
+    QTimer* _searchFilterTimer;
 
     bool _urlFilterUpdateRequired;
 
     int _searchStartLine;
     int _prevSearchResultLine;
+    QPointer<SearchHistoryTask> _searchTask;
     QPointer<IncrementalSearchBar> _searchBar;
 
     KCodecAction* _codecAction;
@@ -464,7 +475,84 @@ private:
     QHash<KJob*, SaveJob> _jobSession;
 };
 
-//class SearchHistoryThread;
+/**
+ * Searches a session's output for a regular expression.
+ *
+ * The thread uses a copy of the history's HistorySearchIndex to find the
+ * lines which might contain the search text.  Lines which are not in the
+ * history are always candidates.  As the output can only be read in the
+ * GUI thread, the thread asks for the text of the candidate lines with the
+ * linesRequested() signal, in the order of the search and in blocks of at
+ * most 10000 lines.  The text is passed back with addLines() and matched
+ * by the thread.
+ */
+class SearchHistoryThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructs a thread which searches for @p regExp in the output with
+     * @p lineCount lines, of which the first ones are indexed by @p index.
+     * The search starts at @p startLine and wraps around at the end of the
+     * output.  If @p trigrams is empty, all lines are candidates.
+     */
+    SearchHistoryThread(int id, const HistorySearchIndex& index, const QVector<quint32>& trigrams,
+                        const QRegExp& regExp, int lineCount, int startLine, bool forwards,
+                        QObject* parent = 0);
+
+    /**
+     * Passes the text of the lines requested by linesRequested() to the thread.
+     * @p linePositions are the positions in @p text at which the lines start.
+     * @p text is empty if the lines are not available anymore.
+     */
+    void addLines(int fromLine, const QString& text, const QList<int>& linePositions);
+
+    /** Stops the thread as soon as possible. */
+    void abort();
+
+signals:
+    /**
+     * Emitted for lines which might contain the search text.  The text of the
+     * lines must be passed to addLines(), in the order of the requests.
+     */
+    void linesRequested(int id, int fromLine, int toLine);
+    /** Emitted when a match has been found in the line @p line. */
+    void matchFound(int id, int line);
+    /** Emitted after all lines have been searched without a match. */
+    void searchFinished(int id);
+
+protected:
+    virtual void run();
+
+private:
+    struct Lines {
+        int fromLine;
+        QString text;
+        QList<int> linePositions;
+    };
+
+    bool isAborted() const;
+    bool isCandidate(int line) const;
+    void findCandidates(int fromLine, int toLine, QList< QPair<int, int> >& ranges) const;
+    bool takeLines(Lines& lines);
+    int findMatch(const Lines& lines, const QRegExp& regExp) const;
+
+    const int _id;
+    const HistorySearchIndex _index;
+    const QVector<quint32> _trigrams;
+    const QRegExp _regExp;
+    const int _lineCount;
+    const int _startLine;
+    const bool _forwards;
+    // set by abort() in the GUI thread
+    mutable QAtomicInt _aborted;
+
+    QMutex _mutex;
+    QWaitCondition _linesAdded;
+    QQueue<Lines> _lines;
+};
+
 /**
  * A task which searches through the output of sessions for matches for a given regular expression.
  * SearchHistoryTask operates on ScreenWindow instances rather than sessions added by addSession().
@@ -476,8 +564,9 @@ private:
  * FIXME - This is not a proper implementation of SessionTask, in that it ignores sessions specified
  * with addSession()
  *
- * TODO - Implementation requirements:
- *          May provide progress feedback to the user when searching very large output logs.
+ * The search runs asynchronously in a SearchHistoryThread, the task only reads
+ * the text of the lines which might contain a match for it.  So the user
+ * interface stays responsive when searching very large output logs.
  */
 class SearchHistoryTask : public SessionTask
 {
@@ -499,6 +588,7 @@ public:
      * Constructs a new search task.
      */
     explicit SearchHistoryTask(QObject* parent = 0);
+    virtual ~SearchHistoryTask();
 
     /** Adds a screen window to the list to search when execute() is called. */
     void addScreenWindow(Session* session , ScreenWindow* searchWindow);
@@ -528,18 +618,31 @@ public:
      */
     virtual void execute();
 
+private slots:
+    void provideLines(int id, int fromLine, int toLine);
+    void matchFound(int id, int line);
+    void searchFinished(int id);
+
 private:
     typedef QPointer<ScreenWindow> ScreenWindowPtr;
 
+    struct Search {
+        SessionPtr session;
+        ScreenWindowPtr window;
+        SearchHistoryThread* thread;
+    };
+
     void executeOnScreenWindow(SessionPtr session , ScreenWindowPtr window);
     void highlightResult(ScreenWindowPtr window , int position);
+    void finishSearch(int id, bool success);
 
     QMap< SessionPtr , ScreenWindowPtr > _windows;
     QRegExp _regExp;
     SearchDirection _direction;
     int _startLine;
 
-    //static QPointer<SearchHistoryThread> _thread;
+    QHash<int, Search> _searches;
+    int _nextSearchId;
 };
 }
 
@@ -209,8 +209,10 @@ void SessionManager::applyProfile(Session* session, const Profile::Ptr profile ,
                                    profile->remoteTabTitleFormat());
 
     // History
-    if (apply.shouldApply(Profile::HistoryMode) || apply.shouldApply(Profile::HistorySize)) {
+    if (apply.shouldApply(Profile::HistoryMode) || apply.shouldApply(Profile::HistorySize)
+            || apply.shouldApply(Profile::MappedHistory)) {
         const int mode = profile->property<int>(Profile::HistoryMode);
+        const bool mapped = profile->property<bool>(Profile::MappedHistory);
         switch (mode) {
         case Enum::NoHistory:
             session->setHistoryType(HistoryTypeNone());
@@ -218,12 +220,18 @@ void SessionManager::applyProfile(Session* session, const Profile::Ptr profile ,
 
         case Enum::FixedSizeHistory: {
             int lines = profile->historySize();
-            session->setHistoryType(CompactHistoryType(lines));
+            if (mapped)
+                session->setHistoryType(MappedHistoryType(lines));
+            else
+                session->setHistoryType(CompactHistoryType(lines));
         }
         break;
 
         case Enum::UnlimitedHistory:
-            session->setHistoryType(HistoryTypeFile());
+            if (mapped)
+                session->setHistoryType(MappedHistoryType());
+            else
+                session->setHistoryType(HistoryTypeFile());
             break;
         }
     }
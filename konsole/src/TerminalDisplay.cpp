@@ -106,6 +106,7 @@ void TerminalDisplay::setScreenWindow(ScreenWindow* window)
     }
 
     _screenWindow = window;
+    _fullImageUpdate = true;
 
     if (_screenWindow) {
         connect(_screenWindow , SIGNAL(outputChanged()) , this , SLOT(updateLineProperties()));
@@ -268,6 +269,10 @@ TerminalDisplay::TerminalDisplay(QWidget* parent)
     , _image(0)
     , _randomSeed(0)
     , _resizing(false)
+    , _fullImageUpdate(true)
+    , _showRepaintStats(!qgetenv("KONSOLE_SHOW_REPAINT_STATS").isEmpty())
+    , _comparedLineCount(0)
+    , _repaintedCellCount(0)
     , _showTerminalSizeHint(false)
     , _bidiEnabled(false)
     , _actSel(0)
@@ -763,13 +768,13 @@ uint TerminalDisplay::randomSeed() const
 // display is much cheaper than re-rendering all the text for the
 // part of the image which has moved up or down.
 // Instead only new lines have to be drawn
-void TerminalDisplay::scrollImage(int lines , const QRect& screenWindowRegion)
+QRect TerminalDisplay::scrollImage(int lines , const QRect& screenWindowRegion)
 {
     // if the flow control warning is enabled this will interfere with the
     // scrolling optimizations and cause artifacts.  the simple solution here
     // is to just disable the optimization whilst it is visible
     if (_outputSuspendedLabel && _outputSuspendedLabel->isVisible())
-        return;
+        return QRect();
 
     // constrain the region to the display
     // the bottom of the region is capped to the number of lines in the display's
@@ -783,7 +788,7 @@ void TerminalDisplay::scrollImage(int lines , const QRect& screenWindowRegion)
             || _image == 0
             || !region.isValid()
             || (region.top() + abs(lines)) >= region.bottom()
-            || this->_lines <= region.height()) return;
+            || this->_lines <= region.height()) return QRect();
 
     // hide terminal size label to prevent it being scrolled
     if (_resizeWidget && _resizeWidget->isVisible())
@@ -849,6 +854,8 @@ void TerminalDisplay::scrollImage(int lines , const QRect& screenWindowRegion)
 
     //scroll the display vertically to match internal _image
     scroll(0 , _fontHeight * (-lines) , scrollRect);
+
+    return QRect(0, region.top(), this->_columns, region.height());
 }
 
 QRegion TerminalDisplay::hotSpotRegion() const
@@ -916,9 +923,10 @@ void TerminalDisplay::updateImage()
     // optimization - scroll the existing image where possible and
     // avoid expensive text drawing for parts of the image that
     // can simply be moved up or down
+    QRect scrolledLines;
     if (_wallpaper->isNull()) {
-        scrollImage(_screenWindow->scrollCount() ,
-                    _screenWindow->scrollRegion());
+        scrolledLines = scrollImage(_screenWindow->scrollCount() ,
+                                    _screenWindow->scrollRegion());
         _screenWindow->resetScrollCount();
     }
 
@@ -942,33 +950,61 @@ void TerminalDisplay::updateImage()
     const QPoint tL  = contentsRect().topLeft();
     const int    tLx = tL.x();
     const int    tLy = tL.y();
-    _hasTextBlinker = false;
 
     CharacterColor cf;       // undefined
 
     const int linesToUpdate = qMin(this->_lines, qMax(0, lines));
     const int columnsToUpdate = qMin(this->_columns, qMax(0, columns));
 
+    // unless the whole window has changed, only the lines which the screen
+    // window reports as changed and the lines which have just been moved
+    // by scrollImage() need to be compared with the new image
+    const bool fullUpdate = _fullImageUpdate || _screenWindow->allLinesDirty();
+
     char* dirtyMask = new char[columnsToUpdate + 2];
     QRegion dirtyRegion;
 
-    // debugging variable, this records the number of lines that are found to
-    // be 'dirty' ( ie. have changed from the old _image to the new _image ) and
+    // debugging variables, these record the number of lines that are compared
+    // with the new _image and the number of characters which are found to be
+    // 'dirty' ( ie. have changed from the old _image to the new _image ) and
     // which therefore need to be repainted
-    int dirtyLineCount = 0;
+    _comparedLineCount = 0;
+    _repaintedCellCount = 0;
 
     for (y = 0; y < linesToUpdate; ++y) {
         const Character* currentLine = &_image[y * this->_columns];
         const Character* const newLine = &newimg[y * columns];
 
-        bool updateLine = false;
+        //both the top and bottom halves of double height _lines must always be redrawn
+        //although both top and bottom halves contain the same characters, only
+        //the top one is actually
+        //drawn.
+        const bool doubleHeight = _lineProperties.count() > y && (_lineProperties[y] & LINE_DOUBLEHEIGHT);
+
+        int changedLeft = 0;
+        int changedRight = columnsToUpdate - 1;
+        if (!fullUpdate && !doubleHeight &&
+                (y < scrolledLines.top() || y > scrolledLines.bottom())) {
+            _screenWindow->getDirtyColumns(y, changedLeft, changedRight);
+            changedLeft = qMax(0, changedLeft);
+            changedRight = qMin(changedRight, columnsToUpdate - 1);
+            if (changedLeft > changedRight)
+                continue;
+        }
+
+        _comparedLineCount++;
+
+        bool updateLine = doubleHeight;
+        bool lineHasBlinker = false;
+        int firstDirtyColumn = columnsToUpdate;
+        int lastDirtyColumn = -1;
 
         // The dirty mask indicates which characters need repainting. We also
         // mark surrounding neighbors dirty, in case the character exceeds
         // its cell boundaries
         memset(dirtyMask, 0, columnsToUpdate + 2);
 
-        for (x = 0 ; x < columnsToUpdate ; ++x) {
+        for (x = changedLeft ; x <= changedRight ; ++x) {
             if (newLine[x] != currentLine[x]) {
                 dirtyMask[x] = true;
             }
@@ -976,7 +1012,7 @@ void TerminalDisplay::updateImage()
 
         if (!_resizing) // not while _resizing, we're expecting a paintEvent
             for (x = 0; x < columnsToUpdate; ++x) {
-                _hasTextBlinker |= (newLine[x].rendition & RE_BLINK);
+                lineHasBlinker |= (newLine[x].rendition & RE_BLINK);
 
                 // Start drawing if this character or the next one differs.
                 // We also take the next one into account to handle the situation
@@ -1014,39 +1050,54 @@ void TerminalDisplay::updateImage()
                         _fixedFont = false;
 
                     updateLine = true;
+                    firstDirtyColumn = qMin(firstDirtyColumn, x);
+                    lastDirtyColumn = qMax(lastDirtyColumn, x + len - 1);
 
                     _fixedFont = saveFixedFont;
                     x += len - 1;
                 }
             }
 
-        //both the top and bottom halves of double height _lines must always be redrawn
-        //although both top and bottom halves contain the same characters, only
-        //the top one is actually
-        //drawn.
-        if (_lineProperties.count() > y)
-            updateLine |= (_lineProperties[y] & LINE_DOUBLEHEIGHT);
+        _blinkingLines.setBit(y, lineHasBlinker);
 
         // if the characters on the line are different in the old and the new _image
-        // then this line must be repainted.
+        // then the changed runs of characters on this line must be repainted.
         if (updateLine) {
-            dirtyLineCount++;
+            // the whole line is repainted if bidi rendering is enabled, as the
+            // position of a character then depends on the other characters, and
+            // for double height lines.  Otherwise the changed runs are repainted
+            // including their neighbors, in case characters exceed their cell width.
+            int left = 0;
+            int right = columnsToUpdate - 1;
+            if (!_bidiEnabled && !doubleHeight && firstDirtyColumn <= lastDirtyColumn) {
+                left = qMax(0, firstDirtyColumn - 1);
+                right = qMin(columnsToUpdate - 1, lastDirtyColumn + 1);
+            }
+            _repaintedCellCount += right - left + 1;
 
-            // add the area occupied by this line to the region which needs to be
-            // repainted
-            QRect dirtyRect = QRect(_contentRect.left() + tLx ,
+            // add the area occupied by the changed characters to the region
+            // which needs to be repainted
+            QRect dirtyRect = QRect(_contentRect.left() + tLx + _fontWidth * left ,
                                     _contentRect.top() + tLy + _fontHeight * y ,
-                                    _fontWidth * columnsToUpdate ,
+                                    _fontWidth * (right - left + 1) ,
                                     _fontHeight);
 
             dirtyRegion |= dirtyRect;
         }
 
-        // replace the line of characters in the old _image with the
-        // current line of the new _image
-        memcpy((void*)currentLine, (const void*)newLine, columnsToUpdate * sizeof(Character));
+        // replace the changed characters in the old _image with the
+        // characters of the new _image
+        memcpy((void*)(currentLine + changedLeft), (const void*)(newLine + changedLeft),
+               (changedRight - changedLeft + 1) * sizeof(Character));
     }
 
+    for (y = linesToUpdate; y < _blinkingLines.size(); ++y)
+        _blinkingLines.clearBit(y);
+    _hasTextBlinker = (_blinkingLines.count(true) > 0);
+
+    _fullImageUpdate = false;
+    _screenWindow->resetDirtyLines();
+
     // if the new _image is smaller than the previous _image, then ensure that the area
     // outside the new _image is cleared
     if (linesToUpdate < _usedLines) {
@@ -1067,6 +1118,9 @@ void TerminalDisplay::updateImage()
 
     dirtyRegion |= _inputMethodData.previousPreeditRect;
 
+    if (_showRepaintStats)
+        dirtyRegion |= repaintStatsRect();
+
     // update the parts of the display which have changed
     update(dirtyRegion);
 
@@ -1080,6 +1134,21 @@ void TerminalDisplay::updateImage()
     delete[] dirtyMask;
 }
 
+QRect TerminalDisplay::repaintStatsRect() const
+{
+    const int width = fontMetrics().width(QLatin1String("000 lines 00000 cells")) + 2 * _margin;
+    return QRect(_contentRect.right() - width, _contentRect.top(), width, fontMetrics().height());
+}
+
+void TerminalDisplay::drawRepaintStats(QPainter& painter)
+{
+    const QRect rect = repaintStatsRect();
+    painter.fillRect(rect, QColor(255, 255, 0, 200));
+    painter.setPen(Qt::black);
+    painter.drawText(rect, Qt::AlignCenter,
+                     QString("%1 lines %2 cells").arg(_comparedLineCount).arg(_repaintedCellCount));
+}
+
 void TerminalDisplay::showResizeNotification()
 {
     if (_showTerminalSizeHint && isVisible()) {
@@ -1117,6 +1186,9 @@ void TerminalDisplay::paintEvent(QPaintEvent* pe)
     drawCurrentResultRect(paint);
     drawInputMethodPreeditString(paint, preeditRect());
     paintFilters(paint);
+
+    if (_showRepaintStats)
+        drawRepaintStats(paint);
 }
 
 void TerminalDisplay::printContent(QPainter& painter, bool friendly)
@@ -1608,6 +1680,7 @@ void TerminalDisplay::makeImage()
     // We over-commit one character so that we can be more relaxed in dealing with
     // certain boundary conditions: _image[_imageSize] is a valid but unused position
     _image = new Character[_imageSize + 1];
+    _blinkingLines.fill(false, _lines);
 
     clearImage();
 }
@@ -1616,6 +1689,8 @@ void TerminalDisplay::clearImage()
 {
     for (int i = 0; i <= _imageSize; ++i)
         _image[i] = Screen::DefaultChar;
+
+    _fullImageUpdate = true;
 }
 
 void TerminalDisplay::calcGeometry()
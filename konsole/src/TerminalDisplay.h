@@ -23,6 +23,7 @@
 
 // Qt
 #include <QtGui/QColor>
+#include <QtCore/QBitArray>
 #include <QtCore/QPointer>
 #include <QWidget>
 
@@ -736,7 +737,9 @@ private:
     // 'region' is the part of the image to scroll - currently only
     // the top, bottom and height of 'region' are taken into account,
     // the left and right are ignored.
-    void scrollImage(int lines , const QRect& region);
+    // returns the lines of the image which have been changed by scrolling
+    // or an empty rect if the image has not been scrolled
+    QRect scrollImage(int lines , const QRect& region);
 
     void calcGeometry();
     void propagateSize();
@@ -745,6 +748,11 @@ private:
 
     void paintFilters(QPainter& painter);
 
+    // returns the area of the widget in which the repaint statistics are
+    // shown, see _showRepaintStats
+    QRect repaintStatsRect() const;
+    void drawRepaintStats(QPainter& painter);
+
     // returns a region covering all of the areas of the widget which contain
     // a hotspot
     QRegion hotSpotRegion() const;
@@ -801,6 +809,15 @@ private:
     uint _randomSeed;
 
     bool _resizing;
+    // set when _image does not match the image of the screen window,
+    // so that updateImage() has to compare all lines
+    bool _fullImageUpdate;
+
+    // statistics of the last call to updateImage(), they are drawn on top of
+    // the terminal if the KONSOLE_SHOW_REPAINT_STATS environment variable is set
+    bool _showRepaintStats;
+    int _comparedLineCount;
+    int _repaintedCellCount;
     bool _showTerminalSizeHint;
     bool _bidiEnabled;
     bool _mouseMarks;
@@ -829,6 +846,7 @@ private:
     bool _textBlinking;   // text is blinking, hide it when drawing
     bool _cursorBlinking;     // cursor is blinking, hide it when drawing
     bool _hasTextBlinker; // has characters to blink
+    QBitArray _blinkingLines; // lines of the image with characters to blink
     QTimer* _blinkTextTimer;
     QTimer* _blinkCursorTimer;
 
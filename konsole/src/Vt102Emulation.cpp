@@ -25,6 +25,7 @@
 
 // Standard
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 // Qt
@@ -390,6 +391,59 @@ void Vt102Emulation::receiveChar(int cc)
     return;
   }
 }
+
+/* Returns the number of characters at the start of 'chars' which are
+   printable US-ASCII characters (0x20..0x7e).
+
+   Text written to a terminal mostly consists of long runs of such
+   characters, so four characters are tested at once by treating them
+   as the 16 bit lanes of a 64 bit word: a lane has its high bit set
+   after the subtraction if it is below 0x20 and after the addition if
+   it is above 0x7e.
+*/
+static int printableRunLength(const ushort* chars, int length)
+{
+  const quint64 ones  = Q_UINT64_C(0x0001000100010001);
+  const quint64 highs = Q_UINT64_C(0x8000800080008000);
+
+  int i = 0;
+  for (; i + 4 <= length; i += 4)
+  {
+    quint64 word;
+    memcpy(&word, chars + i, sizeof(word));
+
+    const quint64 below = (word - ones * 0x20) & ~word;
+    const quint64 above = (word + ones * (0x7fff - 0x7e)) | word;
+    if ((below | above) & highs)
+      break;
+  }
+  while (i < length && chars[i] >= 0x20 && chars[i] <= 0x7e)
+    i++;
+  return i;
+}
+
+// process a block of incoming unicode characters
+void Vt102Emulation::receiveChars(const ushort* chars, int length)
+{
+  int i = 0;
+  while (i < length)
+  {
+    // Plain characters outside of an escape sequence are displayed as a
+    // whole, unless a VT100 charset would translate them.
+    const CharCodes& charset = _charset[_currentScreen == _screen[1]];
+    if (tokenBufferPos == 0 && getMode(MODE_Ansi) && !charset.graphic && !charset.pound)
+    {
+      const int count = printableRunLength(chars + i, length - i);
+      if (count > 1)
+      {
+        _currentScreen->displayCharacters(chars + i, count);
+        i += count;
+        continue;
+      }
+    }
+    receiveChar(chars[i++]);
+  }
+}
 void Vt102Emulation::processWindowAttributeChange()
 {
   // Describes the window or terminal session attribute to change
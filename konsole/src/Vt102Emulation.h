@@ -73,7 +73,7 @@ struct CharCodes {
  * sequences.
  *
  */
-class Vt102Emulation : public Emulation
+class KONSOLEPRIVATE_EXPORT Vt102Emulation : public Emulation
 {
     Q_OBJECT
 
@@ -99,6 +99,7 @@ protected:
     virtual void setMode(int mode);
     virtual void resetMode(int mode);
     virtual void receiveChar(int cc);
+    virtual void receiveChars(const ushort* chars, int length);
 
 private slots:
     //causes changeTitle() to be emitted for each (int,QString) pair in pendingTitleUpdates
@@ -0,0 +1,142 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "HistorySearchIndexTest.h"
+
+// KDE
+#include <qtest_kde.h>
+
+// Konsole
+#include "../Character.h"
+#include "../HistorySearchIndex.h"
+
+using namespace Konsole;
+
+static void addLine(HistorySearchIndex& index, const QString& text, bool wrapped = false)
+{
+    QVector<Character> line(text.length());
+    for (int i = 0; i < text.length(); i++)
+        line[i] = Character(text.at(i).unicode());
+    index.addLine(line.constData(), line.size(), wrapped);
+}
+
+void HistorySearchIndexTest::testTrigrams()
+{
+    QCOMPARE(HistorySearchIndex::trigrams(QString()).count(), 0);
+    QCOMPARE(HistorySearchIndex::trigrams("ab cd").count(), 0);
+    QCOMPARE(HistorySearchIndex::trigrams("abcd").count(), 2);
+    QCOMPARE(HistorySearchIndex::trigrams("abc abc").count(), 1);
+    QCOMPARE(HistorySearchIndex::trigrams("ABC"), HistorySearchIndex::trigrams("abc"));
+}
+
+void HistorySearchIndexTest::testMayContain()
+{
+    HistorySearchIndex index;
+    for (int i = 0; i < 100; i++)
+        addLine(index, QString("line %1 of the output").arg(i));
+    addLine(index, "undefined reference to `main'");
+    for (int i = 0; i < 100; i++)
+        addLine(index, QString("line %1 of the output").arg(i));
+    QCOMPARE(index.lineCount(), 201);
+
+    const QVector<quint32> trigrams = HistorySearchIndex::trigrams("Undefined Reference");
+    QVERIFY(index.mayContain(100, trigrams));
+
+    int candidates = 0;
+    for (int i = 0; i < index.lineCount(); i++) {
+        if (index.mayContain(i, trigrams))
+            candidates++;
+    }
+    QVERIFY(candidates < 64);
+
+    // every line is a candidate for texts without trigrams
+    for (int i = 0; i < index.lineCount(); i++)
+        QVERIFY(index.mayContain(i, QVector<quint32>()));
+}
+
+void HistorySearchIndexTest::testWrappedLines()
+{
+    HistorySearchIndex index;
+    for (int i = 0; i < 50; i++)
+        addLine(index, "some text");
+    addLine(index, "a very long wo", true);
+    addLine(index, "rd which is wrapped");
+    for (int i = 0; i < 50; i++)
+        addLine(index, "some text");
+
+    QVERIFY(index.mayContain(50, HistorySearchIndex::trigrams("long word")));
+
+    // a line which is not wrapped ends a word
+    HistorySearchIndex unwrappedIndex;
+    for (int i = 0; i < 50; i++)
+        addLine(unwrappedIndex, "some text");
+    addLine(unwrappedIndex, "a very long wo");
+    addLine(unwrappedIndex, "rd which is not wrapped");
+    for (int i = 0; i < 50; i++)
+        addLine(unwrappedIndex, "some text");
+
+    QVERIFY(!unwrappedIndex.mayContain(0, HistorySearchIndex::trigrams("word")));
+}
+
+void HistorySearchIndexTest::testRemoveFirstLine()
+{
+    HistorySearchIndex index;
+    addLine(index, "first");
+    for (int i = 0; i < 100; i++)
+        addLine(index, "other");
+    addLine(index, "last");
+
+    index.removeFirstLine();
+    QCOMPARE(index.lineCount(), 101);
+    QVERIFY(index.mayContain(100, HistorySearchIndex::trigrams("last")));
+    QVERIFY(!index.mayContain(50, HistorySearchIndex::trigrams("last")));
+
+    index.clear();
+    QCOMPARE(index.lineCount(), 0);
+    addLine(index, "again");
+    QVERIFY(index.mayContain(0, HistorySearchIndex::trigrams("again")));
+}
+
+void HistorySearchIndexTest::testUnindexedLines()
+{
+    HistorySearchIndex index;
+    index.clear(3);
+    QCOMPARE(index.lineCount(), 3);
+    for (int i = 0; i < 40; i++)
+        addLine(index, "other");
+    addLine(index, "last");
+    QCOMPARE(index.lineCount(), 44);
+
+    const QVector<quint32> trigrams = HistorySearchIndex::trigrams("last");
+    QVERIFY(index.mayContain(0, trigrams));
+    QVERIFY(index.mayContain(2, trigrams));
+    QVERIFY(!index.mayContain(3, trigrams));
+    QVERIFY(index.mayContain(43, trigrams));
+
+    // the unindexed lines are removed first
+    for (int i = 0; i < 3; i++)
+        index.removeFirstLine();
+    QCOMPARE(index.lineCount(), 41);
+    QVERIFY(!index.mayContain(0, trigrams));
+    QVERIFY(index.mayContain(40, trigrams));
+}
+
+QTEST_KDEMAIN_CORE(HistorySearchIndexTest)
+
+#include "moc_HistorySearchIndexTest.cpp"
+
@@ -59,6 +59,25 @@ void HistoryTest::testCompactHistory()
     QCOMPARE(history->isEnabled(), true);
     QCOMPARE(history->isUnlimited(), false);
     QCOMPARE(history->maximumLineCount(), 42);
+    QCOMPARE(history->isMemoryMapped(), false);
+    delete history;
+}
+
+void HistoryTest::testMappedHistory()
+{
+    HistoryType* history;
+
+    history = new MappedHistoryType();
+    QCOMPARE(history->isEnabled(), true);
+    QCOMPARE(history->isUnlimited(), true);
+    QCOMPARE(history->maximumLineCount(), -1);
+    delete history;
+
+    history = new MappedHistoryType(42);
+    QCOMPARE(history->isEnabled(), true);
+    QCOMPARE(history->isUnlimited(), false);
+    QCOMPARE(history->maximumLineCount(), 42);
+    QCOMPARE(history->isMemoryMapped(), true);
     delete history;
 }
 
@@ -137,6 +156,89 @@ void HistoryTest::testHistoryScroll()
     delete historyScroll;
 }
 
+static Character testCharacter(int line, int column)
+{
+    const int format = (line + column / 7) % 3;
+    return Character('a' + (line + column) % 26,
+                     CharacterColor(COLOR_SPACE_SYSTEM, format),
+                     CharacterColor(COLOR_SPACE_DEFAULT, 1),
+                     format == 2 ? RE_BOLD : DEFAULT_RENDITION,
+                     format != 1);
+}
+
+static int testLineLength(int line)
+{
+    return (line * 37) % 200;
+}
+
+static void addTestLines(HistoryScroll* historyScroll, int count)
+{
+    for (int line = 0; line < count; line++) {
+        QVector<Character> cells(testLineLength(line));
+        for (int column = 0; column < cells.size(); column++)
+            cells[column] = testCharacter(line, column);
+        historyScroll->addCellsVector(cells);
+        historyScroll->addLine(line % 5 == 0);
+    }
+}
+
+static bool compareTestLines(HistoryScroll* historyScroll, int firstLine)
+{
+    for (int i = 0; i < historyScroll->getLines(); i++) {
+        const int line = firstLine + i;
+        const int length = testLineLength(line);
+        if (historyScroll->getLineLen(i) != length || historyScroll->isWrappedLine(i) != (line % 5 == 0))
+            return false;
+
+        // read the line in pieces to test the lookup of the formats
+        for (int start = 0; start < length; start += 13) {
+            Character cells[17];
+            const int count = qMin(length - start, 17);
+            historyScroll->getCells(i, start, count, cells);
+            for (int column = 0; column < count; column++) {
+                const Character expected = testCharacter(line, start + column);
+                if (cells[column] != expected || cells[column].isRealCharacter != expected.isRealCharacter)
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+void HistoryTest::testMappedHistoryScroll()
+{
+    MappedHistoryScroll* historyScroll;
+
+    historyScroll = new MappedHistoryScroll();
+    QVERIFY(historyScroll->hasScroll());
+    QCOMPARE(historyScroll->getLines(), 0);
+    QCOMPARE(historyScroll->getLineLen(0), 0);
+    QCOMPARE(historyScroll->getLineLen(10), 0);
+    QCOMPARE(historyScroll->getType().isUnlimited(), true);
+
+    // enough lines for several blocks, so that old blocks get compressed
+    addTestLines(historyScroll, 60000);
+    historyScroll->waitForCompression();
+    QCOMPARE(historyScroll->getLines(), 60000);
+    QVERIFY(historyScroll->compressedBlockCount() > 0);
+    QVERIFY(compareTestLines(historyScroll, 0));
+
+    // drop the oldest lines
+    historyScroll->setMaxNbLines(1000);
+    QCOMPARE(historyScroll->getType().maximumLineCount(), 1000);
+    QCOMPARE(historyScroll->getLines(), 1000);
+    QVERIFY(compareTestLines(historyScroll, 59000));
+    delete historyScroll;
+
+    // converting keeps the lines
+    CompactHistoryScroll* compactScroll = new CompactHistoryScroll(500);
+    addTestLines(compactScroll, 200);
+    HistoryScroll* convertedScroll = MappedHistoryType(100).scroll(compactScroll);
+    QCOMPARE(convertedScroll->getLines(), 100);
+    QVERIFY(compareTestLines(convertedScroll, 100));
+    delete convertedScroll;
+}
+
 QTEST_KDEMAIN(HistoryTest , GUI)
 
 #include "moc_HistoryTest.cpp"
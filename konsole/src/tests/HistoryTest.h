@@ -33,8 +33,10 @@ private slots:
     void testHistoryNone();
     void testHistoryFile();
     void testCompactHistory();
+    void testMappedHistory();
     void testEmulationHistory();
     void testHistoryScroll();
+    void testMappedHistoryScroll();
 
 private:
 };
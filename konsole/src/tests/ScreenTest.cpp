@@ -0,0 +1,108 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+
+// Own
+#include "ScreenTest.h"
+
+// KDE
+#include <qtest_kde.h>
+
+// Konsole
+#include "../Screen.h"
+
+using namespace Konsole;
+
+static bool isLineDirty(const Screen& screen, int line)
+{
+    int left;
+    int right;
+    screen.getDirtyColumns(line, left, right);
+    return left <= right;
+}
+
+void ScreenTest::testDirtyColumns()
+{
+    Screen screen(5, 20);
+    screen.setCursorYX(3, 1);
+    screen.resetDirtyLines();
+
+    screen.setCursorYX(2, 5);
+    screen.displayCharacter('a');
+    screen.resetDirtyLines();
+
+    // the cursor is now in line 1 behind the new character
+    screen.displayCharacter('b');
+    int left;
+    int right;
+    screen.setCursorYX(5, 1);
+    screen.getDirtyColumns(1, left, right);
+    QCOMPARE(left, 0);
+    QCOMPARE(right, 19);
+    QVERIFY(!isLineDirty(screen, 0));
+    QVERIFY(!isLineDirty(screen, 2));
+    QVERIFY(isLineDirty(screen, 4));
+
+    screen.resetDirtyLines();
+    screen.setCursorYX(5, 3);
+    screen.displayCharacter('c');
+    screen.getDirtyColumns(4, left, right);
+    QCOMPARE(left, 0);
+    QCOMPARE(right, 19);
+    QVERIFY(!isLineDirty(screen, 1));
+}
+
+void ScreenTest::testCursorMovesWithoutText()
+{
+    Screen screen(10, 20);
+    screen.setCursorYX(3, 4);
+    screen.resetDirtyLines();
+
+    // only the line of the cursor is reported
+    for (int line = 0; line < 10; line++)
+        QCOMPARE(isLineDirty(screen, line), line == 2);
+
+    // the old and the new line of the cursor are reported after a move
+    screen.cursorDown(4);
+    for (int line = 0; line < 10; line++)
+        QCOMPARE(isLineDirty(screen, line), line == 2 || line == 6);
+
+    screen.resetDirtyLines();
+    screen.toStartOfLine();
+    screen.tab();
+    screen.backspace();
+    for (int line = 0; line < 10; line++)
+        QCOMPARE(isLineDirty(screen, line), line == 6);
+
+    screen.resetDirtyLines();
+    screen.setCursorYX(1, 1);
+    screen.newLine();
+    for (int line = 0; line < 10; line++)
+        QCOMPARE(isLineDirty(screen, line), line == 6 || line == 1);
+
+    // hiding the cursor changes the cursor line
+    screen.resetDirtyLines();
+    screen.resetMode(MODE_Cursor);
+    QVERIFY(isLineDirty(screen, 1));
+    screen.resetDirtyLines();
+    screen.setMode(MODE_Cursor);
+    QVERIFY(isLineDirty(screen, 1));
+}
+
+QTEST_KDEMAIN_CORE(ScreenTest)
+
+#include "moc_ScreenTest.cpp"
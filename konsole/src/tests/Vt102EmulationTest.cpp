@@ -0,0 +1,144 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+    02110-1301  USA.
+*/
+
+// Own
+#include "Vt102EmulationTest.h"
+
+// Qt
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QTextCodec>
+#include <QtCore/QTextStream>
+
+// KDE
+#include <qtest_kde.h>
+
+// Konsole
+#include "../History.h"
+#include "../TerminalCharacterDecoder.h"
+#include "../Vt102Emulation.h"
+
+using namespace Konsole;
+
+static void setupEmulation(Vt102Emulation& emulation)
+{
+    emulation.setCodec(QTextCodec::codecForName("UTF-8"));
+    emulation.setHistory(CompactHistoryType(1000));
+    emulation.setImageSize(24, 80);
+}
+
+static QString screenText(Vt102Emulation& emulation)
+{
+    QString text;
+    QTextStream stream(&text);
+    PlainTextDecoder decoder;
+    decoder.begin(&stream);
+    emulation.writeToStream(&decoder, 0, emulation.lineCount() - 1);
+    decoder.end();
+    return text;
+}
+
+static QByteArray logText(int size, bool colored)
+{
+    const QByteArray words[] = { "INFO", "connection", "established", "to", "192.168.0.1:8080",
+                                 "after", "3", "retries", "-", "request", "id=0x7f3a", "done" };
+    const int wordCount = sizeof(words) / sizeof(words[0]);
+
+    QByteArray text;
+    text.reserve(size + 256);
+    int line = 0;
+    while (text.size() < size) {
+        const int length = 5 + (line * 7) % 30;
+        for (int i = 0; i < length; i++) {
+            const QByteArray& word = words[(line + i * 5) % wordCount];
+            if (colored && i % 4 == 0)
+                text += "\033[1;3" + QByteArray::number(i % 8) + 'm' + word + "\033[0m";
+            else
+                text += word;
+            text += ' ';
+        }
+        text += "\r\n";
+        line++;
+    }
+    return text;
+}
+
+void Vt102EmulationTest::testBulkOutput_data()
+{
+    QTest::addColumn<QByteArray>("data");
+
+    QTest::newRow("plain") << QByteArray("hello world\r\n");
+    QTest::newRow("wrapped") << QByteArray(250, 'x') + "\r\n" + QByteArray(80, 'y') + "z\r\n";
+    QTest::newRow("log") << logText(8000, false);
+    QTest::newRow("colored") << logText(8000, true);
+    QTest::newRow("no wrap") << "\033[?7l" + QByteArray(100, 'a') + "bcd\r\n" + QByteArray(79, 'e') + "\033[?7h\r\n";
+    QTest::newRow("insert mode") << QByteArray("0123456789\r\033[4habc\033[4l\r\n");
+    QTest::newRow("graphics charset") << QByteArray("\033(0lqqk\033(Bqqq\r\n");
+    QTest::newRow("control characters") << QByteArray("ab\tcd\bx\x7f" "ef\r\n\x1b]0;title\x07gh\r\n");
+    QTest::newRow("utf8") << QByteArray("caf\xc3\xa9 na\xc3\xafve \xe4\xb8\xad\xe6\x96\x87 e\xcc\x81\r\n");
+}
+
+void Vt102EmulationTest::testBulkOutput()
+{
+    QFETCH(QByteArray, data);
+
+    Vt102Emulation bulk;
+    setupEmulation(bulk);
+    bulk.receiveData(data.constData(), data.size());
+
+    // Passing one byte at a time never takes the path for runs of characters
+    Vt102Emulation single;
+    setupEmulation(single);
+    for (int i = 0; i < data.size(); i++)
+        single.receiveData(data.constData() + i, 1);
+
+    QCOMPARE(bulk.lineCount(), single.lineCount());
+    QCOMPARE(screenText(bulk), screenText(single));
+}
+
+void Vt102EmulationTest::benchmarkThroughput_data()
+{
+    QTest::addColumn<bool>("colored");
+
+    QTest::newRow("plain") << false;
+    QTest::newRow("colored") << true;
+}
+
+void Vt102EmulationTest::benchmarkThroughput()
+{
+    QFETCH(bool, colored);
+
+    const QByteArray data = logText(4 * 1024 * 1024, colored);
+
+    Vt102Emulation emulation;
+    setupEmulation(emulation);
+
+    int iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        emulation.receiveData(data.constData(), data.size());
+        iterations++;
+    }
+
+    const qint64 elapsed = qMax(qint64(1), timer.elapsed());
+    const double megabytes = double(data.size()) * iterations / (1024 * 1024);
+    qDebug() << "Throughput:" << megabytes * 1000 / elapsed << "MB/s";
+}
+
+QTEST_KDEMAIN_CORE(Vt102EmulationTest)
+
+#include "moc_Vt102EmulationTest.cpp"
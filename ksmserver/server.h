@@ -31,6 +31,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <QTimer>
 #include <QDateTime>
 #include <QDBusInterface>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
 #include <QMap>
 
 #include <kapplication.h>
@@ -163,6 +166,9 @@ private:
     bool defaultSession() const; // empty session
     void setupXIOErrorHandler();
 
+    void startRestoring();
+    void expireRestoringClients();
+    void logRestore( const QString& message );
     bool checkStartupSuspend();
     void finishStartup();
     void resumeStartupInternal();
@@ -226,10 +232,19 @@ private:
     KWorkSpace::ShutdownType pendingShutdown_sdtype;
     KWorkSpace::ShutdownMode pendingShutdown_sdmode;
 
-    // sequential startup
+    // session restore, independent clients are started in parallel
+    struct RestoringClient {
+        QString program;
+        bool ordered; // nothing else is started while it is restoring
+        QElapsedTimer started;
+    };
     int appsToStart;
     int lastAppStarted;
-    QString lastIdStarted;
+    QHash< QString, RestoringClient > restoringClients; // by client id
+    int restoreParallelism;
+    QStringList orderedRestoreApps;
+    QElapsedTimer restorePhaseTimer;
+    QFile restoreLog;
 
     QStringList excludeApps;
 
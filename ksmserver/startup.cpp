@@ -46,7 +46,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <assert.h>
 #include <limits.h>
 
+#include <QFileInfo>
 #include <QPushButton>
+#include <QRegExp>
 #include <QTimer>
 #include <QtDBus/QtDBus>
 
@@ -264,8 +266,6 @@ void KSMServer::autoStart1Done()
         return;
     kDebug() << "Autostart 1 done";
     setupShortcuts(); // done only here, because it needs kglobalaccel :-/
-    lastAppStarted = 0;
-    lastIdStarted.clear();
     state = Restoring;
 #ifdef KSMSERVER_STARTUP_DEBUG1
     kDebug() << t.elapsed();
@@ -274,13 +274,65 @@ void KSMServer::autoStart1Done()
         autoStart2();
         return;
     }
+    startRestoring();
+}
+
+// how long a restored client may take to register before the next ones are started
+static const int RESTORE_TIMEOUT = 2000;
+
+void KSMServer::startRestoring()
+{
+    KConfigGroup generalGroup( KGlobal::config(), "General" );
+    restoreParallelism = qMax( 1, generalGroup.readEntry( "restoreParallelism", 4 ));
+    orderedRestoreApps = generalGroup.readEntry( "orderedRestoreApps" ).toLower().split( QRegExp( "[,:]" ), QString::SkipEmptyParts );
+    lastAppStarted = 0;
+    restoringClients.clear();
+    restorePhaseTimer.start();
+    // kDebug() is compiled out of release builds, the timing of the
+    // restore phase is written to a log file of its own
+    restoreLog.close();
+    restoreLog.setFileName( KStandardDirs::locateLocal( "tmp", "ksmserver-restore.log" ));
+    if ( !restoreLog.open( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text ))
+        kWarning() << "Cannot write" << restoreLog.fileName() << ":" << restoreLog.errorString();
+    logRestore( QString( "restoring %1 clients of %2, at most %3 at once" )
+                .arg( appsToStart ).arg( sessionGroup ).arg( restoreParallelism ));
     tryRestoreNext();
 }
 
+void KSMServer::logRestore( const QString& message )
+{
+    const QString line = QString( "%1 ms: %2\n" ).arg( restorePhaseTimer.elapsed()).arg( message );
+    kDebug() << line.trimmed();
+    if ( restoreLog.isOpen()) {
+        restoreLog.write( line.toLocal8Bit());
+        restoreLog.flush();
+    }
+}
+
 void KSMServer::clientRegistered( const char* previousId )
 {
-    if ( previousId && lastIdStarted == previousId )
-        tryRestoreNext();
+    if ( !previousId )
+        return;
+    QHash< QString, RestoringClient >::iterator it = restoringClients.find( QString::fromLatin1( previousId ));
+    if ( it == restoringClients.end())
+        return;
+    logRestore( QString( "restored %1 registered after %2 ms" ).arg( it->program ).arg( it->started.elapsed()));
+    restoringClients.erase( it );
+    tryRestoreNext();
+}
+
+void KSMServer::expireRestoringClients()
+{
+    QHash< QString, RestoringClient >::iterator it = restoringClients.begin();
+    while ( it != restoringClients.end()) {
+        if ( it->started.elapsed() >= RESTORE_TIMEOUT ) {
+            kWarning() << "Restored client" << it->program << "did not register within" << RESTORE_TIMEOUT << "ms";
+            logRestore( QString( "restored %1 did not register within %2 ms" ).arg( it->program ).arg( RESTORE_TIMEOUT ));
+            it = restoringClients.erase( it );
+        } else {
+            ++it;
+        }
+    }
 }
 
 void KSMServer::tryRestoreNext()
@@ -289,11 +341,21 @@ void KSMServer::tryRestoreNext()
         return;
     restoreTimer.stop();
     startupSuspendTimeoutTimer.stop();
+    expireRestoringClients();
     KConfigGroup config(KGlobal::config(), sessionGroup );
 
-    while ( lastAppStarted < appsToStart ) {
-        lastAppStarted++;
-        QString n = QString::number(lastAppStarted);
+    bool orderedRestoring = false;
+    foreach ( const RestoringClient& client, restoringClients ) {
+        orderedRestoring = orderedRestoring || client.ordered;
+    }
+
+    // Clients flagged as ordered are started alone, like all clients used to be,
+    // everything else is started as long as less than restoreParallelism clients
+    // have not registered yet
+    while ( lastAppStarted < appsToStart && !orderedRestoring
+            && restoringClients.count() < restoreParallelism ) {
+        const int next = lastAppStarted + 1;
+        QString n = QString::number(next);
         QString clientId = config.readEntry( QString("clientId")+n, QString() );
         bool alreadyStarted = false;
         foreach ( KSMClient *c, clients ) {
@@ -302,32 +364,60 @@ void KSMServer::tryRestoreNext()
                 break;
             }
         }
-        if ( alreadyStarted )
-            continue;
-
         QStringList restartCommand = config.readEntry( QString("restartCommand")+n, QStringList() );
-        if ( restartCommand.isEmpty() ||
+        const QString program = config.readEntry( QString("program")+n, QString() );
+        if ( alreadyStarted || restartCommand.isEmpty() ||
              (config.readEntry( QString("restartStyleHint")+n, 0 ) == SmRestartNever)) {
+            lastAppStarted = next;
             continue;
         }
-        if ( isWM( config.readEntry( QString("program")+n, QString() ) ) )
+        if ( isWM( program ) ) {
+            lastAppStarted = next;
             continue; // wm already started
-        if( config.readEntry( QString( "wasWm" )+n, false ))
+        }
+        if( config.readEntry( QString( "wasWm" )+n, false )) {
+            lastAppStarted = next;
             continue; // it was wm before, but not now, don't run it (some have --replace in command :(  )
+        }
+        const bool ordered = config.readEntry( QString( "restoreOrdered" )+n, false )
+                             || orderedRestoreApps.contains( program.toLower())
+                             || orderedRestoreApps.contains( QFileInfo( program ).fileName().toLower());
+        if ( ordered && !restoringClients.isEmpty())
+            break; // wait until the others have registered
+        lastAppStarted = next;
         startApplication( restartCommand,
                           config.readEntry( QString("clientMachine")+n, QString() ),
                           config.readEntry( QString("userId")+n, QString() ));
-        lastIdStarted = clientId;
-        if ( !lastIdStarted.isEmpty() ) {
-            restoreTimer.setSingleShot( true );
-            restoreTimer.start( 2000 );
-            return; // we get called again from the clientRegistered handler
+        if ( clientId.isEmpty()) {
+            // it cannot be recognized when it registers, waiting for it would only
+            // hold back the other clients until it times out
+            logRestore( QString( "started %1%2, no client id, not waited for" ).arg( program ).arg( ordered ? " (ordered)" : "" ));
+            continue;
         }
+        logRestore( QString( "started %1%2" ).arg( program ).arg( ordered ? " (ordered)" : "" ));
+        RestoringClient& client = restoringClients[ clientId ];
+        client.program = program;
+        client.ordered = ordered;
+        client.started.start();
+        orderedRestoring = ordered;
+    }
+
+    if ( !restoringClients.isEmpty()) {
+        // we get called again from the clientRegistered handler,
+        // or when the oldest client did not register in time
+        qint64 oldest = 0;
+        foreach ( const RestoringClient& client, restoringClients ) {
+            oldest = qMax( oldest, client.started.elapsed());
+        }
+        restoreTimer.setSingleShot( true );
+        restoreTimer.start( qMax< qint64 >( 0, RESTORE_TIMEOUT - oldest ));
+        return;
     }
 
     //all done
+    logRestore( QString( "restoring %1 done" ).arg( sessionGroup ));
+    restoreLog.close();
     appsToStart = 0;
-    lastIdStarted.clear();
 
     if (state == Restoring)
         autoStart2();
@@ -491,9 +581,7 @@ void KSMServer::restoreSubSession( const QString& name )
     KConfigGroup configSessionGroup( KGlobal::config(), sessionGroup);
     int count =  configSessionGroup.readEntry( "count", 0 );
     appsToStart = count;
-    lastAppStarted = 0;
-    lastIdStarted.clear();
 
     state = RestoringSubSession;
-    tryRestoreNext();
+    startRestoring();
 }
@@ -1789,19 +1789,35 @@ void Client::setClientShown(bool shown)
     }
 }
 
+// Number of 32 bit values of the WM_HINTS property, see ICCCM 4.1.2.4
+static const int WM_HINTS_ELEMENTS = 9;
+
 void Client::getWMHints()
 {
-    XWMHints* hints = XGetWMHints(display(), window());
+    Xcb::Property property = fetchWMHints();
+    readWMHints(property);
+}
+
+Xcb::Property Client::fetchWMHints() const
+{
+    return Xcb::Property(window(), XCB_ATOM_WM_HINTS, XCB_ATOM_WM_HINTS, WM_HINTS_ELEMENTS);
+}
+
+void Client::readWMHints(Xcb::Property &property)
+{
     input = true;
     m_windowGroup = XCB_WINDOW_NONE;
     urgency = false;
-    if (hints) {
-        if (hints->flags & InputHint)
-            input = hints->input;
-        if (hints->flags & WindowGroupHint)
-            m_windowGroup = hints->window_group;
-        urgency = !!(hints->flags & UrgencyHint);   // Need boolean, it's a uint bitfield
-        XFree((char*)hints);
+    // Clients following ICCCM version 1 don't provide the window group
+    const int count = property.count(32);
+    const uint32_t *hints = property.values<uint32_t>();
+    if (hints && count >= WM_HINTS_ELEMENTS - 1) {
+        const uint32_t flags = hints[0];
+        if (flags & InputHint)
+            input = hints[1];
+        if ((flags & WindowGroupHint) && count >= WM_HINTS_ELEMENTS)
+            m_windowGroup = hints[8];
+        urgency = !!(flags & UrgencyHint);   // Need boolean, it's a uint bitfield
     }
     checkGroup();
     updateUrgency();
@@ -1809,9 +1825,20 @@ void Client::getWMHints()
 }
 
 void Client::getMotifHints()
+{
+    Xcb::Property property = fetchMotifHints();
+    readMotifHints(property);
+}
+
+Xcb::Property Client::fetchMotifHints() const
+{
+    return Xcb::Property(m_client, atoms->motif_wm_hints, atoms->motif_wm_hints, 5);
+}
+
+void Client::readMotifHints(Xcb::Property &property)
 {
     bool mgot_noborder, mnoborder, mresize, mmove, mminimize, mmaximize, mclose;
-    Motif::readFlags(m_client, mgot_noborder, mnoborder, mresize, mmove, mminimize, mmaximize, mclose);
+    Motif::readFlags(property, mgot_noborder, mnoborder, mresize, mmove, mminimize, mmaximize, mclose);
     if (mgot_noborder && motif_noborder != mnoborder) {
         motif_noborder = mnoborder;
         // If we just got a hint telling us to hide decorations, we do so.
@@ -1912,49 +1939,64 @@ QPixmap Client::icon(const QSize& size) const
 
 void Client::getWindowProtocols()
 {
-    Atom* p;
-    int i, n;
+    Xcb::Property property = fetchWindowProtocols();
+    readWindowProtocols(property);
+}
 
+Xcb::Property Client::fetchWindowProtocols() const
+{
+    return Xcb::Property(window(), atoms->wm_protocols, XCB_ATOM_ATOM, 1024);
+}
+
+void Client::readWindowProtocols(Xcb::Property &property)
+{
     Pdeletewindow = 0;
     Ptakefocus = 0;
     Ptakeactivity = 0;
     Pcontexthelp = 0;
     Pping = 0;
 
-    if (XGetWMProtocols(display(), window(), &p, &n)) {
-        for (i = 0; i < n; ++i) {
-            if (p[i] == atoms->wm_delete_window)
-                Pdeletewindow = 1;
-            else if (p[i] == atoms->wm_take_focus)
-                Ptakefocus = 1;
-            else if (p[i] == atoms->net_wm_context_help)
-                Pcontexthelp = 1;
-            else if (p[i] == atoms->net_wm_take_activity)
-                Ptakeactivity = 1;
-            else if (p[i] == atoms->net_wm_ping)
-                Pping = 1;
-        }
-        if (n > 0)
-            XFree(p);
+    const int n = property.count(32);
+    const xcb_atom_t *p = property.values<xcb_atom_t>();
+    for (int i = 0; i < n; ++i) {
+        if (p[i] == atoms->wm_delete_window)
+            Pdeletewindow = 1;
+        else if (p[i] == atoms->wm_take_focus)
+            Ptakefocus = 1;
+        else if (p[i] == atoms->net_wm_context_help)
+            Pcontexthelp = 1;
+        else if (p[i] == atoms->net_wm_take_activity)
+            Ptakeactivity = 1;
+        else if (p[i] == atoms->net_wm_ping)
+            Pping = 1;
     }
 }
 
 void Client::getSyncCounter()
+{
+    Xcb::Property property = fetchSyncCounter();
+    readSyncCounter(property);
+}
+
+Xcb::Property Client::fetchSyncCounter() const
+{
+#ifdef HAVE_XSYNC
+    if (Xcb::Extensions::self()->isSyncAvailable())
+        return Xcb::Property(window(), atoms->net_wm_sync_request_counter, XCB_ATOM_CARDINAL);
+#endif
+    return Xcb::Property();
+}
+
+void Client::readSyncCounter(Xcb::Property &property)
 {
 #ifdef HAVE_XSYNC
     if (!Xcb::Extensions::self()->isSyncAvailable())
         return;
 
-    Atom retType;
-    unsigned long nItemRet;
-    unsigned long byteRet;
-    int formatRet;
-    unsigned char* propRet;
-    int ret = XGetWindowProperty(display(), window(), atoms->net_wm_sync_request_counter,
-                                 0, 1, false, XA_CARDINAL, &retType, &formatRet, &nItemRet, &byteRet, &propRet);
-
-    if (ret == Success && formatRet == 32) {
-        syncRequest.counter = *(long*)(propRet);
+    bool ok = false;
+    const uint32_t counter = property.value<uint32_t>(0, &ok);
+    if (ok) {
+        syncRequest.counter = counter;
         XSyncIntToValue(&syncRequest.value, 0);
         XSyncValue zero;
         XSyncIntToValue(&zero, 0);
@@ -1971,9 +2013,8 @@ void Client::getSyncCounter()
                                           &attrs);
         }
     }
-
-    if (ret == Success)
-        XFree(propRet);
+#else
+    Q_UNUSED(property)
 #endif
 }
 
@@ -2017,7 +2058,7 @@ void Client::sendSyncRequest()
     ev.xclient.data.l[4] = 0;
     syncRequest.isPending = true;
     XSendEvent(display(), window(), False, NoEventMask, &ev);
-    XSync(display(), false);
+    XFlush(display());
 #endif
 }
 
@@ -2204,19 +2245,18 @@ KDecorationDefines::Position Client::titlebarPosition() const
 void Client::updateFirstInTabBox()
 {
     // TODO: move into KWindowInfo
-    Atom type;
-    int format, status;
-    unsigned long nitems = 0;
-    unsigned long extra = 0;
-    unsigned char *data = 0;
-    status = XGetWindowProperty(display(), window(), atoms->kde_first_in_window_list, 0, 1, false, atoms->kde_first_in_window_list, &type, &format, &nitems, &extra, &data);
-    if (status == Success && format == 32 && nitems == 1) {
-        setFirstInTabBox(true);
-    } else {
-        setFirstInTabBox(false);
-    }
-    if (data)
-        XFree(data);
+    Xcb::Property property = fetchFirstInTabBox();
+    readFirstInTabBox(property);
+}
+
+Xcb::Property Client::fetchFirstInTabBox() const
+{
+    return Xcb::Property(window(), atoms->kde_first_in_window_list, atoms->kde_first_in_window_list);
+}
+
+void Client::readFirstInTabBox(Xcb::Property &property)
+{
+    setFirstInTabBox(property.count(32) == 1);
 }
 
 bool Client::isClient() const
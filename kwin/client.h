@@ -738,7 +738,13 @@ private:
     int checkFullScreenHack(const QRect& geom) const;   // 0 - None, 1 - One xinerama screen, 2 - Full area
     void updateFullScreenHack(const QRect& geom);
     void getWmNormalHints();
+    Xcb::Property fetchWmNormalHints() const;
+    void readWmNormalHints(Xcb::Property &property);
     void getMotifHints();
+    Xcb::Property fetchMotifHints() const;
+    void readMotifHints(Xcb::Property &property);
+    Xcb::Property fetchFirstInTabBox() const;
+    void readFirstInTabBox(Xcb::Property &property);
     void getIcons();
     void fetchName();
     void fetchIconicName();
@@ -753,6 +759,8 @@ private:
     int checkShadeGeometry(int w, int h);
     void blockGeometryUpdates(bool block);
     void getSyncCounter();
+    Xcb::Property fetchSyncCounter() const;
+    void readSyncCounter(Xcb::Property &property);
     void sendSyncRequest();
     bool startMoveResize();
     void finishMoveResize(bool cancel);
@@ -832,6 +840,7 @@ private:
     int quick_tile_mode;
 
     void readTransient();
+    void readTransientProperty(Xcb::TransientFor &transientFor);
     xcb_window_t verifyTransientFor(xcb_window_t transient_for, bool set);
     void addTransient(Client* cl);
     void removeTransient(Client* cl);
@@ -874,8 +883,12 @@ private:
     bool blocks_compositing;
     WindowRules client_rules;
     void getWMHints();
+    Xcb::Property fetchWMHints() const;
+    void readWMHints(Xcb::Property &property);
     void readIcons();
     void getWindowProtocols();
+    Xcb::Property fetchWindowProtocols() const;
+    void readWindowProtocols(Xcb::Property &property);
     QPixmap icon_pix;
     QPixmap miniicon_pix;
     QPixmap bigicon_pix;
@@ -446,6 +446,8 @@ void Compositor::performCompositing()
     if (!isOverlayWindowVisible())
         return; // nothing is visible anyway
 
+    m_frameTracer.startFrame();
+
     // Create a list of all windows in the stacking order
     ToplevelList windows = Workspace::self()->xStackingOrder();
     ToplevelList damaged;
@@ -471,9 +473,11 @@ void Compositor::performCompositing()
     foreach (Toplevel *win, damaged) {
         win->getDamageRegionReply();
     }
+    m_frameTracer.endPhase(FrameTracer::DamagePhase);
 
     if (repaints_region.isEmpty() && !windowRepaintsPending()) {
         m_scene->idle();
+        m_frameTracer.discardFrame();
         m_timeSinceLastVBlank = fpsInterval - (options->vBlankTime() + 1); // means "start now"
         // Note: It would seem here we should undo suspended unredirect, but when scenes need
         // it for some reason, e.g. transformations or translucency, the next pass that does not
@@ -499,6 +503,7 @@ void Compositor::performCompositing()
     repaints_region = QRegion();
 
     m_timeSinceLastVBlank = m_scene->paint(repaints, windows);
+    m_frameTracer.endFrame();
 
     compositeTimer.stop(); // stop here to ensure *we* cause the next repaint schedule - not some effect through m_scene->paint()
 
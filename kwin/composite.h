@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define KWIN_COMPOSITE_H
 // KWin
 #include <kwinglobals.h>
+#include "frametracer.h"
 // KDE
 #include <KSelectionOwner>
 // Qt
@@ -104,6 +105,13 @@ public:
         return m_scene;
     }
 
+    /**
+     * @brief The tracer recording the duration of the phases of the recently painted frames.
+     **/
+    FrameTracer *frameTracer() {
+        return &m_frameTracer;
+    }
+
     /**
      * @brief Checks whether the Compositor has already been created by the Workspace.
      *
@@ -277,6 +285,7 @@ private:
     bool m_starting; // start() sets this variable while starting
     qint64 m_timeSinceLastVBlank;
     Scene *m_scene;
+    FrameTracer m_frameTracer;
 
     KWIN_SINGLETON_VARIABLE(Compositor, s_compositor)
 };
@@ -156,6 +156,21 @@ void DBusInterface::toggleCompositing()
     Compositor::self()->toggleCompositing();
 }
 
+QString DBusInterface::frameTimings()
+{
+    return Compositor::self()->frameTracer()->statistics();
+}
+
+bool DBusInterface::dumpFrameTrace(const QString &fileName)
+{
+    return Compositor::self()->frameTracer()->writeChromeTrace(fileName);
+}
+
+void DBusInterface::resetFrameTimings()
+{
+    Compositor::self()->frameTracer()->clear();
+}
+
 // wrap returning QStringList methods with no argument to EffectsHandlerImpl
 #define WRAP( name ) \
 QStringList DBusInterface::name( ) \
@@ -79,6 +79,19 @@ public Q_SLOTS: // METHODS
     void showWindowMenuAt(qlonglong winId, int x, int y);
     QString supportInformation();
     void unclutterDesktop();
+    /**
+     * @returns p50, p99 and maximum duration of the phases of the recently composited frames.
+     **/
+    QString frameTimings();
+    /**
+     * Writes the recently composited frames as Chrome trace to @p fileName.
+     * The file can be loaded in chrome://tracing.
+     **/
+    bool dumpFrameTrace(const QString &fileName);
+    /**
+     * Removes all recorded frames, e.g. before reproducing a stutter.
+     **/
+    void resetFrameTimings();
     // from compositor
     /**
      * @deprecated
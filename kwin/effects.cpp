@@ -1469,6 +1469,16 @@ QVariant EffectsHandlerImpl::kwinOption(KWinOption kwopt)
     }
 }
 
+int EffectsHandlerImpl::culledWindows() const
+{
+    return m_scene->culledWindows();
+}
+
+int EffectsHandlerImpl::regionOperations() const
+{
+    return m_scene->regionOperations();
+}
+
 QString EffectsHandlerImpl::supportInformation(const QString &name) const
 {
     if (!isEffectLoaded(name)) {
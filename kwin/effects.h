@@ -164,6 +164,8 @@ public:
     virtual EffectFrame* effectFrame(bool staticSize, const QPoint& position, Qt::Alignment alignment) const;
 
     virtual QVariant kwinOption(KWinOption kwopt);
+    virtual int culledWindows() const;
+    virtual int regionOperations() const;
     virtual bool isScreenLocked() const;
 
     // internal (used by kwin core or compositing code)
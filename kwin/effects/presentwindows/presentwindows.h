@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define KWIN_PRESENTWINDOWS_H
 
 #include "presentwindows_proxy.h"
+#include "presentwindowslayout.h"
 
 #include <kwineffects.h>
 #include <kshortcut.h>
@@ -215,30 +216,21 @@ private slots:
     void closeWindow();
     void elevateCloseWindow();
     void screenCountChanged();
+    void slotLayoutCalculated();
 
 protected:
     // Window rearranging
     void rearrangeWindows();
     void calculateWindowTransformations(EffectWindowList windowlist, int screen,
                                         WindowMotionManager& motionManager, bool external = false);
-    void calculateWindowTransformationsClosest(EffectWindowList windowlist, int screen,
-            WindowMotionManager& motionManager);
-    void calculateWindowTransformationsKompose(EffectWindowList windowlist, int screen,
-            WindowMotionManager& motionManager);
-    void calculateWindowTransformationsNatural(EffectWindowList windowlist, int screen,
-            WindowMotionManager& motionManager);
-
-    // Helper functions for window rearranging
-    inline double aspectRatio(EffectWindow *w) {
-        return w->width() / double(w->height());
-    }
-    inline int widthForHeight(EffectWindow *w, int height) {
-        return int((height / double(w->height())) * w->width());
-    }
-    inline int heightForWidth(EffectWindow *w, int width) {
-        return int((width / double(w->width())) * w->height());
-    }
-    bool isOverlappingAny(EffectWindow *w, const QHash<EffectWindow*, QRect> &targets, const QRegion &border);
+    PresentWindowsLayout createLayout(const EffectWindowList &windowlist, int screen,
+                                      WindowMotionManager& motionManager);
+    /**
+     * Calculates @p layout or takes the result from the layout cache.
+     **/
+    void calculateLayout(PresentWindowsLayout *layout);
+    void applyLayout(const PresentWindowsLayout &layout, int screen, WindowMotionManager& motionManager);
+    void updateTextFrames();
 
     // Filter box
     void updateFilterFrame();
@@ -327,6 +319,10 @@ private:
     QList<EffectFrame*> m_dropTargets;
     EffectFrame *m_highlightedDropTarget;
     bool m_dragToClose;
+
+    PresentWindowsLayoutCache m_layoutCache;
+    QList<PresentWindowsLayoutThread*> m_layoutThreads;
+    int m_layoutGeneration;
 };
 
 } // namespace
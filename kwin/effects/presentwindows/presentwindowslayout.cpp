@@ -0,0 +1,653 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "presentwindowslayout.h"
+
+#include <math.h>
+#include <assert.h>
+#include <limits.h>
+
+#include <algorithm>
+
+namespace KWin
+{
+
+namespace
+{
+class WindowLessThan
+{
+public:
+    explicit WindowLessThan(const QVector<EffectWindow*> &windows)
+        : m_windows(windows)
+    {
+    }
+    bool operator()(int a, int b) const {
+        return m_windows.at(a) < m_windows.at(b);
+    }
+private:
+    const QVector<EffectWindow*> &m_windows;
+};
+
+inline int distance(const QPoint &pos1, const QPoint &pos2)
+{
+    const int xdiff = pos1.x() - pos2.x();
+    const int ydiff = pos1.y() - pos2.y();
+    return int(sqrt(float(xdiff*xdiff + ydiff*ydiff)));
+}
+
+inline uint hashRect(const QRect &rect, uint seed)
+{
+    seed = seed * 31 + uint(rect.x());
+    seed = seed * 31 + uint(rect.y());
+    seed = seed * 31 + uint(rect.width());
+    return seed * 31 + uint(rect.height());
+}
+}
+
+PresentWindowsLayout::PresentWindowsLayout()
+    : m_mode(Natural)
+    , m_accuracy(20)
+    , m_fillGaps(false)
+    , m_keepSingleWindow(false)
+    , m_calculated(false)
+    , m_columns(0)
+    , m_rows(0)
+{
+}
+
+PresentWindowsLayout::PresentWindowsLayout(int mode, const QRect &area, int accuracy, bool fillGaps)
+    : m_mode(mode)
+    , m_area(area)
+    , m_accuracy(accuracy)
+    , m_fillGaps(fillGaps)
+    , m_keepSingleWindow(false)
+    , m_calculated(false)
+    , m_columns(0)
+    , m_rows(0)
+{
+}
+
+void PresentWindowsLayout::addWindow(EffectWindow *w, const QRect &geometry)
+{
+    m_windows.append(w);
+    m_geometries.append(geometry);
+    m_calculated = false;
+}
+
+void PresentWindowsLayout::setKeepSingleWindow(bool keep)
+{
+    m_keepSingleWindow = keep;
+    m_calculated = false;
+}
+
+bool PresentWindowsLayout::hasSameInput(const PresentWindowsLayout &other) const
+{
+    return m_mode == other.m_mode &&
+           m_area == other.m_area &&
+           m_accuracy == other.m_accuracy &&
+           m_fillGaps == other.m_fillGaps &&
+           m_keepSingleWindow == other.m_keepSingleWindow &&
+           m_windows == other.m_windows &&
+           m_geometries == other.m_geometries;
+}
+
+uint PresentWindowsLayout::inputHash() const
+{
+    uint hash = uint(m_mode) * 4 + (m_fillGaps ? 2 : 0) + (m_keepSingleWindow ? 1 : 0);
+    hash = hash * 31 + uint(m_accuracy);
+    hash = hashRect(m_area, hash);
+    for (int i = 0; i < m_windows.count(); ++i) {
+        hash = hash * 31 + qHash(m_windows.at(i));
+        hash = hashRect(m_geometries.at(i), hash);
+    }
+    return hash;
+}
+
+void PresentWindowsLayout::calculate()
+{
+    m_targets = m_geometries;
+    m_columns = 0;
+    m_rows = 0;
+    // The layout modes require at least one window
+    if (!m_windows.isEmpty()) {
+        if (m_mode == RegularGrid)
+            calculateClosest();
+        else if (m_mode == FlexibleGrid)
+            calculateKompose();
+        else
+            calculateNatural();
+    }
+    m_calculated = true;
+}
+
+QVector<int> PresentWindowsLayout::sortedWindows() const
+{
+    QVector<int> sorted(m_windows.count());
+    for (int i = 0; i < sorted.count(); ++i)
+        sorted[i] = i;
+    std::sort(sorted.begin(), sorted.end(), WindowLessThan(m_windows));
+    return sorted;
+}
+
+void PresentWindowsLayout::calculateClosest()
+{
+    const QRect area = m_area;
+    const int count = m_windows.count();
+    int columns = int(ceil(sqrt(double(count))));
+    int rows = int(ceil(count / double(columns)));
+    m_columns = columns;
+    m_rows = rows;
+
+    // Assign slots
+    int slotWidth = area.width() / columns;
+    int slotHeight = area.height() / rows;
+    QVector<int> takenSlots;
+    takenSlots.resize(rows*columns);
+    takenSlots.fill(-1);
+
+    // precalculate all slot centers
+    QVector<QPoint> slotCenters;
+    slotCenters.resize(rows*columns);
+    for (int x = 0; x < columns; ++x)
+        for (int y = 0; y < rows; ++y) {
+            slotCenters[x + y*columns] = QPoint(area.x() + slotWidth * x + slotWidth / 2,
+                                                area.y() + slotHeight * y + slotHeight / 2);
+        }
+
+    QVector<QPoint> centers(count);
+    for (int i = 0; i < count; ++i)
+        centers[i] = m_geometries.at(i).center();
+
+    // Assign each window to the closest available slot
+    QList<int> tmpList;
+    for (int i = 0; i < count; ++i)
+        tmpList << i;
+    while (!tmpList.isEmpty()) {
+        const int w = tmpList.first();
+        int slotCandidate = -1, slotCandidateDistance = INT_MAX;
+        const QPoint pos = centers.at(w);
+        for (int i = 0; i < columns*rows; ++i) { // all slots
+            const int dist = distance(pos, slotCenters[i]);
+            if (dist < slotCandidateDistance) { // window is interested in this slot
+                const int occupier = takenSlots[i];
+                assert(occupier != w);
+                if (occupier == -1 || dist < distance(centers.at(occupier), slotCenters[i])) {
+                    // either nobody lives here, or we're better - takeover the slot if it's our best
+                    slotCandidate = i;
+                    slotCandidateDistance = dist;
+                }
+            }
+        }
+        assert(slotCandidate != -1);
+        if (takenSlots[slotCandidate] != -1)
+            tmpList << takenSlots[slotCandidate]; // occupier needs a new home now :p
+        tmpList.removeAll(w);
+        takenSlots[slotCandidate] = w; // ...and we rumble in =)
+    }
+
+    for (int slot = 0; slot < columns*rows; ++slot) {
+        const int w = takenSlots[slot];
+        if (w == -1) // some slots might be empty
+            continue;
+        const int width = m_geometries.at(w).width();
+        const int height = m_geometries.at(w).height();
+
+        // Work out where the slot is
+        QRect target(
+            area.x() + (slot % columns) * slotWidth,
+            area.y() + (slot / columns) * slotHeight,
+            slotWidth, slotHeight);
+        target.adjust(10, 10, -10, -10);   // Borders
+        double scale;
+        if (target.width() / double(width) < target.height() / double(height)) {
+            // Center vertically
+            scale = target.width() / double(width);
+            target.moveTop(target.top() + (target.height() - int(height * scale)) / 2);
+            target.setHeight(int(height * scale));
+        } else {
+            // Center horizontally
+            scale = target.height() / double(height);
+            target.moveLeft(target.left() + (target.width() - int(width * scale)) / 2);
+            target.setWidth(int(width * scale));
+        }
+        // Don't scale the windows too much
+        if (scale > 2.0 || (scale > 1.0 && (width > 300 || height > 300))) {
+            scale = (width > 300 || height > 300) ? 1.0 : 2.0;
+            target = QRect(
+                         target.center().x() - int(width * scale) / 2,
+                         target.center().y() - int(height * scale) / 2,
+                         scale * width, scale * height);
+        }
+        m_targets[w] = target;
+    }
+}
+
+void PresentWindowsLayout::calculateKompose()
+{
+    const QRect availRect = m_area;
+    // The location of the windows should not depend on the stacking order
+    const QVector<int> windowlist = sortedWindows();
+
+    // Following code is taken from Kompose 0.5.4, src/komposelayout.cpp
+
+    int spacing = 10;
+    int rows, columns;
+    double parentRatio = availRect.width() / (double)availRect.height();
+    // Use more columns than rows when parent's width > parent's height
+    if (parentRatio > 1) {
+        columns = (int)ceil(sqrt((double)windowlist.count()));
+        rows = (int)ceil((double)windowlist.count() / (double)columns);
+    } else {
+        rows = (int)ceil(sqrt((double)windowlist.count()));
+        columns = (int)ceil((double)windowlist.count() / (double)rows);
+    }
+
+    // Calculate width & height
+    int w = (availRect.width() - (columns + 1) * spacing) / columns;
+    int h = (availRect.height() - (rows + 1) * spacing) / rows;
+
+    int it = 0;
+    QList<QRect> geometryRects;
+    QList<int> maxRowHeights;
+    // Process rows
+    for (int i = 0; i < rows; ++i) {
+        int xOffsetFromLastCol = 0;
+        int maxHeightInRow = 0;
+        // Process columns
+        for (int j = 0; j < columns; ++j) {
+            // Check for end of List
+            if (it == windowlist.count())
+                break;
+            const int window = windowlist.at(it);
+            const QRect &geometry = m_geometries.at(window);
+
+            // Calculate width and height of widget
+            double ratio = aspectRatio(window);
+
+            int widgetw = 100;
+            int widgeth = 100;
+            int usableW = w;
+            int usableH = h;
+
+            // use width of two boxes if there is no right neighbour
+            if (it == windowlist.count() - 1 && j != columns - 1) {
+                usableW = 2 * w;
+            }
+            ++it; // We need access to the neighbour in the following
+            // expand if right neighbour has ratio < 1
+            if (j != columns - 1 && it != windowlist.count() && aspectRatio(windowlist.at(it)) < 1) {
+                int addW = w - widthForHeight(windowlist.at(it), h);
+                if (addW > 0) {
+                    usableW = w + addW;
+                }
+            }
+
+            if (ratio == -1) {
+                widgetw = w;
+                widgeth = h;
+            } else {
+                double widthByHeight = widthForHeight(window, usableH);
+                double heightByWidth = heightForWidth(window, usableW);
+                if ((ratio >= 1.0 && heightByWidth <= usableH) ||
+                        (ratio < 1.0 && widthByHeight > usableW)) {
+                    widgetw = usableW;
+                    widgeth = (int)heightByWidth;
+                } else if ((ratio < 1.0 && widthByHeight <= usableW) ||
+                          (ratio >= 1.0 && heightByWidth > usableH)) {
+                    widgeth = usableH;
+                    widgetw = (int)widthByHeight;
+                }
+                // Don't upscale large-ish windows
+                if (widgetw > geometry.width() && (geometry.width() > 300 || geometry.height() > 300)) {
+                    widgetw = geometry.width();
+                    widgeth = geometry.height();
+                }
+            }
+
+            // Set the Widget's size
+
+            int alignmentXoffset = 0;
+            int alignmentYoffset = 0;
+            if (i == 0 && h > widgeth)
+                alignmentYoffset = h - widgeth;
+            if (j == 0 && w > widgetw)
+                alignmentXoffset = w - widgetw;
+            QRect geom(availRect.x() + j *(w + spacing) + spacing + alignmentXoffset + xOffsetFromLastCol,
+                       availRect.y() + i *(h + spacing) + spacing + alignmentYoffset,
+                       widgetw, widgeth);
+            geometryRects.append(geom);
+
+            // Set the x offset for the next column
+            if (alignmentXoffset == 0)
+                xOffsetFromLastCol += widgetw - w;
+            if (maxHeightInRow < widgeth)
+                maxHeightInRow = widgeth;
+        }
+        maxRowHeights.append(maxHeightInRow);
+    }
+
+    int topOffset = 0;
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < columns; j++) {
+            int pos = i * columns + j;
+            if (pos >= windowlist.count())
+                break;
+
+            QRect target = geometryRects[pos];
+            target.setY(target.y() + topOffset);
+            m_targets[windowlist.at(pos)] = target;
+        }
+        if (maxRowHeights[i] - h > 0)
+            topOffset += maxRowHeights[i] - h;
+    }
+}
+
+void PresentWindowsLayout::calculateNatural()
+{
+    if (m_windows.count() == 1 && m_keepSingleWindow) {
+        // Just keep the window at its original location to save time
+        m_targets[0] = m_geometries.at(0);
+        return;
+    }
+
+    // As we are using pseudo-random movement (See "slot") we need to make sure the list
+    // is always sorted the same way no matter which window is currently active.
+    const QVector<int> windowlist = sortedWindows();
+
+    const QRect area = m_area;
+    QRect bounds = area;
+    int direction = 0;
+    QVector<QRect> &targets = m_targets;
+    QVector<int> directions(m_windows.count());
+    foreach (int w, windowlist) {
+        bounds = bounds.united(m_geometries.at(w));
+        targets[w] = m_geometries.at(w);
+        // Reuse the unused "slot" as a preferred direction attribute. This is used when the window
+        // is on the edge of the screen to try to use as much screen real estate as possible.
+        directions[w] = direction;
+        direction++;
+        if (direction == 4)
+            direction = 0;
+    }
+
+    // Iterate over all windows, if two overlap push them apart _slightly_ as we try to
+    // brute-force the most optimal positions over many iterations.
+    bool overlap;
+    do {
+        overlap = false;
+        foreach (int w, windowlist) {
+            QRect *target_w = &targets[w];
+            foreach (int e, windowlist) {
+                if (w == e)
+                    continue;
+                QRect *target_e = &targets[e];
+                if (target_w->adjusted(-5, -5, 5, 5).intersects(target_e->adjusted(-5, -5, 5, 5))) {
+                    overlap = true;
+
+                    // Determine pushing direction
+                    QPoint diff(target_e->center() - target_w->center());
+                    // Prevent dividing by zero and non-movement
+                    if (diff.x() == 0 && diff.y() == 0)
+                        diff.setX(1);
+                    // Approximate a vector of between 10px and 20px in magnitude in the same direction
+                    diff *= m_accuracy / double(diff.manhattanLength());
+                    // Move both windows apart
+                    target_w->translate(-diff);
+                    target_e->translate(diff);
+
+                    // Try to keep the bounding rect the same aspect as the screen so that more
+                    // screen real estate is utilised. We do this by splitting the screen into nine
+                    // equal sections, if the window center is in any of the corner sections pull the
+                    // window towards the outer corner. If it is in any of the other edge sections
+                    // alternate between each corner on that edge. We don't want to determine it
+                    // randomly as it will not produce consistant locations when using the filter.
+                    // Only move one window so we don't cause large amounts of unnecessary zooming
+                    // in some situations. We need to do this even when expanding later just in case
+                    // all windows are the same size.
+                    // (We are using an old bounding rect for this, hopefully it doesn't matter)
+                    int xSection = (target_w->x() - bounds.x()) / (bounds.width() / 3);
+                    int ySection = (target_w->y() - bounds.y()) / (bounds.height() / 3);
+                    diff = QPoint(0, 0);
+                    if (xSection != 1 || ySection != 1) { // Remove this if you want the center to pull as well
+                        if (xSection == 1)
+                            xSection = (directions[w] / 2 ? 2 : 0);
+                        if (ySection == 1)
+                            ySection = (directions[w] % 2 ? 2 : 0);
+                    }
+                    if (xSection == 0 && ySection == 0)
+                        diff = QPoint(bounds.topLeft() - target_w->center());
+                    if (xSection == 2 && ySection == 0)
+                        diff = QPoint(bounds.topRight() - target_w->center());
+                    if (xSection == 2 && ySection == 2)
+                        diff = QPoint(bounds.bottomRight() - target_w->center());
+                    if (xSection == 0 && ySection == 2)
+                        diff = QPoint(bounds.bottomLeft() - target_w->center());
+                    if (diff.x() != 0 || diff.y() != 0) {
+                        diff *= m_accuracy / double(diff.manhattanLength());
+                        target_w->translate(diff);
+                    }
+
+                    // Update bounding rect
+                    bounds = bounds.united(*target_w);
+                    bounds = bounds.united(*target_e);
+                }
+            }
+        }
+    } while (overlap);
+
+    // Work out scaling by getting the most top-left and most bottom-right window coords.
+    // The 20's and 10's are so that the windows don't touch the edge of the screen.
+    double scale;
+    if (bounds == area)
+        scale = 1.0; // Don't add borders to the screen
+    else if (area.width() / double(bounds.width()) < area.height() / double(bounds.height()))
+        scale = (area.width() - 20) / double(bounds.width());
+    else
+        scale = (area.height() - 20) / double(bounds.height());
+    // Make bounding rect fill the screen size for later steps
+    bounds = QRect(
+                 bounds.x() - (area.width() - 20 - bounds.width() * scale) / 2 - 10 / scale,
+                 bounds.y() - (area.height() - 20 - bounds.height() * scale) / 2 - 10 / scale,
+                 area.width() / scale,
+                 area.height() / scale
+             );
+
+    // Move all windows back onto the screen and set their scale
+    for (QVector<QRect>::iterator target = targets.begin(); target != targets.end(); ++target) {
+        target->setRect((target->x() - bounds.x()) * scale + area.x(),
+                        (target->y() - bounds.y()) * scale + area.y(),
+                        target->width() * scale,
+                        target->height() * scale
+                        );
+    }
+
+    // Try to fill the gaps by enlarging windows if they have the space
+    if (m_fillGaps) {
+        // Don't expand onto or over the border, which is the area between the outer
+        // and the inner border
+        const QRect outerBorder = area.adjusted(-200, -200, 200, 200);
+        const QRect innerBorder = area.adjusted(10 / scale, 10 / scale, -10 / scale, -10 / scale);
+
+        bool moved;
+        do {
+            moved = false;
+            foreach (int w, windowlist) {
+                QRect oldRect;
+                QRect *target = &targets[w];
+                // This may cause some slight distortion if the windows are enlarged a large amount
+                int widthDiff = m_accuracy;
+                int heightDiff = heightForWidth(w, target->width() + widthDiff) - target->height();
+                int xDiff = widthDiff / 2;  // Also move a bit in the direction of the enlarge, allows the
+                int yDiff = heightDiff / 2; // center windows to be enlarged if there is gaps on the side.
+
+                // Attempt enlarging to the top-right
+                oldRect = *target;
+                target->setRect(target->x() + xDiff,
+                                target->y() - yDiff - heightDiff,
+                                target->width() + widthDiff,
+                                target->height() + heightDiff
+                                );
+                if (isOverlappingAny(w, targets, outerBorder, innerBorder))
+                    *target = oldRect;
+                else
+                    moved = true;
+
+                // Attempt enlarging to the bottom-right
+                oldRect = *target;
+                target->setRect(
+                                 target->x() + xDiff,
+                                 target->y() + yDiff,
+                                 target->width() + widthDiff,
+                                 target->height() + heightDiff
+                             );
+                if (isOverlappingAny(w, targets, outerBorder, innerBorder))
+                    *target = oldRect;
+                else
+                    moved = true;
+
+                // Attempt enlarging to the bottom-left
+                oldRect = *target;
+                target->setRect(
+                                 target->x() - xDiff - widthDiff,
+                                 target->y() + yDiff,
+                                 target->width() + widthDiff,
+                                 target->height() + heightDiff
+                             );
+                if (isOverlappingAny(w, targets, outerBorder, innerBorder))
+                    *target = oldRect;
+                else
+                    moved = true;
+
+                // Attempt enlarging to the top-left
+                oldRect = *target;
+                target->setRect(
+                                 target->x() - xDiff - widthDiff,
+                                 target->y() - yDiff - heightDiff,
+                                 target->width() + widthDiff,
+                                 target->height() + heightDiff
+                             );
+                if (isOverlappingAny(w, targets, outerBorder, innerBorder))
+                    *target = oldRect;
+                else
+                    moved = true;
+            }
+        } while (moved);
+
+        // The expanding code above can actually enlarge windows over 1.0/2.0 scale, we don't like this
+        // We can't add this to the loop above as it would cause a never-ending loop so we have to make
+        // do with the less-than-optimal space usage with using this method.
+        foreach (int w, windowlist) {
+            QRect *target = &targets[w];
+            const int width = m_geometries.at(w).width();
+            const int height = m_geometries.at(w).height();
+            double scale = target->width() / double(width);
+            if (scale > 2.0 || (scale > 1.0 && (width > 300 || height > 300))) {
+                scale = (width > 300 || height > 300) ? 1.0 : 2.0;
+                target->setRect(
+                                 target->center().x() - int(width * scale) / 2,
+                                 target->center().y() - int(height * scale) / 2,
+                                 width * scale,
+                                 height * scale);
+            }
+        }
+    }
+}
+
+bool PresentWindowsLayout::isOverlappingAny(int index, const QVector<QRect> &targets,
+                                            const QRect &outerBorder, const QRect &innerBorder) const
+{
+    const QRect &winTarget = targets.at(index);
+    if (winTarget.intersects(outerBorder) && !innerBorder.contains(winTarget))
+        return true;
+    const QRect adjusted = winTarget.adjusted(-5, -5, 5, 5);
+    for (int i = 0; i < targets.count(); ++i) {
+        if (i == index)
+            continue;
+        if (adjusted.intersects(targets.at(i).adjusted(-5, -5, 5, 5)))
+            return true;
+    }
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+// PresentWindowsLayoutCache
+
+PresentWindowsLayoutCache::PresentWindowsLayoutCache(int capacity)
+    : m_capacity(qMax(capacity, 1))
+{
+}
+
+bool PresentWindowsLayoutCache::find(PresentWindowsLayout *layout) const
+{
+    QMultiHash<uint, PresentWindowsLayout>::const_iterator it = m_layouts.constFind(layout->inputHash());
+    for (; it != m_layouts.constEnd() && it.key() == layout->inputHash(); ++it) {
+        if (it->hasSameInput(*layout)) {
+            *layout = *it;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PresentWindowsLayoutCache::insert(const PresentWindowsLayout &layout)
+{
+    if (!layout.isCalculated()) {
+        return;
+    }
+    PresentWindowsLayout cached = layout;
+    if (find(&cached)) {
+        return;
+    }
+    if (m_order.count() >= m_capacity) {
+        // items with the same hash are ordered from the newest to the oldest one
+        const uint oldest = m_order.takeFirst();
+        QMultiHash<uint, PresentWindowsLayout>::iterator it = m_layouts.find(oldest);
+        QMultiHash<uint, PresentWindowsLayout>::iterator last = it;
+        for (; it != m_layouts.end() && it.key() == oldest; ++it) {
+            last = it;
+        }
+        m_layouts.erase(last);
+    }
+    const uint hash = layout.inputHash();
+    m_layouts.insert(hash, layout);
+    m_order.append(hash);
+}
+
+void PresentWindowsLayoutCache::clear()
+{
+    m_layouts.clear();
+    m_order.clear();
+}
+
+//-----------------------------------------------------------------------------
+// PresentWindowsLayoutThread
+
+PresentWindowsLayoutThread::PresentWindowsLayoutThread(const PresentWindowsLayout &layout, int screen, int generation)
+    : QThread()
+    , m_layout(layout)
+    , m_screen(screen)
+    , m_generation(generation)
+{
+}
+
+void PresentWindowsLayoutThread::run()
+{
+    m_layout.calculate();
+}
+
+} // namespace KWin
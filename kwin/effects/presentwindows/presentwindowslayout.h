@@ -0,0 +1,273 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#ifndef KWIN_PRESENTWINDOWSLAYOUT_H
+#define KWIN_PRESENTWINDOWSLAYOUT_H
+
+#include <QHash>
+#include <QList>
+#include <QRect>
+#include <QThread>
+#include <QVector>
+
+namespace KWin
+{
+class EffectWindow;
+
+/**
+ * @brief The layout of the windows on one screen of the Present Windows effect.
+ *
+ * A layout is calculated from the geometries of the windows and the area of the
+ * screen only. The EffectWindows just identify the windows and decide about the
+ * order of windows which would be placed equally, they are never dereferenced.
+ * Therefore a layout can be calculated in any thread and two layouts with the
+ * same input always have the same result.
+ **/
+class PresentWindowsLayout
+{
+public:
+    /**
+     * The values match the layout modes of the PresentWindowsEffect.
+     **/
+    enum Mode {
+        Natural,
+        RegularGrid,
+        FlexibleGrid
+    };
+    PresentWindowsLayout();
+    PresentWindowsLayout(int mode, const QRect &area, int accuracy, bool fillGaps);
+
+    /**
+     * Adds the window @p w with the geometry @p geometry to the layout.
+     **/
+    void addWindow(EffectWindow *w, const QRect &geometry);
+    /**
+     * In the natural layout a single window is not moved if @p keep is @c true.
+     * The caller has to decide whether the window is completely on its screen.
+     **/
+    void setKeepSingleWindow(bool keep);
+
+    /**
+     * Calculates the target geometries of all windows.
+     **/
+    void calculate();
+    bool isCalculated() const;
+
+    int mode() const;
+    int windowCount() const;
+    EffectWindow *window(int index) const;
+    QRect geometry(int index) const;
+    /**
+     * @returns The target geometry of the window at @p index, only valid after calculate().
+     **/
+    QRect target(int index) const;
+    /**
+     * @returns The number of columns of the regular grid.
+     **/
+    int columns() const;
+    /**
+     * @returns The number of rows of the regular grid.
+     **/
+    int rows() const;
+
+    /**
+     * @returns @c true if the layout has the same input as @p other.
+     **/
+    bool hasSameInput(const PresentWindowsLayout &other) const;
+    /**
+     * @returns A hash over the input of the layout.
+     **/
+    uint inputHash() const;
+
+private:
+    void calculateClosest();
+    void calculateKompose();
+    void calculateNatural();
+    /**
+     * @returns The indexes of the windows sorted by the windows, so that the layout
+     * does not depend on the stacking order.
+     **/
+    QVector<int> sortedWindows() const;
+    bool isOverlappingAny(int index, const QVector<QRect> &targets, const QRect &outerBorder, const QRect &innerBorder) const;
+
+    double aspectRatio(int index) const;
+    int widthForHeight(int index, int height) const;
+    int heightForWidth(int index, int width) const;
+
+    int m_mode;
+    QRect m_area;
+    int m_accuracy;
+    bool m_fillGaps;
+    bool m_keepSingleWindow;
+    QVector<EffectWindow*> m_windows;
+    QVector<QRect> m_geometries;
+
+    bool m_calculated;
+    QVector<QRect> m_targets;
+    int m_columns;
+    int m_rows;
+};
+
+/**
+ * @brief Keeps the most recently calculated layouts.
+ *
+ * Filtering the windows and activating the effect again usually ends in a set of
+ * windows which has been layouted before, so the layout can be reused.
+ **/
+class PresentWindowsLayoutCache
+{
+public:
+    explicit PresentWindowsLayoutCache(int capacity = 16);
+
+    /**
+     * Looks for a calculated layout with the same input as @p layout and copies its
+     * result into @p layout.
+     * @returns @c true if a layout was found.
+     **/
+    bool find(PresentWindowsLayout *layout) const;
+    /**
+     * Adds the calculated @p layout, replacing the oldest layout if the cache is full.
+     **/
+    void insert(const PresentWindowsLayout &layout);
+    void clear();
+    int count() const;
+
+private:
+    int m_capacity;
+    QMultiHash<uint, PresentWindowsLayout> m_layouts;
+    QList<uint> m_order;
+};
+
+/**
+ * @brief Calculates a PresentWindowsLayout in a separate thread.
+ **/
+class PresentWindowsLayoutThread : public QThread
+{
+public:
+    PresentWindowsLayoutThread(const PresentWindowsLayout &layout, int screen, int generation);
+
+    const PresentWindowsLayout &layout() const;
+    int screen() const;
+    /**
+     * The effect uses the generation to recognize layouts which were superseded
+     * while they were calculated.
+     **/
+    int generation() const;
+
+protected:
+    virtual void run();
+
+private:
+    PresentWindowsLayout m_layout;
+    int m_screen;
+    int m_generation;
+};
+
+inline
+bool PresentWindowsLayout::isCalculated() const
+{
+    return m_calculated;
+}
+
+inline
+int PresentWindowsLayout::mode() const
+{
+    return m_mode;
+}
+
+inline
+int PresentWindowsLayout::windowCount() const
+{
+    return m_windows.count();
+}
+
+inline
+EffectWindow *PresentWindowsLayout::window(int index) const
+{
+    return m_windows.at(index);
+}
+
+inline
+QRect PresentWindowsLayout::geometry(int index) const
+{
+    return m_geometries.at(index);
+}
+
+inline
+QRect PresentWindowsLayout::target(int index) const
+{
+    return m_targets.value(index);
+}
+
+inline
+int PresentWindowsLayout::columns() const
+{
+    return m_columns;
+}
+
+inline
+int PresentWindowsLayout::rows() const
+{
+    return m_rows;
+}
+
+inline
+double PresentWindowsLayout::aspectRatio(int index) const
+{
+    return m_geometries.at(index).width() / double(m_geometries.at(index).height());
+}
+
+inline
+int PresentWindowsLayout::widthForHeight(int index, int height) const
+{
+    return int((height / double(m_geometries.at(index).height())) * m_geometries.at(index).width());
+}
+
+inline
+int PresentWindowsLayout::heightForWidth(int index, int width) const
+{
+    return int((width / double(m_geometries.at(index).width())) * m_geometries.at(index).height());
+}
+
+inline
+int PresentWindowsLayoutCache::count() const
+{
+    return m_layouts.count();
+}
+
+inline
+const PresentWindowsLayout &PresentWindowsLayoutThread::layout() const
+{
+    return m_layout;
+}
+
+inline
+int PresentWindowsLayoutThread::screen() const
+{
+    return m_screen;
+}
+
+inline
+int PresentWindowsLayoutThread::generation() const
+{
+    return m_generation;
+}
+
+} // namespace KWin
+
+#endif // KWIN_PRESENTWINDOWSLAYOUT_H
@@ -44,6 +44,8 @@ const int MAX_TIME = 100;
 ShowFpsEffect::ShowFpsEffect()
     : paints_pos(0)
     , frames_pos(0)
+    , culled_windows(0)
+    , region_operations(0)
     , m_noBenchmark(effects->effectFrame(false))
 {
     for (int i = 0;
@@ -147,6 +149,9 @@ void ShowFpsEffect::paintWindow(EffectWindow* w, int mask, QRegion region, Windo
 void ShowFpsEffect::paintScreen(int mask, QRegion region, ScreenPaintData& data)
 {
     effects->paintScreen(mask, region, data);
+    // the scene is done with this frame, remember its statistics
+    culled_windows = effects->culledWindows();
+    region_operations = effects->regionOperations();
     int fps = 0;
     for (int i = 0;
             i < MAX_FPS;
@@ -343,7 +348,9 @@ QImage ShowFpsEffect::fpsTextImage(int fps)
     QPainter painter(&im);
     painter.setFont(textFont);
     painter.setPen(textColor);
-    painter.drawText(QRect(0, 0, 100, 100), textAlign, QString::number(fps));
+    painter.drawText(QRect(0, 0, 100, 100), textAlign, QString::number(fps) + QLatin1Char('\n')
+                     + i18nc("Windows not painted because they are covered", "%1 culled", culled_windows) + QLatin1Char('\n')
+                     + i18nc("Approximate number of QRegion operations of the compositor", "~%1 region ops", region_operations));
     painter.end();
     return im;
 }
@@ -88,6 +88,8 @@ private:
     enum { MAX_FPS = 200 };
     qint64 frames[ MAX_FPS ]; // the time the frame was done (ms)
     int frames_pos; // position in the queue
+    int culled_windows; // windows not painted in the last frame, because they are covered
+    int region_operations; // QRegion operations of the scene in the last frame
     double alpha;
     int x;
     int y;
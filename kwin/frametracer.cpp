@@ -0,0 +1,216 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "frametracer.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+
+#include <algorithm>
+
+namespace KWin
+{
+
+FrameTracer::FrameTracer(int capacity)
+    : m_frames(qMax(capacity, 1))
+    , m_next(0)
+    , m_count(0)
+    , m_inFrame(false)
+    , m_phaseBegin(0)
+{
+    m_clock.start();
+}
+
+FrameTracer::~FrameTracer()
+{
+}
+
+void FrameTracer::startFrame()
+{
+    m_current.start = m_clock.nsecsElapsed();
+    m_current.end = m_current.start;
+    for (int i = 0; i < PhaseCount; ++i) {
+        m_current.phaseStart[i] = m_current.start;
+        m_current.phaseDuration[i] = 0;
+    }
+    m_phaseBegin = m_current.start;
+    m_inFrame = true;
+}
+
+void FrameTracer::endPhase(Phase phase)
+{
+    if (!m_inFrame) {
+        return;
+    }
+    const qint64 now = m_clock.nsecsElapsed();
+    // a phase might be entered several times per frame, e.g. by several screens
+    if (m_current.phaseDuration[phase] == 0) {
+        m_current.phaseStart[phase] = m_phaseBegin;
+    }
+    m_current.phaseDuration[phase] += now - m_phaseBegin;
+    m_phaseBegin = now;
+}
+
+void FrameTracer::endFrame()
+{
+    if (!m_inFrame) {
+        return;
+    }
+    m_current.end = m_clock.nsecsElapsed();
+    m_frames[m_next] = m_current;
+    m_next = (m_next + 1) % m_frames.size();
+    m_count = qMin(m_count + 1, m_frames.size());
+    m_inFrame = false;
+}
+
+void FrameTracer::discardFrame()
+{
+    m_inFrame = false;
+}
+
+void FrameTracer::clear()
+{
+    m_next = 0;
+    m_count = 0;
+    m_inFrame = false;
+}
+
+QVector<FrameTracer::Frame> FrameTracer::frames() const
+{
+    QVector<Frame> result;
+    result.reserve(m_count);
+    const int first = (m_next - m_count + m_frames.size()) % m_frames.size();
+    for (int i = 0; i < m_count; ++i) {
+        result.append(m_frames.at((first + i) % m_frames.size()));
+    }
+    return result;
+}
+
+qint64 FrameTracer::percentileOf(QVector<qint64> &values, int percentile)
+{
+    if (values.isEmpty()) {
+        return 0;
+    }
+    // nearest rank
+    int rank = (qBound(0, percentile, 100) * values.size() + 99) / 100;
+    rank = qBound(1, rank, values.size());
+    std::nth_element(values.begin(), values.begin() + rank - 1, values.end());
+    return values.at(rank - 1);
+}
+
+qint64 FrameTracer::percentile(Phase phase, int percentile) const
+{
+    QVector<qint64> durations;
+    durations.reserve(m_count);
+    foreach (const Frame &frame, frames()) {
+        durations.append(frame.phaseDuration[phase]);
+    }
+    return percentileOf(durations, percentile);
+}
+
+qint64 FrameTracer::framePercentile(int percentile) const
+{
+    QVector<qint64> durations;
+    durations.reserve(m_count);
+    foreach (const Frame &frame, frames()) {
+        durations.append(frame.end - frame.start);
+    }
+    return percentileOf(durations, percentile);
+}
+
+const char *FrameTracer::phaseName(Phase phase)
+{
+    switch (phase) {
+    case DamagePhase:
+        return "damage";
+    case PrePaintPhase:
+        return "prePaint";
+    case PaintPhase:
+        return "paint";
+    case PostPaintPhase:
+        return "postPaint";
+    case PresentPhase:
+        return "present";
+    default:
+        return "unknown";
+    }
+}
+
+QString FrameTracer::statistics() const
+{
+    QString text;
+    QTextStream stream(&text);
+    stream << "Recorded frames: " << m_count << endl;
+    if (m_count == 0) {
+        return text;
+    }
+    const QString line = QString::fromLatin1("%1 %2 %3 %4");
+    stream << line.arg(QString::fromLatin1("Phase"), -10)
+                  .arg(QString::fromLatin1("p50 (ms)"), 10)
+                  .arg(QString::fromLatin1("p99 (ms)"), 10)
+                  .arg(QString::fromLatin1("max (ms)"), 10) << endl;
+    for (int i = 0; i < PhaseCount; ++i) {
+        const Phase phase = static_cast<Phase>(i);
+        stream << line.arg(QString::fromLatin1(phaseName(phase)), -10)
+                      .arg(percentile(phase, 50) / 1000000.0, 10, 'f', 3)
+                      .arg(percentile(phase, 99) / 1000000.0, 10, 'f', 3)
+                      .arg(percentile(phase, 100) / 1000000.0, 10, 'f', 3) << endl;
+    }
+    stream << line.arg(QString::fromLatin1("frame"), -10)
+                  .arg(framePercentile(50) / 1000000.0, 10, 'f', 3)
+                  .arg(framePercentile(99) / 1000000.0, 10, 'f', 3)
+                  .arg(framePercentile(100) / 1000000.0, 10, 'f', 3) << endl;
+    return text;
+}
+
+bool FrameTracer::writeChromeTrace(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream stream(&file);
+    stream.setRealNumberNotation(QTextStream::FixedNotation);
+    stream.setRealNumberPrecision(3);
+    const qint64 pid = QCoreApplication::applicationPid();
+    // "X" events are complete events, timestamps and durations are in microseconds
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    foreach (const Frame &frame, frames()) {
+        stream << (first ? "" : ",") << endl
+               << "{\"name\":\"frame\",\"cat\":\"kwin\",\"ph\":\"X\",\"pid\":" << pid
+               << ",\"tid\":1,\"ts\":" << frame.start / 1000.0
+               << ",\"dur\":" << (frame.end - frame.start) / 1000.0 << "}";
+        first = false;
+        for (int i = 0; i < PhaseCount; ++i) {
+            if (frame.phaseDuration[i] == 0) {
+                continue;
+            }
+            stream << "," << endl
+                   << "{\"name\":\"" << phaseName(static_cast<Phase>(i))
+                   << "\",\"cat\":\"kwin\",\"ph\":\"X\",\"pid\":" << pid
+                   << ",\"tid\":1,\"ts\":" << frame.phaseStart[i] / 1000.0
+                   << ",\"dur\":" << frame.phaseDuration[i] / 1000.0 << "}";
+        }
+    }
+    stream << endl << "]}" << endl;
+    stream.flush();
+    return file.error() == QFile::NoError;
+}
+
+} // namespace KWin
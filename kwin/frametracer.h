@@ -0,0 +1,152 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#ifndef KWIN_FRAMETRACER_H
+#define KWIN_FRAMETRACER_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+class TestFrameTracer;
+
+namespace KWin
+{
+
+/**
+ * @brief Records how long the phases of the most recent compositor frames took.
+ *
+ * The Compositor starts a frame in performCompositing() and every part of the
+ * rendering pipeline ends the phase it is responsible for. A phase always lasts
+ * from the end of the previous phase (or the start of the frame) to the call of
+ * endPhase(), so the phases of a frame do not overlap.
+ *
+ * Finished frames are kept in a ring buffer of fixed size, so tracing does not
+ * allocate while compositing and the costs per frame are a few clock reads.
+ * The recorded frames can be summarized with statistics() or written as a
+ * Chrome trace (chrome://tracing) with writeChromeTrace().
+ **/
+class FrameTracer
+{
+public:
+    enum Phase {
+        /**
+         * Resetting the damage of the windows and waiting for the damage regions.
+         **/
+        DamagePhase,
+        /**
+         * The effects' prePaintScreen pass.
+         **/
+        PrePaintPhase,
+        /**
+         * The effects' paintScreen pass including prePaintWindow, paintWindow and
+         * the composition of the windows.
+         **/
+        PaintPhase,
+        /**
+         * The effects' postPaintWindow and postPaintScreen passes.
+         **/
+        PostPaintPhase,
+        /**
+         * Copying the composed buffer to the screen.
+         **/
+        PresentPhase,
+        PhaseCount
+    };
+    explicit FrameTracer(int capacity = 512);
+    ~FrameTracer();
+
+    /**
+     * Starts recording a new frame. A frame which has been started but not
+     * finished is discarded.
+     **/
+    void startFrame();
+    /**
+     * Ends the phase @p phase of the current frame. Does nothing if no frame is started.
+     **/
+    void endPhase(Phase phase);
+    /**
+     * Stores the current frame in the ring buffer.
+     **/
+    void endFrame();
+    /**
+     * Discards the current frame, e.g. because nothing had to be painted.
+     **/
+    void discardFrame();
+    /**
+     * Removes all recorded frames.
+     **/
+    void clear();
+
+    /**
+     * @returns The number of recorded frames, at most the capacity of the ring buffer.
+     **/
+    int frameCount() const;
+    /**
+     * @returns The @p percentile (0 to 100) of the duration of @p phase in nanoseconds
+     * over all recorded frames, or @c 0 if no frame has been recorded.
+     **/
+    qint64 percentile(Phase phase, int percentile) const;
+    /**
+     * @returns The @p percentile of the duration of the complete frames in nanoseconds.
+     **/
+    qint64 framePercentile(int percentile) const;
+    /**
+     * @returns A human readable summary with p50, p99 and maximum of each phase.
+     **/
+    QString statistics() const;
+    /**
+     * Writes the recorded frames in the Chrome trace event format to @p fileName.
+     * @returns @c true on success, @c false if the file could not be written.
+     **/
+    bool writeChromeTrace(const QString &fileName) const;
+
+    static const char *phaseName(Phase phase);
+
+private:
+    friend class ::TestFrameTracer;
+    struct Frame {
+        qint64 start;
+        qint64 end;
+        qint64 phaseStart[PhaseCount];
+        qint64 phaseDuration[PhaseCount];
+    };
+    /**
+     * @returns The recorded frames ordered from the oldest to the newest.
+     **/
+    QVector<Frame> frames() const;
+    static qint64 percentileOf(QVector<qint64> &values, int percentile);
+
+    QElapsedTimer m_clock;
+    QVector<Frame> m_frames;
+    int m_next;
+    int m_count;
+    bool m_inFrame;
+    qint64 m_phaseBegin;
+    Frame m_current;
+};
+
+inline
+int FrameTracer::frameCount() const
+{
+    return m_count;
+}
+
+} // namespace KWin
+
+#endif // KWIN_FRAMETRACER_H
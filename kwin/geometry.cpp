@@ -1405,10 +1405,52 @@ QSize Client::sizeForClientSize(const QSize& wsize, Sizemode mode, bool noframe)
  */
 void Client::getWmNormalHints()
 {
-    long msize;
+    Xcb::Property property = fetchWmNormalHints();
+    readWmNormalHints(property);
+}
+
+// Number of 32 bit values of WM_NORMAL_HINTS, older clients don't provide the last three
+static const int WM_SIZE_HINTS_ELEMENTS = 18;
+static const int OLD_WM_SIZE_HINTS_ELEMENTS = 15;
+
+Xcb::Property Client::fetchWmNormalHints() const
+{
+    return Xcb::Property(window(), XCB_ATOM_WM_NORMAL_HINTS, XCB_ATOM_WM_SIZE_HINTS, WM_SIZE_HINTS_ELEMENTS);
+}
+
+void Client::readWmNormalHints(Xcb::Property &property)
+{
     const bool hadFixedAspect = xSizeHint.flags & PAspect;
-    if (XGetWMNormalHints(display(), window(), &xSizeHint, &msize) == 0)
+    // Same decoding as XGetWMNormalHints(), but without the round trip
+    const int count = property.count(32);
+    const int32_t *values = property.values<int32_t>();
+    if (values && count >= OLD_WM_SIZE_HINTS_ELEMENTS) {
+        xSizeHint.flags = values[0];
+        xSizeHint.x = values[1];
+        xSizeHint.y = values[2];
+        xSizeHint.width = values[3];
+        xSizeHint.height = values[4];
+        xSizeHint.min_width = values[5];
+        xSizeHint.min_height = values[6];
+        xSizeHint.max_width = values[7];
+        xSizeHint.max_height = values[8];
+        xSizeHint.width_inc = values[9];
+        xSizeHint.height_inc = values[10];
+        xSizeHint.min_aspect.x = values[11];
+        xSizeHint.min_aspect.y = values[12];
+        xSizeHint.max_aspect.x = values[13];
+        xSizeHint.max_aspect.y = values[14];
+        if (count >= WM_SIZE_HINTS_ELEMENTS) {
+            xSizeHint.base_width = values[15];
+            xSizeHint.base_height = values[16];
+            xSizeHint.win_gravity = values[17];
+        } else {
+            xSizeHint.flags &= ~(PBaseSize | PWinGravity);
+        }
+        xSizeHint.flags &= (USPosition | USSize | PAllHints | PBaseSize | PWinGravity);
+    } else {
         xSizeHint.flags = 0;
+    }
     // set defined values for the fields, even if they're not in flags
 
     if (!(xSizeHint.flags & PMinSize))
@@ -585,8 +585,13 @@ bool Client::sameAppWindowRoleMatch(const Client* c1, const Client* c2, bool act
 
 void Client::readTransient()
 {
-    TRANSIENCY_CHECK(this);
     Xcb::TransientFor transientFor(window());
+    readTransientProperty(transientFor);
+}
+
+void Client::readTransientProperty(Xcb::TransientFor &transientFor)
+{
+    TRANSIENCY_CHECK(this);
     xcb_window_t new_transient_for_id = XCB_WINDOW_NONE;
     if (transientFor.getTransientFor(&new_transient_for_id)) {
         m_originalTransientForId = new_transient_for_id;
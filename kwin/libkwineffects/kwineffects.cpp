@@ -892,9 +892,72 @@ bool WindowQuad::smoothNeeded() const
  WindowQuadList
 ***************************************************************/
 
+void WindowQuadList::translate(double dx, double dy)
+{
+    WindowQuad *quad = data();
+    WindowQuad *const end = quad + count();
+    for (; quad != end; ++quad) {
+        for (int i = 0; i < 4; ++i) {
+            quad->verts[ i ].px += dx;
+            quad->verts[ i ].py += dy;
+        }
+    }
+}
+
+void WindowQuadList::scale(double xScale, double yScale)
+{
+    WindowQuad *quad = data();
+    WindowQuad *const end = quad + count();
+    for (; quad != end; ++quad) {
+        for (int i = 0; i < 4; ++i) {
+            quad->verts[ i ].px *= xScale;
+            quad->verts[ i ].py *= yScale;
+        }
+    }
+}
+
+void WindowQuadList::interpolate(const QRectF &target, double progress)
+{
+    if (empty())
+        return;
+
+    const WindowQuad *const begin = constData();
+    const WindowQuad *const end = begin + count();
+
+    // Find the bounding rectangle of the original positions
+    double left   = begin->originalLeft();
+    double right  = begin->originalRight();
+    double top    = begin->originalTop();
+    double bottom = begin->originalBottom();
+    for (const WindowQuad *quad = begin; quad != end; ++quad) {
+        left   = qMin(left,   quad->originalLeft());
+        right  = qMax(right,  quad->originalRight());
+        top    = qMin(top,    quad->originalTop());
+        bottom = qMax(bottom, quad->originalBottom());
+    }
+
+    // position = original + progress * (mapped original - original), as one linear map
+    const double xScale = (right > left) ? target.width() / (right - left) : 1.0;
+    const double yScale = (bottom > top) ? target.height() / (bottom - top) : 1.0;
+    const double xFactor = 1.0 + progress * (xScale - 1.0);
+    const double yFactor = 1.0 + progress * (yScale - 1.0);
+    const double xOffset = progress * (target.x() - left * xScale);
+    const double yOffset = progress * (target.y() - top * yScale);
+
+    WindowQuad *quad = data();
+    WindowQuad *const dataEnd = quad + count();
+    for (; quad != dataEnd; ++quad) {
+        for (int i = 0; i < 4; ++i) {
+            quad->verts[ i ].px = quad->verts[ i ].ox * xFactor + xOffset;
+            quad->verts[ i ].py = quad->verts[ i ].oy * yFactor + yOffset;
+        }
+    }
+}
+
 WindowQuadList WindowQuadList::splitAtX(double x) const
 {
     WindowQuadList ret;
+    ret.reserve(count());
     foreach (const WindowQuad & quad, *this) {
 #ifndef NDEBUG
         if (quad.isTransformed())
@@ -927,6 +990,7 @@ WindowQuadList WindowQuadList::splitAtX(double x) const
 WindowQuadList WindowQuadList::splitAtY(double y) const
 {
     WindowQuadList ret;
+    ret.reserve(count());
     foreach (const WindowQuad & quad, *this) {
 #ifndef NDEBUG
         if (quad.isTransformed())
@@ -979,6 +1043,7 @@ WindowQuadList WindowQuadList::makeGrid(int maxQuadSize) const
     }
 
     WindowQuadList ret;
+    ret.reserve(qCeil((right - left) / maxQuadSize) * qCeil((bottom - top) / maxQuadSize));
 
     foreach (const WindowQuad &quad, *this) {
         const double quadLeft   = quad.left();
@@ -1033,6 +1098,7 @@ WindowQuadList WindowQuadList::makeRegularGrid(int xSubdivisions, int ySubdivisi
     double yIncrement = (bottom - top) / ySubdivisions;
 
     WindowQuadList ret;
+    ret.reserve(xSubdivisions * ySubdivisions);
 
     foreach (const WindowQuad &quad, *this) {
         const double quadLeft   = quad.left();
@@ -167,7 +167,7 @@ X-KDE-Library=kwin4_effect_cooleffect
 
 #define KWIN_EFFECT_API_MAKE_VERSION( major, minor ) (( major ) << 8 | ( minor ))
 #define KWIN_EFFECT_API_VERSION_MAJOR 0
-#define KWIN_EFFECT_API_VERSION_MINOR 224
+#define KWIN_EFFECT_API_VERSION_MINOR 225
 #define KWIN_EFFECT_API_VERSION KWIN_EFFECT_API_MAKE_VERSION( \
         KWIN_EFFECT_API_VERSION_MAJOR, KWIN_EFFECT_API_VERSION_MINOR )
 
@@ -573,6 +573,22 @@ public:
     virtual void drawWindow(EffectWindow* w, int mask, QRegion region, WindowPaintData& data) = 0;
     virtual void buildQuads(EffectWindow* w, WindowQuadList& quadList) = 0;
     virtual QVariant kwinOption(KWinOption kwopt) = 0;
+    /**
+     * Statistics of the last painted frame, meant for debugging effects like showfps.
+     * @returns the number of windows which were not painted because opaque windows cover them
+     * @since 4.11
+     **/
+    virtual int culledWindows() const = 0;
+    /**
+     * @returns the number of QRegion operations the scene needed to paint the last frame
+     * This is an approximation meant to compare frames: only the operations of the
+     * occlusion culling and of collecting the painted area are counted, not those of
+     * effects or of the compositing backend, and every operation counts the same
+     * regardless of the number of rectangles involved.
+     * @see culledWindows
+     * @since 4.11
+     **/
+    virtual int regionOperations() const = 0;
     /**
      * Sets the cursor while the mouse is intercepted.
      * @see startMouseInterception
@@ -1635,7 +1651,7 @@ private:
 class KWIN_EXPORT WindowQuad
 {
 public:
-    explicit WindowQuad(WindowQuadType type, int id = -1);
+    explicit WindowQuad(WindowQuadType type = WindowQuadError, int id = -1);
     WindowQuad makeSubQuad(double x1, double y1, double x2, double y2) const;
     WindowVertex& operator[](int index);
     const WindowVertex& operator[](int index) const;
@@ -1660,10 +1676,34 @@ private:
     int quadID;
 };
 
+/**
+ * @short List of WindowQuads.
+ *
+ * The quads are stored in one contiguous array, the four vertices of a quad
+ * next to each other. Use the bulk operations like translate() instead of
+ * moving each vertex on its own, if all vertices get the same transformation.
+ */
 class KWIN_EXPORT WindowQuadList
-    : public QList< WindowQuad >
+    : public QVector< WindowQuad >
 {
 public:
+    /**
+     * Moves all vertices by @p dx, @p dy.
+     * @since 4.11
+     */
+    void translate(double dx, double dy);
+    /**
+     * Scales the positions of all vertices by @p xScale, @p yScale, relative to the origin.
+     * @since 4.11
+     */
+    void scale(double xScale, double yScale);
+    /**
+     * Moves all vertices between their original position and the position they have
+     * when the bounding rectangle of the original positions is mapped onto @p target.
+     * With @p progress 0 the vertices are at their original positions, with 1 at the target.
+     * @since 4.11
+     */
+    void interpolate(const QRectF &target, double progress);
     WindowQuadList splitAtX(double x) const;
     WindowQuadList splitAtY(double y) const;
     WindowQuadList makeGrid(int maxquadsize) const;
@@ -2714,6 +2754,8 @@ int Effect::animationTime(int defaultDuration)
 }
 
 } // namespace
+Q_DECLARE_TYPEINFO(KWin::WindowVertex, Q_MOVABLE_TYPE);
+Q_DECLARE_TYPEINFO(KWin::WindowQuad, Q_MOVABLE_TYPE);
 Q_DECLARE_METATYPE(KWin::EffectWindow*)
 Q_DECLARE_METATYPE(QList<KWin::EffectWindow*>)
 
@@ -63,17 +63,32 @@ bool Client::manage(xcb_window_t w, bool isMapped)
 
     embedClient(w, attr);
 
+    // Request all properties which are read below at once, so that they share a single round
+    // trip instead of waiting for each of them. WinInfo reads the NETWM properties on its own.
+    Xcb::Property resourceClassCookie = fetchResourceClass();
+    Xcb::Property windowRoleCookie = fetchWindowRole();
+    Xcb::Property wmClientLeaderCookie = fetchWmClientLeader();
+    Xcb::Property syncCounterCookie = fetchSyncCounter();
+    Xcb::Property wmHintsCookie = fetchWMHints();
+    Xcb::TransientFor transientCookie(window());
+    Xcb::Property protocolsCookie = fetchWindowProtocols();
+    Xcb::Property normalHintsCookie = fetchWmNormalHints();
+    Xcb::Property motifHintsCookie = fetchMotifHints();
+    Xcb::Property opaqueRegionCookie = fetchWmOpaqueRegion();
+    Xcb::Property skipCloseAnimationCookie = fetchSkipCloseAnimation();
+    Xcb::Property firstInTabBoxCookie = fetchFirstInTabBox();
+
     vis = attr.visual;
     bit_depth = attr.depth;
 
     // SELI TODO: Order all these things in some sane manner
 
     bool init_minimize = false;
-    XWMHints* hints = XGetWMHints(display(), w);
-    if (hints && (hints->flags & StateHint) && hints->initial_state == IconicState)
-        init_minimize = true;
-    if (hints)
-        XFree(hints);
+    if (wmHintsCookie.count(32) >= 3) {
+        const uint32_t *hints = wmHintsCookie.values<uint32_t>();
+        if ((hints[0] & StateHint) && hints[2] == IconicState)
+            init_minimize = true;
+    }
     if (isMapped)
         init_minimize = false; // If it's already mapped, ignore hint
 
@@ -102,11 +117,11 @@ bool Client::manage(xcb_window_t w, bool isMapped)
 
     m_colormap = attr.colormap;
 
-    getResourceClass();
-    getWindowRole();
-    getWmClientLeader();
+    readResourceClass(resourceClassCookie);
+    readWindowRole(windowRoleCookie);
+    readWmClientLeader(wmClientLeaderCookie);
     getWmClientMachine();
-    getSyncCounter();
+    readSyncCounter(syncCounterCookie);
     // First only read the caption text, so that setupWindowRules() can use it for matching,
     // and only then really set the caption using setCaption(), which checks for duplicates etc.
     // and also relies on rules already existing
@@ -119,21 +134,21 @@ bool Client::manage(xcb_window_t w, bool isMapped)
     detectShape(window());
     detectNoBorder();
     fetchIconicName();
-    getWMHints(); // Needs to be done before readTransient() because of reading the group
+    readWMHints(wmHintsCookie); // Needs to be done before readTransient() because of reading the group
     modal = (info->state() & NET::Modal) != 0;   // Needs to be valid before handling groups
-    readTransient();
+    readTransientProperty(transientCookie);
     getIcons();
-    getWindowProtocols();
-    getWmNormalHints(); // Get xSizeHint
-    getMotifHints();
-    getWmOpaqueRegion();
-    getSkipCloseAnimation();
+    readWindowProtocols(protocolsCookie);
+    readWmNormalHints(normalHintsCookie); // Get xSizeHint
+    readMotifHints(motifHintsCookie);
+    readWmOpaqueRegion(opaqueRegionCookie);
+    readSkipCloseAnimation(skipCloseAnimationCookie);
 
     // TODO: Try to obey all state information from info->state()
 
     original_skip_taskbar = skip_taskbar = (info->state() & NET::SkipTaskbar) != 0;
     skip_pager = (info->state() & NET::SkipPager) != 0;
-    updateFirstInTabBox();
+    readFirstInTabBox(firstInTabBoxCookie);
 
     setupCompositing();
 
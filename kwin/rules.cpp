@@ -346,7 +346,7 @@ NET::WindowType Rules::readType(const KConfigGroup& cfg, const QString& key)
     return NET::Unknown;
 }
 
-bool Rules::matchType(NET::WindowType match_type) const
+static bool typeMatches(NET::WindowType match_type, unsigned long types)
 {
     if (types != NET::AllTypesMask) {
         if (match_type == NET::Unknown)
@@ -357,13 +357,33 @@ bool Rules::matchType(NET::WindowType match_type) const
     return true;
 }
 
+bool Rules::matchType(NET::WindowType match_type) const
+{
+    return typeMatches(match_type, types);
+}
+
+// Creating a QRegExp compiles the pattern, so the rules keep their QRegExp
+// and only update it if the pattern has been changed (e.g. by the rules dialog)
+static bool matchRegExp(QRegExp& regexp, const QString& pattern, const QString& text)
+{
+    if (regexp.pattern() != pattern)
+        regexp.setPattern(pattern);
+    return regexp.indexIn(text) != -1;
+}
+
+static bool matchRegExp(QRegExp& regexp, const QByteArray& pattern, const QByteArray& text)
+{
+    if (regexp.pattern() != QLatin1String(pattern.constData()))
+        regexp.setPattern(QString::fromLatin1(pattern.constData()));
+    return regexp.indexIn(QString::fromLatin1(text.constData())) != -1;
+}
+
 bool Rules::matchWMClass(const QByteArray& match_class, const QByteArray& match_name) const
 {
     if (wmclassmatch != UnimportantMatch) {
-        // TODO optimize?
         QByteArray cwmclass = wmclasscomplete
                               ? match_name + ' ' + match_class : match_class;
-        if (wmclassmatch == RegExpMatch && QRegExp(wmclass).indexIn(cwmclass) == -1)
+        if (wmclassmatch == RegExpMatch && !matchRegExp(wmclassregexp, wmclass, cwmclass))
             return false;
         if (wmclassmatch == ExactMatch && wmclass != cwmclass)
             return false;
@@ -376,7 +396,7 @@ bool Rules::matchWMClass(const QByteArray& match_class, const QByteArray& match_
 bool Rules::matchRole(const QByteArray& match_role) const
 {
     if (windowrolematch != UnimportantMatch) {
-        if (windowrolematch == RegExpMatch && QRegExp(windowrole).indexIn(match_role) == -1)
+        if (windowrolematch == RegExpMatch && !matchRegExp(windowroleregexp, windowrole, match_role))
             return false;
         if (windowrolematch == ExactMatch && windowrole != match_role)
             return false;
@@ -389,7 +409,7 @@ bool Rules::matchRole(const QByteArray& match_role) const
 bool Rules::matchTitle(const QString& match_title) const
 {
     if (titlematch != UnimportantMatch) {
-        if (titlematch == RegExpMatch && QRegExp(title).indexIn(match_title) == -1)
+        if (titlematch == RegExpMatch && !matchRegExp(titleregexp, title, match_title))
             return false;
         if (titlematch == ExactMatch && title != match_title)
             return false;
@@ -407,7 +427,7 @@ bool Rules::matchClientMachine(const QByteArray& match_machine, bool local) cons
                 && matchClientMachine("localhost", true))
             return true;
         if (clientmachinematch == RegExpMatch
-                && QRegExp(clientmachine).indexIn(match_machine) == -1)
+                && !matchRegExp(clientmachineregexp, clientmachine, match_machine))
             return false;
         if (clientmachinematch == ExactMatch
                 && clientmachine != match_machine)
@@ -419,22 +439,83 @@ bool Rules::matchClientMachine(const QByteArray& match_machine, bool local) cons
     return true;
 }
 
-#ifndef KCMRULES
-bool Rules::match(const Client* c) const
+bool Rules::match(NET::WindowType type, const QByteArray& resourceClass, const QByteArray& resourceName,
+                  const QByteArray& role, const QString& title, const QByteArray& machine, bool local) const
 {
-    if (!matchType(c->windowType(true)))
+    if (!matchType(type))
         return false;
-    if (!matchWMClass(c->resourceClass(), c->resourceName()))
+    if (!matchWMClass(resourceClass, resourceName))
         return false;
-    if (!matchRole(c->windowRole()))
+    if (!matchRole(role))
         return false;
-    if (!matchTitle(c->caption(false)))
+    if (!matchTitle(title))
         return false;
-    if (!matchClientMachine(c->clientMachine()->hostName(), c->clientMachine()->isLocal()))
+    if (!matchClientMachine(machine, local))
         return false;
     return true;
 }
 
+RuleIndex::RuleIndex()
+{
+}
+
+void RuleIndex::clear()
+{
+    m_rules.clear();
+    m_exactClass.clear();
+    m_exactCompleteClass.clear();
+    m_types.clear();
+    m_others.clear();
+}
+
+void RuleIndex::build(const QList<Rules*>& rules)
+{
+    clear();
+    m_rules.reserve(rules.count());
+    foreach (Rules * rule, rules) {
+        const int position = m_rules.count();
+        m_rules.append(rule);
+        if (rule->wmclassmatch == Rules::ExactMatch) {
+            if (rule->wmclasscomplete)
+                m_exactCompleteClass[rule->wmclass].append(position);
+            else
+                m_exactClass[rule->wmclass].append(position);
+        } else if (rule->types != NET::AllTypesMask)
+            m_types[rule->types].append(position);
+        else
+            m_others.append(position);
+    }
+}
+
+QVector<Rules*> RuleIndex::candidates(NET::WindowType type, const QByteArray& resourceClass,
+                                      const QByteArray& resourceName) const
+{
+    QVector<int> positions = m_exactClass.value(resourceClass);
+    if (!m_exactCompleteClass.isEmpty())
+        positions += m_exactCompleteClass.value(resourceName + ' ' + resourceClass);
+    // there are only a few different sets of window types in the rules
+    for (QHash<unsigned long, QVector<int> >::const_iterator it = m_types.constBegin();
+            it != m_types.constEnd(); ++it) {
+        if (typeMatches(type, it.key()))
+            positions += it.value();
+    }
+    positions += m_others;
+    // keep the priority of the rules
+    qSort(positions);
+    QVector<Rules*> result;
+    result.reserve(positions.count());
+    foreach (int position, positions)
+        result.append(m_rules.at(position));
+    return result;
+}
+
+#ifndef KCMRULES
+bool Rules::match(const Client* c) const
+{
+    return match(c->windowType(true), c->resourceClass(), c->resourceName(), c->windowRole(),
+                 c->caption(false), c->clientMachine()->hostName(), c->clientMachine()->isLocal());
+}
+
 #define NOW_REMEMBER(_T_, _V_) ((selection & _T_) && (_V_##rule == (SetRule)Remember))
 
 bool Rules::update(Client* c, int selection)
@@ -916,6 +997,7 @@ RuleBook::RuleBook(QObject *parent)
     : QObject(parent)
     , m_updateTimer(new QTimer(this))
     , m_updatesDisabled(false)
+    , m_indexDirty(true)
     , m_temporaryRulesMessages(new KXMessages("_KDE_NET_WM_TEMPORARY_RULES"))
 {
     connect(m_temporaryRulesMessages.data(), SIGNAL(gotMessage(QString)), SLOT(temporaryRulesMessage(QString)));
@@ -934,29 +1016,38 @@ void RuleBook::deleteAll()
 {
     qDeleteAll(m_rules);
     m_rules.clear();
+    invalidateIndex();
+}
+
+void RuleBook::invalidateIndex()
+{
+    m_indexDirty = true;
 }
 
 WindowRules RuleBook::find(const Client* c, bool ignore_temporary)
 {
+    if (m_indexDirty) {
+        m_index.build(m_rules);
+        m_indexDirty = false;
+    }
     QVector< Rules* > ret;
-    for (QList< Rules* >::Iterator it = m_rules.begin();
-            it != m_rules.end();
-       ) {
-        if (ignore_temporary && (*it)->isTemporary()) {
-            ++it;
+    // only the rules which can match the window class and type have to be tested
+    const NET::WindowType type = c->windowType(true);
+    const QVector< Rules* > candidates = m_index.candidates(type, c->resourceClass(), c->resourceName());
+    const QString title = c->caption(false);
+    const QByteArray machine = c->clientMachine()->hostName();
+    const bool local = c->clientMachine()->isLocal();
+    foreach (Rules * rule, candidates) {
+        if (ignore_temporary && rule->isTemporary())
             continue;
-        }
-        if ((*it)->match(c)) {
-            Rules* rule = *it;
+        if (rule->match(type, c->resourceClass(), c->resourceName(), c->windowRole(), title, machine, local)) {
             kDebug(1212) << "Rule found:" << rule << ":" << c;
-            if (rule->isTemporary())
-                it = m_rules.erase(it);
-            else
-                ++it;
+            if (rule->isTemporary()) {
+                m_rules.removeOne(rule);
+                invalidateIndex();
+            }
             ret.append(rule);
-            continue;
         }
-        ++it;
     }
     return WindowRules(ret);
 }
@@ -1002,6 +1093,7 @@ void RuleBook::load()
             ruleids.append(id);
         }
     }
+    invalidateIndex();
 }
 
 void RuleBook::save()
@@ -1036,6 +1128,7 @@ void RuleBook::temporaryRulesMessage(const QString& message)
             was_temporary = true;
     Rules* rule = new Rules(message, true);
     m_rules.prepend(rule);   // highest priority first
+    invalidateIndex();
     if (!was_temporary)
         QTimer::singleShot(60000, this, SLOT(cleanupTemporaryRules()));
 }
@@ -1048,6 +1141,7 @@ void RuleBook::cleanupTemporaryRules()
        ) {
         if ((*it)->discardTemporary(false)) { // deletes (*it)
             it = m_rules.erase(it);
+            invalidateIndex();
         } else {
             if ((*it)->isTemporary())
                 has_temporary = true;
@@ -1071,6 +1165,7 @@ void RuleBook::discardUsed(Client* c, bool withdrawn)
                 c->removeRule(*it);
                 Rules* r = *it;
                 it = m_rules.erase(it);
+                invalidateIndex();
                 delete r;
                 continue;
             }
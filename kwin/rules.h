@@ -23,8 +23,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 
 #include <netwm_def.h>
+#include <QHash>
 #include <QRect>
+#include <QRegExp>
 #include <QTimer>
+#include <QVector>
 #include <kconfiggroup.h>
 #include <kdebug.h>
 
@@ -114,6 +117,11 @@ public:
     Q_DECLARE_FLAGS(Types, Type)
     void write(KConfigGroup&) const;
     bool isEmpty() const;
+    /**
+     * Matches the rule against the given window properties, see match(const Client*).
+     **/
+    bool match(NET::WindowType type, const QByteArray& resourceClass, const QByteArray& resourceName,
+               const QByteArray& role, const QString& title, const QByteArray& machine, bool local) const;
 #ifndef KCMRULES
     void discardUsed(bool withdrawn);
     bool match(const Client* c) const;
@@ -211,6 +219,11 @@ private:
     QByteArray clientmachine;
     StringMatch clientmachinematch;
     unsigned long types; // types for matching
+    // the regular expressions of the RegExpMatch patterns, compiled on first use
+    mutable QRegExp wmclassregexp;
+    mutable QRegExp windowroleregexp;
+    mutable QRegExp titleregexp;
+    mutable QRegExp clientmachineregexp;
     Placement::Policy placement;
     ForceRule placementrule;
     QPoint position;
@@ -278,6 +291,35 @@ private:
     bool disableglobalshortcuts;
     ForceRule disableglobalshortcutsrule;
     friend QDebug& operator<<(QDebug& stream, const Rules*);
+    friend class RuleIndex;
+};
+
+/**
+ * Index over a list of rules to find the rules which can match a window without testing all
+ * of them. Rules matching the window class exactly, which is the default of rules created by
+ * the rules dialog, are looked up by the class. Of the other rules, those limited to some
+ * window types are looked up by the type, only the remaining ones are always candidates.
+ **/
+class RuleIndex
+{
+public:
+    RuleIndex();
+    void build(const QList<Rules*>& rules);
+    void clear();
+    /**
+     * @returns The rules which might match a window of the given type and class, in the order of
+     * the list passed to build(). Rules which don't match the window class or type are not included.
+     **/
+    QVector<Rules*> candidates(NET::WindowType type, const QByteArray& resourceClass,
+                               const QByteArray& resourceName) const;
+private:
+    QVector<Rules*> m_rules;
+    // positions in m_rules, sorted
+    QHash<QByteArray, QVector<int> > m_exactClass;
+    QHash<QByteArray, QVector<int> > m_exactCompleteClass;
+    // rules without an exact class by their window types mask
+    QHash<unsigned long, QVector<int> > m_types;
+    QVector<int> m_others;
 };
 
 #ifndef KCMRULES
@@ -300,9 +342,13 @@ private Q_SLOTS:
 
 private:
     void deleteAll();
+    // to be called whenever m_rules is modified
+    void invalidateIndex();
     QTimer *m_updateTimer;
     bool m_updatesDisabled;
     QList<Rules*> m_rules;
+    RuleIndex m_index;
+    bool m_indexDirty;
     QScopedPointer<KXMessages> m_temporaryRulesMessages;
 
     KWIN_SINGLETON(RuleBook)
@@ -75,6 +75,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QVector2D>
 
 #include "client.h"
+#include "composite.h"
 #include "decorations.h"
 #include "deleted.h"
 #include "effects.h"
@@ -93,6 +94,8 @@ namespace KWin
 
 Scene::Scene(Workspace* ws)
     : QObject(ws)
+    , m_culledWindows(0)
+    , m_regionOperations(0)
 {
     last_time.invalidate(); // Initialize the timer
     connect(Workspace::self(), SIGNAL(deletedRemoved(KWin::Deleted*)), SLOT(windowDeleted(KWin::Deleted*)));
@@ -119,7 +122,9 @@ void Scene::paintScreen(int* mask, const QRegion &damage, const QRegion &repaint
     pdata.mask = *mask;
     pdata.paint = region;
 
+    FrameTracer *tracer = Compositor::self()->frameTracer();
     effects->prePaintScreen(pdata, time_diff);
+    tracer->endPhase(FrameTracer::PrePaintPhase);
     *mask = pdata.mask;
     region = pdata.paint;
 
@@ -145,12 +150,14 @@ void Scene::paintScreen(int* mask, const QRegion &damage, const QRegion &repaint
 
     ScreenPaintData data;
     effects->paintScreen(*mask, region, data);
+    tracer->endPhase(FrameTracer::PaintPhase);
 
     foreach (Window *w, stacking_order) {
         effects->postPaintWindow(effectWindow(w));
     }
 
     effects->postPaintScreen();
+    tracer->endPhase(FrameTracer::PostPaintPhase);
 
     // make sure not to go outside of the screen area
     *updateRegion = damaged_region;
@@ -201,6 +208,8 @@ void Scene::finalPaintScreen(int mask, QRegion region, ScreenPaintData& data)
 // It simply paints bottom-to-top.
 void Scene::paintGenericScreen(int orig_mask, ScreenPaintData)
 {
+    m_culledWindows = 0;
+    m_regionOperations = 0;
     if (!(orig_mask & PAINT_SCREEN_BACKGROUND_FIRST)) {
         paintBackground(infiniteRegion());
     }
@@ -250,6 +259,8 @@ void Scene::paintSimpleScreen(int orig_mask, QRegion region)
     assert((orig_mask & (PAINT_SCREEN_TRANSFORMED
                          | PAINT_SCREEN_WITH_TRANSFORMED_WINDOWS)) == 0);
     QList< QPair< Window*, Phase2Data > > phase2data;
+    m_culledWindows = 0;
+    m_regionOperations = 0;
 
     QRegion dirtyArea = region;
     bool opaqueFullscreen(false);
@@ -329,30 +340,62 @@ void Scene::paintSimpleScreen(int orig_mask, QRegion region)
     QRegion allclips, upperTranslucentDamage;
     upperTranslucentDamage = repaint_region;
 
+    // The clips of the windows above as list of rectangles, as long as all
+    // clips are simple rectangles. Enough to find the windows that are fully
+    // covered without any QRegion operation.
+    QVector<QRect> clipRects;
+    bool clipsAreRects = true;
+
     // This is the occlusion culling pass
     for (int i = phase2data.count() - 1; i >= 0; --i) {
         QPair< Window*, Phase2Data > *entry = &phase2data[i];
         Phase2Data *data = &entry->second;
 
+        // windows completely below opaque windows don't need to be painted at all
+        if (!(data->mask & PAINT_WINDOW_TRANSFORMED) && !allclips.isEmpty()) {
+            const QRect bounds = data->window->window()->visibleRect();
+            bool covered = isCoveredBy(bounds, clipRects);
+            if (!covered && !clipsAreRects) {
+                ++m_regionOperations;
+                covered = (QRegion(bounds) - allclips).isEmpty();
+            }
+            if (covered) {
+                data->culled = true;
+                ++m_culledWindows;
+                continue;
+            }
+        }
+
         if (fullRepaint)
             data->region = displayRegion;
-        else
+        else {
             data->region |= upperTranslucentDamage;
+            ++m_regionOperations;
+        }
 
         // subtract the parts which will possibly been drawn as part of
         // a higher opaque window
         data->region -= allclips;
+        ++m_regionOperations;
 
         // Here we rely on WindowPrePaintData::setTranslucent() to remove
         // the clip if needed.
         if (!data->clip.isEmpty() && !(data->mask & PAINT_WINDOW_TRANSFORMED)) {
             // clip away the opaque regions for all windows below this one
             allclips |= data->clip;
+            ++m_regionOperations;
+            if (data->clip.rectCount() == 1)
+                clipRects.append(data->clip.boundingRect());
+            else
+                clipsAreRects = false;
             // extend the translucent damage for windows below this by remaining (translucent) regions
-            if (!fullRepaint)
+            if (!fullRepaint) {
                 upperTranslucentDamage |= data->region - data->clip;
+                m_regionOperations += 2;
+            }
         } else if (!fullRepaint) {
             upperTranslucentDamage |= data->region;
+            ++m_regionOperations;
         }
     }
 
@@ -366,9 +409,17 @@ void Scene::paintSimpleScreen(int orig_mask, QRegion region)
     // Now walk the list bottom to top and draw the windows.
     for (int i = 0; i < phase2data.count(); ++i) {
         Phase2Data *data = &phase2data[i].second;
+        // Culled windows are treated like windows whose region is clipped away
+        // completely, see paintWindow(): the effects' paintWindow() chain is not
+        // run for them. postPaintWindow() is still called for every window in
+        // the stacking order by paintScreen(), so each prePaintWindow() has its
+        // postPaintWindow().
+        if (data->culled)
+            continue;
 
         // add all regions which have been drawn so far
         paintedArea |= data->region;
+        ++m_regionOperations;
         data->region = paintedArea;
 
         paintWindow(data->window, data->mask, data->region, data->quads);
@@ -390,6 +441,40 @@ void Scene::paintSimpleScreen(int orig_mask, QRegion region)
     }
 }
 
+bool Scene::isCoveredBy(const QRect &rect, const QVector<QRect> &rects)
+{
+    // give up on heavily fragmented areas, they are left to the QRegion code
+    static const int maxPieces = 32;
+
+    // subtract the rectangles one after another from the parts of rect not covered so far
+    QVector<QRect> remaining;
+    remaining.append(rect);
+    foreach (const QRect &cover, rects) {
+        QVector<QRect> next;
+        foreach (const QRect &r, remaining) {
+            if (!r.intersects(cover)) {
+                next.append(r);
+                continue;
+            }
+            const QRect i = r & cover;
+            if (i.top() > r.top())
+                next.append(QRect(r.left(), r.top(), r.width(), i.top() - r.top()));
+            if (i.bottom() < r.bottom())
+                next.append(QRect(r.left(), i.bottom() + 1, r.width(), r.bottom() - i.bottom()));
+            if (i.left() > r.left())
+                next.append(QRect(r.left(), i.top(), i.left() - r.left(), i.height()));
+            if (i.right() < r.right())
+                next.append(QRect(i.right() + 1, i.top(), r.right() - i.right(), i.height()));
+        }
+        if (next.isEmpty())
+            return true;
+        if (next.count() > maxPieces)
+            return false;
+        remaining = next;
+    }
+    return false;
+}
+
 static Scene::Window *s_recursionCheck = NULL;
 
 void Scene::paintWindow(Window* w, int mask, QRegion region, WindowQuadList quads)
@@ -98,6 +98,12 @@ public:
     // there's nothing to paint (adjust time_diff later)
     virtual void idle();
     virtual OverlayWindow* overlayWindow() = 0;
+    // statistics of the last frame painted with paintSimpleScreen(), see the showfps effect
+    // windows not painted at all because they are covered by opaque windows
+    int culledWindows() const;
+    // approximate number of QRegion operations done for the occlusion culling and the
+    // painted area, operations of the effects and backends are not counted
+    int regionOperations() const;
 public Q_SLOTS:
     // a window has been destroyed
     virtual void windowDeleted(KWin::Deleted*) = 0;
@@ -136,16 +142,19 @@ protected:
     // saved data for 2nd pass of optimized screen painting
     struct Phase2Data {
         Phase2Data(Window* w, QRegion r, QRegion c, int m, const WindowQuadList& q)
-            : window(w), region(r), clip(c), mask(m), quads(q) {}
+            : window(w), region(r), clip(c), mask(m), quads(q), culled(false) {}
         Phase2Data()  {
             window = 0;
             mask = 0;
+            culled = false;
         }
         Window* window;
         QRegion region;
         QRegion clip;
         int mask;
         WindowQuadList quads;
+        // fully covered by opaque windows above, not painted
+        bool culled;
     };
     // windows in their stacking order
     QVector< Window* > stacking_order;
@@ -163,6 +172,8 @@ protected:
     int time_diff;
     QElapsedTimer last_time;
 private:
+    // true if @p rect is completely covered by the union of @p rects
+    static bool isCoveredBy(const QRect &rect, const QVector<QRect> &rects);
     void paintWindowThumbnails(Scene::Window *w, QRegion region, qreal opacity, qreal brightness, qreal saturation);
     void paintDesktopThumbnails(Scene::Window *w);
     /**
@@ -172,8 +183,22 @@ private:
     **/
     QGraphicsView *findViewForThumbnailItem(AbstractThumbnailItem *item, Scene::Window *w);
     QPoint findOffsetInWindow(QWidget *view, xcb_window_t idOfTopmostWindow);
+    int m_culledWindows;
+    int m_regionOperations;
 };
 
+inline
+int Scene::culledWindows() const
+{
+    return m_culledWindows;
+}
+
+inline
+int Scene::regionOperations() const
+{
+    return m_regionOperations;
+}
+
 // The base class for windows representations in composite backends
 class Scene::Window
 {
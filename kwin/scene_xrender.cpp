@@ -28,6 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "toplevel.h"
 #include "client.h"
+#include "composite.h"
 #include "decorations.h"
 #include "deleted.h"
 #include "effects.h"
@@ -196,6 +197,7 @@ qint64 SceneXrender::paint(QRegion damage, ToplevelList toplevels)
         m_overlayWindow->show();   // that pass may take long
 
     present(mask, updateRegion);
+    Compositor::self()->frameTracer()->endPhase(FrameTracer::PresentPhase);
     // do cleanup
     stacking_order.clear();
 
@@ -0,0 +1,215 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../frametracer.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryFile>
+#include <QtTest/QtTest>
+
+Q_DECLARE_METATYPE(QList<qint64>)
+
+using namespace KWin;
+
+class TestFrameTracer : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testPercentile_data();
+    void testPercentile();
+    void testEmpty();
+    void testWrapAround();
+    void testDiscardFrame();
+    void testPhases();
+    void testChromeTrace();
+
+private:
+    static void recordFrame(FrameTracer &tracer, int sleepMs);
+};
+
+void TestFrameTracer::recordFrame(FrameTracer &tracer, int sleepMs)
+{
+    tracer.startFrame();
+    if (sleepMs > 0) {
+        QTest::qSleep(sleepMs);
+    }
+    tracer.endPhase(FrameTracer::PaintPhase);
+    tracer.endFrame();
+}
+
+void TestFrameTracer::testPercentile_data()
+{
+    QTest::addColumn<QList<qint64> >("values");
+    QTest::addColumn<int>("percentile");
+    QTest::addColumn<qint64>("expected");
+
+    const QList<qint64> ten = QList<qint64>() << 7 << 3 << 10 << 1 << 9 << 2 << 8 << 4 << 6 << 5;
+    QTest::newRow("empty") << QList<qint64>() << 50 << qint64(0);
+    QTest::newRow("single/0") << (QList<qint64>() << 42) << 0 << qint64(42);
+    QTest::newRow("single/100") << (QList<qint64>() << 42) << 100 << qint64(42);
+    QTest::newRow("ten/0") << ten << 0 << qint64(1);
+    QTest::newRow("ten/10") << ten << 10 << qint64(1);
+    QTest::newRow("ten/11") << ten << 11 << qint64(2);
+    QTest::newRow("ten/50") << ten << 50 << qint64(5);
+    QTest::newRow("ten/51") << ten << 51 << qint64(6);
+    QTest::newRow("ten/90") << ten << 90 << qint64(9);
+    QTest::newRow("ten/99") << ten << 99 << qint64(10);
+    QTest::newRow("ten/100") << ten << 100 << qint64(10);
+    QTest::newRow("ten/below range") << ten << -5 << qint64(1);
+    QTest::newRow("ten/above range") << ten << 150 << qint64(10);
+    QTest::newRow("duplicates/50") << (QList<qint64>() << 4 << 4 << 1 << 4) << 50 << qint64(4);
+    QTest::newRow("duplicates/25") << (QList<qint64>() << 4 << 4 << 1 << 4) << 25 << qint64(1);
+}
+
+void TestFrameTracer::testPercentile()
+{
+    QFETCH(QList<qint64>, values);
+    QFETCH(int, percentile);
+    QFETCH(qint64, expected);
+
+    QVector<qint64> vector = values.toVector();
+    QCOMPARE(FrameTracer::percentileOf(vector, percentile), expected);
+}
+
+void TestFrameTracer::testEmpty()
+{
+    FrameTracer tracer;
+    QCOMPARE(tracer.frameCount(), 0);
+    QCOMPARE(tracer.framePercentile(50), qint64(0));
+    QCOMPARE(tracer.percentile(FrameTracer::PaintPhase, 99), qint64(0));
+    QVERIFY(tracer.frames().isEmpty());
+}
+
+void TestFrameTracer::testWrapAround()
+{
+    FrameTracer tracer(4);
+    for (int i = 0; i < 10; ++i) {
+        recordFrame(tracer, 0);
+        QCOMPARE(tracer.frameCount(), qMin(i + 1, 4));
+    }
+
+    // only the four newest frames are kept, ordered from the oldest to the newest
+    QVector<qint64> starts;
+    foreach (const FrameTracer::Frame &frame, tracer.frames()) {
+        starts.append(frame.start);
+    }
+    QCOMPARE(starts.count(), 4);
+    for (int i = 1; i < starts.count(); ++i) {
+        QVERIFY(starts.at(i - 1) <= starts.at(i));
+    }
+
+    // a frame which takes considerably longer pushes out the oldest one
+    recordFrame(tracer, 20);
+    QCOMPARE(tracer.frameCount(), 4);
+    QVERIFY(tracer.framePercentile(100) >= qint64(20) * 1000000);
+    QVERIFY(tracer.framePercentile(50) < qint64(20) * 1000000);
+    QVERIFY(tracer.frames().last().start >= starts.last());
+
+    // four more short frames push out the long one again
+    for (int i = 0; i < 4; ++i) {
+        recordFrame(tracer, 0);
+    }
+    QVERIFY(tracer.framePercentile(100) < qint64(20) * 1000000);
+
+    tracer.clear();
+    QCOMPARE(tracer.frameCount(), 0);
+    recordFrame(tracer, 0);
+    QCOMPARE(tracer.frameCount(), 1);
+}
+
+void TestFrameTracer::testDiscardFrame()
+{
+    FrameTracer tracer;
+    tracer.startFrame();
+    tracer.endPhase(FrameTracer::DamagePhase);
+    tracer.discardFrame();
+    QCOMPARE(tracer.frameCount(), 0);
+
+    // ending a frame or a phase without a started frame is ignored
+    tracer.endPhase(FrameTracer::PaintPhase);
+    tracer.endFrame();
+    QCOMPARE(tracer.frameCount(), 0);
+}
+
+void TestFrameTracer::testPhases()
+{
+    FrameTracer tracer;
+    tracer.startFrame();
+    tracer.endPhase(FrameTracer::DamagePhase);
+    QTest::qSleep(10);
+    tracer.endPhase(FrameTracer::PaintPhase);
+    // a phase entered a second time accumulates its durations
+    QTest::qSleep(10);
+    tracer.endPhase(FrameTracer::PaintPhase);
+    tracer.endFrame();
+
+    QCOMPARE(tracer.frameCount(), 1);
+    const FrameTracer::Frame frame = tracer.frames().first();
+    QVERIFY(tracer.percentile(FrameTracer::PaintPhase, 50) >= qint64(20) * 1000000);
+    QCOMPARE(tracer.percentile(FrameTracer::PrePaintPhase, 50), qint64(0));
+    QVERIFY(frame.phaseStart[FrameTracer::PaintPhase] >= frame.start);
+    QVERIFY(frame.phaseStart[FrameTracer::DamagePhase] <= frame.phaseStart[FrameTracer::PaintPhase]);
+
+    // the phases do not overlap, so together they cannot last longer than the frame
+    qint64 sum = 0;
+    for (int i = 0; i < FrameTracer::PhaseCount; ++i) {
+        sum += frame.phaseDuration[i];
+    }
+    QVERIFY(sum <= frame.end - frame.start);
+    QVERIFY(tracer.framePercentile(50) >= tracer.percentile(FrameTracer::PaintPhase, 50));
+}
+
+void TestFrameTracer::testChromeTrace()
+{
+    FrameTracer tracer;
+    for (int i = 0; i < 3; ++i) {
+        tracer.startFrame();
+        tracer.endPhase(FrameTracer::PrePaintPhase);
+        QTest::qSleep(1);
+        tracer.endPhase(FrameTracer::PaintPhase);
+        tracer.endFrame();
+    }
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QVERIFY(tracer.writeChromeTrace(file.fileName()));
+
+    QFile trace(file.fileName());
+    QVERIFY(trace.open(QIODevice::ReadOnly | QIODevice::Text));
+    const QString json = QString::fromUtf8(trace.readAll()).trimmed();
+    QVERIFY(json.startsWith(QLatin1String("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[")));
+    QVERIFY(json.endsWith(QLatin1String("]}")));
+    QCOMPARE(json.count(QLatin1Char('{')), json.count(QLatin1Char('}')));
+
+    // one event per frame and one per phase which took any time, no trailing comma
+    QCOMPARE(json.count(QLatin1String("\"name\":\"frame\"")), 3);
+    QCOMPARE(json.count(QLatin1String("\"name\":\"paint\"")), 3);
+    QCOMPARE(json.count(QLatin1String("\"name\":\"present\"")), 0);
+    QCOMPARE(json.count(QLatin1String("\"ph\":\"X\"")), json.count(QLatin1String("\"name\":")));
+    QVERIFY(!json.contains(QRegExp(QLatin1String(",\\s*\\]"))));
+
+    // timestamps and durations are written in microseconds
+    QRegExp paint(QLatin1String("\"name\":\"paint\"[^}]*\"dur\":([0-9.]+)"));
+    QVERIFY(paint.indexIn(json) != -1);
+    QVERIFY(paint.cap(1).toDouble() >= 1000.0);
+    QVERIFY(paint.cap(1).toDouble() < 1000000.0);
+
+    QVERIFY(!tracer.writeChromeTrace(QLatin1String("/nonexistent/directory/kwin-trace.json")));
+}
+
+QTEST_MAIN(TestFrameTracer)
+#include "test_frame_tracer.moc"
@@ -0,0 +1,247 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../effects/presentwindows/presentwindowslayout.h"
+
+#include <QtTest/QtTest>
+
+using namespace KWin;
+
+class TestPresentWindowsLayout : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testTargetsInArea_data();
+    void testTargetsInArea();
+    void testStackingOrder();
+    void testKeepSingleWindow();
+    void testCache();
+    void testThread();
+
+    void benchmarkLayout_data();
+    void benchmarkLayout();
+    void benchmarkScreens_data();
+    void benchmarkScreens();
+};
+
+static EffectWindow *fakeWindow(int i)
+{
+    // the layout never dereferences the windows
+    return reinterpret_cast<EffectWindow*>(quintptr(i + 1) * 64);
+}
+
+/**
+ * Creates a layout of @p count windows with pseudo random, but reproducible geometries
+ * on a 1920x1080 screen at @p screenX.
+ **/
+static PresentWindowsLayout createLayout(int mode, int count, int screenX = 0)
+{
+    const QRect area(screenX, 0, 1920, 1080);
+    PresentWindowsLayout layout(mode, area, 20, true);
+    quint32 seed = 42;
+    for (int i = 0; i < count; ++i) {
+        seed = seed * 1103515245 + 12345;
+        const int width = 200 + (seed >> 8) % 1000;
+        seed = seed * 1103515245 + 12345;
+        const int height = 150 + (seed >> 8) % 700;
+        seed = seed * 1103515245 + 12345;
+        const int x = area.x() + (seed >> 8) % (area.width() - width);
+        seed = seed * 1103515245 + 12345;
+        const int y = area.y() + (seed >> 8) % (area.height() - height);
+        layout.addWindow(fakeWindow(i + screenX), QRect(x, y, width, height));
+    }
+    return layout;
+}
+
+void TestPresentWindowsLayout::testTargetsInArea_data()
+{
+    QTest::addColumn<int>("mode");
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("natural/5") << int(PresentWindowsLayout::Natural) << 5;
+    QTest::newRow("natural/30") << int(PresentWindowsLayout::Natural) << 30;
+    QTest::newRow("regular/5") << int(PresentWindowsLayout::RegularGrid) << 5;
+    QTest::newRow("regular/30") << int(PresentWindowsLayout::RegularGrid) << 30;
+    QTest::newRow("flexible/5") << int(PresentWindowsLayout::FlexibleGrid) << 5;
+    QTest::newRow("flexible/30") << int(PresentWindowsLayout::FlexibleGrid) << 30;
+}
+
+void TestPresentWindowsLayout::testTargetsInArea()
+{
+    QFETCH(int, mode);
+    QFETCH(int, count);
+    PresentWindowsLayout layout = createLayout(mode, count);
+    QVERIFY(!layout.isCalculated());
+    layout.calculate();
+    QVERIFY(layout.isCalculated());
+    QCOMPARE(layout.windowCount(), count);
+    const QRect area(0, 0, 1920, 1080);
+    for (int i = 0; i < count; ++i) {
+        QVERIFY(layout.target(i).isValid());
+        if (mode != PresentWindowsLayout::FlexibleGrid) {
+            // the rows of the flexible grid might grow beyond the area
+            QVERIFY(area.contains(layout.target(i).center()));
+        }
+    }
+    if (mode == PresentWindowsLayout::RegularGrid) {
+        QVERIFY(layout.columns() * layout.rows() >= count);
+    }
+}
+
+void TestPresentWindowsLayout::testStackingOrder()
+{
+    // the natural layout must not depend on the order in which the windows are added
+    PresentWindowsLayout layout = createLayout(PresentWindowsLayout::Natural, 10);
+    PresentWindowsLayout reversed(PresentWindowsLayout::Natural, QRect(0, 0, 1920, 1080), 20, true);
+    for (int i = layout.windowCount() - 1; i >= 0; --i) {
+        reversed.addWindow(layout.window(i), layout.geometry(i));
+    }
+    layout.calculate();
+    reversed.calculate();
+    for (int i = 0; i < layout.windowCount(); ++i) {
+        QCOMPARE(reversed.target(layout.windowCount() - 1 - i), layout.target(i));
+    }
+}
+
+void TestPresentWindowsLayout::testKeepSingleWindow()
+{
+    PresentWindowsLayout layout(PresentWindowsLayout::Natural, QRect(0, 0, 1920, 1080), 20, true);
+    layout.addWindow(fakeWindow(0), QRect(100, 100, 400, 300));
+    layout.setKeepSingleWindow(true);
+    layout.calculate();
+    QCOMPARE(layout.target(0), QRect(100, 100, 400, 300));
+}
+
+void TestPresentWindowsLayout::testCache()
+{
+    PresentWindowsLayoutCache cache(2);
+    PresentWindowsLayout layout = createLayout(PresentWindowsLayout::Natural, 10);
+    QVERIFY(!cache.find(&layout));
+    // not calculated layouts are not cached
+    cache.insert(layout);
+    QCOMPARE(cache.count(), 0);
+    layout.calculate();
+    cache.insert(layout);
+    cache.insert(layout);
+    QCOMPARE(cache.count(), 1);
+
+    PresentWindowsLayout same = createLayout(PresentWindowsLayout::Natural, 10);
+    QVERIFY(cache.find(&same));
+    QVERIFY(same.isCalculated());
+    for (int i = 0; i < layout.windowCount(); ++i) {
+        QCOMPARE(same.target(i), layout.target(i));
+    }
+
+    // a different geometry or mode is a different layout
+    PresentWindowsLayout other = createLayout(PresentWindowsLayout::Natural, 11);
+    QVERIFY(!cache.find(&other));
+    other = createLayout(PresentWindowsLayout::FlexibleGrid, 10);
+    QVERIFY(!cache.find(&other));
+
+    // the oldest layout is dropped
+    other.calculate();
+    cache.insert(other);
+    PresentWindowsLayout third = createLayout(PresentWindowsLayout::RegularGrid, 10);
+    third.calculate();
+    cache.insert(third);
+    QCOMPARE(cache.count(), 2);
+    same = createLayout(PresentWindowsLayout::Natural, 10);
+    QVERIFY(!cache.find(&same));
+    QVERIFY(cache.find(&other));
+    QVERIFY(cache.find(&third));
+
+    cache.clear();
+    QCOMPARE(cache.count(), 0);
+    QVERIFY(!cache.find(&third));
+}
+
+void TestPresentWindowsLayout::testThread()
+{
+    PresentWindowsLayout layout = createLayout(PresentWindowsLayout::Natural, 30);
+    PresentWindowsLayoutThread thread(layout, 1, 5);
+    thread.start();
+    QVERIFY(thread.wait());
+    QCOMPARE(thread.screen(), 1);
+    QCOMPARE(thread.generation(), 5);
+    QVERIFY(thread.layout().isCalculated());
+    layout.calculate();
+    for (int i = 0; i < layout.windowCount(); ++i) {
+        QCOMPARE(thread.layout().target(i), layout.target(i));
+    }
+}
+
+void TestPresentWindowsLayout::benchmarkLayout_data()
+{
+    QTest::addColumn<int>("mode");
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("natural/20") << int(PresentWindowsLayout::Natural) << 20;
+    QTest::newRow("natural/100") << int(PresentWindowsLayout::Natural) << 100;
+    QTest::newRow("regular/20") << int(PresentWindowsLayout::RegularGrid) << 20;
+    QTest::newRow("regular/100") << int(PresentWindowsLayout::RegularGrid) << 100;
+    QTest::newRow("flexible/20") << int(PresentWindowsLayout::FlexibleGrid) << 20;
+    QTest::newRow("flexible/100") << int(PresentWindowsLayout::FlexibleGrid) << 100;
+}
+
+void TestPresentWindowsLayout::benchmarkLayout()
+{
+    QFETCH(int, mode);
+    QFETCH(int, count);
+    const PresentWindowsLayout input = createLayout(mode, count);
+    QBENCHMARK {
+        PresentWindowsLayout layout = input;
+        layout.calculate();
+    }
+}
+
+void TestPresentWindowsLayout::benchmarkScreens_data()
+{
+    QTest::addColumn<bool>("threaded");
+
+    QTest::newRow("sequential") << false;
+    QTest::newRow("thread per screen") << true;
+}
+
+void TestPresentWindowsLayout::benchmarkScreens()
+{
+    // 120 windows on three screens
+    QFETCH(bool, threaded);
+    QList<PresentWindowsLayout> screens;
+    for (int screen = 0; screen < 3; ++screen) {
+        screens << createLayout(PresentWindowsLayout::Natural, 40, screen * 1920);
+    }
+    QBENCHMARK {
+        if (threaded) {
+            QList<PresentWindowsLayoutThread*> threads;
+            for (int screen = 0; screen < screens.count(); ++screen) {
+                threads << new PresentWindowsLayoutThread(screens.at(screen), screen, 0);
+                threads.last()->start();
+            }
+            foreach (PresentWindowsLayoutThread *thread, threads) {
+                thread->wait();
+            }
+            qDeleteAll(threads);
+        } else {
+            foreach (PresentWindowsLayout layout, screens) {
+                layout.calculate();
+            }
+        }
+    }
+}
+
+QTEST_MAIN(TestPresentWindowsLayout)
+#include "test_presentwindows_layout.moc"
@@ -0,0 +1,245 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../rules.h"
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <QtTest/QtTest>
+
+using namespace KWin;
+
+struct TestWindow {
+    QByteArray resourceClass;
+    QByteArray resourceName;
+    QByteArray role;
+    QString title;
+    NET::WindowType type;
+};
+
+class TestRules : public QObject
+{
+    Q_OBJECT
+private slots:
+    void cleanup();
+    void matchRegExp();
+    void indexCandidates();
+    void indexMatchesAllRules();
+    void benchmarkFind_data();
+    void benchmarkFind();
+private:
+    Rules *createRule(const QString &wmclass, int wmclassMatch, bool complete = false,
+                      const QString &title = QString(), int titleMatch = Rules::UnimportantMatch,
+                      unsigned long types = NET::AllTypesMask);
+    void createRuleBook(int count);
+    QList<TestWindow> createWindows(int count) const;
+    static bool matches(const Rules *rule, const TestWindow &window);
+    QList<Rules*> m_rules;
+};
+
+void TestRules::cleanup()
+{
+    qDeleteAll(m_rules);
+    m_rules.clear();
+}
+
+Rules *TestRules::createRule(const QString &wmclass, int wmclassMatch, bool complete,
+                             const QString &title, int titleMatch, unsigned long types)
+{
+    KSharedConfig::Ptr config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup group = config->group("Rule");
+    group.writeEntry("wmclass", wmclass);
+    group.writeEntry("wmclassmatch", wmclassMatch);
+    group.writeEntry("wmclasscomplete", complete);
+    group.writeEntry("title", title);
+    group.writeEntry("titlematch", titleMatch);
+    group.writeEntry("types", uint(types));
+    Rules *rule = new Rules(group);
+    m_rules << rule;
+    return rule;
+}
+
+void TestRules::createRuleBook(int count)
+{
+    // similar to a large configuration: mostly rules created by the rules dialog for
+    // the exact window class, some of them also matching the title, and a few generic rules
+    for (int i = 0; i < count; ++i) {
+        const QString wmclass = QString("app%1").arg(i % (count / 2));
+        switch (i % 10) {
+        case 0:
+            createRule(QString("^app%1[0-9]$").arg(i % 10), Rules::RegExpMatch);
+            break;
+        case 1:
+            createRule(QString("app%1").arg(i % 7), Rules::SubstringMatch);
+            break;
+        case 6:
+            // e.g. a rule for all dialogs
+            createRule(QString(), Rules::UnimportantMatch, false, QString(), Rules::UnimportantMatch,
+                       (i % 20 == 6) ? NET::DialogMask : (NET::UtilityMask | NET::ToolbarMask));
+            break;
+        case 2:
+        case 3:
+            createRule(wmclass, Rules::ExactMatch, false, QString("^.* - Document [0-9]*5$"), Rules::RegExpMatch);
+            break;
+        case 4:
+            createRule("name " + wmclass, Rules::ExactMatch, true);
+            break;
+        default:
+            createRule(wmclass, Rules::ExactMatch);
+            break;
+        }
+    }
+}
+
+QList<TestWindow> TestRules::createWindows(int count) const
+{
+    QList<TestWindow> windows;
+    for (int i = 0; i < count; ++i) {
+        TestWindow window;
+        window.resourceClass = QByteArray("app") + QByteArray::number(i);
+        window.resourceName = (i % 2) ? "name" : "other";
+        window.title = QString("Title %1 - Document %2").arg(i).arg(i * 7);
+        const NET::WindowType types[] = { NET::Normal, NET::Unknown, NET::Dialog, NET::Utility };
+        window.type = types[i % 4];
+        windows << window;
+    }
+    return windows;
+}
+
+bool TestRules::matches(const Rules *rule, const TestWindow &window)
+{
+    return rule->match(window.type, window.resourceClass, window.resourceName, window.role,
+                       window.title, "localhost", true);
+}
+
+void TestRules::matchRegExp()
+{
+    Rules *rule = createRule("^kon.*le$", Rules::RegExpMatch, false, "^Shell [0-9]+$", Rules::RegExpMatch);
+    TestWindow window;
+    window.resourceClass = "konsole";
+    window.title = "Shell 1";
+    window.type = NET::Normal;
+    QVERIFY(matches(rule, window));
+    window.title = "Shell";
+    QVERIFY(!matches(rule, window));
+    window.title = "Shell 42";
+    QVERIFY(matches(rule, window));
+    window.resourceClass = "kate";
+    QVERIFY(!matches(rule, window));
+
+    // changing the pattern has to be picked up by the compiled regular expression
+    rule->title = "^Shell$";
+    window.resourceClass = "konsole";
+    QVERIFY(!matches(rule, window));
+    window.title = "Shell";
+    QVERIFY(matches(rule, window));
+}
+
+void TestRules::indexCandidates()
+{
+    Rules *exact = createRule("konsole", Rules::ExactMatch);
+    Rules *substring = createRule("kon", Rules::SubstringMatch);
+    Rules *other = createRule("kate", Rules::ExactMatch);
+    Rules *complete = createRule("konsole konsole", Rules::ExactMatch, true);
+    Rules *unimportant = createRule(QString(), Rules::UnimportantMatch);
+    Rules *exact2 = createRule("konsole", Rules::ExactMatch);
+    Rules *dialogs = createRule(QString(), Rules::UnimportantMatch, false, QString(), Rules::UnimportantMatch,
+                                NET::DialogMask);
+    Rules *normal = createRule("kon", Rules::SubstringMatch, false, QString(), Rules::UnimportantMatch,
+                               NET::NormalMask | NET::UtilityMask);
+
+    RuleIndex index;
+    index.build(m_rules);
+    QVector<Rules*> expected;
+    expected << exact << substring << complete << unimportant << exact2 << normal;
+    QCOMPARE(index.candidates(NET::Normal, "konsole", "konsole"), expected);
+    // unknown types are matched like normal windows
+    QCOMPARE(index.candidates(NET::Unknown, "konsole", "konsole"), expected);
+    expected.clear();
+    expected << exact << substring << unimportant << exact2 << normal;
+    QCOMPARE(index.candidates(NET::Normal, "konsole", "other"), expected);
+    expected.clear();
+    expected << substring << other << unimportant << dialogs;
+    QCOMPARE(index.candidates(NET::Dialog, "kate", "kate"), expected);
+    expected.clear();
+    expected << substring << other << unimportant;
+    QCOMPARE(index.candidates(NET::Splash, "kate", "kate"), expected);
+
+    index.clear();
+    QVERIFY(index.candidates(NET::Normal, "konsole", "konsole").isEmpty());
+}
+
+void TestRules::indexMatchesAllRules()
+{
+    createRuleBook(500);
+    RuleIndex index;
+    index.build(m_rules);
+    foreach (const TestWindow &window, createWindows(200)) {
+        QVector<Rules*> linear;
+        foreach (Rules *rule, m_rules) {
+            if (matches(rule, window)) {
+                linear << rule;
+            }
+        }
+        QVector<Rules*> indexed;
+        foreach (Rules *rule, index.candidates(window.type, window.resourceClass, window.resourceName)) {
+            if (matches(rule, window)) {
+                indexed << rule;
+            }
+        }
+        QCOMPARE(indexed, linear);
+    }
+}
+
+void TestRules::benchmarkFind_data()
+{
+    QTest::addColumn<bool>("useIndex");
+
+    QTest::newRow("all rules") << false;
+    QTest::newRow("index") << true;
+}
+
+void TestRules::benchmarkFind()
+{
+    QFETCH(bool, useIndex);
+    // 500 rules x 200 windows
+    createRuleBook(500);
+    const QList<TestWindow> windows = createWindows(200);
+    RuleIndex index;
+    int found = 0;
+    QBENCHMARK {
+        found = 0;
+        if (useIndex) {
+            index.build(m_rules);
+        }
+        foreach (const TestWindow &window, windows) {
+            const QVector<Rules*> candidates = useIndex
+                                               ? index.candidates(window.type, window.resourceClass, window.resourceName)
+                                               : m_rules.toVector();
+            foreach (Rules *rule, candidates) {
+                if (matches(rule, window)) {
+                    ++found;
+                }
+            }
+        }
+    }
+    QVERIFY(found > 0);
+}
+
+QTEST_MAIN(TestRules)
+#include "test_rules.moc"
@@ -0,0 +1,153 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include <kwineffects.h>
+
+#include <QtTest/QtTest>
+
+using namespace KWin;
+
+class TestWindowQuadList : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testMakeRegularGrid();
+    void testTranslate();
+    void testScale();
+    void testInterpolate();
+
+    void benchmarkMakeRegularGrid();
+    void benchmarkSplit();
+    void benchmarkTransform();
+};
+
+static WindowQuad makeQuad(double x1, double y1, double x2, double y2)
+{
+    WindowQuad quad(WindowQuadContents);
+    // vertices are clockwise starting from topleft
+    quad[ 0 ] = WindowVertex(x1, y1, x1, y1);
+    quad[ 1 ] = WindowVertex(x2, y1, x2, y1);
+    quad[ 2 ] = WindowVertex(x2, y2, x2, y2);
+    quad[ 3 ] = WindowVertex(x1, y2, x1, y2);
+    return quad;
+}
+
+// one window of 1000x1000 split into 100x100, i.e. 10k quads
+static WindowQuadList makeGridList()
+{
+    WindowQuadList list;
+    list << makeQuad(0, 0, 1000, 1000);
+    return list.makeRegularGrid(100, 100);
+}
+
+void TestWindowQuadList::testMakeRegularGrid()
+{
+    const WindowQuadList grid = makeGridList();
+    QCOMPARE(grid.count(), 10000);
+    QVERIFY(!grid.isTransformed());
+    QCOMPARE(grid.first().left(), 0.0);
+    QCOMPARE(grid.first().right(), 10.0);
+    QCOMPARE(grid.last().bottom(), 1000.0);
+    // texture coordinates are split with the quads
+    QCOMPARE(grid.last()[ 0 ].textureX(), 990.0);
+}
+
+void TestWindowQuadList::testTranslate()
+{
+    WindowQuadList list;
+    list << makeQuad(10, 20, 30, 40);
+    list.translate(5, -5);
+    QVERIFY(list.isTransformed());
+    QCOMPARE(list.first().left(), 15.0);
+    QCOMPARE(list.first().top(), 15.0);
+    QCOMPARE(list.first().right(), 35.0);
+    QCOMPARE(list.first().bottom(), 35.0);
+    // original positions are kept
+    QCOMPARE(list.first().originalLeft(), 10.0);
+    QCOMPARE(list.first().originalTop(), 20.0);
+}
+
+void TestWindowQuadList::testScale()
+{
+    WindowQuadList list;
+    list << makeQuad(10, 20, 30, 40);
+    list.scale(2, 0.5);
+    QCOMPARE(list.first().left(), 20.0);
+    QCOMPARE(list.first().top(), 10.0);
+    QCOMPARE(list.first().right(), 60.0);
+    QCOMPARE(list.first().bottom(), 20.0);
+}
+
+void TestWindowQuadList::testInterpolate()
+{
+    WindowQuadList list;
+    list << makeQuad(0, 0, 100, 50) << makeQuad(100, 0, 200, 50);
+
+    list.interpolate(QRectF(100, 100, 100, 25), 0.0);
+    QVERIFY(!list.isTransformed());
+
+    list.interpolate(QRectF(100, 100, 100, 25), 1.0);
+    QCOMPARE(list.first().left(), 100.0);
+    QCOMPARE(list.first().top(), 100.0);
+    QCOMPARE(list.first().right(), 150.0);
+    QCOMPARE(list.last().right(), 200.0);
+    QCOMPARE(list.last().bottom(), 125.0);
+
+    list.interpolate(QRectF(100, 100, 100, 25), 0.5);
+    QCOMPARE(list.first().left(), 50.0);
+    QCOMPARE(list.first().top(), 50.0);
+    QCOMPARE(list.last().right(), 200.0);
+    QCOMPARE(list.last().bottom(), 87.5);
+}
+
+void TestWindowQuadList::benchmarkMakeRegularGrid()
+{
+    WindowQuadList list;
+    list << makeQuad(0, 0, 1000, 1000);
+    WindowQuadList grid;
+    QBENCHMARK {
+        grid = list.makeRegularGrid(100, 100);
+    }
+    QCOMPARE(grid.count(), 10000);
+}
+
+void TestWindowQuadList::benchmarkSplit()
+{
+    const WindowQuadList grid = makeGridList();
+    WindowQuadList split;
+    QBENCHMARK {
+        split = grid.splitAtX(505).splitAtY(505);
+    }
+    QCOMPARE(split.count(), 10000 + 100 + 101);
+}
+
+void TestWindowQuadList::benchmarkTransform()
+{
+    WindowQuadList grid = makeGridList();
+    double progress = 0.0;
+    QBENCHMARK {
+        grid.interpolate(QRectF(100, 100, 400, 300), progress);
+        grid.translate(10, 10);
+        grid.scale(1.5, 1.5);
+        progress += 0.01;
+    }
+    QCOMPARE(grid.count(), 10000);
+}
+
+QTEST_MAIN(TestWindowQuadList)
+#include "test_window_quad_list.moc"
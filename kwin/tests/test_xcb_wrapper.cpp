@@ -44,6 +44,9 @@ private slots:
     void assignmentBeforeRetrieve();
     void assignmentAfterRetrieve();
     void discard();
+    void propertyByteArray();
+    void propertyValues();
+    void batchedPropertyRoundTrips();
 private:
     void testEmpty(WindowGeometry &geometry);
     void testGeometry(WindowGeometry &geometry, const QRect &rect);
@@ -210,5 +213,120 @@ void TestXcbWrapper::discard()
     delete geometry;
 }
 
+void TestXcbWrapper::propertyByteArray()
+{
+    m_testWindow = createWindow();
+    QVERIFY(m_testWindow != noneWindow());
+    const QByteArray name("foo\0bar", 7);
+    xcb_change_property(connection(), XCB_PROP_MODE_REPLACE, m_testWindow, XCB_ATOM_WM_CLASS,
+                        XCB_ATOM_STRING, 8, name.length(), name.constData());
+
+    Property property(m_testWindow, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 100);
+    QVERIFY(!property.isRetrieved());
+    QCOMPARE(property.window(), m_testWindow);
+    bool ok = false;
+    QCOMPARE(property.toByteArray(&ok), name);
+    QVERIFY(ok);
+    QVERIFY(property.isRetrieved());
+    QVERIFY(!property.hasMoreData());
+    QCOMPARE(property.count(8), 7);
+    QCOMPARE(property.count(32), 0);
+
+    // not matching type
+    Property cardinal(m_testWindow, XCB_ATOM_WM_CLASS, XCB_ATOM_CARDINAL, 100);
+    QCOMPARE(cardinal.toByteArray(&ok), QByteArray());
+    QVERIFY(!ok);
+
+    // truncated
+    Property truncated(m_testWindow, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 1);
+    QCOMPARE(truncated.toByteArray(), QByteArray("foo\0", 4));
+    QVERIFY(truncated.hasMoreData());
+
+    // not existing
+    Property missing(m_testWindow, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 100);
+    QCOMPARE(missing.toByteArray(&ok), QByteArray());
+    QVERIFY(!ok);
+
+    // default constructed
+    Property empty;
+    QVERIFY(!empty);
+    QCOMPARE(empty.toByteArray(), QByteArray());
+}
+
+void TestXcbWrapper::propertyValues()
+{
+    m_testWindow = createWindow();
+    QVERIFY(m_testWindow != noneWindow());
+    const uint32_t values[] = { 1, 2, 3, 4 };
+    xcb_change_property(connection(), XCB_PROP_MODE_REPLACE, m_testWindow, XCB_ATOM_WM_HINTS,
+                        XCB_ATOM_CARDINAL, 32, 4, values);
+
+    Property property(m_testWindow, XCB_ATOM_WM_HINTS, XCB_ATOM_CARDINAL, 4);
+    QCOMPARE(property.count(32), 4);
+    QVERIFY(property.isValid(32));
+    QVERIFY(!property.isValid(8));
+    const uint32_t *data = property.values<uint32_t>();
+    QVERIFY(data);
+    for (int i = 0; i < 4; ++i) {
+        QCOMPARE(data[i], values[i]);
+    }
+    bool ok = false;
+    QCOMPARE(property.value<uint32_t>(0, &ok), uint32_t(1));
+    QVERIFY(ok);
+    // values of the wrong size are not valid
+    QVERIFY(!property.values<uint16_t>());
+
+    // copying takes over the reply
+    Property other(property);
+    QVERIFY(!property.data());
+    QCOMPARE(other.value<uint32_t>(), uint32_t(1));
+
+    Property missing(m_testWindow, XCB_ATOM_WM_NORMAL_HINTS, XCB_ATOM_CARDINAL);
+    QCOMPARE(missing.value<uint32_t>(42, &ok), uint32_t(42));
+    QVERIFY(!ok);
+}
+
+void TestXcbWrapper::batchedPropertyRoundTrips()
+{
+    // Client::manage() requests twelve properties of a new window at once
+    const xcb_atom_t atoms[] = {
+        XCB_ATOM_CUT_BUFFER0, XCB_ATOM_CUT_BUFFER1, XCB_ATOM_CUT_BUFFER2, XCB_ATOM_CUT_BUFFER3,
+        XCB_ATOM_CUT_BUFFER4, XCB_ATOM_CUT_BUFFER5, XCB_ATOM_CUT_BUFFER6, XCB_ATOM_CUT_BUFFER7,
+        XCB_ATOM_WM_NAME, XCB_ATOM_WM_ICON_NAME, XCB_ATOM_WM_COMMAND, XCB_ATOM_WM_CLIENT_MACHINE
+    };
+    const int count = sizeof(atoms) / sizeof(atoms[0]);
+    m_testWindow = createWindow();
+    QVERIFY(m_testWindow != noneWindow());
+    for (int i = 0; i < count; ++i) {
+        const uint32_t value = i;
+        xcb_change_property(connection(), XCB_PROP_MODE_REPLACE, m_testWindow, atoms[i],
+                            XCB_ATOM_CARDINAL, 32, 1, &value);
+    }
+    // make sure nothing is pending
+    free(xcb_get_input_focus_reply(connection(), xcb_get_input_focus(connection()), NULL));
+
+    // one request after the other
+    quint64 before = roundTrips();
+    for (int i = 0; i < count; ++i) {
+        Property property(m_testWindow, atoms[i], XCB_ATOM_CARDINAL);
+        QCOMPARE(property.value<uint32_t>(), uint32_t(i));
+    }
+    const quint64 sequential = roundTrips() - before;
+    QCOMPARE(sequential, quint64(count));
+
+    // all requests first
+    before = roundTrips();
+    QVector<Property> properties(count);
+    for (int i = 0; i < count; ++i) {
+        properties[i] = Property(m_testWindow, atoms[i], XCB_ATOM_CARDINAL);
+    }
+    for (int i = 0; i < count; ++i) {
+        QCOMPARE(properties[i].value<uint32_t>(), uint32_t(i));
+    }
+    const quint64 batched = roundTrips() - before;
+    QVERIFY(batched >= 1);
+    QVERIFY(batched < sequential);
+}
+
 KWIN_TEST_MAIN(TestXcbWrapper)
 #include "test_xcb_wrapper.moc"
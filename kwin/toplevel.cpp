@@ -20,8 +20,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "toplevel.h"
 
-#include <kxerrorhandler.h>
-
 #include "atoms.h"
 #include "client.h"
 #include "client_machine.h"
@@ -147,7 +145,18 @@ QRect Toplevel::visibleRect() const
 
 void Toplevel::getWindowRole()
 {
-    window_role = getStringProperty(window(), atoms->wm_window_role).toLower();
+    Xcb::Property property = fetchWindowRole();
+    readWindowRole(property);
+}
+
+Xcb::Property Toplevel::fetchWindowRole() const
+{
+    return Xcb::Property(window(), atoms->wm_window_role, XCB_ATOM_STRING, 10000);
+}
+
+void Toplevel::readWindowRole(Xcb::Property &property)
+{
+    window_role = property.toByteArray().toLower();
 }
 
 /*!
@@ -166,33 +175,23 @@ QByteArray Toplevel::staticWmCommand(WId w)
     return getStringProperty(w, XA_WM_COMMAND, ' ');
 }
 
-/*!
-  Returns WM_CLIENT_LEADER property for a given window.
- */
-Window Toplevel::staticWmClientLeader(WId w)
-{
-    Atom type;
-    int format, status;
-    unsigned long nitems = 0;
-    unsigned long extra = 0;
-    unsigned char *data = 0;
-    Window result = w;
-    KXErrorHandler err;
-    status = XGetWindowProperty(display(), w, atoms->wm_client_leader, 0, 10000,
-                                false, XA_WINDOW, &type, &format,
-                                &nitems, &extra, &data);
-    if (status == Success && !err.error(false)) {
-        if (data && nitems > 0)
-            result = *((Window*) data);
-        XFree(data);
-    }
-    return result;
+void Toplevel::getWmClientLeader()
+{
+    Xcb::Property property = fetchWmClientLeader();
+    readWmClientLeader(property);
 }
 
+Xcb::Property Toplevel::fetchWmClientLeader() const
+{
+    return Xcb::Property(window(), atoms->wm_client_leader, XCB_ATOM_WINDOW);
+}
 
-void Toplevel::getWmClientLeader()
+/*!
+  Reads the WM_CLIENT_LEADER property, the window itself is the leader if it is not set.
+ */
+void Toplevel::readWmClientLeader(Xcb::Property &property)
 {
-    wmClientLeaderWin = staticWmClientLeader(window());
+    wmClientLeaderWin = property.value<xcb_window_t>(window());
 }
 
 /*!
@@ -254,17 +253,35 @@ Window Toplevel::wmClientLeader() const
 
 void Toplevel::getResourceClass()
 {
-    XClassHint classHint;
-    if (XGetClassHint(display(), window(), &classHint)) {
-        // Qt3.2 and older had this all lowercase, Qt3.3 capitalized resource class.
-        // Force lowercase, so that workarounds listing resource classes still work.
-        resource_name = QByteArray(classHint.res_name).toLower();
-        resource_class = QByteArray(classHint.res_class).toLower();
-        XFree(classHint.res_name);
-        XFree(classHint.res_class);
-    } else {
+    Xcb::Property property = fetchResourceClass();
+    readResourceClass(property);
+}
+
+Xcb::Property Toplevel::fetchResourceClass() const
+{
+    return Xcb::Property(window(), XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 2048);
+}
+
+void Toplevel::readResourceClass(Xcb::Property &property)
+{
+    // WM_CLASS consists of two null terminated strings: the resource name and the resource class
+    const QByteArray classHint = property.toByteArray();
+    if (classHint.isEmpty()) {
         resource_name = resource_class = QByteArray();
+        return;
+    }
+    const int separator = classHint.indexOf('\0');
+    // Qt3.2 and older had this all lowercase, Qt3.3 capitalized resource class.
+    // Force lowercase, so that workarounds listing resource classes still work.
+    if (separator < 0) {
+        resource_name = classHint.toLower();
+        resource_class = QByteArray();
+        return;
     }
+    resource_name = classHint.left(separator).toLower();
+    const QByteArray rest = classHint.mid(separator + 1);
+    const int end = rest.indexOf('\0');
+    resource_class = (end < 0 ? rest : rest.left(end)).toLower();
 }
 
 double Toplevel::opacity() const
@@ -400,39 +417,38 @@ const Shadow *Toplevel::shadow() const
 
 void Toplevel::getWmOpaqueRegion()
 {
-    const int length=32768;
-    unsigned long bytes_after_return=0;
-    QRegion new_opaque_region;
-    do {
-        unsigned long* data;
-        Atom type;
-        int rformat;
-        unsigned long nitems;
-        if (XGetWindowProperty(display(), client,
-                               atoms->net_wm_opaque_region, 0, length, false, XA_CARDINAL,
-                               &type, &rformat, &nitems, &bytes_after_return,
-                               reinterpret_cast< unsigned char** >(&data)) == Success) {
-            if (type != XA_CARDINAL || rformat != 32 || nitems%4) {
-                // it can happen, that the window does not provide this property
-                XFree(data);
-                break;
-            }
+    Xcb::Property property = fetchWmOpaqueRegion();
+    readWmOpaqueRegion(property);
+}
 
-            for (unsigned int i = 0; i < nitems;) {
-                const int x = data[i++];
-                const int y = data[i++];
-                const int w = data[i++];
-                const int h = data[i++];
+Xcb::Property Toplevel::fetchWmOpaqueRegion() const
+{
+    return Xcb::Property(client, atoms->net_wm_opaque_region, XCB_ATOM_CARDINAL, 32768);
+}
 
-                new_opaque_region += QRect(x,y,w,h);
-            }
-            XFree(data);
-        } else {
-            kWarning(1212) << "XGetWindowProperty failed";
-            break;
+void Toplevel::readWmOpaqueRegion(Xcb::Property &property)
+{
+    if (property.hasMoreData()) {
+        // very uncommon, fetch the complete property
+        const uint32_t length = property->value_len + property->bytes_after / 4 + 1;
+        Xcb::Property complete(client, atoms->net_wm_opaque_region, XCB_ATOM_CARDINAL, length);
+        readWmOpaqueRegion(complete);
+        return;
+    }
+    QRegion new_opaque_region;
+    const int count = property.count(32);
+    const uint32_t *data = property.values<uint32_t>();
+    // it can happen, that the window does not provide this property
+    if (data && count % 4 == 0) {
+        for (int i = 0; i < count;) {
+            const int x = int32_t(data[i++]);
+            const int y = int32_t(data[i++]);
+            const int w = int32_t(data[i++]);
+            const int h = int32_t(data[i++]);
+
+            new_opaque_region += QRect(x, y, w, h);
         }
-    } while (bytes_after_return > 0);
-
+    }
     opaque_region = new_opaque_region;
 }
 
@@ -462,16 +478,18 @@ pid_t Toplevel::pid() const
 
 void Toplevel::getSkipCloseAnimation()
 {
-    xcb_get_property_cookie_t cookie = xcb_get_property_unchecked(connection(), false, window(), atoms->kde_skip_close_animation, XCB_ATOM_CARDINAL, 0, 1);
-    ScopedCPointer<xcb_get_property_reply_t> reply(xcb_get_property_reply(connection(), cookie, NULL));
-    bool newValue = false;
-    if (!reply.isNull()) {
-        if (reply->format == 32 && reply->type == XCB_ATOM_CARDINAL && reply->value_len == 1) {
-            const uint32_t value = *reinterpret_cast<uint32_t*>(xcb_get_property_value(reply.data()));
-            newValue = (value != 0);
-        }
-    }
-    setSkipCloseAnimation(newValue);
+    Xcb::Property property = fetchSkipCloseAnimation();
+    readSkipCloseAnimation(property);
+}
+
+Xcb::Property Toplevel::fetchSkipCloseAnimation() const
+{
+    return Xcb::Property(window(), atoms->kde_skip_close_animation, XCB_ATOM_CARDINAL);
+}
+
+void Toplevel::readSkipCloseAnimation(Xcb::Property &property)
+{
+    setSkipCloseAnimation(property.count(32) == 1 && property.value<uint32_t>() != 0);
 }
 
 bool Toplevel::skipsCloseAnimation() const
@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // kwin
 #include "utils.h"
 #include "virtualdesktops.h"
+#include "xcbutils.h"
 // KDE
 #include <NETWinInfo>
 // Qt
@@ -357,6 +358,8 @@ protected:
     void discardWindowPixmap();
     void addDamageFull();
     void getWmClientLeader();
+    Xcb::Property fetchWmClientLeader() const;
+    void readWmClientLeader(Xcb::Property &property);
     void getWmClientMachine();
     /**
      * @returns Whether there is a compositor and it is active.
@@ -368,10 +371,24 @@ protected:
      * Will only be called on corresponding property changes and for initialization.
      **/
     void getWmOpaqueRegion();
+    Xcb::Property fetchWmOpaqueRegion() const;
+    void readWmOpaqueRegion(Xcb::Property &property);
 
+    /**
+     * The get methods fetch a property and wait for it. When several properties are needed at
+     * once, e.g. when starting to manage a window, all of them should be requested with the
+     * fetch methods first and then be passed to the read methods, so that they share a single
+     * round trip to the X server.
+     **/
     void getResourceClass();
+    Xcb::Property fetchResourceClass() const;
+    void readResourceClass(Xcb::Property &property);
     void getWindowRole();
+    Xcb::Property fetchWindowRole() const;
+    void readWindowRole(Xcb::Property &property);
     void getSkipCloseAnimation();
+    Xcb::Property fetchSkipCloseAnimation() const;
+    void readSkipCloseAnimation(Xcb::Property &property);
     virtual void debug(QDebug& stream) const = 0;
     void copyToDeleted(Toplevel* c);
     void disownDataPassedToDeleted();
@@ -394,7 +411,6 @@ private:
     static QByteArray staticSessionId(WId);
     static QByteArray staticWmCommand(WId);
     static QByteArray staticWmClientMachine(WId);
-    static Window staticWmClientLeader(WId);
     // when adding new data members, check also copyToDeleted()
     Window client;
     Window frame;
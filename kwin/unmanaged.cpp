@@ -71,16 +71,22 @@ bool Unmanaged::track(Window w)
     properties[ NETWinInfo::PROTOCOLS2 ] =
         NET::WM2Opacity |
         0;
+    // Request the properties before NETWinInfo reads its ones, so that they share the round trip
+    Xcb::Property resourceClassCookie = fetchResourceClass();
+    Xcb::Property windowRoleCookie = fetchWindowRole();
+    Xcb::Property wmClientLeaderCookie = fetchWmClientLeader();
+    Xcb::Property opaqueRegionCookie = fetchWmOpaqueRegion();
+    Xcb::Property skipCloseAnimationCookie = fetchSkipCloseAnimation();
     info = new NETWinInfo(display(), w, rootWindow(), properties, 2);
-    getResourceClass();
-    getWindowRole();
-    getWmClientLeader();
+    readResourceClass(resourceClassCookie);
+    readWindowRole(windowRoleCookie);
+    readWmClientLeader(wmClientLeaderCookie);
     getWmClientMachine();
     if (Xcb::Extensions::self()->isShapeAvailable())
         XShapeSelectInput(display(), w, ShapeNotifyMask);
     detectShape(w);
-    getWmOpaqueRegion();
-    getSkipCloseAnimation();
+    readWmOpaqueRegion(opaqueRegionCookie);
+    readSkipCloseAnimation(skipCloseAnimationCookie);
     setupCompositing();
     ungrabXServer();
     if (effects)
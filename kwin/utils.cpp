@@ -44,6 +44,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "atoms.h"
 #include "cursor.h"
 #include "workspace.h"
+#include "xcbutils.h"
 
 #endif
 
@@ -72,19 +73,18 @@ StrutRect::StrutRect(const StrutRect& other)
 // Motif
 //************************************
 
-void Motif::readFlags(xcb_window_t w, bool& got_noborder, bool& noborder,
+void Motif::readFlags(Xcb::Property &property, bool& got_noborder, bool& noborder,
                       bool& resize, bool& move, bool& minimize, bool& maximize, bool& close)
 {
-    Atom type;
-    int format;
-    unsigned long length, after;
-    unsigned char* data;
+    // The property consists of 32 bit values, MwmHints uses longs as returned by Xlib
     MwmHints* hints = 0;
-    if (XGetWindowProperty(display(), w, atoms->motif_wm_hints, 0, 5,
-                          false, atoms->motif_wm_hints, &type, &format,
-                          &length, &after, &data) == Success) {
-        if (data)
-            hints = (MwmHints*) data;
+    MwmHints values;
+    if (property.count(32) >= 3) {
+        const uint32_t *data = property.values<uint32_t>();
+        values.flags = data[0];
+        values.functions = data[1];
+        values.decorations = data[2];
+        hints = &values;
     }
     got_noborder = false;
     noborder = false;
@@ -114,7 +114,6 @@ void Motif::readFlags(xcb_window_t w, bool& got_noborder, bool& noborder,
             got_noborder = true;
             noborder = !hints->decorations;
         }
-        XFree(data);
     }
 }
 
@@ -72,6 +72,11 @@ class Deleted;
 class Group;
 class Options;
 
+namespace Xcb
+{
+class Property;
+}
+
 typedef QList< Toplevel* > ToplevelList;
 typedef QList< Client* > ClientList;
 typedef QList< const Client* > ConstClientList;
@@ -164,7 +169,7 @@ public:
     // property.  If it explicitly requests that decorations be shown
     // or hidden, 'got_noborder' is set to true and 'noborder' is set
     // appropriately.
-    static void readFlags(xcb_window_t w, bool& got_noborder, bool& noborder,
+    static void readFlags(Xcb::Property &property, bool& got_noborder, bool& noborder,
                           bool& resize, bool& move, bool& minimize, bool& maximize,
                           bool& close);
     struct MwmHints {
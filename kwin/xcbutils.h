@@ -45,39 +45,60 @@ static void setInputFocus(xcb_window_t window, uint8_t revertTo = XCB_INPUT_FOCU
 static void moveWindow(xcb_window_t window, const QPoint &pos);
 static void moveWindow(xcb_window_t window, uint32_t x, uint32_t y);
 
+/**
+ * @returns Reference to the number of replies which had not been received yet when they were
+ * needed, that is how often a Wrapper had to block on a round trip to the X server.
+ *
+ * Requests which are issued together and read afterwards share one round trip, so this counter
+ * can be used to verify that requests are properly batched.
+ **/
+inline quint64 &roundTrips()
+{
+    static quint64 s_roundTrips = 0;
+    return s_roundTrips;
+}
+
+/**
+ * @brief Returns the reply for @p cookie, blocking only if it has not been received yet.
+ **/
+template <typename Reply, typename Cookie>
+inline Reply *waitForReply(Reply *(*replyFunc)(xcb_connection_t*, Cookie, xcb_generic_error_t**), Cookie cookie)
+{
+    void *reply = NULL;
+    xcb_generic_error_t *error = NULL;
+    if (xcb_poll_for_reply(connection(), cookie.sequence, &reply, &error)) {
+        free(error);
+        return static_cast<Reply*>(reply);
+    }
+    ++roundTrips();
+    return replyFunc(connection(), cookie, NULL);
+}
+
+/**
+ * Base class for the request wrappers. The request is sent when the wrapper is created and the
+ * reply is only retrieved when it is accessed for the first time. If the reply is never accessed
+ * it gets discarded.
+ *
+ * Subclasses decide how the request is created, see Wrapper and Property.
+ **/
 template <typename Reply,
     typename Cookie,
-    Reply *(*replyFunc)(xcb_connection_t*, Cookie, xcb_generic_error_t**),
-    Cookie (*requestFunc)(xcb_connection_t*, xcb_window_t)>
-class Wrapper
+    Reply *(*replyFunc)(xcb_connection_t*, Cookie, xcb_generic_error_t**)>
+class AbstractWrapper
 {
 public:
-    Wrapper()
-        : m_retrieved(false)
-        , m_window(XCB_WINDOW_NONE)
-        , m_reply(NULL)
-        {
-            m_cookie.sequence = 0;
-        }
-    explicit Wrapper(WindowId window)
-        : m_retrieved(false)
-        , m_cookie(requestFunc(connection(), window))
-        , m_window(window)
-        , m_reply(NULL)
-    {
-    }
-    explicit Wrapper(const Wrapper &other)
+    explicit AbstractWrapper(const AbstractWrapper &other)
         : m_retrieved(other.m_retrieved)
         , m_cookie(other.m_cookie)
         , m_window(other.m_window)
         , m_reply(NULL)
     {
-        takeFromOther(const_cast<Wrapper&>(other));
+        takeFromOther(const_cast<AbstractWrapper&>(other));
     }
-    virtual ~Wrapper() {
+    virtual ~AbstractWrapper() {
         cleanup();
     }
-    inline Wrapper &operator=(const Wrapper &other) {
+    inline AbstractWrapper &operator=(const AbstractWrapper &other) {
         if (this != &other) {
             // if we had managed a reply, free it
             cleanup();
@@ -87,7 +108,7 @@ public:
             m_window = other.m_window;
             m_reply = other.m_reply;
             // take over the responsibility for the reply pointer
-            takeFromOther(const_cast<Wrapper&>(other));
+            takeFromOther(const_cast<AbstractWrapper&>(other));
         }
         return *this;
     }
@@ -129,11 +150,25 @@ public:
     }
 
 protected:
+    AbstractWrapper()
+        : m_retrieved(false)
+        , m_window(XCB_WINDOW_NONE)
+        , m_reply(NULL)
+        {
+            m_cookie.sequence = 0;
+        }
+    AbstractWrapper(WindowId window, Cookie cookie)
+        : m_retrieved(false)
+        , m_cookie(cookie)
+        , m_window(window)
+        , m_reply(NULL)
+    {
+    }
     void getReply() {
         if (m_retrieved || !m_cookie.sequence) {
             return;
         }
-        m_reply = replyFunc(connection(), m_cookie, NULL);
+        m_reply = waitForReply(replyFunc, m_cookie);
         m_retrieved = true;
     }
 
@@ -145,7 +180,7 @@ private:
             free(m_reply);
         }
     }
-    inline void takeFromOther(Wrapper &other) {
+    inline void takeFromOther(AbstractWrapper &other) {
         if (m_retrieved) {
             m_reply = other.take();
         } else {
@@ -160,6 +195,31 @@ private:
     Reply *m_reply;
 };
 
+template <typename Reply,
+    typename Cookie,
+    Reply *(*replyFunc)(xcb_connection_t*, Cookie, xcb_generic_error_t**),
+    Cookie (*requestFunc)(xcb_connection_t*, xcb_window_t)>
+class Wrapper : public AbstractWrapper<Reply, Cookie, replyFunc>
+{
+public:
+    Wrapper()
+        : AbstractWrapper<Reply, Cookie, replyFunc>()
+    {
+    }
+    explicit Wrapper(WindowId window)
+        : AbstractWrapper<Reply, Cookie, replyFunc>(window, requestFunc(connection(), window))
+    {
+    }
+    explicit Wrapper(const Wrapper &other)
+        : AbstractWrapper<Reply, Cookie, replyFunc>(other)
+    {
+    }
+    inline Wrapper &operator=(const Wrapper &other) {
+        AbstractWrapper<Reply, Cookie, replyFunc>::operator=(other);
+        return *this;
+    }
+};
+
 typedef Wrapper<xcb_get_window_attributes_reply_t, xcb_get_window_attributes_cookie_t, &xcb_get_window_attributes_reply, &xcb_get_window_attributes_unchecked> WindowAttributes;
 typedef Wrapper<xcb_composite_get_overlay_window_reply_t, xcb_composite_get_overlay_window_cookie_t, &xcb_composite_get_overlay_window_reply, &xcb_composite_get_overlay_window_unchecked> OverlayWindow;
 
@@ -238,6 +298,95 @@ public:
     }
 };
 
+/**
+ * @brief Wrapper for an arbitrary window property.
+ *
+ * In contrast to the other wrappers the property, the expected type and the number of 32 bit
+ * values to fetch have to be passed to the constructor. The accessors verify that the reply
+ * matches the expected type and format and return a default value otherwise.
+ *
+ * Like the other wrappers a copy takes over the request, so a Property can be returned from a
+ * method which only sends the request.
+ **/
+class Property : public AbstractWrapper<xcb_get_property_reply_t, xcb_get_property_cookie_t, &xcb_get_property_reply>
+{
+public:
+    Property()
+        : AbstractWrapper<xcb_get_property_reply_t, xcb_get_property_cookie_t, &xcb_get_property_reply>()
+        , m_type(XCB_ATOM_NONE)
+    {
+    }
+    Property(WindowId window, xcb_atom_t property, xcb_atom_t type, uint32_t length = 1)
+        : AbstractWrapper<xcb_get_property_reply_t, xcb_get_property_cookie_t, &xcb_get_property_reply>(window,
+            xcb_get_property_unchecked(connection(), false, window, property, type, 0, length))
+        , m_type(type)
+    {
+    }
+
+    /**
+     * @returns Whether the property exists with the expected type and with @p format.
+     **/
+    inline bool isValid(uint8_t format) {
+        const xcb_get_property_reply_t *reply = data();
+        return reply && reply->type == m_type && reply->format == format;
+    }
+    /**
+     * @returns The number of values of the property, @c 0 if it is not valid for @p format.
+     **/
+    inline int count(uint8_t format) {
+        if (!isValid(format)) {
+            return 0;
+        }
+        return xcb_get_property_value_length(data()) / (format / 8);
+    }
+    /**
+     * @returns Pointer to the values of the property interpreted as @p T or @c NULL if the
+     * property is not valid. Use count() for the number of values.
+     **/
+    template <typename T>
+    inline const T *values() {
+        if (count(sizeof(T) * 8) == 0) {
+            return NULL;
+        }
+        return reinterpret_cast<const T*>(xcb_get_property_value(data()));
+    }
+    /**
+     * @returns The first value of the property interpreted as @p T, or @p defaultValue.
+     **/
+    template <typename T>
+    inline T value(T defaultValue = T(), bool *ok = NULL) {
+        const T *v = values<T>();
+        if (ok) {
+            *ok = (v != NULL);
+        }
+        return v ? *v : defaultValue;
+    }
+    /**
+     * @returns The value of an 8 bit property, e.g. a string.
+     **/
+    inline QByteArray toByteArray(bool *ok = NULL) {
+        const bool valid = isValid(8);
+        if (ok) {
+            *ok = valid;
+        }
+        if (!valid) {
+            return QByteArray();
+        }
+        return QByteArray(static_cast<const char*>(xcb_get_property_value(data())),
+                          xcb_get_property_value_length(data()));
+    }
+    /**
+     * @returns Whether the property has been truncated by the length passed to the constructor.
+     **/
+    inline bool hasMoreData() {
+        const xcb_get_property_reply_t *reply = data();
+        return reply && reply->bytes_after > 0;
+    }
+
+private:
+    xcb_atom_t m_type;
+};
+
 class ExtensionData
 {
 public: